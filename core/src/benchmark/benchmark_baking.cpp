@@ -27,10 +27,17 @@ using namespace ipl;
 
 void BenchmarkBakingForSettings(shared_ptr<Context> context, shared_ptr<IScene> scene, const SceneType type,
         shared_ptr<OpenCLDevice> openCL, shared_ptr<ipl::RadeonRaysDevice> radeonRays, byte_t* probeData, size_t probeDataSize,
-        const float spacing, const int rays, const int diffuseSamples, const int bounces, const int threads)
+        const float spacing, const int rays, const int diffuseSamples, const int bounces, const int threads,
+        const bool probeParallel = false)
 {
     auto simulator = ReflectionSimulatorFactory::create(type, rays, diffuseSamples, 2.0f, 1, 1, 1, threads, 1, radeonRays);
 
+    Array<unique_ptr<IReflectionSimulator>> simulators(probeParallel ? threads : 0);
+    for (auto i = 0u; i < simulators.size(0); ++i)
+    {
+        simulators[i] = ReflectionSimulatorFactory::create(type, rays, diffuseSamples, 2.0f, 1, 1, 1, 1, 1, radeonRays);
+    }
+
     SerializedObject serializedObject(probeDataSize, probeData);
     ProbeBatch probeBatch(serializedObject);
 
@@ -50,6 +57,11 @@ void BenchmarkBakingForSettings(shared_ptr<Context> context, shared_ptr<IScene>
 
     Timer timer;
     timer.start();
+    if (probeParallel)
+    {
+        ReflectionBaker::bakeProbeParallel(*scene, simulators, identifier, true, false, rays, bounces, 2.0f, 2.0f, 1, 1.0f, probeBatch);
+    }
+    else
     {
         ReflectionBaker::bake(*scene, *simulator, identifier, true, false, rays, bounces, 2.0f, 2.0f, 1, 1.0f, threads, 1, type, openCL, probeBatch);
 #if defined(IPL_USES_RADEONRAYS)
@@ -64,8 +76,8 @@ void BenchmarkBakingForSettings(shared_ptr<Context> context, shared_ptr<IScene>
     SerializedObject bakedDataSize;
     probeBatch.serializeAsRoot(bakedDataSize);
 
-    PrintOutput("%-6d  %10d  %10d  %8.2f  %10d  %10d %8.2f %16.4f\n", rays, diffuseSamples, bounces, spacing, probeBatch.numProbes(), threads,
-        elapsedSeconds, static_cast<float>(bakedDataSize.size()) / 1e6);
+    PrintOutput("%-6d  %10d  %10d  %8.2f  %10d  %10d %8.2f %16.4f %10s\n", rays, diffuseSamples, bounces, spacing, probeBatch.numProbes(), threads,
+        elapsedSeconds, static_cast<float>(bakedDataSize.size()) / 1e6, probeParallel ? "probes" : "rays");
 }
 
 uint64_t GetProbeData(const std::string& fileName, const float spacing,
@@ -184,7 +196,7 @@ void BenchmarkBakingForScene(const std::string& fileName, const SceneType type,
 
     // Single thread benchmarking.
     {
-        PrintOutput("%-6s  %10s  %10s  %10s  %10s  %10s  %10s %12s\n", "Rays", "Diffuse", "Bounces", "Spacing", "#Probes", "Threads", "Time (sec)", "Size (MB)");
+        PrintOutput("%-6s  %10s  %10s  %10s  %10s  %10s  %10s %12s %10s\n", "Rays", "Diffuse", "Bounces", "Spacing", "#Probes", "Threads", "Time (sec)", "Size (MB)", "Parallel");
 
         {
             auto probeDataSize = GetProbeData(fileName, 8.0f, 32768, 512, 4, 1, &probeData);
@@ -231,7 +243,7 @@ void BenchmarkBakingForScene(const std::string& fileName, const SceneType type,
     // Multi-threaded benchmarking.
     if (type != SceneType::RadeonRays)
     {
-        PrintOutput("%-6s  %10s  %10s  %10s  %10s  %10s  %10s %12s\n", "Rays", "Diffuse", "Bounces", "Spacing", "#Probes", "Threads", "Time (s)", "Size (MB)");
+        PrintOutput("%-6s  %10s  %10s  %10s  %10s  %10s  %10s %12s %10s\n", "Rays", "Diffuse", "Bounces", "Spacing", "#Probes", "Threads", "Time (s)", "Size (MB)", "Parallel");
 
         auto threads = { 1, 2, 4, 6, 8, 12, 16, 20, 24, 28, 32, 40, 48, 56, 64, 72 };
         for (auto thread : threads)
@@ -239,6 +251,12 @@ void BenchmarkBakingForScene(const std::string& fileName, const SceneType type,
             {
                 auto probeDataSize = GetProbeData(fileName, 8.0f, 16384, 512, 64, thread, &probeData);
                 BenchmarkBakingForSettings(context, scene, type, openCL, radeonRays, probeData, static_cast<size_t>(probeDataSize), 8.0f, 32768, 512, 64, thread);
+
+                // Compare against tracing probes in parallel, with each probe traced by a single thread.
+                if (thread > 1)
+                {
+                    BenchmarkBakingForSettings(context, scene, type, openCL, radeonRays, probeData, static_cast<size_t>(probeDataSize), 8.0f, 32768, 512, 64, thread, true);
+                }
             }
 
         PrintOutput("\n");
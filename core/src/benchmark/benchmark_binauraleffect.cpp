@@ -15,6 +15,7 @@
 //
 
 #include <log.h>
+#include <math_functions.h>
 #include <profiler.h>
 using namespace ipl;
 
@@ -59,9 +60,77 @@ void BenchmarkBinauralEffectWithInterpolation()
     PrintOutput("Creation time per effect = %.5f ms\n", elapsedTime);
 }
 
+void BenchmarkBinauralEffectWithInterpolationGrid(float interpolationGridResolution)
+{
+    const int kNumRuns = 10000;
+    const int kSamplingRate = 48000;
+    const int kFrameSize = 1024;
+
+    IPLContext context = nullptr;
+    IPLContextSettings contextSettings{ STEAMAUDIO_VERSION, nullptr, nullptr, nullptr, IPL_SIMDLEVEL_AVX512 };
+    iplContextCreate(&contextSettings, &context);
+
+    IPLAudioSettings dspParams = { kSamplingRate, kFrameSize };
+
+    Timer timer;
+    timer.start();
+
+    IPLHRTF hrtf = nullptr;
+    IPLHRTFSettings hrtfSettings{ IPL_HRTFTYPE_DEFAULT, nullptr, nullptr, 0, 1.0f, IPL_HRTFNORMTYPE_NONE, interpolationGridResolution };
+    iplHRTFCreate(context, &dspParams, &hrtfSettings, &hrtf);
+
+    auto creationTime = timer.elapsedMilliseconds();
+
+    IPLBinauralEffect effect = nullptr;
+    IPLBinauralEffectSettings effectSettings{ hrtf };
+    iplBinauralEffectCreate(context, &dspParams, &effectSettings, &effect);
+
+    std::vector<float> inData(kFrameSize);
+    std::vector<float> outDataLeft(kFrameSize);
+    std::vector<float> outDataRight(kFrameSize);
+    FillRandomData(inData.data(), kFrameSize);
+
+    float* inChannels[] = { inData.data() };
+    float* outChannels[] = { outDataLeft.data(), outDataRight.data() };
+    IPLAudioBuffer inBuffer{ 1, kFrameSize, inChannels };
+    IPLAudioBuffer outBuffer{ 2, kFrameSize, outChannels };
+
+    timer.start();
+
+    for (auto i = 0; i < kNumRuns; ++i)
+    {
+        // Move the source around the listener, so every frame needs a new interpolated HRTF.
+        auto angle = (2.0f * Math::kPi * i) / kNumRuns;
+        IPLVector3 direction{ sinf(angle), 0.2f, -cosf(angle) };
+
+        IPLBinauralEffectParams params{ direction, IPL_HRTFINTERPOLATION_BILINEAR, 1.0f, hrtf };
+        iplBinauralEffectApply(effect, &params, &inBuffer, &outBuffer);
+    }
+
+    auto timePerRun = timer.elapsedSeconds() / kNumRuns;
+
+    iplBinauralEffectRelease(&effect);
+    iplHRTFRelease(&hrtf);
+    iplContextRelease(&context);
+
+    auto frameTime = static_cast<double>(kFrameSize) / static_cast<double>(kSamplingRate);
+    auto cpuUsage = (timePerRun / frameTime) * 100.0;
+
+    PrintOutput("%-12.1f %12.2f ms %12.4f ms %8.2f%%\n", interpolationGridResolution, creationTime,
+                timePerRun * 1000.0, cpuUsage);
+}
+
 BENCHMARK(binauraleffect)
 {
     PrintOutput("Running benchmark: Create Object-Based Binaural Effect...\n");
     BenchmarkBinauralEffectWithInterpolation();
     PrintOutput("\n");
+
+    PrintOutput("Running benchmark: Bilinear Binaural Effect With Interpolation Grid...\n");
+    PrintOutput("%-12s %15s %15s %9s\n", "Grid (deg)", "HRTF Creation", "Time/Frame", "CPU");
+    BenchmarkBinauralEffectWithInterpolationGrid(0.0f);
+    BenchmarkBinauralEffectWithInterpolationGrid(10.0f);
+    BenchmarkBinauralEffectWithInterpolationGrid(5.0f);
+    BenchmarkBinauralEffectWithInterpolationGrid(2.0f);
+    PrintOutput("\n");
 }
@@ -0,0 +1,146 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <direct_effect.h>
+#include <profiler.h>
+using namespace ipl;
+
+#include <phonon.h>
+
+#include "phonon_perf.h"
+
+// Compares applying the direct effect to numVoices mono sources one at a time, using iplDirectEffectApply, against
+// applying it to all of them with a single DirectEffectBatch.
+void BenchmarkDirectEffectBatchWithOptions(int numVoices)
+{
+    const int kNumRuns = 1000;
+    const int kSamplingRate = 48000;
+    const int kFrameSize = 1024;
+
+    IPLContext context = nullptr;
+    IPLContextSettings contextSettings{ STEAMAUDIO_VERSION, nullptr, nullptr, nullptr, IPL_SIMDLEVEL_AVX512 };
+    iplContextCreate(&contextSettings, &context);
+
+    IPLAudioSettings renderSettings = { kSamplingRate, kFrameSize };
+
+    std::vector<IPLDirectEffect> directEffects(numVoices);
+    IPLDirectEffectSettings effectSettings{ 1 };
+    for (auto i = 0; i < numVoices; ++i)
+    {
+        iplDirectEffectCreate(context, &renderSettings, &effectSettings, &directEffects[i]);
+    }
+
+    AudioSettings audioSettings{};
+    audioSettings.samplingRate = kSamplingRate;
+    audioSettings.frameSize = kFrameSize;
+
+    DirectEffectBatch directEffectBatch(audioSettings, numVoices);
+
+    std::vector<std::vector<float>> inData(numVoices, std::vector<float>(kFrameSize));
+    std::vector<std::vector<float>> outData(numVoices, std::vector<float>(kFrameSize));
+    std::vector<float*> inDatad(numVoices);
+    std::vector<float*> outDatad(numVoices);
+    for (auto i = 0; i < numVoices; ++i)
+    {
+        FillRandomData(inData[i].data(), kFrameSize);
+        inDatad[i] = inData[i].data();
+        outDatad[i] = outData[i].data();
+    }
+
+    std::vector<IPLDirectEffectParams> directParams(numVoices);
+    std::vector<DirectEffectParams> batchParams(numVoices);
+    for (auto i = 0; i < numVoices; ++i)
+    {
+        auto& params = directParams[i];
+        params.flags = (IPLDirectEffectFlags) (IPL_DIRECTEFFECTFLAGS_APPLYDISTANCEATTENUATION | IPL_DIRECTEFFECTFLAGS_APPLYAIRABSORPTION |
+                                               IPL_DIRECTEFFECTFLAGS_APPLYOCCLUSION | IPL_DIRECTEFFECTFLAGS_APPLYTRANSMISSION);
+        params.distanceAttenuation = 1.0f / (1.0f + i);
+        for (auto iBand = 0; iBand < Bands::kNumBands; ++iBand)
+            params.airAbsorption[iBand] = 0.9f - 0.1f * iBand;
+        params.occlusion = 0.5f;
+        for (auto iBand = 0; iBand < Bands::kNumBands; ++iBand)
+            params.transmission[iBand] = 0.1f;
+        params.transmissionType = IPL_TRANSMISSIONTYPE_FREQDEPENDENT;
+
+        batchParams[i].flags = static_cast<DirectEffectFlags>(params.flags);
+        batchParams[i].transmissionType = TransmissionType::FreqDependent;
+        batchParams[i].directPath.distanceAttenuation = params.distanceAttenuation;
+        batchParams[i].directPath.occlusion = params.occlusion;
+        for (auto iBand = 0; iBand < Bands::kNumBands; ++iBand)
+        {
+            batchParams[i].directPath.airAbsorption[iBand] = params.airAbsorption[iBand];
+            batchParams[i].directPath.transmission[iBand] = params.transmission[iBand];
+        }
+    }
+
+    Timer timer;
+    timer.start();
+
+    for (auto i = 0; i < kNumRuns; ++i)
+    {
+        for (auto j = 0; j < numVoices; ++j)
+        {
+            // Changing transmission factor each run to get the worst case performance.
+            directParams[j].transmission[0] = (i + .1f) / kNumRuns;
+
+            IPLAudioBuffer inBuffer{ 1, kFrameSize, &inDatad[j] };
+            IPLAudioBuffer outBuffer{ 1, kFrameSize, &outDatad[j] };
+            iplDirectEffectApply(directEffects[j], &directParams[j], &inBuffer, &outBuffer);
+        }
+    }
+
+    auto timePerRunPerVoice = timer.elapsedSeconds() / kNumRuns;
+
+    timer.start();
+
+    for (auto i = 0; i < kNumRuns; ++i)
+    {
+        for (auto j = 0; j < numVoices; ++j)
+        {
+            batchParams[j].directPath.transmission[0] = (i + .1f) / kNumRuns;
+        }
+
+        directEffectBatch.apply(numVoices, batchParams.data(), inDatad.data(), outDatad.data());
+    }
+
+    auto timePerRunBatched = timer.elapsedSeconds() / kNumRuns;
+
+    for (auto i = 0; i < numVoices; ++i)
+    {
+        iplDirectEffectRelease(&directEffects[i]);
+    }
+    iplContextRelease(&context);
+
+    auto frameTime = static_cast<double>(kFrameSize) / static_cast<double>(kSamplingRate);
+    auto cpuUsagePerVoice = (timePerRunPerVoice / frameTime) * 100.0;
+    auto cpuUsageBatched = (timePerRunBatched / frameTime) * 100.0;
+
+    PrintOutput("%-12d %16.4f %16.4f %12.2fx\n",
+        numVoices, cpuUsagePerVoice, cpuUsageBatched, timePerRunPerVoice / timePerRunBatched);
+}
+
+BENCHMARK(directeffectbatch)
+{
+    PrintOutput("Running benchmark: Direct Effect Batch...\n");
+    PrintOutput("%-12s %16s %16s %13s\n", "Voices", "Per-Voice CPU %", "Batched CPU %", "Speedup");
+
+    BenchmarkDirectEffectBatchWithOptions(4);
+    BenchmarkDirectEffectBatchWithOptions(8);
+    BenchmarkDirectEffectBatchWithOptions(32);
+    BenchmarkDirectEffectBatchWithOptions(128);
+
+    PrintOutput("\n");
+}
@@ -26,7 +26,8 @@ using namespace ipl;
 
 enum LookUpMode {
     NEAREST,
-    ALL
+    ALL,
+    CACHED
 };
 
 void benchmarkProbeLookupForSettings(shared_ptr<Context> context, shared_ptr<IScene> scene, float spacing, LookUpMode mode)
@@ -46,6 +47,7 @@ void benchmarkProbeLookupForSettings(shared_ptr<Context> context, shared_ptr<ISc
 
     ProbeManager probeManager;
     probeManager.addProbeBatch(probeBatch);
+    probeManager.commit();
 
     PathSimulator pathSimulator(*probeBatch, 1, true, -Vector3f::kYAxis);
 
@@ -76,11 +78,75 @@ void benchmarkProbeLookupForSettings(shared_ptr<Context> context, shared_ptr<ISc
                 neighborhood.calcWeights(queryPosition);
             }
         }
+        else if (mode == CACHED)
+        {
+            ProbeOcclusionCache occlusionCache;
+
+            for (int i = 0; i < kNumRuns; ++i)
+            {
+                probeManager.getInfluencingProbes(queryPosition, neighborhood);
+                neighborhood.checkOcclusion(*scene, queryPosition, occlusionCache);
+                neighborhood.calcWeights(queryPosition);
+            }
+        }
     }
     auto elapsedTime = timer.elapsedMicroseconds() / kNumRuns;
 
     printf("\r");
-    PrintOutput("%-10s %-8.2f %-10d %-10.2f\n", mode == NEAREST ? "Nearest" : "All", spacing, numProbes, elapsedTime);
+    PrintOutput("%-10s %-8.2f %-10d %-10.2f\n", mode == NEAREST ? "Nearest" : (mode == ALL ? "All" : "Cached"), spacing, numProbes, elapsedTime);
+}
+
+// Compares looking up probes for many points one at a time with looking them up in a single batch.
+void benchmarkBatchedProbeLookupForSettings(shared_ptr<IScene> scene, float spacing, int numPoints)
+{
+    Matrix4x4f localToWorldTransform{};
+    localToWorldTransform.identity();
+    localToWorldTransform *= 8000;
+
+    auto height = 1.5f;
+    ProbeArray probes;
+    ProbeGenerator::generateProbes(*scene, localToWorldTransform, ProbeGenerationType::UniformFloor, spacing, height, probes);
+    auto numProbes = probes.numProbes();
+    if (numProbes == 0)
+        return;
+
+    auto probeBatch = make_shared<ProbeBatch>();
+    probeBatch->addProbeArray(probes);
+    probeBatch->commit();
+
+    ProbeManager probeManager;
+    probeManager.addProbeBatch(probeBatch);
+    probeManager.commit();
+
+    vector<Vector3f> points(numPoints);
+    for (auto i = 0; i < numPoints; ++i)
+    {
+        points[i] = probes[(i * 7919) % numProbes].influence.center;
+    }
+
+    Array<ProbeNeighborhood> neighborhoods(numPoints);
+
+    int kNumRuns = 100;
+
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < kNumRuns; ++i)
+    {
+        for (auto j = 0; j < numPoints; ++j)
+        {
+            probeManager.getInfluencingProbes(points[j], neighborhoods[j]);
+        }
+    }
+    auto singleTime = timer.elapsedMicroseconds() / kNumRuns;
+
+    timer.start();
+    for (int i = 0; i < kNumRuns; ++i)
+    {
+        probeManager.getInfluencingProbes(numPoints, points.data(), neighborhoods.data());
+    }
+    auto batchedTime = timer.elapsedMicroseconds() / kNumRuns;
+
+    PrintOutput("%-10s %-8.2f %-10d %-10d %-12.2f %-12.2f\n", "Batched", spacing, numProbes, numPoints, singleTime, batchedTime);
 }
 
 BENCHMARK(probelookup)
@@ -124,4 +190,16 @@ BENCHMARK(probelookup)
     benchmarkProbeLookupForSettings(context, scene, 2.0f, LookUpMode::ALL);
     benchmarkProbeLookupForSettings(context, scene, 1.5f, LookUpMode::ALL);
     benchmarkProbeLookupForSettings(context, scene, 1.0f, LookUpMode::ALL);
+
+    benchmarkProbeLookupForSettings(context, scene, 2.5f, LookUpMode::CACHED);
+    benchmarkProbeLookupForSettings(context, scene, 2.0f, LookUpMode::CACHED);
+    benchmarkProbeLookupForSettings(context, scene, 1.5f, LookUpMode::CACHED);
+    benchmarkProbeLookupForSettings(context, scene, 1.0f, LookUpMode::CACHED);
+
+    PrintOutput("%-10s %-8s %-10s %-10s %-12s %-12s\n", "Mode", "Spacing", "#Probes", "#Points", "Single (us)", "Batched (us)");
+
+    benchmarkBatchedProbeLookupForSettings(scene, 2.0f, 64);
+    benchmarkBatchedProbeLookupForSettings(scene, 2.0f, 256);
+    benchmarkBatchedProbeLookupForSettings(scene, 1.0f, 64);
+    benchmarkBatchedProbeLookupForSettings(scene, 1.0f, 256);
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "audio_buffer.h"
+#include "audio_thread_pool.h"
+using namespace ipl;
+
+#include "phonon.h"
+#include "util.h"
+
+#define STEAMAUDIO_SKIP_API_FUNCTIONS
+#include "phonon_interfaces.h"
+#include "api_context.h"
+#include "api_audio_effect_batch.h"
+
+namespace api {
+
+// --------------------------------------------------------------------------------------------------------------------
+// CAudioEffectBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+CAudioEffectBatch::CAudioEffectBatch(CContext* context,
+                                     IPLAudioEffectBatchSettings* settings)
+{
+    auto _context = context->mHandle.get();
+    if (!_context)
+        throw Exception(Status::Failure);
+
+    new (&mHandle) Handle<AudioThreadPool>(ipl::make_shared<AudioThreadPool>(settings->numThreads), _context);
+}
+
+IAudioEffectBatch* CAudioEffectBatch::retain()
+{
+    mHandle.retain();
+    return this;
+}
+
+void CAudioEffectBatch::release()
+{
+    if (mHandle.release())
+    {
+        this->~CAudioEffectBatch();
+        gMemory().free(this);
+    }
+}
+
+void CAudioEffectBatch::apply(IPLint32 numItems,
+                              IPLAudioEffectBatchItem* items)
+{
+    PROFILE_FUNCTION();
+
+    if (numItems <= 0 || !items)
+        return;
+
+    auto _threadPool = mHandle.get();
+    if (!_threadPool)
+        return;
+
+    // Reflection effects that write to a mixer all accumulate into the same mixer state, so they cannot run in
+    // parallel with each other. Everything else writes only to its own effect and output buffer.
+    mParallelItems.clear();
+    mSerialItems.clear();
+    for (auto i = 0; i < numItems; ++i)
+    {
+        if (items[i].type == IPL_AUDIOEFFECTBATCHITEMTYPE_REFLECTION && items[i].reflectionMixer)
+        {
+            mSerialItems.push_back(i);
+        }
+        else
+        {
+            mParallelItems.push_back(i);
+        }
+    }
+
+    _threadPool->process(static_cast<int>(mParallelItems.size()), [this, items](int index)
+    {
+        applyItem(items[mParallelItems[index]]);
+    });
+
+    for (auto index : mSerialItems)
+    {
+        applyItem(items[index]);
+    }
+
+    for (auto i = 0; i < numItems; ++i)
+    {
+        if (items[i].mix && items[i].out)
+        {
+            AudioBuffer _out(items[i].out->numChannels, items[i].out->numSamples, items[i].out->data);
+            AudioBuffer _mix(items[i].mix->numChannels, items[i].mix->numSamples, items[i].mix->data);
+
+            AudioBuffer::mix(_out, _mix);
+        }
+    }
+}
+
+void CAudioEffectBatch::applyItem(IPLAudioEffectBatchItem& item)
+{
+    switch (item.type)
+    {
+    case IPL_AUDIOEFFECTBATCHITEMTYPE_BINAURAL:
+        item.state = (item.binauralEffect) ? reinterpret_cast<IBinauralEffect*>(item.binauralEffect)->apply(item.binauralParams, item.in, item.out) : IPL_AUDIOEFFECTSTATE_TAILCOMPLETE;
+        break;
+
+    case IPL_AUDIOEFFECTBATCHITEMTYPE_DIRECT:
+        item.state = (item.directEffect) ? reinterpret_cast<IDirectEffect*>(item.directEffect)->apply(item.directParams, item.in, item.out) : IPL_AUDIOEFFECTSTATE_TAILCOMPLETE;
+        break;
+
+    case IPL_AUDIOEFFECTBATCHITEMTYPE_REFLECTION:
+        item.state = (item.reflectionEffect) ? reinterpret_cast<IReflectionEffect*>(item.reflectionEffect)->apply(item.reflectionParams, item.in, item.out, reinterpret_cast<IReflectionMixer*>(item.reflectionMixer)) : IPL_AUDIOEFFECTSTATE_TAILCOMPLETE;
+        break;
+
+    case IPL_AUDIOEFFECTBATCHITEMTYPE_PATH:
+        item.state = (item.pathEffect) ? reinterpret_cast<IPathEffect*>(item.pathEffect)->apply(item.pathParams, item.in, item.out) : IPL_AUDIOEFFECTSTATE_TAILCOMPLETE;
+        break;
+
+    default:
+        item.state = IPL_AUDIOEFFECTSTATE_TAILCOMPLETE;
+        break;
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// CContext
+// --------------------------------------------------------------------------------------------------------------------
+
+IPLerror CContext::createAudioEffectBatch(IPLAudioEffectBatchSettings* settings,
+                                          IAudioEffectBatch** batch)
+{
+    if (!settings || !batch)
+        return IPL_STATUS_FAILURE;
+
+    if (settings->numThreads < 0)
+        return IPL_STATUS_FAILURE;
+
+    try
+    {
+        auto _batch = reinterpret_cast<CAudioEffectBatch*>(gMemory().allocate(sizeof(CAudioEffectBatch), Memory::kDefaultAlignment));
+        new (_batch) CAudioEffectBatch(this, settings);
+        *batch = _batch;
+    }
+    catch (Exception e)
+    {
+        return static_cast<IPLerror>(e.status());
+    }
+
+    return IPL_STATUS_SUCCESS;
+}
+
+}
@@ -0,0 +1,57 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "audio_thread_pool.h"
+using namespace ipl;
+
+#include "phonon.h"
+#include "util.h"
+
+#define STEAMAUDIO_SKIP_API_FUNCTIONS
+#include "phonon_interfaces.h"
+#include "api_context.h"
+
+namespace api {
+
+// --------------------------------------------------------------------------------------------------------------------
+// CAudioEffectBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+class CAudioEffectBatch : public IAudioEffectBatch
+{
+public:
+    Handle<AudioThreadPool> mHandle;
+
+    CAudioEffectBatch(CContext* context,
+                      IPLAudioEffectBatchSettings* settings);
+
+    virtual IAudioEffectBatch* retain() override;
+
+    virtual void release() override;
+
+    virtual void apply(IPLint32 numItems,
+                       IPLAudioEffectBatchItem* items) override;
+
+private:
+    vector<int> mParallelItems; // Indices of work items that can be processed in parallel.
+    vector<int> mSerialItems; // Indices of work items that write to a reflection mixer, processed in order.
+
+    static void applyItem(IPLAudioEffectBatchItem& item);
+};
+
+}
@@ -52,6 +52,28 @@ void CContext::bakeReflections(IPLReflectionsBakeParams* params,
     auto _bakeConvolution = (params->bakeFlags & IPL_REFLECTIONSBAKEFLAGS_BAKECONVOLUTION);
     auto _bakeParametric = (params->bakeFlags & IPL_REFLECTIONSBAKEFLAGS_BAKEPARAMETRIC);
 
+    EnergyFieldCompressionSettings _compression{};
+    _compression.enabled = ((params->bakeFlags & IPL_REFLECTIONSBAKEFLAGS_COMPRESSCONVOLUTION) != 0);
+    _compression.numBits = (params->bakeFlags & IPL_REFLECTIONSBAKEFLAGS_COMPRESSCONVOLUTIONLOWPRECISION) ? 8 : 16;
+    _compression.orderReductionThreshold = CompressedEnergyField::kDefaultOrderReductionThreshold;
+
+    ReflectionBakeCheckpointSettings _checkpoint{};
+    _checkpoint.skipValidProbes = ((params->bakeFlags & IPL_REFLECTIONSBAKEFLAGS_INCREMENTAL) != 0);
+    if (Context::isCallerAPIVersionAtLeast(4, 9))
+    {
+        if ((params->bakeFlags & IPL_REFLECTIONSBAKEFLAGS_CHECKPOINT) && params->checkpointFileName)
+        {
+            _checkpoint.fileName = params->checkpointFileName;
+            _checkpoint.interval = std::max(params->checkpointInterval, 0);
+        }
+
+        if (params->numShards > 1)
+        {
+            _checkpoint.shard.index = params->shardIndex;
+            _checkpoint.shard.numShards = params->numShards;
+        }
+    }
+
     auto _bakeBatchSize = params->bakeBatchSize;
     if (params->sceneType != IPL_SCENETYPE_RADEONRAYS && params->identifier.variation != IPL_BAKEDDATAVARIATION_STATICLISTENER)
     {
@@ -79,6 +101,26 @@ void CContext::bakeReflections(IPLReflectionsBakeParams* params,
     auto _openCL = (params->openCLDevice) ? reinterpret_cast<COpenCLDevice*>(params->openCLDevice)->mHandle.get() : nullptr;
     auto _radeonRays = (params->radeonRaysDevice) ? reinterpret_cast<CRadeonRaysDevice*>(params->radeonRaysDevice)->mHandle.get() : nullptr;
 
+    auto _numProbesInShard = (_probeBatch->numProbes() + _checkpoint.shard.numShards - 1) / _checkpoint.shard.numShards;
+
+    if (ReflectionBaker::isProbeParallelBakingSupported(_sceneType, _identifier, _bakeBatchSize, _numProbesInShard, params->numThreads))
+    {
+        Array<unique_ptr<IReflectionSimulator>> simulators(params->numThreads);
+        for (auto i = 0; i < params->numThreads; ++i)
+        {
+            simulators[i] = ReflectionSimulatorFactory::create(_sceneType, params->numRays, params->numDiffuseSamples,
+                                                               params->simulatedDuration, params->order, 1, 1, 1,
+                                                               params->rayBatchSize, _radeonRays);
+        }
+
+        ReflectionBaker::bakeProbeParallel(*_scene, simulators, _identifier, _bakeConvolution, _bakeParametric,
+                                           params->numRays, params->numBounces, params->simulatedDuration,
+                                           params->savedDuration, params->order, params->irradianceMinDistance,
+                                           *_probeBatch, progressCallback, userData, _compression, _checkpoint);
+
+        return;
+    }
+
     auto simulator = ReflectionSimulatorFactory::create(_sceneType, params->numRays, params->numDiffuseSamples,
                                                         params->simulatedDuration, params->order, maxNumSources,
                                                         maxNumListeners, params->numThreads, params->rayBatchSize, _radeonRays);
@@ -86,7 +128,7 @@ void CContext::bakeReflections(IPLReflectionsBakeParams* params,
     ReflectionBaker::bake(*_scene, *simulator, _identifier, _bakeConvolution, _bakeParametric, params->numRays,
                           params->numBounces, params->simulatedDuration, params->savedDuration, params->order,
                           params->irradianceMinDistance, params->numThreads, params->bakeBatchSize, _sceneType, _openCL,
-                          *_probeBatch, progressCallback, userData);
+                          *_probeBatch, progressCallback, userData, _compression, _checkpoint);
 }
 
 void CContext::cancelBakeReflections()
@@ -94,6 +136,51 @@ void CContext::cancelBakeReflections()
     ReflectionBaker::cancel();
 }
 
+// Returns the core probe batches for a list of shards, or false if any of them are invalid. The shared pointers keep
+// the probe batches alive while they are being merged.
+static bool getShardProbeBatches(IPLint32 numShards,
+                                 IProbeBatch** shards,
+                                 vector<shared_ptr<ProbeBatch>>& handles,
+                                 vector<ProbeBatch*>& probeBatches)
+{
+    handles.resize(numShards);
+    probeBatches.resize(numShards);
+
+    for (auto i = 0; i < numShards; ++i)
+    {
+        if (!shards[i])
+            return false;
+
+        handles[i] = reinterpret_cast<CProbeBatch*>(shards[i])->mHandle.get();
+        probeBatches[i] = handles[i].get();
+        if (!probeBatches[i])
+            return false;
+    }
+
+    return true;
+}
+
+IPLerror CContext::mergeReflections(IPLReflectionsBakeParams* params,
+                                    IPLint32 numShards,
+                                    IProbeBatch** shards)
+{
+    if (!params || !params->probeBatch || numShards <= 0 || !shards)
+        return IPL_STATUS_FAILURE;
+
+    auto _probeBatch = reinterpret_cast<CProbeBatch*>(params->probeBatch)->mHandle.get();
+    vector<shared_ptr<ProbeBatch>> _shardHandles;
+    vector<ProbeBatch*> _shards;
+    if (!_probeBatch || !getShardProbeBatches(numShards, shards, _shardHandles, _shards))
+        return IPL_STATUS_FAILURE;
+
+    auto _identifier = *reinterpret_cast<BakedDataIdentifier*>(&params->identifier);
+
+    if (!ReflectionBaker::merge(_identifier, numShards, _shards.data(), *_probeBatch))
+        return IPL_STATUS_FAILURE;
+
+    return IPL_STATUS_SUCCESS;
+}
+
 void CContext::bakePaths(IPLPathBakeParams* params,
                          IPLProgressCallback progressCallback,
                          void* userData)
@@ -112,9 +199,28 @@ void CContext::bakePaths(IPLPathBakeParams* params,
     auto _visRangeRealTime = params->visRange;
     auto _pruneVisGraph = false;
 
+    BakeShard _shard{};
+    if (Context::isCallerAPIVersionAtLeast(4, 9))
+    {
+        if (params->numShards > 1)
+        {
+            _shard.index = params->shardIndex;
+            _shard.numShards = params->numShards;
+        }
+    }
+
+    auto _regionSize = 0.0f;
+    auto _incremental = false;
+    if (Context::isCallerAPIVersionAtLeast(4, 9))
+    {
+        _regionSize = params->regionSize;
+        _incremental = ((params->bakeFlags & IPL_PATHBAKEFLAGS_INCREMENTAL) != 0);
+    }
+
     PathBaker::bake(*_scene, _identifier, params->numSamples, params->radius, params->threshold, params->visRange,
                     _visRangeRealTime, params->pathRange, _asymmetricVisRange, _down, _pruneVisGraph,
-                    params->numThreads, *_probeBatch, progressCallback, userData);
+                    params->numThreads, *_probeBatch, progressCallback, userData, _shard, _regionSize,
+                    _incremental);
 }
 
 void CContext::cancelBakePaths()
@@ -122,4 +228,41 @@ void CContext::cancelBakePaths()
     PathBaker::cancel();
 }
 
+IPLerror CContext::mergePaths(IPLPathBakeParams* params,
+                              IPLint32 numShards,
+                              IProbeBatch** shards,
+                              IPLProgressCallback progressCallback,
+                              void* userData)
+{
+    if (!params || !params->probeBatch || numShards <= 0 || !shards)
+        return IPL_STATUS_FAILURE;
+
+    auto _probeBatch = reinterpret_cast<CProbeBatch*>(params->probeBatch)->mHandle.get();
+    vector<shared_ptr<ProbeBatch>> _shardHandles;
+    vector<ProbeBatch*> _shards;
+    if (!_probeBatch || !getShardProbeBatches(numShards, shards, _shardHandles, _shards))
+        return IPL_STATUS_FAILURE;
+
+    auto _identifier = *reinterpret_cast<BakedDataIdentifier*>(&params->identifier);
+    auto _asymmetricVisRange = true;
+    auto _down = Vector3f(0.0f, -1.0f, 0.0f);
+    auto _visRangeRealTime = params->visRange;
+    auto _pruneVisGraph = false;
+
+    auto _regionSize = 0.0f;
+    if (Context::isCallerAPIVersionAtLeast(4, 9))
+    {
+        _regionSize = params->regionSize;
+    }
+
+    if (!PathBaker::merge(_identifier, numShards, _shards.data(), _visRangeRealTime, params->pathRange,
+                          _asymmetricVisRange, _down, _pruneVisGraph, params->numThreads, *_probeBatch,
+                          progressCallback, userData, _regionSize))
+    {
+        return IPL_STATUS_FAILURE;
+    }
+
+    return IPL_STATUS_SUCCESS;
+}
+
 }
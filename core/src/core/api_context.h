@@ -158,6 +158,9 @@ public:
                                       IPLPathEffectSettings* effectSettings,
                                       IPathEffect** effect) override;
 
+    virtual IPLerror createAudioEffectBatch(IPLAudioEffectBatchSettings* settings,
+                                            IAudioEffectBatch** batch) override;
+
     virtual IPLerror createProbeArray(IProbeArray** probeArray) override;
 
     virtual IPLerror createProbeBatch(IProbeBatch** probeBatch) override;
@@ -165,18 +168,32 @@ public:
     virtual IPLerror loadProbeBatch(ISerializedObject* serializedObject,
                                     IProbeBatch** probeBatch) override;
 
+    virtual IPLerror loadProbeBatchStreaming(ISerializedObject* serializedObject,
+                                             IPLProbeBatchStreamingSettings* settings,
+                                             IProbeBatch** probeBatch) override;
+
     virtual void bakeReflections(IPLReflectionsBakeParams* params,
                                  IPLProgressCallback progressCallback,
                                  void* userData) override;
 
     virtual void cancelBakeReflections() override;
 
+    virtual IPLerror mergeReflections(IPLReflectionsBakeParams* params,
+                                      IPLint32 numShards,
+                                      IProbeBatch** shards) override;
+
     virtual void bakePaths(IPLPathBakeParams* params,
                            IPLProgressCallback progressCallback,
                            void* userData) override;
 
     virtual void cancelBakePaths() override;
 
+    virtual IPLerror mergePaths(IPLPathBakeParams* params,
+                                IPLint32 numShards,
+                                IProbeBatch** shards,
+                                IPLProgressCallback progressCallback,
+                                void* userData) override;
+
     virtual IPLerror createSimulator(IPLSimulationSettings* settings,
                                      ISimulator** simulator) override;
 
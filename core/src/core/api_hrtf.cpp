@@ -55,6 +55,11 @@ CHRTF::CHRTF(CContext* context,
         _hrtfSettings.normType = static_cast<HRTFNormType>(hrtfSettings->normType);
     }
 
+    if (Context::isCallerAPIVersionAtLeast(4, 9))
+    {
+        _hrtfSettings.interpolationGridResolution = hrtfSettings->interpolationGridResolution;
+    }
+
     new (&mHandle) Handle<HRTFDatabase>(ipl::make_shared<HRTFDatabase>(_hrtfSettings, audioSettings->samplingRate, audioSettings->frameSize), _context);
 }
 
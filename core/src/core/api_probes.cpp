@@ -74,7 +74,21 @@ void CProbeArray::generateProbes(IScene* scene,
     if (!_scene || !_probeArray)
         return;
 
-    ProbeGenerator::generateProbes(*_scene, _transform, _type, params->spacing, params->height, *_probeArray);
+    AdaptiveProbeGenerationSettings _adaptive{};
+    _adaptive.numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    if (Context::isCallerAPIVersionAtLeast(4, 9))
+    {
+        if (params->numSubdivisions > 0)
+        {
+            _adaptive.numSubdivisions = params->numSubdivisions;
+        }
+        if (params->tolerance > 0.0f)
+        {
+            _adaptive.tolerance = params->tolerance;
+        }
+    }
+
+    ProbeGenerator::generateProbes(*_scene, _transform, _type, params->spacing, params->height, *_probeArray, _adaptive);
 }
 
 IPLint32 CProbeArray::getNumProbes()
@@ -159,6 +173,21 @@ CProbeBatch::CProbeBatch(CContext* context,
     new (&mHandle) Handle<ProbeBatch>(ipl::make_shared<ProbeBatch>(*_serializedObject), _context);
 }
 
+CProbeBatch::CProbeBatch(CContext* context,
+                         ISerializedObject* serializedObject,
+                         IPLProbeBatchStreamingSettings* settings)
+{
+    auto _context = context->mHandle.get();
+    if (!_context)
+        throw Exception(Status::Failure);
+
+    auto _serializedObject = static_cast<CSerializedObject*>(serializedObject)->mHandle.get();
+    if (!_serializedObject)
+        throw Exception(Status::Failure);
+
+    new (&mHandle) Handle<ProbeBatch>(ipl::make_shared<ProbeBatch>(_serializedObject, settings->cacheSize), _context);
+}
+
 IProbeBatch* CProbeBatch::retain()
 {
     mHandle.retain();
@@ -255,6 +284,24 @@ void CProbeBatch::removeData(IPLBakedDataIdentifier* identifier)
     _probeBatch->removeData(_identifier);
 }
 
+void CProbeBatch::invalidateData(IPLBakedDataIdentifier* identifier,
+                                 IPLBox changedBounds,
+                                 IPLfloat32 radius)
+{
+    if (!identifier)
+        return;
+
+    auto _probeBatch = mHandle.get();
+    if (!_probeBatch)
+        return;
+
+    const auto& _identifier = *reinterpret_cast<BakedDataIdentifier*>(identifier);
+    auto _changedBounds = Box(*reinterpret_cast<Vector3f*>(&changedBounds.minCoordinates),
+                              *reinterpret_cast<Vector3f*>(&changedBounds.maxCoordinates));
+
+    _probeBatch->invalidateBakedData(_identifier, _changedBounds, radius);
+}
+
 IPLsize CProbeBatch::getDataSize(IPLBakedDataIdentifier* identifier)
 {
     auto _probeBatch = mHandle.get();
@@ -289,12 +336,7 @@ void CProbeBatch::getEnergyField(IPLBakedDataIdentifier* identifier, int probeIn
     if (!_energyField)
         return;
 
-    auto _sourceEnergyField = static_cast<BakedReflectionsData&>((*_probeBatch)[_identifier]).lookupEnergyField(probeIndex);
-    if (!_sourceEnergyField)
-        return;
-
-    _energyField->reset();
-    _energyField->copyFrom(*_sourceEnergyField);
+    static_cast<BakedReflectionsData&>((*_probeBatch)[_identifier]).getEnergyField(probeIndex, *_energyField);
 }
 
 void CProbeBatch::getReverb(IPLBakedDataIdentifier* identifier, int probeIndex, float* reverbTimes)
@@ -383,4 +425,25 @@ IPLerror CContext::loadProbeBatch(ISerializedObject* serializedObject,
     return IPL_STATUS_SUCCESS;
 }
 
+IPLerror CContext::loadProbeBatchStreaming(ISerializedObject* serializedObject,
+                                           IPLProbeBatchStreamingSettings* settings,
+                                           IProbeBatch** probeBatch)
+{
+    if (!serializedObject || !settings || !probeBatch)
+        return IPL_STATUS_FAILURE;
+
+    try
+    {
+        auto _probeBatch = reinterpret_cast<CProbeBatch*>(gMemory().allocate(sizeof(CProbeBatch), Memory::kDefaultAlignment));
+        new (_probeBatch) CProbeBatch(this, serializedObject, settings);
+        *probeBatch = _probeBatch;
+    }
+    catch (Exception e)
+    {
+        return static_cast<IPLerror>(e.status());
+    }
+
+    return IPL_STATUS_SUCCESS;
+}
+
 }
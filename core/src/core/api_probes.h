@@ -76,6 +76,10 @@ public:
     CProbeBatch(CContext* context,
                 ISerializedObject* serializedObject);
 
+    CProbeBatch(CContext* context,
+                ISerializedObject* serializedObject,
+                IPLProbeBatchStreamingSettings* settings);
+
     virtual IProbeBatch* retain() override;
 
     virtual void release() override;
@@ -94,6 +98,8 @@ public:
 
     virtual void removeData(IPLBakedDataIdentifier* identifier) override;
 
+    virtual void invalidateData(IPLBakedDataIdentifier* identifier, IPLBox changedBounds, IPLfloat32 radius) override;
+
     virtual IPLsize getDataSize(IPLBakedDataIdentifier* identifier) override;
 
     virtual void getEnergyField(IPLBakedDataIdentifier* identifier, int probeIndex, IEnergyField* energyField) override;
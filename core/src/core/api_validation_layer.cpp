@@ -38,6 +38,7 @@
 #include "api_direct_effect.h"
 #include "api_indirect_effect.h"
 #include "api_path_effect.h"
+#include "api_audio_effect_batch.h"
 #include "api_probes.h"
 #include "api_simulator.h"
 #include "api_energy_field.h"
@@ -172,8 +173,12 @@ std::string to_string(T* value)
     VALIDATE(IPLReflectionEffectType, value, (IPL_REFLECTIONEFFECTTYPE_CONVOLUTION <= value && value <= IPL_REFLECTIONEFFECTTYPE_TAN)); \
 }
 
+#define VALIDATE_IPLAudioEffectBatchItemType(value) { \
+    VALIDATE(IPLAudioEffectBatchItemType, value, (IPL_AUDIOEFFECTBATCHITEMTYPE_BINAURAL <= value && value <= IPL_AUDIOEFFECTBATCHITEMTYPE_PATH)); \
+}
+
 #define VALIDATE_IPLProbeGenerationType(value) { \
-    VALIDATE(IPLProbeGenerationType, value, (IPL_PROBEGENERATIONTYPE_CENTROID <= value && value <= IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR)); \
+    VALIDATE(IPLProbeGenerationType, value, (IPL_PROBEGENERATIONTYPE_CENTROID <= value && value <= IPL_PROBEGENERATIONTYPE_ADAPTIVE)); \
 }
 
 #define VALIDATE_IPLBakedDataType(value) { \
@@ -207,7 +212,11 @@ std::string to_string(T* value)
 }
 
 #define VALIDATE_IPLReflectionsBakeFlags(value) { \
-    VALIDATE(IPLReflectionsBakeFlags, value, ((value & ~(IPL_REFLECTIONSBAKEFLAGS_BAKECONVOLUTION | IPL_REFLECTIONSBAKEFLAGS_BAKEPARAMETRIC)) == 0)); \
+    VALIDATE(IPLReflectionsBakeFlags, value, ((value & ~(IPL_REFLECTIONSBAKEFLAGS_BAKECONVOLUTION | IPL_REFLECTIONSBAKEFLAGS_BAKEPARAMETRIC | IPL_REFLECTIONSBAKEFLAGS_COMPRESSCONVOLUTION | IPL_REFLECTIONSBAKEFLAGS_COMPRESSCONVOLUTIONLOWPRECISION | IPL_REFLECTIONSBAKEFLAGS_INCREMENTAL | IPL_REFLECTIONSBAKEFLAGS_CHECKPOINT)) == 0)); \
+}
+
+#define VALIDATE_IPLPathBakeFlags(value) { \
+    VALIDATE(IPLPathBakeFlags, value, ((value & ~(IPL_PATHBAKEFLAGS_INCREMENTAL)) == 0)); \
 }
 
 #define VALIDATE_IPLSimulationFlags(value) { \
@@ -383,6 +392,9 @@ std::string to_string(T* value)
         } \
         VALIDATE(IPLfloat32, value->volume, (value->volume > 0.0f)); \
         VALIDATE_IPLHRTFNormType(value->normType); \
+        if (Context::isCallerAPIVersionAtLeast(4, 9)) { \
+            VALIDATE(IPLfloat32, value->interpolationGridResolution, (value->interpolationGridResolution >= 0.0f)); \
+        } \
     } \
 }
 
@@ -613,6 +625,30 @@ std::string to_string(T* value)
     } \
 }
 
+#define VALIDATE_IPLAudioEffectBatchSettings(value) { \
+    VALIDATE_POINTER(value); \
+    if (value) { \
+        VALIDATE(IPLint32, value->numThreads, (value->numThreads >= 0)); \
+    } \
+}
+
+#define VALIDATE_IPLAudioEffectBatchItem(value) { \
+    VALIDATE_IPLAudioEffectBatchItemType(value->type); \
+    if (value->type == IPL_AUDIOEFFECTBATCHITEMTYPE_BINAURAL) { \
+        VALIDATE_POINTER(value->binauralEffect); \
+    } else if (value->type == IPL_AUDIOEFFECTBATCHITEMTYPE_DIRECT) { \
+        VALIDATE_POINTER(value->directEffect); \
+    } else if (value->type == IPL_AUDIOEFFECTBATCHITEMTYPE_REFLECTION) { \
+        VALIDATE_POINTER(value->reflectionEffect); \
+    } else if (value->type == IPL_AUDIOEFFECTBATCHITEMTYPE_PATH) { \
+        VALIDATE_POINTER(value->pathEffect); \
+    } \
+    if (value->mix) { \
+        VALIDATE_POINTER(value->out); \
+        VALIDATE(IPLAudioBuffer*, value->mix, (value->mix != value->in && value->mix != value->out)); \
+    } \
+}
+
 #define VALIDATE_IPLProbeGenerationParams(value) { \
     VALIDATE_POINTER(value); \
     if (value) { \
@@ -620,9 +656,12 @@ std::string to_string(T* value)
         if (value->type != IPL_PROBEGENERATIONTYPE_CENTROID) { \
             VALIDATE(IPLfloat32, value->spacing, (value->spacing > 0.0f)); \
         } \
-        if (value->type == IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR) { \
+        if (value->type == IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR || value->type == IPL_PROBEGENERATIONTYPE_ADAPTIVE) { \
             VALIDATE(IPLfloat32, value->height, (value->height > 0.0f)); \
         } \
+        if (value->type == IPL_PROBEGENERATIONTYPE_ADAPTIVE) { \
+            VALIDATE(IPLint32, value->numSubdivisions, (value->numSubdivisions <= ProbeGenerator::kMaxSubdivisions)); \
+        } \
         VALIDATE_IPLMatrix4x4(value->transform); \
     } \
 }
@@ -657,6 +696,15 @@ std::string to_string(T* value)
             VALIDATE_POINTER(value->openCLDevice); \
             VALIDATE_POINTER(value->radeonRaysDevice); \
         } \
+        if (Context::isCallerAPIVersionAtLeast(4, 9)) { \
+            if (value->bakeFlags & IPL_REFLECTIONSBAKEFLAGS_CHECKPOINT) { \
+                VALIDATE_POINTER(value->checkpointFileName); \
+                VALIDATE(IPLint32, value->checkpointInterval, (value->checkpointInterval >= 0)); \
+            } \
+            if (value->numShards > 1) { \
+                VALIDATE(IPLint32, value->shardIndex, (0 <= value->shardIndex && value->shardIndex < value->numShards)); \
+            } \
+        } \
     } \
 }
 
@@ -672,6 +720,13 @@ std::string to_string(T* value)
         VALIDATE(IPLfloat32, value->visRange, (value->visRange > 0.0f)); \
         VALIDATE(IPLfloat32, value->pathRange, (value->pathRange > 0.0f)); \
         VALIDATE(IPLint32, value->numThreads, (value->numThreads > 0)); \
+        if (Context::isCallerAPIVersionAtLeast(4, 9)) { \
+            if (value->numShards > 1) { \
+                VALIDATE(IPLint32, value->shardIndex, (0 <= value->shardIndex && value->shardIndex < value->numShards)); \
+            } \
+            VALIDATE(IPLfloat32, value->regionSize, (value->regionSize >= 0.0f)); \
+            VALIDATE_IPLPathBakeFlags(value->bakeFlags); \
+        } \
     } \
 }
 
@@ -903,6 +958,7 @@ class CValidatedDirectEffect;
 class CValidatedReflectionEffect;
 class CValidatedReflectionMixer;
 class CValidatedPathEffect;
+class CValidatedAudioEffectBatch;
 class CValidatedProbeArray;
 class CValidatedProbeBatch;
 class CValidatedSimulator;
@@ -1190,6 +1246,14 @@ public:
         return apiObjectAllocate<CValidatedPathEffect, CContext, IPathEffect>(effect, this, audioSettings, effectSettings);
     }
 
+    virtual IPLerror createAudioEffectBatch(IPLAudioEffectBatchSettings* settings, IAudioEffectBatch** batch) override
+    {
+        VALIDATE_IPLAudioEffectBatchSettings(settings);
+        VALIDATE_POINTER(batch);
+
+        return apiObjectAllocate<CValidatedAudioEffectBatch, CContext, IAudioEffectBatch>(batch, this, settings);
+    }
+
     virtual IPLerror createProbeArray(IProbeArray** probeArray) override
     {
         VALIDATE_POINTER(probeArray);
@@ -1212,6 +1276,15 @@ public:
         return apiObjectAllocate<CValidatedProbeBatch, CContext, IProbeBatch>(probeBatch, this, serializedObject);
     }
 
+    virtual IPLerror loadProbeBatchStreaming(ISerializedObject* serializedObject, IPLProbeBatchStreamingSettings* settings, IProbeBatch** probeBatch) override
+    {
+        VALIDATE_POINTER(serializedObject);
+        VALIDATE_POINTER(settings);
+        VALIDATE_POINTER(probeBatch);
+
+        return apiObjectAllocate<CValidatedProbeBatch, CContext, IProbeBatch>(probeBatch, this, serializedObject, settings);
+    }
+
     virtual void bakeReflections(IPLReflectionsBakeParams* params, IPLProgressCallback progressCallback, void* userData) override
     {
         VALIDATE_IPLReflectionsBakeParams(params);
@@ -1219,6 +1292,20 @@ public:
         CContext::bakeReflections(params, progressCallback, userData);
     }
 
+    virtual IPLerror mergeReflections(IPLReflectionsBakeParams* params, IPLint32 numShards, IProbeBatch** shards) override
+    {
+        VALIDATE_POINTER(params);
+        if (params)
+        {
+            VALIDATE_POINTER(params->probeBatch);
+            VALIDATE_IPLBakedDataIdentifier(params->identifier);
+        }
+        VALIDATE(IPLint32, numShards, (numShards > 0));
+        VALIDATE_POINTER(shards);
+
+        return CContext::mergeReflections(params, numShards, shards);
+    }
+
     virtual void bakePaths(IPLPathBakeParams* params, IPLProgressCallback progressCallback, void* userData) override
     {
         VALIDATE_IPLPathBakeParams(params);
@@ -1226,6 +1313,27 @@ public:
         CContext::bakePaths(params, progressCallback, userData);
     }
 
+    virtual IPLerror mergePaths(IPLPathBakeParams* params, IPLint32 numShards, IProbeBatch** shards, IPLProgressCallback progressCallback, void* userData) override
+    {
+        VALIDATE_POINTER(params);
+        if (params)
+        {
+            VALIDATE_POINTER(params->probeBatch);
+            VALIDATE_IPLBakedDataIdentifier(params->identifier);
+            VALIDATE(IPLfloat32, params->visRange, (params->visRange > 0.0f));
+            VALIDATE(IPLfloat32, params->pathRange, (params->pathRange > 0.0f));
+            VALIDATE(IPLint32, params->numThreads, (params->numThreads > 0));
+            if (Context::isCallerAPIVersionAtLeast(4, 9))
+            {
+                VALIDATE(IPLfloat32, params->regionSize, (params->regionSize >= 0.0f));
+            }
+        }
+        VALIDATE(IPLint32, numShards, (numShards > 0));
+        VALIDATE_POINTER(shards);
+
+        return CContext::mergePaths(params, numShards, shards, progressCallback, userData);
+    }
+
     virtual IPLerror createSimulator(IPLSimulationSettings* settings, ISimulator** simulator) override
     {
         VALIDATE_IPLSimulationSettings(settings);
@@ -1936,6 +2044,38 @@ public:
 };
 
 
+// --------------------------------------------------------------------------------------------------------------------
+// CValidatedAudioEffectBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+class CValidatedAudioEffectBatch : public CAudioEffectBatch
+{
+public:
+    CValidatedAudioEffectBatch(CContext* context, IPLAudioEffectBatchSettings* settings)
+        : CAudioEffectBatch(context, settings)
+    {}
+
+    virtual void apply(IPLint32 numItems, IPLAudioEffectBatchItem* items) override
+    {
+        VALIDATE(IPLint32, numItems, (numItems >= 0));
+        if (numItems > 0)
+        {
+            VALIDATE_POINTER(items);
+        }
+
+        if (items)
+        {
+            for (auto i = 0; i < numItems; ++i)
+            {
+                VALIDATE_IPLAudioEffectBatchItem((&items[i]));
+            }
+        }
+
+        CAudioEffectBatch::apply(numItems, items);
+    }
+};
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // CValidatedProbeArray
 // --------------------------------------------------------------------------------------------------------------------
@@ -1992,6 +2132,10 @@ public:
         : CProbeBatch(context, serializedObject)
     {}
 
+    CValidatedProbeBatch(CContext* context, ISerializedObject* serializedObject, IPLProbeBatchStreamingSettings* settings)
+        : CProbeBatch(context, serializedObject, settings)
+    {}
+
     virtual void save(ISerializedObject* serializedObject) override
     {
         VALIDATE_POINTER(serializedObject);
@@ -2040,6 +2184,20 @@ public:
         CProbeBatch::removeData(identifier);
     }
 
+    virtual void invalidateData(IPLBakedDataIdentifier* identifier, IPLBox changedBounds, IPLfloat32 radius) override
+    {
+        VALIDATE_POINTER(identifier);
+        if (identifier)
+        {
+            VALIDATE_IPLBakedDataIdentifier((*identifier));
+        }
+        VALIDATE_IPLVector3(changedBounds.minCoordinates);
+        VALIDATE_IPLVector3(changedBounds.maxCoordinates);
+        VALIDATE(IPLfloat32, radius, (radius >= 0.0f));
+
+        CProbeBatch::invalidateData(identifier, changedBounds, radius);
+    }
+
     virtual IPLsize getDataSize(IPLBakedDataIdentifier* identifier) override
     {
         VALIDATE_POINTER(identifier);
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "half.h"
 #include "types.h"
 
 namespace ipl {
@@ -60,6 +61,28 @@ namespace ArrayMath
                             const complex_t* in2,
                             complex_t* accum);
 
+    // Complex-valued multiply-accumulate, with both inputs stored in half precision.
+    void multiplyAccumulate(int size,
+                            const complexh_t* in1,
+                            const complexh_t* in2,
+                            complex_t* accum);
+
+    // Complex-valued multiply-accumulate, with the second input stored in half precision.
+    void multiplyAccumulate(int size,
+                            const complex_t* in1,
+                            const complexh_t* in2,
+                            complex_t* accum);
+
+    // Conversion of complex values to half precision.
+    void convert(int size,
+                 const complex_t* in,
+                 complexh_t* out);
+
+    // Conversion of complex values from half precision.
+    void convert(int size,
+                 const complexh_t* in,
+                 complex_t* out);
+
     // Scaling by a constant.
     void scale(int size,
                const float* in,
@@ -131,6 +154,28 @@ namespace ArrayMath
                           const float* inMagnitude,
                           const float* inPhase,
                           complex_t* out);
+
+#if defined(IPL_ENABLE_FLOAT8)
+    // AVX + F16C implementations of the half-precision functions above. These must only be called if gSIMDLevel()
+    // is at least SIMDLevel::AVX2, since some CPUs that support AVX do not support F16C.
+    void multiplyAccumulate_float8(int size,
+                                   const complexh_t* in1,
+                                   const complexh_t* in2,
+                                   complex_t* accum);
+
+    void multiplyAccumulate_float8(int size,
+                                   const complex_t* in1,
+                                   const complexh_t* in2,
+                                   complex_t* accum);
+
+    void convert_float8(int size,
+                        const complex_t* in,
+                        complexh_t* out);
+
+    void convert_float8(int size,
+                        const complexh_t* in,
+                        complex_t* out);
+#endif
 }
 
 }
@@ -0,0 +1,157 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "audio_thread_pool.h"
+
+#include "profiler.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// AudioThreadPool
+// --------------------------------------------------------------------------------------------------------------------
+
+AudioThreadPool::AudioThreadPool(int numThreads)
+    : mThreads(numThreads)
+    , mTaskState(0)
+    , mNumTasksCompleted(0)
+    , mNumSleeping(0)
+    , mQuit(false)
+    , mCallback(nullptr)
+{
+    mNumTasks[0] = 0;
+    mNumTasks[1] = 0;
+
+    for (auto i = 0; i < numThreads; ++i)
+    {
+        mThreads[i] = std::thread(&AudioThreadPool::threadFunc, this);
+    }
+}
+
+AudioThreadPool::~AudioThreadPool()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mQuit = true;
+    mCondVar.notify_all();
+    lock.unlock();
+
+    for (auto i = 0u; i < mThreads.size(0); ++i)
+    {
+        mThreads[i].join();
+    }
+}
+
+void AudioThreadPool::process(int numTasks,
+                              const AudioTaskCallback& callback)
+{
+    PROFILE_FUNCTION();
+
+    if (numTasks <= 0)
+        return;
+
+    if (mThreads.size(0) == 0)
+    {
+        for (auto i = 0; i < numTasks; ++i)
+        {
+            callback(i);
+        }
+
+        return;
+    }
+
+    // Everything a worker needs to run a task must be written before the new batch number is published. Workers
+    // still finishing up the previous batch will see the batch number change, and will not claim any more tasks.
+    // The task count is stored separately for consecutive batches: a worker that read the task index of the previous
+    // batch must compare it against that batch's count, otherwise it could claim a task from this batch before it
+    // has been published, and the same task would then be claimed again afterwards.
+    auto batch = batchOf(mTaskState.load()) + 1;
+    mCallback = &callback;
+    mNumTasks[batch % 2] = numTasks;
+    mNumTasksCompleted = 0;
+    mTaskState = static_cast<uint64_t>(batch) << 32;
+
+    // Workers that are still spinning will pick up the batch on their own. Only take the lock if some of them
+    // have gone to sleep.
+    if (mNumSleeping > 0)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondVar.notify_all();
+    }
+
+    processTasks(batch);
+
+    while (mNumTasksCompleted < numTasks)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void AudioThreadPool::threadFunc()
+{
+    auto lastBatch = batchOf(mTaskState.load());
+
+    while (true)
+    {
+        auto batch = lastBatch;
+
+        for (auto i = 0; i < kNumSpinIterations && batch == lastBatch && !mQuit; ++i)
+        {
+            std::this_thread::yield();
+            batch = batchOf(mTaskState.load());
+        }
+
+        if (batch == lastBatch && !mQuit)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            ++mNumSleeping;
+            mCondVar.wait(lock, [this, lastBatch]() { return (mQuit || batchOf(mTaskState.load()) != lastBatch); });
+            --mNumSleeping;
+            batch = batchOf(mTaskState.load());
+        }
+
+        if (mQuit)
+            break;
+
+        lastBatch = batch;
+        processTasks(batch);
+    }
+}
+
+void AudioThreadPool::processTasks(uint32_t batch)
+{
+    while (true)
+    {
+        auto taskState = mTaskState.load();
+        if (batchOf(taskState) != batch)
+            return;
+
+        auto taskIndex = taskIndexOf(taskState);
+        if (taskIndex >= mNumTasks[batch % 2])
+            return;
+
+        // The claim only succeeds if the batch number is unchanged, so a stale worker can never run a task from a
+        // later batch using an index it read from an earlier one. The count of the next batch is stored in the other
+        // slot, and the one after that can only be set up once the next batch has been published, after which this
+        // claim will fail.
+        if (mTaskState.compare_exchange_weak(taskState, taskState + 1))
+        {
+            (*mCallback)(taskIndex);
+            ++mNumTasksCompleted;
+        }
+    }
+}
+
+}
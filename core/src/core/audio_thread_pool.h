@@ -0,0 +1,76 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "array.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// AudioThreadPool
+// --------------------------------------------------------------------------------------------------------------------
+
+using AudioTaskCallback = std::function<void(int)>;
+
+// A pool of worker threads that runs a batch of independent tasks from within the audio processing thread. Unlike
+// ThreadPool, the calling thread takes part in processing the batch, tasks are claimed without taking locks, and
+// workers spin for a short while before going to sleep between batches, so a batch submitted every audio frame
+// usually does not have to wait for threads to be woken up. A batch may only be submitted by one thread at a time.
+class AudioThreadPool
+{
+public:
+    // numThreads is the number of worker threads to create, in addition to the thread that calls process().
+    AudioThreadPool(int numThreads);
+
+    ~AudioThreadPool();
+
+    int numThreads() const { return static_cast<int>(mThreads.size(0)); }
+
+    // Calls callback(i) for every i in [0, numTasks), and returns once all calls have completed. Calls may run on any
+    // thread in the pool, in any order.
+    void process(int numTasks,
+                 const AudioTaskCallback& callback);
+
+private:
+    static const int kNumSpinIterations = 4096;
+
+    Array<std::thread> mThreads;
+    std::atomic<uint64_t> mTaskState; // Batch number in the upper 32 bits, index of next task to claim in the lower.
+    std::atomic<int> mNumTasks[2]; // Number of tasks in the two most recent batches, indexed by batch number % 2.
+    std::atomic<int> mNumTasksCompleted;
+    std::atomic<int> mNumSleeping;
+    std::atomic<bool> mQuit;
+    const AudioTaskCallback* mCallback;
+    std::mutex mMutex;
+    std::condition_variable mCondVar;
+
+    void threadFunc();
+
+    // Claims and runs tasks from the given batch until there are none left.
+    void processTasks(uint32_t batch);
+
+    static uint32_t batchOf(uint64_t taskState) { return static_cast<uint32_t>(taskState >> 32); }
+    static int taskIndexOf(uint64_t taskState) { return static_cast<int>(taskState & 0xffffffff); }
+};
+
+}
@@ -24,6 +24,8 @@ namespace ipl {
 // BakedReflectionsData
 // ---------------------------------------------------------------------------------------------------------------------
 
+std::atomic<uint64_t> BakedReflectionsData::sNextVersion(0);
+
 BakedReflectionsData::BakedReflectionsData(const BakedDataIdentifier& identifier,
                                            int numProbes,
                                            bool hasConvolution,
@@ -32,10 +34,15 @@ BakedReflectionsData::BakedReflectionsData(const BakedDataIdentifier& identifier
     , mHasConvolution(hasConvolution)
     , mHasParametric(hasParametric)
     , mNeedsUpdate(numProbes)
+    , mSerializedObject(nullptr)
+    , mSerializedIndices(numProbes, -1)
+    , mCache(0)
+    , mVersion(++sNextVersion)
 {
     if (hasConvolution)
     {
         mEnergyFields.resize(numProbes);
+        mCompressedEnergyFields.resize(numProbes);
     }
 
     if (hasParametric)
@@ -52,8 +59,36 @@ BakedReflectionsData::BakedReflectionsData(const BakedDataIdentifier& identifier
 BakedReflectionsData::BakedReflectionsData(const BakedDataIdentifier& identifier,
                                            int numProbes,
                                            const Serialized::BakedReflectionsData* serializedObject)
+    : BakedReflectionsData(identifier, numProbes, serializedObject, 0)
+{
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        if (mSerializedIndices[i] < 0)
+            continue;
+
+        mEnergyFields[i] = loadEnergyField(serializedObject, mSerializedIndices[i]);
+        if (!mEnergyFields[i])
+        {
+            mCompressedEnergyFields[i] = loadCompressedEnergyField(serializedObject, mSerializedIndices[i]);
+        }
+
+        mSerializedIndices[i] = -1;
+    }
+
+    mSerializedObject = nullptr;
+}
+
+BakedReflectionsData::BakedReflectionsData(const BakedDataIdentifier& identifier,
+                                           int numProbes,
+                                           const Serialized::BakedReflectionsData* serializedObject,
+                                           uint64_t cacheSize)
     : mIdentifier(identifier)
     , mNeedsUpdate(numProbes)
+    , mSerializedObject(serializedObject)
+    , mSerializedIndices(numProbes, -1)
+    , mSerializedSizes(numProbes, 0)
+    , mCache(cacheSize)
+    , mVersion(++sNextVersion)
 {
     assert(serializedObject);
     assert(serializedObject->needs_update() && serializedObject->needs_update()->Length() > 0);
@@ -63,22 +98,29 @@ BakedReflectionsData::BakedReflectionsData(const BakedDataIdentifier& identifier
     mHasConvolution = (serializedObject->energy_fields() != nullptr);
     mHasParametric = (serializedObject->reverbs() != nullptr);
 
+    mShard.index = serializedObject->shard_index();
+    mShard.numShards = serializedObject->num_shards();
+
     if (mHasConvolution)
     {
         mEnergyFields.resize(numProbes);
+        mCompressedEnergyFields.resize(numProbes);
+
+        auto energyFields = serializedObject->energy_fields();
+        auto compressedEnergyFields = serializedObject->compressed_energy_fields();
 
         for (auto i = 0; i < numProbes; ++i)
         {
-            if (!mNeedsUpdate[i])
+            if (mNeedsUpdate[i])
+                continue;
+
+            auto hasEnergyField = (energyFields->Length() > static_cast<uint32_t>(i) && energyFields->Get(i) != nullptr);
+            auto hasCompressedEnergyField = (compressedEnergyFields && compressedEnergyFields->Length() > static_cast<uint32_t>(i) && compressedEnergyFields->Get(i) != nullptr);
+
+            if (hasEnergyField || hasCompressedEnergyField)
             {
-                if (serializedObject->energy_fields()->Length() > i && serializedObject->energy_fields()->Get(i) != nullptr)
-                {
-                    mEnergyFields[i] = ipl::make_unique<EnergyField>(serializedObject->energy_fields()->Get(i));
-                }
-                else
-                {
-                    mEnergyFields[i] = nullptr;
-                }
+                mSerializedIndices[i] = i;
+                mSerializedSizes[i] = loadedEnergyFieldSize(serializedObject, i);
             }
         }
     }
@@ -99,10 +141,14 @@ void BakedReflectionsData::updateProbePosition(int index,
 void BakedReflectionsData::addProbe(const Sphere& influence)
 {
     mNeedsUpdate.push_back(true);
+    mSerializedIndices.push_back(-1);
+
+    updateVersion();
 
     if (mHasConvolution)
     {
         mEnergyFields.push_back(nullptr);
+        mCompressedEnergyFields.push_back(nullptr);
     }
 
     if (mHasParametric)
@@ -114,10 +160,14 @@ void BakedReflectionsData::addProbe(const Sphere& influence)
 void BakedReflectionsData::removeProbe(int index)
 {
     mNeedsUpdate.erase(mNeedsUpdate.begin() + index);
+    mSerializedIndices.erase(mSerializedIndices.begin() + index);
+
+    updateVersion();
 
     if (mHasConvolution)
     {
         mEnergyFields.erase(mEnergyFields.begin() + index);
+        mCompressedEnergyFields.erase(mCompressedEnergyFields.begin() + index);
     }
 
     if (mHasParametric)
@@ -133,6 +183,8 @@ void BakedReflectionsData::updateEndpoint(const BakedDataIdentifier& identifier,
     if (identifier != mIdentifier)
         return;
 
+    updateVersion();
+
     if (mIdentifier.endpointInfluence.center != endpointInfluence.center)
     {
         for (auto i = 0u; i < mEnergyFields.size(); ++i)
@@ -156,6 +208,8 @@ void BakedReflectionsData::updateEndpoint(const BakedDataIdentifier& identifier,
                 if (mHasConvolution)
                 {
                     mEnergyFields[i] = nullptr;
+                    mCompressedEnergyFields[i] = nullptr;
+                    mSerializedIndices[i] = -1;
                 }
 
                 if (mHasParametric)
@@ -184,6 +238,14 @@ uint64_t BakedReflectionsData::serializedSize() const
                 {
                     size += mEnergyFields[i]->serializedSize();
                 }
+                else if (mCompressedEnergyFields[i])
+                {
+                    size += mCompressedEnergyFields[i]->serializedSize();
+                }
+                else if (mSerializedIndices[i] >= 0)
+                {
+                    size += mSerializedSizes[mSerializedIndices[i]];
+                }
             }
         }
     }
@@ -204,6 +266,15 @@ uint64_t BakedReflectionsData::serializedSize() const
 
 void BakedReflectionsData::evaluateEnergyField(const ProbeNeighborhood& neighborhood, EnergyField& energyField)
 {
+    if (!mHasConvolution)
+        return;
+
+    std::unique_lock<std::mutex> lock(mCacheMutex, std::defer_lock);
+    if (isStreaming())
+    {
+        lock.lock();
+    }
+
     for (auto i = 0; i < neighborhood.numProbes(); ++i)
     {
         if (!neighborhood.batches[i] || neighborhood.probeIndices[i] < 0)
@@ -212,11 +283,18 @@ void BakedReflectionsData::evaluateEnergyField(const ProbeNeighborhood& neighbor
         if (neighborhood.batches[i]->hasData(mIdentifier) && &(*neighborhood.batches[i])[mIdentifier] != this)
             continue;
 
-        auto* probeEnergyField = lookupEnergyField(neighborhood.probeIndices[i]);
-        if (!probeEnergyField)
-            continue;
+        const EnergyField* probeEnergyField = nullptr;
+        const CompressedEnergyField* probeCompressedEnergyField = nullptr;
+        findEnergyField(neighborhood.probeIndices[i], &probeEnergyField, &probeCompressedEnergyField);
 
-        EnergyField::scaleAccumulate(*probeEnergyField, neighborhood.weights[i], energyField);
+        if (probeEnergyField)
+        {
+            EnergyField::scaleAccumulate(*probeEnergyField, neighborhood.weights[i], energyField);
+        }
+        else if (probeCompressedEnergyField)
+        {
+            probeCompressedEnergyField->decodeScaleAccumulate(neighborhood.weights[i], energyField);
+        }
     }
 }
 
@@ -241,6 +319,27 @@ void BakedReflectionsData::evaluateReverb(const ProbeNeighborhood& neighborhood,
     }
 }
 
+void BakedReflectionsData::prefetch(const ProbeNeighborhood& neighborhood) const
+{
+    if (!isStreaming() || !mHasConvolution)
+        return;
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    for (auto i = 0; i < neighborhood.numProbes(); ++i)
+    {
+        if (!neighborhood.batches[i] || neighborhood.probeIndices[i] < 0)
+            continue;
+
+        if (neighborhood.batches[i]->hasData(mIdentifier) && &(*neighborhood.batches[i])[mIdentifier] != this)
+            continue;
+
+        const EnergyField* probeEnergyField = nullptr;
+        const CompressedEnergyField* probeCompressedEnergyField = nullptr;
+        findEnergyField(neighborhood.probeIndices[i], &probeEnergyField, &probeCompressedEnergyField);
+    }
+}
+
 flatbuffers::Offset<Serialized::BakedReflectionsData> BakedReflectionsData::serialize(SerializedObject& serializedObject) const
 {
     auto& fbb = serializedObject.fbb();
@@ -249,16 +348,50 @@ flatbuffers::Offset<Serialized::BakedReflectionsData> BakedReflectionsData::seri
     needsUpdateOffset = fbb.CreateVector(mNeedsUpdate.data(), mNeedsUpdate.size());
 
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialized::EnergyField>>> energyFieldsOffset = 0;
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialized::CompressedEnergyField>>> compressedEnergyFieldsOffset = 0;
     if (mHasConvolution)
     {
         vector<flatbuffers::Offset<Serialized::EnergyField>> energyFieldOffsets(mEnergyFields.size());
+        vector<flatbuffers::Offset<Serialized::CompressedEnergyField>> compressedEnergyFieldOffsets(mCompressedEnergyFields.size());
+        auto hasCompressedEnergyFields = false;
 
         for (auto i = 0u; i < mEnergyFields.size(); ++i)
         {
-            energyFieldOffsets[i] = (!mNeedsUpdate[i] && mEnergyFields[i]) ? mEnergyFields[i]->serialize(serializedObject) : 0;
+            if (mNeedsUpdate[i])
+                continue;
+
+            unique_ptr<EnergyField> streamedEnergyField;
+            unique_ptr<CompressedEnergyField> streamedCompressedEnergyField;
+            if (mSerializedIndices[i] >= 0)
+            {
+                streamedEnergyField = loadEnergyField(mSerializedObject, mSerializedIndices[i]);
+                if (!streamedEnergyField)
+                {
+                    streamedCompressedEnergyField = loadCompressedEnergyField(mSerializedObject, mSerializedIndices[i]);
+                }
+            }
+
+            const auto* energyField = (mEnergyFields[i]) ? mEnergyFields[i].get() : streamedEnergyField.get();
+            const auto* compressedEnergyField = (mCompressedEnergyFields[i]) ? mCompressedEnergyFields[i].get() : streamedCompressedEnergyField.get();
+
+            if (energyField)
+            {
+                energyFieldOffsets[i] = energyField->serialize(serializedObject);
+            }
+            else if (compressedEnergyField)
+            {
+                compressedEnergyFieldOffsets[i] = compressedEnergyField->serialize(serializedObject);
+                hasCompressedEnergyFields = true;
+            }
         }
 
         energyFieldsOffset = fbb.CreateVector(energyFieldOffsets.data(), energyFieldOffsets.size());
+
+        // Only written if needed, so uncompressed data can still be loaded by older versions.
+        if (hasCompressedEnergyFields)
+        {
+            compressedEnergyFieldsOffset = fbb.CreateVector(compressedEnergyFieldOffsets.data(), compressedEnergyFieldOffsets.size());
+        }
     }
 
     flatbuffers::Offset<flatbuffers::Vector<const Serialized::Reverb*>> reverbsOffset = 0;
@@ -267,7 +400,8 @@ flatbuffers::Offset<Serialized::BakedReflectionsData> BakedReflectionsData::seri
         reverbsOffset = fbb.CreateVectorOfStructs(reinterpret_cast<const Serialized::Reverb*>(mReverbs.data()), mReverbs.size());
     }
 
-    return Serialized::CreateBakedReflectionsData(fbb, energyFieldsOffset, reverbsOffset, needsUpdateOffset);
+    return Serialized::CreateBakedReflectionsData(fbb, energyFieldsOffset, reverbsOffset, needsUpdateOffset, compressedEnergyFieldsOffset,
+                                                  mShard.index, mShard.numShards);
 }
 
 int BakedReflectionsData::numProbes() const
@@ -275,11 +409,18 @@ int BakedReflectionsData::numProbes() const
     return static_cast<int>(mNeedsUpdate.size());
 }
 
+uint64_t BakedReflectionsData::cacheSize() const
+{
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    return mCache.size();
+}
+
 void BakedReflectionsData::setHasConvolution(bool hasConvolution)
 {
     if (!mHasConvolution && hasConvolution)
     {
         mEnergyFields.resize(mNeedsUpdate.size());
+        mCompressedEnergyFields.resize(mNeedsUpdate.size());
 
         for (auto i = 0u; i < mNeedsUpdate.size(); ++i)
         {
@@ -288,6 +429,7 @@ void BakedReflectionsData::setHasConvolution(bool hasConvolution)
     }
 
     mHasConvolution = hasConvolution;
+    updateVersion();
 }
 
 void BakedReflectionsData::setHasParametric(bool hasParametric)
@@ -303,6 +445,17 @@ void BakedReflectionsData::setHasParametric(bool hasParametric)
     }
 
     mHasParametric = hasParametric;
+    updateVersion();
+}
+
+void BakedReflectionsData::setCompression(const EnergyFieldCompressionSettings& compression)
+{
+    mCompression = compression;
+}
+
+void BakedReflectionsData::setShard(const BakeShard& shard)
+{
+    mShard = shard;
 }
 
 bool BakedReflectionsData::needsUpdate(int index) const
@@ -310,11 +463,52 @@ bool BakedReflectionsData::needsUpdate(int index) const
     return (mNeedsUpdate[index] != 0);
 }
 
+void BakedReflectionsData::invalidate(int index)
+{
+    mNeedsUpdate[index] = true;
+}
+
+void BakedReflectionsData::takeProbe(int index,
+                                     BakedReflectionsData& other)
+{
+    assert(!other.isStreaming());
+
+    if (mHasConvolution && other.mHasConvolution)
+    {
+        mEnergyFields[index] = std::move(other.mEnergyFields[index]);
+        mCompressedEnergyFields[index] = std::move(other.mCompressedEnergyFields[index]);
+        mSerializedIndices[index] = -1;
+    }
+
+    if (mHasParametric && other.mHasParametric)
+    {
+        mReverbs[index] = other.mReverbs[index];
+    }
+
+    mNeedsUpdate[index] = other.mNeedsUpdate[index];
+
+    updateVersion();
+}
+
 void BakedReflectionsData::set(int index,
                                unique_ptr<EnergyField> value)
 {
-    mEnergyFields[index] = std::move(value);
+    if (mCompression.enabled && value)
+    {
+        mCompressedEnergyFields[index] = ipl::make_unique<CompressedEnergyField>(*value, mCompression);
+        mEnergyFields[index] = nullptr;
+    }
+    else
+    {
+        mEnergyFields[index] = std::move(value);
+        mCompressedEnergyFields[index] = nullptr;
+    }
+
+    mSerializedIndices[index] = -1;
+
     mNeedsUpdate[index] = false;
+
+    updateVersion();
 }
 
 void BakedReflectionsData::set(int index,
@@ -322,16 +516,119 @@ void BakedReflectionsData::set(int index,
 {
     mReverbs[index] = value;
     mNeedsUpdate[index] = false;
+
+    updateVersion();
 }
 
 EnergyField* BakedReflectionsData::lookupEnergyField(int index)
 {
+    // Streamed energy fields live in the cache, and may be evicted by another thread as soon as the cache mutex is
+    // released, so only energy fields owned by this object are returned.
     return (mHasConvolution) ? mEnergyFields[index].get() : nullptr;
 }
 
+bool BakedReflectionsData::getEnergyField(int index,
+                                          EnergyField& energyField) const
+{
+    if (!mHasConvolution)
+        return false;
+
+    std::unique_lock<std::mutex> lock(mCacheMutex, std::defer_lock);
+    if (isStreaming())
+    {
+        lock.lock();
+    }
+
+    const EnergyField* sourceEnergyField = nullptr;
+    const CompressedEnergyField* sourceCompressedEnergyField = nullptr;
+    findEnergyField(index, &sourceEnergyField, &sourceCompressedEnergyField);
+
+    if (sourceEnergyField)
+    {
+        energyField.reset();
+        energyField.copyFrom(*sourceEnergyField);
+        return true;
+    }
+    else if (sourceCompressedEnergyField)
+    {
+        sourceCompressedEnergyField->decode(energyField);
+        return true;
+    }
+
+    return false;
+}
+
 Reverb* BakedReflectionsData::lookupReverb(int index)
 {
     return (mHasParametric) ? &mReverbs[index] : nullptr;
 }
 
+void BakedReflectionsData::updateVersion()
+{
+    mVersion = ++sNextVersion;
+}
+
+void BakedReflectionsData::findEnergyField(int index,
+                                           const EnergyField** energyField,
+                                           const CompressedEnergyField** compressedEnergyField) const
+{
+    *energyField = mEnergyFields[index].get();
+    *compressedEnergyField = mCompressedEnergyFields[index].get();
+
+    if (*energyField || *compressedEnergyField || mSerializedIndices[index] < 0)
+        return;
+
+    auto serializedIndex = mSerializedIndices[index];
+
+    const auto* entry = mCache.find(serializedIndex);
+    if (!entry)
+    {
+        EnergyFieldCache::Entry newEntry;
+        newEntry.energyField = loadEnergyField(mSerializedObject, serializedIndex);
+        if (!newEntry.energyField)
+        {
+            newEntry.compressedEnergyField = loadCompressedEnergyField(mSerializedObject, serializedIndex);
+        }
+
+        entry = mCache.insert(serializedIndex, std::move(newEntry));
+    }
+
+    *energyField = entry->energyField.get();
+    *compressedEnergyField = entry->compressedEnergyField.get();
+}
+
+unique_ptr<EnergyField> BakedReflectionsData::loadEnergyField(const Serialized::BakedReflectionsData* serializedObject,
+                                                              int index)
+{
+    auto energyFields = serializedObject->energy_fields();
+    if (!energyFields || energyFields->Length() <= static_cast<uint32_t>(index) || !energyFields->Get(index))
+        return nullptr;
+
+    return ipl::make_unique<EnergyField>(energyFields->Get(index));
+}
+
+unique_ptr<CompressedEnergyField> BakedReflectionsData::loadCompressedEnergyField(const Serialized::BakedReflectionsData* serializedObject,
+                                                                                  int index)
+{
+    auto compressedEnergyFields = serializedObject->compressed_energy_fields();
+    if (!compressedEnergyFields || compressedEnergyFields->Length() <= static_cast<uint32_t>(index) || !compressedEnergyFields->Get(index))
+        return nullptr;
+
+    return ipl::make_unique<CompressedEnergyField>(compressedEnergyFields->Get(index));
+}
+
+uint64_t BakedReflectionsData::loadedEnergyFieldSize(const Serialized::BakedReflectionsData* serializedObject,
+                                                     int index)
+{
+    auto energyFields = serializedObject->energy_fields();
+    if (energyFields && energyFields->Length() > static_cast<uint32_t>(index) && energyFields->Get(index))
+        return EnergyField::serializedSize(energyFields->Get(index));
+
+    auto compressedEnergyFields = serializedObject->compressed_energy_fields();
+    if (compressedEnergyFields && compressedEnergyFields->Length() > static_cast<uint32_t>(index) && compressedEnergyFields->Get(index))
+        return CompressedEnergyField::serializedSize(compressedEnergyFields->Get(index));
+
+    return 0;
+}
+
 }
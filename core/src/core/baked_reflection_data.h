@@ -16,7 +16,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
+#include "compressed_energy_field.h"
 #include "energy_field.h"
+#include "energy_field_cache.h"
 #include "probe_batch.h"
 #include "probe_data.h"
 #include "reflection_simulator.h"
@@ -55,6 +60,13 @@ public:
                          int numProbes,
                          const Serialized::BakedReflectionsData* serializedObject);
 
+    // Streams energy fields from the serialized object on demand, instead of loading them all up front. At most
+    // cacheSize bytes of energy fields are kept in memory. The serialized object must outlive this object.
+    BakedReflectionsData(const BakedDataIdentifier& identifier,
+                         int numProbes,
+                         const Serialized::BakedReflectionsData* serializedObject,
+                         uint64_t cacheSize);
+
     virtual void updateProbePosition(int index,
                                      const Vector3f& position) override;
 
@@ -72,24 +84,79 @@ public:
 
     virtual void evaluateReverb(const ProbeNeighborhood& neighborhood, Reverb& reverb) override;
 
+    // When streaming, loads the energy fields for the given probes into the cache, so subsequent lookups for the same
+    // probes don't need to decode anything. Does nothing otherwise.
+    void prefetch(const ProbeNeighborhood& neighborhood) const;
+
     flatbuffers::Offset<Serialized::BakedReflectionsData> serialize(SerializedObject& serializedObject) const;
 
     int numProbes() const;
 
+    // Changes whenever baked data is modified. Versions are unique across all instances.
+    uint64_t version() const
+    {
+        return mVersion.load();
+    }
+
+    bool isStreaming() const
+    {
+        return (mSerializedObject != nullptr);
+    }
+
+    // Total size (in bytes) of energy fields currently held in the streaming cache.
+    uint64_t cacheSize() const;
+
+    bool hasConvolution() const
+    {
+        return mHasConvolution;
+    }
+
+    bool hasParametric() const
+    {
+        return mHasParametric;
+    }
+
+    // The shard of the probe batch for which this data was most recently baked. Only probes in this shard are taken
+    // from this data when merging the shards of a sharded bake.
+    const BakeShard& shard() const
+    {
+        return mShard;
+    }
+
     void setHasConvolution(bool hasConvolution);
 
     void setHasParametric(bool hasParametric);
 
+    void setShard(const BakeShard& shard);
+
+    // Energy fields passed to set() after this call will be compressed using the given settings. Previously-set
+    // energy fields are unaffected.
+    void setCompression(const EnergyFieldCompressionSettings& compression);
+
     bool needsUpdate(int index) const;
 
+    // Marks the given probe as needing to be baked again. Its existing data remains usable until then.
+    void invalidate(int index);
+
+    // Moves the baked data for the given probe out of another data layer for the same probes, along with its
+    // needs-update flag. The other data layer must not be streaming.
+    void takeProbe(int index,
+                   BakedReflectionsData& other);
+
     void set(int index,
              unique_ptr<EnergyField> value);
 
     void set(int index,
              const Reverb& value);
 
+    // Returns nullptr if the energy field for the given probe is compressed, or has not been loaded from streamed
+    // data. Use getEnergyField instead to handle all cases.
     EnergyField* lookupEnergyField(int index);
 
+    // Copies (decoding if necessary) the energy field for the given probe. Returns false if there is no energy field.
+    bool getEnergyField(int index,
+                        EnergyField& energyField) const;
+
     Reverb* lookupReverb(int index);
 
     vector<unique_ptr<EnergyField>>& getEnergyFields() { return mEnergyFields; }
@@ -99,9 +166,38 @@ private:
     BakedDataIdentifier mIdentifier;
     bool mHasConvolution;
     bool mHasParametric;
+    BakeShard mShard;
     vector<unique_ptr<EnergyField>> mEnergyFields;
+    vector<unique_ptr<CompressedEnergyField>> mCompressedEnergyFields;
+    EnergyFieldCompressionSettings mCompression;
     vector<Reverb> mReverbs;
     vector<uint8_t> mNeedsUpdate;
+    const Serialized::BakedReflectionsData* mSerializedObject;
+    vector<int> mSerializedIndices; // index into mSerializedObject for each probe, -1 if none
+    vector<uint64_t> mSerializedSizes; // serializedSize() of each energy field in mSerializedObject
+    mutable EnergyFieldCache mCache;
+    mutable std::mutex mCacheMutex;
+    std::atomic<uint64_t> mVersion;
+
+    static std::atomic<uint64_t> sNextVersion;
+
+    void updateVersion();
+
+    // Finds the energy field for the given probe, loading it into the cache if streaming. At most one of the outputs
+    // is non-null. If streaming, mCacheMutex must be held.
+    void findEnergyField(int index,
+                         const EnergyField** energyField,
+                         const CompressedEnergyField** compressedEnergyField) const;
+
+    static unique_ptr<EnergyField> loadEnergyField(const Serialized::BakedReflectionsData* serializedObject,
+                                                   int index);
+
+    static unique_ptr<CompressedEnergyField> loadCompressedEnergyField(const Serialized::BakedReflectionsData* serializedObject,
+                                                                       int index);
+
+    // Returns the serialized size of the given energy field once loaded, without decoding it.
+    static uint64_t loadedEnergyFieldSize(const Serialized::BakedReflectionsData* serializedObject,
+                                          int index);
 };
 
 }
@@ -87,4 +87,24 @@ void BakedReflectionSimulator::lookupReverb(const BakedDataIdentifier& identifie
     }
 }
 
+void BakedReflectionSimulator::prefetchEnergyFields(const ProbeNeighborhood& probeNeighborhood,
+                                                    const unordered_set<const ProbeBatch*>& uniqueBatches)
+{
+    PROFILE_FUNCTION();
+
+    if (!probeNeighborhood.hasValidProbes())
+        return;
+
+    for (const auto* batch : uniqueBatches)
+    {
+        for (const auto& data : batch->getData())
+        {
+            if (data.first.type != BakedDataType::Reflections)
+                continue;
+
+            static_cast<const BakedReflectionsData&>(*data.second).prefetch(probeNeighborhood);
+        }
+    }
+}
+
 }
@@ -38,6 +38,11 @@ namespace BakedReflectionSimulator
                       const ProbeNeighborhood& probeNeighborhood,
                       const unordered_set<const ProbeBatch*>& uniqueBatches,
                       Reverb& reverb);
+
+    // Loads the energy fields for the given probes into the caches of any streaming probe batches, for every
+    // reflections data layer.
+    void prefetchEnergyFields(const ProbeNeighborhood& probeNeighborhood,
+                              const unordered_set<const ProbeBatch*>& uniqueBatches);
 };
 
 }
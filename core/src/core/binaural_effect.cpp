@@ -62,11 +62,9 @@ AudioEffectState BinauralEffect::apply(const BinauralEffectParams& params,
     int peakDelayInSamples[] = { 0, 0 };
     auto enableSpatialBlend = (in.numChannels() == 2 && params.spatialBlend < 1.0f);
 
-    auto& _hrtf = const_cast<HRTFDatabase&>(*params.hrtf);
-
     if (params.interpolation == HRTFInterpolation::NearestNeighbor)
     {
-        _hrtf.nearestHRTF(*params.direction, hrtfData, params.spatialBlend, params.phaseType, mInterpolatedHRTF.data(), peakDelayInSamples);
+        params.hrtf->nearestHRTF(*params.direction, hrtfData, params.spatialBlend, params.phaseType, *mHRTFQueryState, mInterpolatedHRTF.data(), peakDelayInSamples);
 
         if (enableSpatialBlend)
         {
@@ -74,9 +72,13 @@ AudioEffectState BinauralEffect::apply(const BinauralEffectParams& params,
             hrtfData[1] = mInterpolatedHRTF[1];
         }
     }
+    else if (params.interpolation == HRTFInterpolation::Bilinear && params.spatialBlend >= 1.0f && params.hrtf->hasInterpolationGrid())
+    {
+        params.hrtf->gridInterpolatedHRTF(*params.direction, hrtfData, peakDelayInSamples);
+    }
     else if (params.interpolation == HRTFInterpolation::Bilinear)
     {
-        _hrtf.interpolatedHRTF(*params.direction, mInterpolatedHRTF.data(), params.spatialBlend, params.phaseType, peakDelayInSamples);
+        params.hrtf->interpolatedHRTF(*params.direction, mInterpolatedHRTF.data(), params.spatialBlend, params.phaseType, *mHRTFQueryState, peakDelayInSamples);
 
         hrtfData[0] = mInterpolatedHRTF[0];
         hrtfData[1] = mInterpolatedHRTF[1];
@@ -139,6 +141,7 @@ void BinauralEffect::init(const HRTFDatabase& hrtf)
     mOverlapAddEffect = make_unique<OverlapAddConvolutionEffect>(audioSettings, overlapAddSettings);
 
     mInterpolatedHRTF.resize(2, hrtf.numSpectrumSamples());
+    mHRTFQueryState = make_unique<HRTFQueryState>(hrtf);
 }
 
 }
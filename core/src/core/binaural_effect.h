@@ -62,6 +62,7 @@ private:
     int mHRIRSize;
     unique_ptr<OverlapAddConvolutionEffect> mOverlapAddEffect;
     Array<complex_t, 2> mInterpolatedHRTF;
+    unique_ptr<HRTFQueryState> mHRTFQueryState;
     AudioBuffer mPartialDownmixed;
     AudioBuffer mPartialOutput;
 
@@ -74,6 +74,15 @@ public:
         return (maxCoordinates - minCoordinates);
     }
 
+    // Returns the distance from a point to the nearest point in the box, or 0 if the point is inside the box.
+    float distanceTo(const Vector3f& point) const
+    {
+        auto dx = std::max(std::max(minCoordinates.x() - point.x(), point.x() - maxCoordinates.x()), 0.0f);
+        auto dy = std::max(std::max(minCoordinates.y() - point.y(), point.y() - maxCoordinates.y()), 0.0f);
+        auto dz = std::max(std::max(minCoordinates.z() - point.z(), point.z() - maxCoordinates.z()), 0.0f);
+        return sqrtf(dx * dx + dy * dy + dz * dz);
+    }
+
     // Returns the surface area of the box.
     float surfaceArea() const
     {
@@ -0,0 +1,318 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "compressed_energy_field.h"
+
+#include "bands.h"
+#include "log.h"
+#include "sh.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// CompressedEnergyField
+// --------------------------------------------------------------------------------------------------------------------
+
+// Codes are stored as a sign bit followed by a magnitude index. Magnitude index 0 means zero, and the remaining
+// indices are evenly spaced in log2 over the dynamic range, with the largest index corresponding to the scale factor.
+const int CompressedEnergyField::kDynamicRange8Bit = 20;
+const int CompressedEnergyField::kDynamicRange16Bit = 40;
+
+// Ambisonics channels whose energy is 40 dB below the omnidirectional channel have no audible effect.
+const float CompressedEnergyField::kDefaultOrderReductionThreshold = 1e-4f;
+
+CompressedEnergyField::CompressedEnergyField(const EnergyField& energyField,
+                                             const EnergyFieldCompressionSettings& settings)
+    : mNumChannels(reducedNumChannels(energyField, settings.orderReductionThreshold))
+    , mNumBins(0)
+    , mNumBits(settings.numBits)
+    , mScales(mNumChannels, Bands::kNumBands)
+{
+    assert(mNumBits == 8 || mNumBits == 16);
+
+    auto signBit = 1u << (mNumBits - 1);
+    auto maxIndex = signBit - 1;
+    auto dynamicRange = static_cast<float>((mNumBits == 8) ? kDynamicRange8Bit : kDynamicRange16Bit);
+    auto step = dynamicRange / (maxIndex - 1);
+
+    auto numBins = energyField.numBins();
+    Array<uint16_t, 3> codes(mNumChannels, Bands::kNumBands, numBins);
+    codes.zero();
+
+    for (auto i = 0; i < mNumChannels; ++i)
+    {
+        for (auto j = 0; j < Bands::kNumBands; ++j)
+        {
+            const auto* values = energyField[i][j];
+
+            auto scale = 0.0f;
+            for (auto k = 0; k < numBins; ++k)
+            {
+                scale = std::max(scale, fabsf(values[k]));
+            }
+
+            mScales[i][j] = scale;
+            if (scale <= 0.0f)
+                continue;
+
+            for (auto k = 0; k < numBins; ++k)
+            {
+                auto magnitude = fabsf(values[k]) / scale;
+                if (magnitude <= 0.0f)
+                    continue;
+
+                auto index = static_cast<int>(roundf((log2f(magnitude) + dynamicRange) / step)) + 1;
+                if (index <= 0)
+                    continue;
+
+                auto code = std::min(static_cast<unsigned int>(index), maxIndex);
+                if (values[k] < 0.0f)
+                {
+                    code |= signBit;
+                }
+
+                codes[i][j][k] = static_cast<uint16_t>(code);
+                mNumBins = std::max(mNumBins, k + 1);
+            }
+        }
+    }
+
+    auto numValues = static_cast<size_t>(mNumChannels) * Bands::kNumBands * mNumBins;
+    if (mNumBits == 8)
+    {
+        mData8.resize(numValues);
+    }
+    else
+    {
+        mData16.resize(numValues);
+    }
+
+    for (auto i = 0, index = 0; i < mNumChannels; ++i)
+    {
+        for (auto j = 0; j < Bands::kNumBands; ++j)
+        {
+            for (auto k = 0; k < mNumBins; ++k, ++index)
+            {
+                if (mNumBits == 8)
+                {
+                    mData8[index] = static_cast<uint8_t>(codes[i][j][k]);
+                }
+                else
+                {
+                    mData16[index] = codes[i][j][k];
+                }
+            }
+        }
+    }
+}
+
+CompressedEnergyField::CompressedEnergyField(const Serialized::CompressedEnergyField* serializedObject)
+    : mNumChannels(1)
+    , mNumBins(0)
+    , mNumBits(16)
+    , mScales(1, Bands::kNumBands)
+{
+    assert(serializedObject);
+
+    // Data that is inconsistent with its own header would cause reads past the end of the serialized arrays, so
+    // reject it and leave this energy field silent instead.
+    if (!isValid(serializedObject))
+    {
+        gLog().message(MessageSeverity::Warning, "Malformed compressed energy field, ignoring.");
+        mScales.zero();
+        return;
+    }
+
+    mNumChannels = serializedObject->num_channels();
+    mNumBins = serializedObject->num_bins();
+    mNumBits = serializedObject->num_bits();
+
+    mScales.resize(mNumChannels, Bands::kNumBands);
+    memcpy(mScales.flatData(), serializedObject->scales()->data(), mScales.totalSize() * sizeof(float));
+
+    auto numValues = static_cast<size_t>(mNumChannels) * Bands::kNumBands * mNumBins;
+    if (mNumBits == 8)
+    {
+        mData8.resize(numValues);
+        memcpy(mData8.data(), serializedObject->data8()->data(), numValues * sizeof(uint8_t));
+    }
+    else
+    {
+        mData16.resize(numValues);
+        memcpy(mData16.data(), serializedObject->data16()->data(), numValues * sizeof(uint16_t));
+    }
+}
+
+uint64_t CompressedEnergyField::serializedSize() const
+{
+    return (3 * sizeof(int32_t) +
+            mScales.totalSize() * sizeof(float) +
+            mData8.size() * sizeof(uint8_t) +
+            mData16.size() * sizeof(uint16_t));
+}
+
+uint64_t CompressedEnergyField::serializedSize(const Serialized::CompressedEnergyField* serializedObject)
+{
+    // Malformed data is loaded as a silent energy field with a single channel.
+    if (!isValid(serializedObject))
+        return (3 * sizeof(int32_t) + Bands::kNumBands * sizeof(float));
+
+    auto numValues = static_cast<uint64_t>(serializedObject->num_channels()) * Bands::kNumBands * serializedObject->num_bins();
+    auto bytesPerValue = (serializedObject->num_bits() == 8) ? sizeof(uint8_t) : sizeof(uint16_t);
+
+    return (3 * sizeof(int32_t) +
+            serializedObject->scales()->size() * sizeof(float) +
+            numValues * bytesPerValue);
+}
+
+flatbuffers::Offset<Serialized::CompressedEnergyField> CompressedEnergyField::serialize(SerializedObject& serializedObject) const
+{
+    auto& fbb = serializedObject.fbb();
+
+    auto scalesOffset = fbb.CreateVector(mScales.flatData(), mScales.totalSize());
+
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data8Offset = 0;
+    flatbuffers::Offset<flatbuffers::Vector<uint16_t>> data16Offset = 0;
+    if (mNumBits == 8)
+    {
+        data8Offset = fbb.CreateVector(mData8.data(), mData8.size());
+    }
+    else
+    {
+        data16Offset = fbb.CreateVector(mData16.data(), mData16.size());
+    }
+
+    return Serialized::CreateCompressedEnergyField(fbb, mNumChannels, mNumBins, mNumBits, scalesOffset, data8Offset,
+                                                   data16Offset);
+}
+
+void CompressedEnergyField::decode(EnergyField& energyField) const
+{
+    energyField.reset();
+    decodeScaleAccumulate(1.0f, energyField);
+}
+
+void CompressedEnergyField::decodeScaleAccumulate(float scalar,
+                                                  EnergyField& energyField) const
+{
+    auto numChannels = std::min(mNumChannels, energyField.numChannels());
+    auto numBins = std::min(mNumBins, energyField.numBins());
+
+    auto signBit = 1u << (mNumBits - 1);
+    const auto* magnitudes = magnitudeTable(mNumBits);
+
+    for (auto i = 0; i < numChannels; ++i)
+    {
+        for (auto j = 0; j < Bands::kNumBands; ++j)
+        {
+            auto scale = scalar * mScales[i][j];
+            if (scale == 0.0f)
+                continue;
+
+            auto* out = energyField[i][j];
+            auto offset = (static_cast<size_t>(i) * Bands::kNumBands + j) * mNumBins;
+
+            for (auto k = 0; k < numBins; ++k)
+            {
+                auto code = (mNumBits == 8) ? static_cast<unsigned int>(mData8[offset + k]) : static_cast<unsigned int>(mData16[offset + k]);
+                auto value = scale * magnitudes[code & ~signBit];
+                out[k] += (code & signBit) ? -value : value;
+            }
+        }
+    }
+}
+
+bool CompressedEnergyField::isValid(const Serialized::CompressedEnergyField* serializedObject)
+{
+    auto numChannels = serializedObject->num_channels();
+    auto numBins = serializedObject->num_bins();
+    auto numBits = serializedObject->num_bits();
+
+    if (numChannels <= 0 || numBins < 0 || (numBits != 8 && numBits != 16))
+        return false;
+
+    auto numScales = static_cast<uint64_t>(numChannels) * Bands::kNumBands;
+    if (!serializedObject->scales() || serializedObject->scales()->size() != numScales)
+        return false;
+
+    auto numValues = numScales * static_cast<uint64_t>(numBins);
+    if (numBits == 8)
+        return (serializedObject->data8() && serializedObject->data8()->size() == numValues);
+    else
+        return (serializedObject->data16() && serializedObject->data16()->size() == numValues);
+}
+
+int CompressedEnergyField::reducedNumChannels(const EnergyField& energyField,
+                                              float threshold)
+{
+    auto numChannels = energyField.numChannels();
+    if (threshold <= 0.0f)
+        return numChannels;
+
+    auto peakEnergy = [&](int startChannel, int endChannel)
+    {
+        auto peak = 0.0f;
+        for (auto i = startChannel; i < endChannel; ++i)
+        {
+            for (auto j = 0; j < Bands::kNumBands; ++j)
+            {
+                for (auto k = 0; k < energyField.numBins(); ++k)
+                {
+                    peak = std::max(peak, fabsf(energyField[i][j][k]));
+                }
+            }
+        }
+        return peak;
+    };
+
+    auto maxEnergy = threshold * peakEnergy(0, 1);
+
+    auto order = static_cast<int>(sqrtf(static_cast<float>(numChannels))) - 1;
+    for (; order > 0; --order)
+    {
+        auto startChannel = SphericalHarmonics::numCoeffsForOrder(order - 1);
+        if (peakEnergy(startChannel, SphericalHarmonics::numCoeffsForOrder(order)) > maxEnergy)
+            break;
+    }
+
+    return SphericalHarmonics::numCoeffsForOrder(order);
+}
+
+// Returns a table mapping magnitude indices to magnitudes relative to the scale factor.
+const float* CompressedEnergyField::magnitudeTable(int numBits)
+{
+    auto buildTable = [](int numBits, int dynamicRange)
+    {
+        auto maxIndex = (1 << (numBits - 1)) - 1;
+        auto step = static_cast<float>(dynamicRange) / (maxIndex - 1);
+
+        vector<float> table(maxIndex + 1);
+        table[0] = 0.0f;
+        for (auto i = 1; i <= maxIndex; ++i)
+        {
+            table[i] = exp2f((i - 1) * step - dynamicRange);
+        }
+
+        return table;
+    };
+
+    static const auto kTable8Bit = buildTable(8, kDynamicRange8Bit);
+    static const auto kTable16Bit = buildTable(16, kDynamicRange16Bit);
+
+    return (numBits == 8) ? kTable8Bit.data() : kTable16Bit.data();
+}
+
+}
@@ -0,0 +1,110 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "containers.h"
+#include "energy_field.h"
+
+#include "compressed_energy_field.fbs.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// EnergyFieldCompressionSettings
+// --------------------------------------------------------------------------------------------------------------------
+
+struct EnergyFieldCompressionSettings
+{
+    // If false, energy fields are stored uncompressed.
+    bool enabled = false;
+
+    // Number of bits used to store each value. Must be 8 or 16.
+    int numBits = 16;
+
+    // Higher-order Ambisonics channels are dropped, one order at a time, as long as their peak energy is at most this
+    // fraction of the peak energy in channel 0. If 0, the order is never reduced.
+    float orderReductionThreshold = 0.0f;
+};
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// CompressedEnergyField
+// --------------------------------------------------------------------------------------------------------------------
+
+// An energy field stored in a compact, lossy form, for use in baked data. Each value is quantized in the log domain,
+// relative to a scale factor stored for each channel and band. Values more than a fixed dynamic range below the
+// scale factor are stored as zero, and trailing bins that contain only zeros are not stored at all.
+class CompressedEnergyField
+{
+public:
+    static const int kDynamicRange8Bit; // in powers of 2
+    static const int kDynamicRange16Bit; // in powers of 2
+    static const float kDefaultOrderReductionThreshold;
+
+    CompressedEnergyField(const EnergyField& energyField,
+                          const EnergyFieldCompressionSettings& settings);
+
+    // If the serialized data is malformed, a warning is logged and the energy field is silent.
+    CompressedEnergyField(const Serialized::CompressedEnergyField* serializedObject);
+
+    int numChannels() const
+    {
+        return mNumChannels;
+    }
+
+    int numBins() const
+    {
+        return mNumBins;
+    }
+
+    int numBits() const
+    {
+        return mNumBits;
+    }
+
+    uint64_t serializedSize() const;
+
+    // Returns the value serializedSize() would return for an energy field loaded from the given serialized object.
+    static uint64_t serializedSize(const Serialized::CompressedEnergyField* serializedObject);
+
+    flatbuffers::Offset<Serialized::CompressedEnergyField> serialize(SerializedObject& serializedObject) const;
+
+    // Decodes into the given energy field. Channels and bins that were not stored are set to zero.
+    void decode(EnergyField& energyField) const;
+
+    // Decodes, multiplies by the given scalar, and adds to the given energy field.
+    void decodeScaleAccumulate(float scalar,
+                               EnergyField& energyField) const;
+
+private:
+    int mNumChannels;
+    int mNumBins;
+    int mNumBits;
+    Array<float, 2> mScales;
+    vector<uint8_t> mData8;
+    vector<uint16_t> mData16;
+
+    // Returns true if the sizes of the serialized arrays match the header.
+    static bool isValid(const Serialized::CompressedEnergyField* serializedObject);
+
+    static int reducedNumChannels(const EnergyField& energyField,
+                                  float threshold);
+
+    static const float* magnitudeTable(int numBits);
+};
+
+}
@@ -18,8 +18,10 @@
 
 #include <algorithm>
 
+#include "context.h"
 #include "error.h"
 #include "log.h"
+#include "profiler.h"
 
 namespace ipl {
 
@@ -53,8 +55,7 @@ AudioEffectState DirectEffect::apply(const DirectEffectParams& params,
     float eqCoeffs[Bands::kNumBands];
     calculateGainAndEQ(params.directPath, params.flags, params.transmissionType, gain, eqCoeffs);
 
-    auto applyEQ = ((params.flags & ApplyAirAbsorption) ||
-        ((params.flags & ApplyTransmission) && params.transmissionType == TransmissionType::FreqDependent));
+    auto applyEQ = requiresEQ(params);
 
     for (auto i = 0; i < mNumChannels; ++i)
     {
@@ -150,4 +151,365 @@ void DirectEffect::calculateGainAndEQ(const DirectSoundPath& directPath,
     }
 }
 
+bool DirectEffect::requiresEQ(const DirectEffectParams& params)
+{
+    return ((params.flags & ApplyAirAbsorption) ||
+            ((params.flags & ApplyTransmission) && params.transmissionType == TransmissionType::FreqDependent));
+}
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// DirectEffectBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+DirectEffectBatch::DirectEffectBatch(const AudioSettings& audioSettings,
+                                     int maxVoices)
+    : mSamplingRate(audioSettings.samplingRate)
+    , mFrameSize(audioSettings.frameSize)
+    , mMaxVoices(maxVoices)
+    , mGroups((maxVoices + kMaxLanes - 1) / kMaxLanes)
+    , mVoices(maxVoices)
+    , mInterleaved(audioSettings.frameSize * kMaxLanes)
+{
+#if defined(IPL_ENABLE_FLOAT8)
+    mApplyDispatch = (gSIMDLevel() >= SIMDLevel::AVX) ? &DirectEffectBatch::applyGroup_float8 : &DirectEffectBatch::applyGroup_float4;
+#else
+    mApplyDispatch = &DirectEffectBatch::applyGroup_float4;
+#endif
+
+    for (auto i = 0u; i < mGroups.size(0); ++i)
+    {
+        memset(&mGroups[i], 0, sizeof(VoiceGroup));
+    }
+
+    reset();
+}
+
+void DirectEffectBatch::reset()
+{
+    for (auto i = 0; i < mMaxVoices; ++i)
+    {
+        reset(i);
+    }
+}
+
+void DirectEffectBatch::reset(int voice)
+{
+    assert(0 <= voice && voice < mMaxVoices);
+
+    auto& voiceState = mVoices[voice];
+    for (auto i = 0; i < Bands::kNumBands; ++i)
+    {
+        voiceState.prevEQGains[i] = 1.0f;
+    }
+    voiceState.prevGain = 0.0f;
+    voiceState.eqFirstFrame = true;
+    voiceState.gainFirstFrame = true;
+
+    IIR2 filters[Bands::kNumBands];
+    calcFilters(voiceState.prevEQGains, filters);
+
+    auto& group = mGroups[voice / kMaxLanes];
+    auto lane = voice % kMaxLanes;
+
+    for (auto bank = 0; bank < 2; ++bank)
+    {
+        setFilters(group, bank, lane, filters);
+
+        for (auto i = 0; i < Bands::kNumBands; ++i)
+        {
+            for (auto j = 0; j < 4; ++j)
+            {
+                group.state[bank][i][j][lane] = 0.0f;
+            }
+        }
+    }
+}
+
+void DirectEffectBatch::apply(int numVoices,
+                              const DirectEffectParams* params,
+                              const float* const* in,
+                              float* const* out)
+{
+    assert(0 <= numVoices && numVoices <= mMaxVoices);
+
+    PROFILE_FUNCTION();
+
+    float* data = mInterleaved.data();
+
+    for (auto firstVoice = 0; firstVoice < numVoices; firstVoice += kMaxLanes)
+    {
+        auto& group = mGroups[firstVoice / kMaxLanes];
+        auto numLanes = std::min(numVoices - firstVoice, static_cast<int>(kMaxLanes));
+
+        GroupFrame frame{};
+        for (auto i = 0; i < numLanes; ++i)
+        {
+            prepareVoice(firstVoice + i, params[firstVoice + i], frame);
+        }
+
+        for (auto i = 0; i < numLanes; ++i)
+        {
+            const auto* voiceIn = in[firstVoice + i];
+            for (auto j = 0; j < mFrameSize; ++j)
+            {
+                data[j * kMaxLanes + i] = voiceIn[j];
+            }
+        }
+
+        for (auto i = numLanes; i < kMaxLanes; ++i)
+        {
+            for (auto j = 0; j < mFrameSize; ++j)
+            {
+                data[j * kMaxLanes + i] = 0.0f;
+            }
+        }
+
+        // Lanes whose EQ is bypassed must keep their filter state, as they would if they were processed by a
+        // DirectEffect, so save it before filtering and restore it afterwards.
+        alignas(32) float savedState[Bands::kNumBands][4][kMaxLanes];
+        if (frame.anyEQ)
+        {
+            memcpy(savedState, group.state[0], sizeof(savedState));
+        }
+
+        (this->*mApplyDispatch)(group, frame, data);
+
+        if (frame.anyEQ)
+        {
+            for (auto lane = 0; lane < kMaxLanes; ++lane)
+            {
+                if (frame.eqWeight[lane] != 0.0f)
+                    continue;
+
+                for (auto i = 0; i < Bands::kNumBands; ++i)
+                {
+                    for (auto j = 0; j < 4; ++j)
+                    {
+                        group.state[0][i][j][lane] = savedState[i][j][lane];
+                    }
+                }
+            }
+        }
+
+        for (auto i = 0; i < numLanes; ++i)
+        {
+            auto* voiceOut = out[firstVoice + i];
+            for (auto j = 0; j < mFrameSize; ++j)
+            {
+                voiceOut[j] = data[j * kMaxLanes + i];
+            }
+        }
+    }
+}
+
+void DirectEffectBatch::prepareVoice(int voice,
+                                     const DirectEffectParams& params,
+                                     GroupFrame& frame)
+{
+    auto& voiceState = mVoices[voice];
+    auto& group = mGroups[voice / kMaxLanes];
+    auto lane = voice % kMaxLanes;
+
+    float gain;
+    float eqGains[Bands::kNumBands];
+    DirectEffect::calculateGainAndEQ(params.directPath, params.flags, params.transmissionType, gain, eqGains);
+
+    // This follows EQEffect::apply, except that the previous filter is copied into bank 1 instead of swapping banks,
+    // so bank 0 always contains the current filter.
+    if (DirectEffect::requiresEQ(params))
+    {
+        frame.eqWeight[lane] = 1.0f;
+        frame.anyEQ = true;
+
+        auto gainsChanged = false;
+        for (auto i = 0; i < Bands::kNumBands; ++i)
+        {
+            if (voiceState.eqFirstFrame || voiceState.prevEQGains[i] != eqGains[i])
+            {
+                gainsChanged = true;
+                break;
+            }
+        }
+
+        if (gainsChanged)
+        {
+            if (voiceState.eqFirstFrame)
+            {
+                voiceState.eqFirstFrame = false;
+            }
+            else
+            {
+                for (auto i = 0; i < Bands::kNumBands; ++i)
+                {
+                    for (auto j = 0; j < 5; ++j)
+                    {
+                        group.coeffs[1][i][j][lane] = group.coeffs[0][i][j][lane];
+                    }
+
+                    for (auto j = 0; j < 4; ++j)
+                    {
+                        group.state[1][i][j][lane] = group.state[0][i][j][lane];
+                    }
+                }
+
+                frame.crossfade[lane] = 1.0f;
+                frame.anyCrossfade = true;
+            }
+
+            IIR2 filters[Bands::kNumBands];
+            calcFilters(eqGains, filters);
+            setFilters(group, 0, lane, filters);
+
+            for (auto i = 0; i < Bands::kNumBands; ++i)
+            {
+                voiceState.prevEQGains[i] = eqGains[i];
+            }
+        }
+    }
+
+    // This follows GainEffect::apply.
+    if (voiceState.gainFirstFrame)
+    {
+        frame.gain[lane] = gain;
+        frame.dGain[lane] = 0.0f;
+        voiceState.prevGain = gain;
+        voiceState.gainFirstFrame = false;
+    }
+    else
+    {
+        auto targetGain = voiceState.prevGain + (1.0f / GainEffect::kNumInterpolationFrames) * (gain - voiceState.prevGain);
+
+        frame.gain[lane] = voiceState.prevGain;
+        frame.dGain[lane] = (targetGain - voiceState.prevGain) / mFrameSize;
+        voiceState.prevGain = targetGain;
+    }
+}
+
+void DirectEffectBatch::calcFilters(const float* gains,
+                                    IIR2* filters) const
+{
+    filters[0] = IIR2::lowShelf(Bands::kHighCutoffFrequencies[0], gains[0], mSamplingRate);
+
+    for (auto i = 1; i < Bands::kNumBands - 1; ++i)
+    {
+        filters[i] = IIR2::peaking(Bands::kLowCutoffFrequencies[i], Bands::kHighCutoffFrequencies[i], gains[i], mSamplingRate);
+    }
+
+    filters[Bands::kNumBands - 1] = IIR2::highShelf(Bands::kLowCutoffFrequencies[Bands::kNumBands - 1], gains[Bands::kNumBands - 1], mSamplingRate);
+}
+
+void DirectEffectBatch::setFilters(VoiceGroup& group,
+                                   int bank,
+                                   int lane,
+                                   const IIR2* filters)
+{
+    for (auto i = 0; i < Bands::kNumBands; ++i)
+    {
+        group.coeffs[bank][i][0][lane] = filters[i].b0;
+        group.coeffs[bank][i][1][lane] = filters[i].b1;
+        group.coeffs[bank][i][2][lane] = filters[i].b2;
+        group.coeffs[bank][i][3][lane] = filters[i].a1;
+        group.coeffs[bank][i][4][lane] = filters[i].a2;
+    }
+}
+
+void DirectEffectBatch::applyGroup_float4(VoiceGroup& group,
+                                          const GroupFrame& frame,
+                                          float* data)
+{
+    const auto one = float4::set1(1.0f);
+    const auto epsilon = float4::set1(1e-9f);
+    const auto numBanks = (frame.anyCrossfade) ? 2 : 1;
+
+    // Each filter is applied to a whole block before moving on to the next one. Within a block, the recursion for
+    // lanes 0-3 and lanes 4-7 is interleaved, so the two independent dependency chains can overlap.
+    alignas(float4_t) float filtered[2][kBlockSize * kMaxLanes];
+
+    float4_t eqWeight[2] = { float4::load(&frame.eqWeight[0]), float4::load(&frame.eqWeight[4]) };
+    float4_t crossfade[2] = { float4::load(&frame.crossfade[0]), float4::load(&frame.crossfade[4]) };
+    float4_t gain[2] = { float4::load(&frame.gain[0]), float4::load(&frame.gain[4]) };
+    float4_t dGain[2] = { float4::load(&frame.dGain[0]), float4::load(&frame.dGain[4]) };
+
+    for (auto start = 0; start < mFrameSize; start += kBlockSize)
+    {
+        auto blockSize = std::min(mFrameSize - start, static_cast<int>(kBlockSize));
+        auto* block = &data[start * kMaxLanes];
+
+        for (auto bank = 0; frame.anyEQ && bank < numBanks; ++bank)
+        {
+            for (auto band = 0; band < Bands::kNumBands; ++band)
+            {
+                const auto& coeffs = group.coeffs[bank][band];
+                auto& state = group.state[bank][band];
+
+                auto b0 = float4::load(&coeffs[0][0]), b0_ = float4::load(&coeffs[0][4]);
+                auto b1 = float4::load(&coeffs[1][0]), b1_ = float4::load(&coeffs[1][4]);
+                auto b2 = float4::load(&coeffs[2][0]), b2_ = float4::load(&coeffs[2][4]);
+                auto a1 = float4::load(&coeffs[3][0]), a1_ = float4::load(&coeffs[3][4]);
+                auto a2 = float4::load(&coeffs[4][0]), a2_ = float4::load(&coeffs[4][4]);
+                auto xm1 = float4::load(&state[0][0]), xm1_ = float4::load(&state[0][4]);
+                auto xm2 = float4::load(&state[1][0]), xm2_ = float4::load(&state[1][4]);
+                auto ym1 = float4::load(&state[2][0]), ym1_ = float4::load(&state[2][4]);
+                auto ym2 = float4::load(&state[3][0]), ym2_ = float4::load(&state[3][4]);
+
+                const auto* in = (band == 0) ? block : filtered[bank];
+                auto* out = filtered[bank];
+
+                for (auto i = 0; i < blockSize; ++i)
+                {
+                    auto x = float4::add(float4::load(&in[i * kMaxLanes]), epsilon);
+                    auto x_ = float4::add(float4::load(&in[i * kMaxLanes + 4]), epsilon);
+
+                    // Only the last two operations depend on the previous output, which shortens the recursion.
+                    auto y = float4::sub(float4::add(float4::mul(b1, xm1), float4::mul(b2, xm2)), float4::mul(a2, ym2));
+                    auto y_ = float4::sub(float4::add(float4::mul(b1_, xm1_), float4::mul(b2_, xm2_)), float4::mul(a2_, ym2_));
+                    y = float4::add(float4::mul(b0, x), float4::sub(y, float4::mul(a1, ym1)));
+                    y_ = float4::add(float4::mul(b0_, x_), float4::sub(y_, float4::mul(a1_, ym1_)));
+
+                    xm2 = xm1; xm2_ = xm1_;
+                    xm1 = x; xm1_ = x_;
+                    ym2 = ym1; ym2_ = ym1_;
+                    ym1 = y; ym1_ = y_;
+
+                    float4::store(&out[i * kMaxLanes], y);
+                    float4::store(&out[i * kMaxLanes + 4], y_);
+                }
+
+                float4::store(&state[0][0], xm1); float4::store(&state[0][4], xm1_);
+                float4::store(&state[1][0], xm2); float4::store(&state[1][4], xm2_);
+                float4::store(&state[2][0], ym1); float4::store(&state[2][4], ym1_);
+                float4::store(&state[3][0], ym2); float4::store(&state[3][4], ym2_);
+            }
+        }
+
+        for (auto i = 0; i < blockSize; ++i)
+        {
+            for (auto j = 0; j < 2; ++j)
+            {
+                auto offset = i * kMaxLanes + j * 4;
+                auto x = float4::load(&block[offset]);
+                auto y = x;
+
+                if (frame.anyEQ)
+                {
+                    y = float4::load(&filtered[0][offset]);
+
+                    if (frame.anyCrossfade)
+                    {
+                        auto t = float4::set1(static_cast<float>(start + i) / static_cast<float>(mFrameSize));
+                        auto weight = float4::add(float4::mul(crossfade[j], t), float4::sub(one, crossfade[j]));
+                        y = float4::add(float4::mul(weight, y), float4::mul(float4::sub(one, weight), float4::load(&filtered[1][offset])));
+                    }
+
+                    y = float4::add(float4::mul(eqWeight[j], y), float4::mul(float4::sub(one, eqWeight[j]), x));
+                }
+
+                float4::store(&block[offset], float4::mul(gain[j], y));
+                gain[j] = float4::add(gain[j], dGain[j]);
+            }
+        }
+    }
+}
+
 }
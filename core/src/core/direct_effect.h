@@ -72,16 +72,116 @@ public:
 
     int numTailSamplesRemaining() const { return 0; }
 
-private:
-    int mNumChannels;
-    Array<unique_ptr<EQEffect>> mEQEffects; // One filter object per channel to apply effect.
-    Array<unique_ptr<GainEffect>> mGainEffects; // Attenuation interpolation.
-
+    // Calculates the broadband gain and normalized EQ gains to apply for the given parameters.
     static void calculateGainAndEQ(const DirectSoundPath& directPath,
                                    DirectEffectFlags flags,
                                    TransmissionType transmissionType,
                                    float& overallGain,
                                    float* eqCoeffs);
+
+    // Returns true if the given parameters require the EQ filters to be applied.
+    static bool requiresEQ(const DirectEffectParams& params);
+
+private:
+    int mNumChannels;
+    Array<unique_ptr<EQEffect>> mEQEffects; // One filter object per channel to apply effect.
+    Array<unique_ptr<GainEffect>> mGainEffects; // Attenuation interpolation.
+};
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// DirectEffectBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+// Applies direct sound path parameters to several mono sources (voices) at once. Voices are processed in groups of
+// kMaxLanes, with each voice occupying one SIMD lane, so the EQ filter recursion and gain interpolation run for 4
+// (or, with AVX, 8) voices in parallel. Given the same sequence of parameters, each voice produces the same output as
+// a mono DirectEffect, up to rounding. The EQ always uses second-order filters, i.e., IIR::sUseOrder8 is ignored.
+class DirectEffectBatch
+{
+public:
+    static const int kMaxLanes = 8;
+
+    DirectEffectBatch(const AudioSettings& audioSettings,
+                      int maxVoices);
+
+    int maxVoices() const { return mMaxVoices; }
+
+    void reset();
+
+    // Resets the state of a single voice, e.g. when it starts playing a different source.
+    void reset(int voice);
+
+    // Applies the effect to voices 0 through numVoices - 1. Voice i reads one frame of mono audio from in[i] and
+    // writes its output to out[i]. Voices that are not applied in a frame keep their state until the next one.
+    void apply(int numVoices,
+               const DirectEffectParams* params,
+               const float* const* in,
+               float* const* out);
+
+private:
+    // Number of samples processed by each filter at a time, chosen so intermediate buffers stay in cache.
+    static const int kBlockSize = 64;
+
+    // Filters for kMaxLanes voices, with one voice per lane. Index 0 of the first dimension is the current filter,
+    // and index 1 is the previous filter, which is only used while crossfading after the EQ gains change.
+    struct VoiceGroup
+    {
+        alignas(32) float coeffs[2][Bands::kNumBands][5][kMaxLanes]; // b0, b1, b2, a1, a2
+        alignas(32) float state[2][Bands::kNumBands][4][kMaxLanes]; // xm1, xm2, ym1, ym2
+    };
+
+    struct VoiceState
+    {
+        float prevEQGains[Bands::kNumBands];
+        float prevGain;
+        bool eqFirstFrame;
+        bool gainFirstFrame;
+    };
+
+    // Per-lane parameters for processing one frame of a voice group.
+    struct GroupFrame
+    {
+        alignas(32) float eqWeight[kMaxLanes]; // 1 if the lane is EQ'd, 0 if the EQ is bypassed.
+        alignas(32) float crossfade[kMaxLanes]; // 1 if the lane crossfades from its previous filter.
+        alignas(32) float gain[kMaxLanes]; // Gain at the start of the frame.
+        alignas(32) float dGain[kMaxLanes]; // Change in gain per sample.
+        bool anyEQ;
+        bool anyCrossfade;
+    };
+
+    int mSamplingRate;
+    int mFrameSize;
+    int mMaxVoices;
+    Array<VoiceGroup> mGroups;
+    Array<VoiceState> mVoices;
+    Array<float> mInterleaved; // One frame of audio for a voice group, with samples for each lane stored together.
+
+    void (DirectEffectBatch::* mApplyDispatch)(VoiceGroup& group,
+                                               const GroupFrame& frame,
+                                               float* data);
+
+    void prepareVoice(int voice,
+                      const DirectEffectParams& params,
+                      GroupFrame& frame);
+
+    void calcFilters(const float* gains,
+                     IIR2* filters) const;
+
+    static void setFilters(VoiceGroup& group,
+                           int bank,
+                           int lane,
+                           const IIR2* filters);
+
+    void applyGroup_float4(VoiceGroup& group,
+                           const GroupFrame& frame,
+                           float* data);
+
+#if defined(IPL_ENABLE_FLOAT8)
+    void IPL_FLOAT8_ATTR applyGroup_float8(VoiceGroup& group,
+                                           const GroupFrame& frame,
+                                           float* data);
+#endif
 };
 
 }
@@ -63,6 +63,14 @@ uint64_t EnergyField::serializedSize() const
             mData.totalSize() * sizeof(float));
 }
 
+uint64_t EnergyField::serializedSize(const Serialized::EnergyField* serializedObject)
+{
+    auto totalSize = static_cast<uint64_t>(serializedObject->num_channels()) * Bands::kNumBands * serializedObject->num_bins();
+
+    return (2 * sizeof(int32_t) +
+            totalSize * sizeof(float));
+}
+
 flatbuffers::Offset<Serialized::EnergyField> EnergyField::serialize(SerializedObject& serializedObject) const
 {
     auto& fbb = serializedObject.fbb();
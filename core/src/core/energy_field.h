@@ -84,6 +84,9 @@ public:
 
     uint64_t serializedSize() const;
 
+    // Returns the value serializedSize() would return for an energy field loaded from the given serialized object.
+    static uint64_t serializedSize(const Serialized::EnergyField* serializedObject);
+
     flatbuffers::Offset<Serialized::EnergyField> serialize(SerializedObject& serializedObject) const;
 
     void copyFrom(const EnergyField& other);
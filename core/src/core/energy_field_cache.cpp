@@ -0,0 +1,99 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "energy_field_cache.h"
+
+#include "bands.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// EnergyFieldCache
+// --------------------------------------------------------------------------------------------------------------------
+
+EnergyFieldCache::EnergyFieldCache(uint64_t capacity)
+    : mCapacity(capacity)
+    , mSize(0)
+{}
+
+const EnergyFieldCache::Entry* EnergyFieldCache::find(int key)
+{
+    auto it = mEntries.find(key);
+    if (it == mEntries.end())
+        return nullptr;
+
+    mLRUOrder.splice(mLRUOrder.begin(), mLRUOrder, it->second.lruPosition);
+
+    return &it->second.entry;
+}
+
+const EnergyFieldCache::Entry* EnergyFieldCache::insert(int key,
+                                                        Entry entry)
+{
+    auto existing = mEntries.find(key);
+    if (existing != mEntries.end())
+    {
+        mSize -= existing->second.size;
+        mLRUOrder.erase(existing->second.lruPosition);
+        mEntries.erase(existing);
+    }
+
+    auto entrySize = sizeOf(entry);
+
+    while (!mLRUOrder.empty() && mSize + entrySize > mCapacity)
+    {
+        auto evicted = mEntries.find(mLRUOrder.back());
+        mSize -= evicted->second.size;
+        mEntries.erase(evicted);
+        mLRUOrder.pop_back();
+    }
+
+    mLRUOrder.push_front(key);
+    mSize += entrySize;
+
+    auto& slot = mEntries[key];
+    slot.entry = std::move(entry);
+    slot.size = entrySize;
+    slot.lruPosition = mLRUOrder.begin();
+
+    return &slot.entry;
+}
+
+void EnergyFieldCache::clear()
+{
+    mEntries.clear();
+    mLRUOrder.clear();
+    mSize = 0;
+}
+
+uint64_t EnergyFieldCache::sizeOf(const Entry& entry)
+{
+    uint64_t size = 0;
+
+    if (entry.energyField)
+    {
+        size += static_cast<uint64_t>(entry.energyField->numChannels()) * Bands::kNumBands * entry.energyField->numBins() * sizeof(float);
+    }
+
+    if (entry.compressedEnergyField)
+    {
+        size += entry.compressedEnergyField->serializedSize();
+    }
+
+    return size;
+}
+
+}
@@ -0,0 +1,84 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "compressed_energy_field.h"
+#include "containers.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// EnergyFieldCache
+// --------------------------------------------------------------------------------------------------------------------
+
+// A least-recently-used cache of decoded energy fields, used when streaming baked data. Each entry holds either an
+// uncompressed or a compressed energy field, and is identified by an integer key. When the total size of the entries
+// exceeds the capacity, the least recently used entries are evicted. Not thread-safe.
+class EnergyFieldCache
+{
+public:
+    struct Entry
+    {
+        unique_ptr<EnergyField> energyField;
+        unique_ptr<CompressedEnergyField> compressedEnergyField;
+    };
+
+    EnergyFieldCache(uint64_t capacity);
+
+    uint64_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    // Total size (in bytes) of all entries currently in the cache.
+    uint64_t size() const
+    {
+        return mSize;
+    }
+
+    int numEntries() const
+    {
+        return static_cast<int>(mEntries.size());
+    }
+
+    // Returns nullptr if there is no entry with the given key. Otherwise, marks the entry as most recently used.
+    const Entry* find(int key);
+
+    // Adds an entry, evicting least recently used entries as needed. The new entry itself is never evicted by this
+    // call, even if it is larger than the capacity. The returned pointer is valid until the next call to insert.
+    const Entry* insert(int key,
+                        Entry entry);
+
+    void clear();
+
+private:
+    struct Slot
+    {
+        Entry entry;
+        uint64_t size;
+        list<int>::iterator lruPosition;
+    };
+
+    uint64_t mCapacity;
+    uint64_t mSize;
+    unordered_map<int, Slot> mEntries;
+    list<int> mLRUOrder; // most recently used first
+
+    static uint64_t sizeOf(const Entry& entry);
+};
+
+}
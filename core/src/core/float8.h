@@ -26,8 +26,10 @@
 
 #if ( defined(__clang__) || defined(__GNUC__) ) && ( defined(IPL_CPU_X86) || defined(IPL_CPU_X64) )
 #define IPL_FLOAT8_ATTR __attribute__((target("avx")))
+#define IPL_FLOAT8_F16C_ATTR __attribute__((target("avx,f16c")))
 #else
 #define IPL_FLOAT8_ATTR
+#define IPL_FLOAT8_F16C_ATTR
 #endif
 
 #if defined(IPL_CPU_X86) || defined(IPL_CPU_X64)
@@ -0,0 +1,120 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#if defined(IPL_ENABLE_FLOAT8)
+
+#include "direct_effect.h"
+#include "float8.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// DirectEffectBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+void IPL_FLOAT8_ATTR DirectEffectBatch::applyGroup_float8(VoiceGroup& group,
+                                                          const GroupFrame& frame,
+                                                          float* data)
+{
+    const auto one = float8::set1(1.0f);
+    const auto epsilon = float8::set1(1e-9f);
+    const auto numBanks = (frame.anyCrossfade) ? 2 : 1;
+
+    alignas(float8_t) float filtered[2][kBlockSize * kMaxLanes];
+
+    auto eqWeight = float8::load(frame.eqWeight);
+    auto crossfade = float8::load(frame.crossfade);
+    auto gain = float8::load(frame.gain);
+    auto dGain = float8::load(frame.dGain);
+
+    for (auto start = 0; start < mFrameSize; start += kBlockSize)
+    {
+        auto blockSize = std::min(mFrameSize - start, static_cast<int>(kBlockSize));
+        auto* block = &data[start * kMaxLanes];
+
+        for (auto bank = 0; frame.anyEQ && bank < numBanks; ++bank)
+        {
+            for (auto band = 0; band < Bands::kNumBands; ++band)
+            {
+                const auto& coeffs = group.coeffs[bank][band];
+                auto& state = group.state[bank][band];
+
+                auto b0 = float8::load(coeffs[0]);
+                auto b1 = float8::load(coeffs[1]);
+                auto b2 = float8::load(coeffs[2]);
+                auto a1 = float8::load(coeffs[3]);
+                auto a2 = float8::load(coeffs[4]);
+                auto xm1 = float8::load(state[0]);
+                auto xm2 = float8::load(state[1]);
+                auto ym1 = float8::load(state[2]);
+                auto ym2 = float8::load(state[3]);
+
+                const auto* in = (band == 0) ? block : filtered[bank];
+                auto* out = filtered[bank];
+
+                for (auto i = 0; i < blockSize; ++i)
+                {
+                    auto x = float8::add(float8::load(&in[i * kMaxLanes]), epsilon);
+
+                    auto y = float8::sub(float8::add(float8::mul(b1, xm1), float8::mul(b2, xm2)), float8::mul(a2, ym2));
+                    y = float8::add(float8::mul(b0, x), float8::sub(y, float8::mul(a1, ym1)));
+
+                    xm2 = xm1;
+                    xm1 = x;
+                    ym2 = ym1;
+                    ym1 = y;
+
+                    float8::store(&out[i * kMaxLanes], y);
+                }
+
+                float8::store(state[0], xm1);
+                float8::store(state[1], xm2);
+                float8::store(state[2], ym1);
+                float8::store(state[3], ym2);
+            }
+        }
+
+        for (auto i = 0; i < blockSize; ++i)
+        {
+            auto offset = i * kMaxLanes;
+            auto x = float8::load(&block[offset]);
+            auto y = x;
+
+            if (frame.anyEQ)
+            {
+                y = float8::load(&filtered[0][offset]);
+
+                if (frame.anyCrossfade)
+                {
+                    auto t = float8::set1(static_cast<float>(start + i) / static_cast<float>(mFrameSize));
+                    auto weight = float8::add(float8::mul(crossfade, t), float8::sub(one, crossfade));
+                    y = float8::add(float8::mul(weight, y), float8::mul(float8::sub(one, weight), float8::load(&filtered[1][offset])));
+                }
+
+                y = float8::add(float8::mul(eqWeight, y), float8::mul(float8::sub(one, eqWeight), x));
+            }
+
+            float8::store(&block[offset], float8::mul(gain, y));
+            gain = float8::add(gain, dGain);
+        }
+    }
+
+    float8::avoidTransitionPenalty();
+}
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#if defined(IPL_ENABLE_FLOAT8)
+
+#include "array_math.h"
+#include "float8.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// ArrayMath (half precision)
+// --------------------------------------------------------------------------------------------------------------------
+
+// Multiplies 4 pairs of interleaved complex numbers.
+static inline IPL_FLOAT8_F16C_ATTR float8_t complexMultiply(float8_t a,
+                                                           float8_t b)
+{
+    auto aRe = _mm256_moveldup_ps(a);
+    auto aIm = _mm256_movehdup_ps(a);
+    auto bSwapped = _mm256_permute_ps(b, _MM_SHUFFLE(2, 3, 0, 1));
+
+    return _mm256_addsub_ps(float8::mul(aRe, b), float8::mul(aIm, bSwapped));
+}
+
+// Loads 4 complex numbers stored in half precision.
+static inline IPL_FLOAT8_F16C_ATTR float8_t loadHalf(const complexh_t* p)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+void IPL_FLOAT8_F16C_ATTR ArrayMath::multiplyAccumulate_float8(int size,
+                                                              const complexh_t* in1,
+                                                              const complexh_t* in2,
+                                                              complex_t* accum)
+{
+    auto simdSize = size & ~3;
+
+    auto outData = reinterpret_cast<float*>(accum);
+
+    for (auto i = 0; i < simdSize; i += 4)
+    {
+        auto y = float8::loadu(&outData[2 * i]);
+        y = float8::add(y, complexMultiply(loadHalf(&in1[i]), loadHalf(&in2[i])));
+        float8::storeu(&outData[2 * i], y);
+    }
+
+    float8::avoidTransitionPenalty();
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        auto aRe = Half::toFloat(in1[i].real);
+        auto aIm = Half::toFloat(in1[i].imag);
+        auto bRe = Half::toFloat(in2[i].real);
+        auto bIm = Half::toFloat(in2[i].imag);
+
+        accum[i] += complex_t(aRe * bRe - aIm * bIm, aRe * bIm + aIm * bRe);
+    }
+}
+
+void IPL_FLOAT8_F16C_ATTR ArrayMath::multiplyAccumulate_float8(int size,
+                                                              const complex_t* in1,
+                                                              const complexh_t* in2,
+                                                              complex_t* accum)
+{
+    auto simdSize = size & ~3;
+
+    auto in1Data = reinterpret_cast<const float*>(in1);
+    auto outData = reinterpret_cast<float*>(accum);
+
+    for (auto i = 0; i < simdSize; i += 4)
+    {
+        auto y = float8::loadu(&outData[2 * i]);
+        y = float8::add(y, complexMultiply(float8::loadu(&in1Data[2 * i]), loadHalf(&in2[i])));
+        float8::storeu(&outData[2 * i], y);
+    }
+
+    float8::avoidTransitionPenalty();
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        accum[i] += in1[i] * complex_t(Half::toFloat(in2[i].real), Half::toFloat(in2[i].imag));
+    }
+}
+
+void IPL_FLOAT8_F16C_ATTR ArrayMath::convert_float8(int size,
+                                                   const complex_t* in,
+                                                   complexh_t* out)
+{
+    auto simdSize = size & ~3;
+
+    auto inData = reinterpret_cast<const float*>(in);
+
+    for (auto i = 0; i < simdSize; i += 4)
+    {
+        auto x = _mm256_cvtps_ph(float8::loadu(&inData[2 * i]), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), x);
+    }
+
+    float8::avoidTransitionPenalty();
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        out[i].real = Half::fromFloat(in[i].real());
+        out[i].imag = Half::fromFloat(in[i].imag());
+    }
+}
+
+void IPL_FLOAT8_F16C_ATTR ArrayMath::convert_float8(int size,
+                                                   const complexh_t* in,
+                                                   complex_t* out)
+{
+    auto simdSize = size & ~3;
+
+    auto outData = reinterpret_cast<float*>(out);
+
+    for (auto i = 0; i < simdSize; i += 4)
+    {
+        float8::storeu(&outData[2 * i], loadHalf(&in[i]));
+    }
+
+    float8::avoidTransitionPenalty();
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        out[i] = complex_t(Half::toFloat(in[i].real), Half::toFloat(in[i].imag));
+    }
+}
+
+}
+
+#endif
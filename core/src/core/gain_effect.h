@@ -32,6 +32,9 @@ struct GainEffectParams
 class GainEffect
 {
 public:
+    // Number of frames over which a change in gain is smoothed.
+    static const int kNumInterpolationFrames = 4;
+
     GainEffect(const AudioSettings& audioSettings);
 
     void reset();
@@ -47,8 +50,6 @@ public:
     int numTailSamplesRemaining() const { return 0; }
 
 private:
-    static const int kNumInterpolationFrames = 4;
-
     int mFrameSize;
     float mPrevGain;
     bool mFirstFrame;
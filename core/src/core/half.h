@@ -0,0 +1,122 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstring>
+
+#include "types.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// half_t
+// --------------------------------------------------------------------------------------------------------------------
+
+// IEEE 754 half-precision (binary16) floating-point value. Only used for storage: values are converted to single
+// precision before doing any arithmetic on them.
+typedef uint16_t half_t;
+
+// A complex value stored as a pair of half-precision floats, laid out like complex_t.
+struct complexh_t
+{
+    half_t real;
+    half_t imag;
+};
+
+namespace Half
+{
+    // Converts a single-precision value to half precision, rounding to nearest even. Values too large to be
+    // represented become infinities.
+    inline half_t fromFloat(float x)
+    {
+        uint32_t bits = 0;
+        memcpy(&bits, &x, sizeof(float));
+
+        auto sign = static_cast<uint32_t>((bits >> 16) & 0x8000u);
+        auto absBits = bits & 0x7fffffffu;
+
+        if (absBits >= 0x7f800000u)
+            return static_cast<half_t>(sign | 0x7c00u | ((absBits > 0x7f800000u) ? 0x200u : 0u));
+
+        // 65520 and above round to infinity.
+        if (absBits >= 0x477ff000u)
+            return static_cast<half_t>(sign | 0x7c00u);
+
+        // Below 2^-14, the result is subnormal.
+        if (absBits < 0x38800000u)
+        {
+            if (absBits < 0x33000000u)
+                return static_cast<half_t>(sign);
+
+            auto exponent = absBits >> 23;
+            auto mantissa = (absBits & 0x7fffffu) | 0x800000u;
+            auto shift = 126u - exponent;
+
+            auto halfMantissa = mantissa >> shift;
+            auto remainder = mantissa & ((1u << shift) - 1u);
+            auto halfway = 1u << (shift - 1u);
+            if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u)))
+            {
+                ++halfMantissa;
+            }
+
+            return static_cast<half_t>(sign | halfMantissa);
+        }
+
+        auto rounded = absBits + 0xfffu + ((absBits >> 13) & 1u);
+        return static_cast<half_t>(sign | ((rounded - 0x38000000u) >> 13));
+    }
+
+    // Converts a half-precision value to single precision. This is exact.
+    inline float toFloat(half_t x)
+    {
+        auto sign = static_cast<uint32_t>(x & 0x8000u) << 16;
+        auto exponent = static_cast<uint32_t>((x >> 10) & 0x1fu);
+        auto mantissa = static_cast<uint32_t>(x & 0x3ffu);
+
+        uint32_t bits = 0;
+        if (exponent == 0x1fu)
+        {
+            bits = sign | 0x7f800000u | (mantissa << 13);
+        }
+        else if (exponent != 0)
+        {
+            bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+        }
+        else if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            exponent = 113u;
+            while (!(mantissa & 0x400u))
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+
+        auto result = 0.0f;
+        memcpy(&result, &bits, sizeof(float));
+        return result;
+    }
+}
+
+}
@@ -0,0 +1,199 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "array_math.h"
+
+#include "context.h"
+#include "float4.h"
+
+namespace ipl {
+
+// --------------------------------------------------------------------------------------------------------------------
+// ArrayMath (half precision)
+// --------------------------------------------------------------------------------------------------------------------
+
+void ArrayMath::multiplyAccumulate(int size,
+                                   const complexh_t* in1,
+                                   const complexh_t* in2,
+                                   complex_t* accum)
+{
+#if defined(IPL_ENABLE_FLOAT8)
+    if (gSIMDLevel() >= SIMDLevel::AVX2)
+    {
+        multiplyAccumulate_float8(size, in1, in2, accum);
+        return;
+    }
+#endif
+
+    auto simdSize = 0;
+
+#if defined(IPL_CPU_ARM64)
+
+    simdSize = size & ~3;
+
+    auto in1Data = reinterpret_cast<const uint16_t*>(in1);
+    auto in2Data = reinterpret_cast<const uint16_t*>(in2);
+    auto outData = reinterpret_cast<float*>(accum);
+
+    for (auto i = 0; i < simdSize; i += 4)
+    {
+        auto a = vld2_u16(&in1Data[2 * i]);
+        auto b = vld2_u16(&in2Data[2 * i]);
+        auto c = vld2q_f32(&outData[2 * i]);
+
+        auto aRe = vcvt_f32_f16(vreinterpret_f16_u16(a.val[0]));
+        auto aIm = vcvt_f32_f16(vreinterpret_f16_u16(a.val[1]));
+        auto bRe = vcvt_f32_f16(vreinterpret_f16_u16(b.val[0]));
+        auto bIm = vcvt_f32_f16(vreinterpret_f16_u16(b.val[1]));
+
+        c.val[0] = float4::add(c.val[0], float4::sub(float4::mul(aRe, bRe), float4::mul(aIm, bIm)));
+        c.val[1] = float4::add(c.val[1], float4::add(float4::mul(aRe, bIm), float4::mul(aIm, bRe)));
+
+        vst2q_f32(&outData[2 * i], c);
+    }
+
+#endif
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        auto aRe = Half::toFloat(in1[i].real);
+        auto aIm = Half::toFloat(in1[i].imag);
+        auto bRe = Half::toFloat(in2[i].real);
+        auto bIm = Half::toFloat(in2[i].imag);
+
+        accum[i] += complex_t(aRe * bRe - aIm * bIm, aRe * bIm + aIm * bRe);
+    }
+}
+
+void ArrayMath::multiplyAccumulate(int size,
+                                   const complex_t* in1,
+                                   const complexh_t* in2,
+                                   complex_t* accum)
+{
+#if defined(IPL_ENABLE_FLOAT8)
+    if (gSIMDLevel() >= SIMDLevel::AVX2)
+    {
+        multiplyAccumulate_float8(size, in1, in2, accum);
+        return;
+    }
+#endif
+
+    auto simdSize = 0;
+
+#if defined(IPL_CPU_ARM64)
+
+    simdSize = size & ~3;
+
+    auto in1Data = reinterpret_cast<const float*>(in1);
+    auto in2Data = reinterpret_cast<const uint16_t*>(in2);
+    auto outData = reinterpret_cast<float*>(accum);
+
+    for (auto i = 0; i < simdSize; i += 4)
+    {
+        auto a = vld2q_f32(&in1Data[2 * i]);
+        auto b = vld2_u16(&in2Data[2 * i]);
+        auto c = vld2q_f32(&outData[2 * i]);
+
+        auto bRe = vcvt_f32_f16(vreinterpret_f16_u16(b.val[0]));
+        auto bIm = vcvt_f32_f16(vreinterpret_f16_u16(b.val[1]));
+
+        c.val[0] = float4::add(c.val[0], float4::sub(float4::mul(a.val[0], bRe), float4::mul(a.val[1], bIm)));
+        c.val[1] = float4::add(c.val[1], float4::add(float4::mul(a.val[0], bIm), float4::mul(a.val[1], bRe)));
+
+        vst2q_f32(&outData[2 * i], c);
+    }
+
+#endif
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        auto bRe = Half::toFloat(in2[i].real);
+        auto bIm = Half::toFloat(in2[i].imag);
+
+        accum[i] += in1[i] * complex_t(bRe, bIm);
+    }
+}
+
+void ArrayMath::convert(int size,
+                        const complex_t* in,
+                        complexh_t* out)
+{
+#if defined(IPL_ENABLE_FLOAT8)
+    if (gSIMDLevel() >= SIMDLevel::AVX2)
+    {
+        convert_float8(size, in, out);
+        return;
+    }
+#endif
+
+    auto simdSize = 0;
+
+#if defined(IPL_CPU_ARM64)
+
+    simdSize = size & ~1;
+
+    auto inData = reinterpret_cast<const float*>(in);
+    auto outData = reinterpret_cast<uint16_t*>(out);
+
+    for (auto i = 0; i < simdSize; i += 2)
+    {
+        vst1_u16(&outData[2 * i], vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(&inData[2 * i]))));
+    }
+
+#endif
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        out[i].real = Half::fromFloat(in[i].real());
+        out[i].imag = Half::fromFloat(in[i].imag());
+    }
+}
+
+void ArrayMath::convert(int size,
+                        const complexh_t* in,
+                        complex_t* out)
+{
+#if defined(IPL_ENABLE_FLOAT8)
+    if (gSIMDLevel() >= SIMDLevel::AVX2)
+    {
+        convert_float8(size, in, out);
+        return;
+    }
+#endif
+
+    auto simdSize = 0;
+
+#if defined(IPL_CPU_ARM64)
+
+    simdSize = size & ~1;
+
+    auto inData = reinterpret_cast<const uint16_t*>(in);
+    auto outData = reinterpret_cast<float*>(out);
+
+    for (auto i = 0; i < simdSize; i += 2)
+    {
+        vst1q_f32(&outData[2 * i], vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(&inData[2 * i]))));
+    }
+
+#endif
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        out[i] = complex_t(Half::toFloat(in[i].real), Half::toFloat(in[i].imag));
+    }
+}
+
+}
@@ -20,11 +20,26 @@
 #include "array_math.h"
 #include "float4.h"
 #include "fft.h"
+#include "polar_vector.h"
 #include "sh.h"
 #include "profiler.h"
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// HRTFQueryState
+// --------------------------------------------------------------------------------------------------------------------
+
+HRTFQueryState::HRTFQueryState(const HRTFDatabase& hrtf)
+    : mFFTInterpolation(hrtf.numSamples())
+    , mFFTAudioProcessing(hrtf.numPaddedSamples())
+    , mInterpolatedHRTFMagnitude(mFFTInterpolation.numComplexSamples)
+    , mInterpolatedHRTFPhase(mFFTInterpolation.numComplexSamples)
+    , mInterpolatedHRTF(IHRTFMap::kNumEars, mFFTInterpolation.numComplexSamples)
+    , mInterpolatedHRIR(IHRTFMap::kNumEars, mFFTAudioProcessing.numRealSamples)
+{}
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // HRTFDatabase
 // --------------------------------------------------------------------------------------------------------------------
@@ -44,11 +59,11 @@ HRTFDatabase::HRTFDatabase(const HRTFSettings& hrtfSettings,
     , mPeakDelay(IHRTFMap::kNumEars, numHRIRs())
     , mHRTFMagnitude(IHRTFMap::kNumEars, numHRIRs(), mFFTInterpolation.numComplexSamples)
     , mHRTFPhase(IHRTFMap::kNumEars, numHRIRs(), mFFTInterpolation.numComplexSamples)
-    , mInterpolatedHRTFMagnitude(mFFTInterpolation.numComplexSamples)
-    , mInterpolatedHRTFPhase(mFFTInterpolation.numComplexSamples)
-    , mInterpolatedHRTF(IHRTFMap::kNumEars, mFFTInterpolation.numComplexSamples)
-    , mInterpolatedHRIR(IHRTFMap::kNumEars, mFFTAudioProcessing.numRealSamples)
     , mAmbisonicsHRTF(IHRTFMap::kNumEars, SphericalHarmonics::numCoeffsForOrder(IHRTFMap::kMaxAmbisonicsOrder), mFFTAudioProcessing.numComplexSamples)
+    , mNumGridElevations(0)
+    , mNumGridAzimuths(0)
+    , mGridElevationStep(0.0f)
+    , mGridAzimuthStep(0.0f)
 {
     updateReferenceLoudness(hrtfSettings.normType);
     applyVolumeSettings(hrtfSettings.volume, hrtfSettings.normType);
@@ -65,6 +80,11 @@ HRTFDatabase::HRTFDatabase(const HRTFSettings& hrtfSettings,
     {
         fourierTransformHRIRs(ambisonicsHRIR, mAmbisonicsHRTF);
     }
+
+    if (hrtfSettings.interpolationGridResolution > 0.0f)
+    {
+        precomputeInterpolationGrid(hrtfSettings.interpolationGridResolution);
+    }
 }
 
 void HRTFDatabase::getHRTFByIndex(int index,
@@ -80,8 +100,9 @@ void HRTFDatabase::nearestHRTF(const Vector3f& direction,
                                const complex_t** hrtf,
                                float spatialBlend,
                                HRTFPhaseType phaseType,
+                               HRTFQueryState& state,
                                complex_t* const* hrtfWithBlend,
-                               int* peakDelays)
+                               int* peakDelays) const
 {
     PROFILE_FUNCTION();
 
@@ -91,27 +112,27 @@ void HRTFDatabase::nearestHRTF(const Vector3f& direction,
 
     if (spatialBlend < 1.0f)
     {
-        auto numRealSamples = mFFTInterpolation.numRealSamples;
-        auto numComplexSamples = mFFTInterpolation.numComplexSamples;
+        auto numRealSamples = state.mFFTInterpolation.numRealSamples;
+        auto numComplexSamples = state.mFFTInterpolation.numComplexSamples;
 
         for (auto i = 0; i < 2; ++i)
         {
             applySpatialBlend(numRealSamples, numComplexSamples, spatialBlend, phaseType, direction, i,
                               mHRTFMagnitude[i][index], mHRTFPhase[i][index],
-                              mInterpolatedHRTFMagnitude.data(), mInterpolatedHRTFPhase.data());
+                              state.mInterpolatedHRTFMagnitude.data(), state.mInterpolatedHRTFPhase.data());
 
-            wrapPhase(mInterpolatedHRTFPhase);
+            wrapPhase(state.mInterpolatedHRTFPhase);
 
-            ArrayMath::exp(static_cast<int>(mInterpolatedHRTFMagnitude.size(0)), mInterpolatedHRTFMagnitude.data(),
-                           mInterpolatedHRTFMagnitude.data());
+            ArrayMath::exp(static_cast<int>(state.mInterpolatedHRTFMagnitude.size(0)), state.mInterpolatedHRTFMagnitude.data(),
+                           state.mInterpolatedHRTFMagnitude.data());
 
-            ArrayMath::polarToCartesian(static_cast<int>(mInterpolatedHRTFMagnitude.size(0)), mInterpolatedHRTFMagnitude.data(),
-                                        mInterpolatedHRTFPhase.data(), mInterpolatedHRTF[i]);
+            ArrayMath::polarToCartesian(static_cast<int>(state.mInterpolatedHRTFMagnitude.size(0)), state.mInterpolatedHRTFMagnitude.data(),
+                                        state.mInterpolatedHRTFPhase.data(), state.mInterpolatedHRTF[i]);
 
-            memset(mInterpolatedHRIR[i], 0, mInterpolatedHRIR.size(1) * sizeof(float));
-            mFFTInterpolation.applyInverse(mInterpolatedHRTF[i], mInterpolatedHRIR[i]);
+            memset(state.mInterpolatedHRIR[i], 0, state.mInterpolatedHRIR.size(1) * sizeof(float));
+            state.mFFTInterpolation.applyInverse(state.mInterpolatedHRTF[i], state.mInterpolatedHRIR[i]);
 
-            mFFTAudioProcessing.applyForward(mInterpolatedHRIR[i], hrtfWithBlend[i]);
+            state.mFFTAudioProcessing.applyForward(state.mInterpolatedHRIR[i], hrtfWithBlend[i]);
         }
     }
 
@@ -128,27 +149,64 @@ void HRTFDatabase::interpolatedHRTF(const Vector3f& direction,
                                     complex_t* const* hrtf,
                                     float spatialBlend,
                                     HRTFPhaseType phaseType,
-                                    int* peakDelays)
+                                    HRTFQueryState& state,
+                                    int* peakDelays) const
 {
     PROFILE_FUNCTION();
 
+    if (spatialBlend >= 1.0f && hasInterpolationGrid())
+    {
+        auto index = nearestGridDirection(direction);
+
+        for (auto i = 0; i < IHRTFMap::kNumEars; ++i)
+        {
+            memcpy(hrtf[i], mInterpolationGrid[i][index], mInterpolationGrid.size(2) * sizeof(complex_t));
+
+            if (peakDelays)
+            {
+                peakDelays[i] = mInterpolationGridPeakDelay[i][index];
+            }
+        }
+
+        return;
+    }
+
     int indices[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
     float weights[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
     mHRTFMap->interpolatedHRIRWeights(direction, indices, weights);
 
-    interpolateHRIRs(indices, weights, spatialBlend, phaseType, direction);
+    interpolateHRIRs(indices, weights, spatialBlend, phaseType, state, direction);
 
     for (auto i = 0; i < IHRTFMap::kNumEars; ++i)
     {
-        memset(mInterpolatedHRIR[i], 0, mInterpolatedHRIR.size(1) * sizeof(float));
-        mFFTInterpolation.applyInverse(mInterpolatedHRTF[i], mInterpolatedHRIR[i]);
+        memset(state.mInterpolatedHRIR[i], 0, state.mInterpolatedHRIR.size(1) * sizeof(float));
+        state.mFFTInterpolation.applyInverse(state.mInterpolatedHRTF[i], state.mInterpolatedHRIR[i]);
 
         if (peakDelays)
         {
-            peakDelays[i] = extractPeakDelay(mInterpolatedHRIR[i], mHRTFMap->numSamples());
+            peakDelays[i] = extractPeakDelay(state.mInterpolatedHRIR[i], mHRTFMap->numSamples());
         }
 
-        mFFTAudioProcessing.applyForward(mInterpolatedHRIR[i], hrtf[i]);
+        state.mFFTAudioProcessing.applyForward(state.mInterpolatedHRIR[i], hrtf[i]);
+    }
+}
+
+void HRTFDatabase::gridInterpolatedHRTF(const Vector3f& direction,
+                                        const complex_t** hrtf,
+                                        int* peakDelays) const
+{
+    PROFILE_FUNCTION();
+
+    auto index = nearestGridDirection(direction);
+
+    for (auto i = 0; i < IHRTFMap::kNumEars; ++i)
+    {
+        hrtf[i] = mInterpolationGrid[i][index];
+
+        if (peakDelays)
+        {
+            peakDelays[i] = mInterpolationGridPeakDelay[i][index];
+        }
     }
 }
 
@@ -344,11 +402,14 @@ void HRTFDatabase::interpolateHRIRs(const int* indices,
                                     const float* weights,
                                     float spatialBlend,
                                     HRTFPhaseType phaseType,
-                                    const Vector3f& direction)
+                                    HRTFQueryState& state,
+                                    const Vector3f& direction) const
 {
     PROFILE_FUNCTION();
 
     auto size = mFFTInterpolation.numComplexSamples;
+    auto& interpolatedMagnitude = state.mInterpolatedHRTFMagnitude;
+    auto& interpolatedPhase = state.mInterpolatedHRTFPhase;
 
     auto numValidIndices = 0;
     int validIndices[8] = { 0 };
@@ -367,26 +428,26 @@ void HRTFDatabase::interpolateHRIRs(const int* indices,
     {
         // Since the phase has been unwrapped, we can just linearly interpolate the magnitude and phase
         // separately.
-        ArrayMath::scale(static_cast<int>(mInterpolatedHRTFMagnitude.size(0)), mHRTFMagnitude[i][validIndices[0]], weightsForValidIndices[0], mInterpolatedHRTFMagnitude.data());
-        ArrayMath::scale(static_cast<int>(mInterpolatedHRTFPhase.size(0)), mHRTFPhase[i][validIndices[0]], weightsForValidIndices[0], mInterpolatedHRTFPhase.data());
+        ArrayMath::scale(static_cast<int>(interpolatedMagnitude.size(0)), mHRTFMagnitude[i][validIndices[0]], weightsForValidIndices[0], interpolatedMagnitude.data());
+        ArrayMath::scale(static_cast<int>(interpolatedPhase.size(0)), mHRTFPhase[i][validIndices[0]], weightsForValidIndices[0], interpolatedPhase.data());
         for (auto j = 1; j < numValidIndices; ++j)
         {
-            ArrayMath::scaleAccumulate(static_cast<int>(mInterpolatedHRTFMagnitude.size(0)), mHRTFMagnitude[i][validIndices[j]], weightsForValidIndices[j], mInterpolatedHRTFMagnitude.data());
-            ArrayMath::scaleAccumulate(static_cast<int>(mInterpolatedHRTFPhase.size(0)), mHRTFPhase[i][validIndices[j]], weightsForValidIndices[j], mInterpolatedHRTFPhase.data());
+            ArrayMath::scaleAccumulate(static_cast<int>(interpolatedMagnitude.size(0)), mHRTFMagnitude[i][validIndices[j]], weightsForValidIndices[j], interpolatedMagnitude.data());
+            ArrayMath::scaleAccumulate(static_cast<int>(interpolatedPhase.size(0)), mHRTFPhase[i][validIndices[j]], weightsForValidIndices[j], interpolatedPhase.data());
         }
 
         if (spatialBlend < 1.0f)
         {
             applySpatialBlend(mFFTInterpolation.numRealSamples, size, spatialBlend, phaseType, direction, i,
-                              mInterpolatedHRTFMagnitude.data(), mInterpolatedHRTFPhase.data(),
-                              mInterpolatedHRTFMagnitude.data(), mInterpolatedHRTFPhase.data());
+                              interpolatedMagnitude.data(), interpolatedPhase.data(),
+                              interpolatedMagnitude.data(), interpolatedPhase.data());
         }
 
         // After interpolation, wrap the phase.
-        wrapPhase(mInterpolatedHRTFPhase);
+        wrapPhase(interpolatedPhase);
 
-        ArrayMath::exp(static_cast<int>(mInterpolatedHRTFMagnitude.size(0)), mInterpolatedHRTFMagnitude.data(), mInterpolatedHRTFMagnitude.data());
-        ArrayMath::polarToCartesian(static_cast<int>(mInterpolatedHRTFMagnitude.size(0)), mInterpolatedHRTFMagnitude.data(), mInterpolatedHRTFPhase.data(), mInterpolatedHRTF[i]);
+        ArrayMath::exp(static_cast<int>(interpolatedMagnitude.size(0)), interpolatedMagnitude.data(), interpolatedMagnitude.data());
+        ArrayMath::polarToCartesian(static_cast<int>(interpolatedMagnitude.size(0)), interpolatedMagnitude.data(), interpolatedPhase.data(), state.mInterpolatedHRTF[i]);
     }
 }
 
@@ -399,7 +460,7 @@ void HRTFDatabase::applySpatialBlend(int numRealSamples,
                                      const float* hrtfMagnitude,
                                      const float* hrtfPhase,
                                      float* hrtfMagnitudeBlended,
-                                     float* hrtfPhaseBlended)
+                                     float* hrtfPhaseBlended) const
 {
     auto leftDelay = 0.0f;
     auto rightDelay = 0.0f;
@@ -476,6 +537,65 @@ void HRTFDatabase::applySpatialBlend(int numRealSamples,
     }
 }
 
+void HRTFDatabase::precomputeInterpolationGrid(float resolution)
+{
+    PROFILE_FUNCTION();
+
+    // Elevations run from the bottom pole to the top pole, inclusive. Azimuths wrap around, so the last azimuth is
+    // one step short of a full circle.
+    auto numElevations = std::max(2, static_cast<int>(roundf(180.0f / resolution)) + 1);
+    auto numAzimuths = std::max(1, static_cast<int>(roundf(360.0f / resolution)));
+    auto elevationStep = Math::kPi / (numElevations - 1);
+    auto azimuthStep = (2.0f * Math::kPi) / numAzimuths;
+
+    mInterpolationGrid.resize(IHRTFMap::kNumEars, numElevations * numAzimuths, mFFTAudioProcessing.numComplexSamples);
+    mInterpolationGridPeakDelay.resize(IHRTFMap::kNumEars, numElevations * numAzimuths);
+
+    HRTFQueryState state(*this);
+
+    // The grid is filled in using the regular bilinear interpolation path, so it must not be marked as available
+    // until every grid direction has been computed.
+    for (auto i = 0, index = 0; i < numElevations; ++i)
+    {
+        for (auto j = 0; j < numAzimuths; ++j, ++index)
+        {
+            auto elevation = i * elevationStep - Math::kHalfPi;
+            auto azimuth = j * azimuthStep;
+            auto direction = SphericalVector3f(1.0f, elevation, azimuth).toCartesian();
+
+            complex_t* hrtf[] = { mInterpolationGrid[0][index], mInterpolationGrid[1][index] };
+            int peakDelays[] = { 0, 0 };
+            interpolatedHRTF(direction, hrtf, 1.0f, HRTFPhaseType::None, state, peakDelays);
+
+            for (auto k = 0; k < IHRTFMap::kNumEars; ++k)
+            {
+                mInterpolationGridPeakDelay[k][index] = peakDelays[k];
+            }
+        }
+    }
+
+    mNumGridElevations = numElevations;
+    mNumGridAzimuths = numAzimuths;
+    mGridElevationStep = elevationStep;
+    mGridAzimuthStep = azimuthStep;
+}
+
+int HRTFDatabase::nearestGridDirection(const Vector3f& direction) const
+{
+    auto spherical = SphericalVector3f(direction);
+    if (!(spherical.radius > 0.0f))
+    {
+        spherical = SphericalVector3f(Vector3f(0.0f, 0.0f, -1.0f));
+    }
+
+    auto elevationIndex = static_cast<int>(roundf((spherical.elevation + Math::kHalfPi) / mGridElevationStep));
+    elevationIndex = std::max(0, std::min(elevationIndex, mNumGridElevations - 1));
+
+    auto azimuthIndex = static_cast<int>(roundf(spherical.azimuth / mGridAzimuthStep)) % mNumGridAzimuths;
+
+    return elevationIndex * mNumGridAzimuths + azimuthIndex;
+}
+
 void HRTFDatabase::precomputeAmbisonicsHRTFs(int samplingRate,
                                              int frameSize)
 {
@@ -495,6 +615,8 @@ void HRTFDatabase::precomputeAmbisonicsHRTFs(int samplingRate,
 
     Array<complex_t> tempInterpolatedHRTF(mFFTAudioProcessing.numComplexSamples);
 
+    HRTFQueryState state(*this);
+
     for (auto l = 0, index = 0; l <= IHRTFMap::kMaxAmbisonicsOrder; ++l)
     {
         for (auto m = -l; m <= l; ++m, ++index)
@@ -510,11 +632,11 @@ void HRTFDatabase::precomputeAmbisonicsHRTFs(int samplingRate,
                 // We can just blend the (smaller) interpolatedHRTF for each virtual speaker, IFFT it once, and
                 // then FFT it once with zero-padding. This will reduce the number of IFFT/FFTs required during the SH
                 // projection step by a factor of #virtualspeakers.
-                interpolateHRIRs(indices, weights, 1.0f, HRTFPhaseType::None);
+                interpolateHRIRs(indices, weights, 1.0f, HRTFPhaseType::None, state);
 
                 for (auto j = 0; j < IHRTFMap::kNumEars; ++j)
                 {
-                    memcpy(tempInterpolatedHRTF.data(), mInterpolatedHRTF[j], mInterpolatedHRTF.size(1) * sizeof(complex_t));
+                    memcpy(tempInterpolatedHRTF.data(), state.mInterpolatedHRTF[j], state.mInterpolatedHRTF.size(1) * sizeof(complex_t));
                     ArrayMath::scale(mFFTAudioProcessing.numComplexSamples, tempInterpolatedHRTF.data(), weight, tempInterpolatedHRTF.data());
                     ArrayMath::add(mFFTAudioProcessing.numComplexSamples, mAmbisonicsHRTF[j][index], tempInterpolatedHRTF.data(), mAmbisonicsHRTF[j][index]);
                 }
@@ -522,9 +644,9 @@ void HRTFDatabase::precomputeAmbisonicsHRTFs(int samplingRate,
 
             for (auto j = 0; j < IHRTFMap::kNumEars; ++j)
             {
-                mFFTInterpolation.applyInverse(mAmbisonicsHRTF[j][index], mInterpolatedHRIR[j]);
-                memset(mInterpolatedHRIR[j] + numSamples(), 0, (mFFTInterpolation.numRealSamples - numSamples()) * sizeof(float));
-                mFFTAudioProcessing.applyForward(mInterpolatedHRIR[j], mAmbisonicsHRTF[j][index]);
+                mFFTInterpolation.applyInverse(mAmbisonicsHRTF[j][index], state.mInterpolatedHRIR[j]);
+                memset(state.mInterpolatedHRIR[j] + numSamples(), 0, (mFFTInterpolation.numRealSamples - numSamples()) * sizeof(float));
+                mFFTAudioProcessing.applyForward(state.mInterpolatedHRIR[j], mAmbisonicsHRTF[j][index]);
             }
         }
     }
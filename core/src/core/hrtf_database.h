@@ -43,6 +43,27 @@ enum class HRTFPhaseType
     Full // Phase response from the queried HRTF.
 };
 
+class HRTFDatabase;
+
+// Temporary storage used by HRTF queries that blend HRTFs on the fly (bilinear interpolation and spatial blend).
+// HRTFDatabase queries are const and keep no state of their own, so a single HRTFDatabase can be queried from many
+// threads at once, provided each thread uses its own HRTFQueryState.
+class HRTFQueryState
+{
+public:
+    HRTFQueryState(const HRTFDatabase& hrtf);
+
+private:
+    FFT mFFTInterpolation; // FFT for interpolation. #samples -> #spectrumsamples.
+    FFT mFFTAudioProcessing; // FFT for audio processing. #paddedsamples -> #paddedspectrumsamples.
+    Array<float> mInterpolatedHRTFMagnitude; // Interpolated HRTF magnitude. #spectrumsamples.
+    Array<float> mInterpolatedHRTFPhase; // Interpolated HRTF phase. #spectrumsamples.
+    Array<complex_t, 2> mInterpolatedHRTF; // Interpolated HRTF. #ears * #spectrumsamples.
+    Array<float, 2> mInterpolatedHRIR; // Interpolated HRIR. #ears * #paddedsamples.
+
+    friend class HRTFDatabase;
+};
+
 // An HRTF database that can be queried at any given direction.
 class HRTFDatabase
 {
@@ -69,23 +90,44 @@ public:
         return mFFTAudioProcessing.numComplexSamples;
     }
 
+    // Size of the zero-padded HRIRs from which the HRTFs are calculated.
+    int numPaddedSamples() const
+    {
+        return mFFTAudioProcessing.numRealSamples;
+    }
+
     void getHRTFByIndex(int index,
                         const complex_t** hrtf) const;
 
-    // Nearest-neighbor lookup, with optional spatial blend support.
+    // Nearest-neighbor lookup, with optional spatial blend support. The query state is only used when spatial blend
+    // is enabled, in which case the blended HRTF is written to hrtfWithBlend.
     void nearestHRTF(const Vector3f& direction,
                      const complex_t** hrtf,
                      float spatialBlend,
                      HRTFPhaseType phaseType,
+                     HRTFQueryState& state,
                      complex_t* const* hrtfWithBlend = nullptr,
-                     int* peakDelays = nullptr);
+                     int* peakDelays = nullptr) const;
 
     // Bilinear interpolated lookup, with optional spatial blend support.
     void interpolatedHRTF(const Vector3f& direction,
                           complex_t* const* hrtf,
                           float spatialBlend,
                           HRTFPhaseType phaseType,
-                          int* peakDelays = nullptr);
+                          HRTFQueryState& state,
+                          int* peakDelays = nullptr) const;
+
+    // True if bilinear interpolated HRTFs have been precomputed on a grid of directions.
+    bool hasInterpolationGrid() const
+    {
+        return (mNumGridAzimuths > 0);
+    }
+
+    // Bilinear interpolated lookup served from the precomputed interpolation grid. Returns the HRTF for the grid
+    // direction nearest to the given direction. Spatial blend is not supported.
+    void gridInterpolatedHRTF(const Vector3f& direction,
+                              const complex_t** hrtf,
+                              int* peakDelays = nullptr) const;
 
     // Returns a precomputed Ambisonics HRTF.
     void ambisonicsHRTF(int index,
@@ -103,11 +145,13 @@ private:
     Array<int, 2> mPeakDelay; // Index of peaks in each HRIR. #ears * #measurements.
     Array<float, 3> mHRTFMagnitude; // HRTF magnitude. #ears * #measurements * #spectrumsamples.
     Array<float, 3> mHRTFPhase; // HRTF phase (unwrapped). #ears * #measurements * #spectrumsamples.
-    Array<float> mInterpolatedHRTFMagnitude; // Temp. storage for interpolated HRTF magnitude. #spectrumsamples.
-    Array<float> mInterpolatedHRTFPhase; // Temp. storage for interpolated HRTF phase. #spectrumsamples.
-    Array<complex_t, 2> mInterpolatedHRTF; // Interpolated HRTF. #ears * #spectrumsamples.
-    Array<float, 2> mInterpolatedHRIR; // Interpolated HRIR. #ears * #paddedsamples. TODO: check
     Array<complex_t, 3> mAmbisonicsHRTF; // Ambisonics HRTFs. #ears * #coefficients * #paddedspectrumsamples.
+    int mNumGridElevations; // Number of elevations in the interpolation grid, including both poles.
+    int mNumGridAzimuths; // Number of azimuths at each elevation in the interpolation grid. 0 if there is no grid.
+    float mGridElevationStep; // Spacing (in radians) between grid elevations.
+    float mGridAzimuthStep; // Spacing (in radians) between grid azimuths.
+    Array<complex_t, 3> mInterpolationGrid; // Interpolated HRTFs. #ears * #griddirections * #paddedspectrumsamples.
+    Array<int, 2> mInterpolationGridPeakDelay; // Peak delays of interpolated HRIRs. #ears * #griddirections.
     float mReferenceLoudness; // Reference loudness of front HRIR.
 
     // Applies a normalization and volume scaling to the loaded HRIRs. Performs no normalization if HRTFNormType::None is selected.
@@ -127,12 +171,13 @@ private:
                                    Array<float, 3>& magnitude,
                                    Array<float, 3>& phase);
 
-    // Blends up to 4 HRIRs using the given weights.
+    // Blends up to 4 HRIRs using the given weights. The result is stored in the interpolated HRTF of the query state.
     void interpolateHRIRs(const int* indices,
                           const float* weights,
                           float spatialBlend,
                           HRTFPhaseType phaseType,
-                          const Vector3f& direction = Vector3f::kZero);
+                          HRTFQueryState& state,
+                          const Vector3f& direction = Vector3f::kZero) const;
 
     void applySpatialBlend(int numRealSamples,
                            int numComplexSamples,
@@ -143,7 +188,13 @@ private:
                            const float* hrtfMagnitude,
                            const float* hrtfPhase,
                            float* hrtfMagnitudeBlended,
-                           float* hrtfPhaseBlended);
+                           float* hrtfPhaseBlended) const;
+
+    // Precomputes bilinear interpolated HRTFs for a grid of directions with the given angular spacing (in degrees).
+    void precomputeInterpolationGrid(float resolution);
+
+    // Returns the index of the interpolation grid direction nearest to the given direction.
+    int nearestGridDirection(const Vector3f& direction) const;
 
     // Projects an HRIR set into Ambisonics.
     void precomputeAmbisonicsHRTFs(int samplingRate,
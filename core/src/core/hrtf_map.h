@@ -46,6 +46,7 @@ struct HRTFSettings
     int                 sofaDataSize    = 0;
     float               volume          = 0.0f;     // Volume in dB.
     HRTFNormType        normType        = HRTFNormType::None;
+    float               interpolationGridResolution = 0.0f;     // Grid spacing in degrees. 0 disables the grid.
 };
 
 // A data structure that stores loaded HRTF data and allows nearest-neighbor and interpolated queries. This is a base
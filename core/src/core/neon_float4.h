@@ -240,6 +240,14 @@ namespace float4
     {
         return vgetq_lane_f32(in, 0);
     }
+
+    // Returns a 4-bit integer whose bit i is set if the mask in lane i is set.
+    inline int movemask(float4_t mask)
+    {
+        auto bits = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+        return static_cast<int>(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+                                (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+    }
 }
 
 }
\ No newline at end of file
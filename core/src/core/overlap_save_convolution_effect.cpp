@@ -27,21 +27,102 @@ namespace ipl {
 // OverlapSaveFIR
 // --------------------------------------------------------------------------------------------------------------------
 
+bool OverlapSaveFIR::sEnableHalfPrecision = false;
+
 OverlapSaveFIR::OverlapSaveFIR(int numChannels,
                                int irSize,
-                               int frameSize)
+                               int frameSize,
+                               int partitionSize,
+                               bool halfPrecision)
+    : mHalfPrecision(halfPrecision)
+    , mNumChannels(numChannels)
+    , mNumTailBlocks(0)
+    , mNumTailSpectrumSamples(0)
 {
-    auto numBlocks = OverlapSaveConvolutionEffect::numBlocks(frameSize, irSize);
-    auto numSpectrumSamples = Math::nextpow2(2 * frameSize) / 2 + 1;
+    partitionSize = OverlapSaveConvolutionEffect::partitionSize(frameSize, partitionSize);
 
-    mData.resize(numChannels, numBlocks, numSpectrumSamples);
+    mNumBlocks = OverlapSaveConvolutionEffect::numHeadBlocks(frameSize, partitionSize, irSize);
+    mNumSpectrumSamples = Math::nextpow2(2 * frameSize) / 2 + 1;
+
+    if (mHalfPrecision)
+    {
+        mHalfData.resize(mNumChannels, mNumBlocks, mNumSpectrumSamples);
+    }
+    else
+    {
+        mData.resize(mNumChannels, mNumBlocks, mNumSpectrumSamples);
+    }
+
+    auto numTailBlocks = OverlapSaveConvolutionEffect::numTailBlocks(frameSize, partitionSize, irSize);
+    if (numTailBlocks > 0)
+    {
+        mNumTailBlocks = numTailBlocks;
+        mNumTailSpectrumSamples = Math::nextpow2(2 * partitionSize) / 2 + 1;
+
+        if (mHalfPrecision)
+        {
+            mHalfTailData.resize(mNumChannels, mNumTailBlocks, mNumTailSpectrumSamples);
+        }
+        else
+        {
+            mTailData.resize(mNumChannels, mNumTailBlocks, mNumTailSpectrumSamples);
+        }
+    }
 
     reset();
 }
 
+size_t OverlapSaveFIR::sizeInBytes() const
+{
+    auto numValues = static_cast<size_t>(mNumChannels) * (mNumBlocks * mNumSpectrumSamples + mNumTailBlocks * mNumTailSpectrumSamples);
+    return numValues * ((mHalfPrecision) ? sizeof(complexh_t) : sizeof(complex_t));
+}
+
 void OverlapSaveFIR::reset()
 {
-    memset(mData.flatData(), 0, mData.totalSize() * sizeof(complex_t));
+    if (mHalfPrecision)
+    {
+        memset(mHalfData.flatData(), 0, mHalfData.totalSize() * sizeof(complexh_t));
+
+        if (mNumTailBlocks > 0)
+        {
+            memset(mHalfTailData.flatData(), 0, mHalfTailData.totalSize() * sizeof(complexh_t));
+        }
+    }
+    else
+    {
+        memset(mData.flatData(), 0, mData.totalSize() * sizeof(complex_t));
+
+        if (mNumTailBlocks > 0)
+        {
+            memset(mTailData.flatData(), 0, mTailData.totalSize() * sizeof(complex_t));
+        }
+    }
+}
+
+// Copies a single block of spectrum samples between OverlapSaveFIRs, converting between precisions if needed.
+static void copyBlock(int size,
+                      const complex_t* srcFull,
+                      const complexh_t* srcHalf,
+                      complex_t* dstFull,
+                      complexh_t* dstHalf)
+{
+    if (srcFull && dstFull)
+    {
+        memcpy(dstFull, srcFull, size * sizeof(complex_t));
+    }
+    else if (srcHalf && dstHalf)
+    {
+        memcpy(dstHalf, srcHalf, size * sizeof(complexh_t));
+    }
+    else if (srcFull)
+    {
+        ArrayMath::convert(size, srcFull, dstHalf);
+    }
+    else
+    {
+        ArrayMath::convert(size, srcHalf, dstFull);
+    }
 }
 
 void OverlapSaveFIR::copy(const OverlapSaveFIR& src, OverlapSaveFIR& dst)
@@ -54,27 +135,56 @@ void OverlapSaveFIR::copy(const OverlapSaveFIR& src, OverlapSaveFIR& dst)
     {
         for (auto j = 0; j < numBlocksToCopy; ++j)
         {
-            memcpy(dst.mData[i][j], src.mData[i][j], numSpectrumSamplesToCopy * sizeof(complex_t));
+            copyBlock(numSpectrumSamplesToCopy,
+                      (src.mHalfPrecision) ? nullptr : src.mData[i][j], (src.mHalfPrecision) ? src.mHalfData[i][j] : nullptr,
+                      (dst.mHalfPrecision) ? nullptr : dst.mData[i][j], (dst.mHalfPrecision) ? dst.mHalfData[i][j] : nullptr);
+        }
+    }
+
+    auto numTailBlocksToCopy = std::min(src.numTailBlocks(), dst.numTailBlocks());
+    auto numTailSpectrumSamplesToCopy = std::min(src.numTailSpectrumSamples(), dst.numTailSpectrumSamples());
+
+    for (auto i = 0; i < numChannelsToCopy; ++i)
+    {
+        for (auto j = 0; j < numTailBlocksToCopy; ++j)
+        {
+            copyBlock(numTailSpectrumSamplesToCopy,
+                      (src.mHalfPrecision) ? nullptr : src.mTailData[i][j], (src.mHalfPrecision) ? src.mHalfTailData[i][j] : nullptr,
+                      (dst.mHalfPrecision) ? nullptr : dst.mTailData[i][j], (dst.mHalfPrecision) ? dst.mHalfTailData[i][j] : nullptr);
         }
     }
 }
 
 void OverlapSaveFIR::swap(OverlapSaveFIR& a, OverlapSaveFIR& b)
 {
+    std::swap(a.mHalfPrecision, b.mHalfPrecision);
+    std::swap(a.mNumChannels, b.mNumChannels);
+    std::swap(a.mNumBlocks, b.mNumBlocks);
+    std::swap(a.mNumSpectrumSamples, b.mNumSpectrumSamples);
+    std::swap(a.mNumTailBlocks, b.mNumTailBlocks);
+    std::swap(a.mNumTailSpectrumSamples, b.mNumTailSpectrumSamples);
     a.mData.swap(b.mData);
+    a.mTailData.swap(b.mTailData);
+    a.mHalfData.swap(b.mHalfData);
+    a.mHalfTailData.swap(b.mHalfTailData);
 }
 
-
 // --------------------------------------------------------------------------------------------------------------------
 // OverlapSavePartitioner
 // --------------------------------------------------------------------------------------------------------------------
 
-OverlapSavePartitioner::OverlapSavePartitioner(int frameSize)
+OverlapSavePartitioner::OverlapSavePartitioner(int frameSize,
+                                               int partitionSize)
     : mFrameSize(frameSize)
+    , mPartitionSize(OverlapSaveConvolutionEffect::partitionSize(frameSize, partitionSize))
     , mFFT(2 * frameSize)
+    , mTailFFT(2 * mPartitionSize)
     , mTempIRBlock(mFFT.numRealSamples)
+    , mTempIRTailBlock(mTailFFT.numRealSamples)
+    , mTempSpectrum(std::max(mFFT.numComplexSamples, mTailFFT.numComplexSamples))
 {
     mTempIRBlock.zero();
+    mTempIRTailBlock.zero();
 }
 
 void OverlapSavePartitioner::partition(const ImpulseResponse& ir,
@@ -100,7 +210,43 @@ void OverlapSavePartitioner::partition(const ImpulseResponse& ir,
                 break;
 
             memcpy(mTempIRBlock.data(), &ir[i][j * mFrameSize], numSamplesToCopy * sizeof(float));
-            mFFT.applyForward(mTempIRBlock.data(), fftIR[i][j]);
+            memset(&mTempIRBlock[numSamplesToCopy], 0, (mFrameSize - numSamplesToCopy) * sizeof(float));
+
+            if (fftIR.isHalfPrecision())
+            {
+                mFFT.applyForward(mTempIRBlock.data(), mTempSpectrum.data());
+                ArrayMath::convert(mFFT.numComplexSamples, mTempSpectrum.data(), fftIR.half(i)[j]);
+            }
+            else
+            {
+                mFFT.applyForward(mTempIRBlock.data(), fftIR[i][j]);
+            }
+        }
+
+        // The tail blocks start right after the head, which always covers 2 * partitionSize samples when there is
+        // a tail.
+        auto tailStart = 2 * mPartitionSize;
+        numSamplesLeft = std::min(numSamples, ir.numSamples()) - tailStart;
+        for (auto j = 0; j < fftIR.numTailBlocks(); ++j)
+        {
+            auto numSamplesToCopy = std::min(mPartitionSize, numSamplesLeft);
+            numSamplesLeft -= numSamplesToCopy;
+
+            if (numSamplesToCopy <= 0)
+                break;
+
+            memcpy(mTempIRTailBlock.data(), &ir[i][tailStart + j * mPartitionSize], numSamplesToCopy * sizeof(float));
+            memset(&mTempIRTailBlock[numSamplesToCopy], 0, (mPartitionSize - numSamplesToCopy) * sizeof(float));
+
+            if (fftIR.isHalfPrecision())
+            {
+                mTailFFT.applyForward(mTempIRTailBlock.data(), mTempSpectrum.data());
+                ArrayMath::convert(mTailFFT.numComplexSamples, mTempSpectrum.data(), fftIR.halfTail(i)[j]);
+            }
+            else
+            {
+                mTailFFT.applyForward(mTempIRTailBlock.data(), fftIR.tail(i)[j]);
+            }
         }
     }
 }
@@ -115,15 +261,62 @@ OverlapSaveConvolutionEffect::OverlapSaveConvolutionEffect(const AudioSettings&
     : mFrameSize(audioSettings.frameSize)
     , mIRSize(effectSettings.irSize)
     , mNumChannels(effectSettings.numChannels)
+    , mPartitionSize(partitionSize(audioSettings.frameSize, effectSettings.partitionSize))
+    , mNumHeadBlocks(numHeadBlocks(audioSettings.frameSize, mPartitionSize, effectSettings.irSize))
+    , mNumTailBlocks(numTailBlocks(audioSettings.frameSize, mPartitionSize, effectSettings.irSize))
+    , mHalfPrecision(OverlapSaveFIR::sEnableHalfPrecision)
     , mFFT(2 * audioSettings.frameSize)
     , mDryBlock(mFFT.numRealSamples)
-    , mFFTDryBlocks(OverlapSaveConvolutionEffect::numBlocks(audioSettings.frameSize, effectSettings.irSize), mFFT.numComplexSamples)
     , mFFTWet(effectSettings.numChannels, mFFT.numComplexSamples)
     , mPrevFFTWet(effectSettings.numChannels, mFFT.numComplexSamples)
     , mWet(effectSettings.numChannels, mFFT.numRealSamples)
     , mPrevWet(effectSettings.numChannels, mFFT.numRealSamples)
+    , mTailDryBlockIndex(0)
+    , mNumTailSteps(mPartitionSize / audioSettings.frameSize)
+    , mTailStep(0)
+    , mTailNumChannels(effectSettings.numChannels)
+    , mTailWorkItem(0)
+    , mTailWorkDone(0)
+    , mTailFFTCost(0)
 {
-    mPrevFFTIR = ipl::make_unique<OverlapSaveFIR>(mNumChannels, mIRSize, mFrameSize);
+    if (mHalfPrecision)
+    {
+        mHalfFFTDryBlocks.resize(mNumHeadBlocks, mFFT.numComplexSamples);
+        mFFTDryBlock.resize(mFFT.numComplexSamples);
+    }
+    else
+    {
+        mFFTDryBlocks.resize(mNumHeadBlocks, mFFT.numComplexSamples);
+    }
+
+    mPrevFFTIR = ipl::make_unique<OverlapSaveFIR>(mNumChannels, mIRSize, mFrameSize, mPartitionSize, mHalfPrecision);
+
+    if (mNumTailBlocks > 0)
+    {
+        mTailFFT = ipl::make_unique<FFT>(2 * mPartitionSize);
+
+        mTailInput.resize(mTailFFT->numRealSamples);
+        mTailDry.resize(mTailFFT->numRealSamples);
+        if (mHalfPrecision)
+        {
+            mHalfTailFFTDryBlocks.resize(mNumTailBlocks, mTailFFT->numComplexSamples);
+            mTailFFTDryBlock.resize(mTailFFT->numComplexSamples);
+        }
+        else
+        {
+            mTailFFTDryBlocks.resize(mNumTailBlocks, mTailFFT->numComplexSamples);
+        }
+
+        mTailFFTWet.resize(mNumChannels, mTailFFT->numComplexSamples);
+        mTailWet.resize(mNumChannels, mTailFFT->numRealSamples);
+        mTailOutput.resize(mNumChannels, mPartitionSize);
+        mTailOutputBlock.resize(mFFT.numRealSamples);
+        mTailFFTOutputBlock.resize(mFFT.numComplexSamples);
+
+        // An FFT of size n takes roughly n log n operations, compared to roughly n operations for a complex
+        // multiply-accumulate with n / 2 bins.
+        mTailFFTCost = std::max(1, static_cast<int>(log2f(static_cast<float>(mTailFFT->numRealSamples))) / 2);
+    }
 
     reset();
 }
@@ -131,10 +324,44 @@ OverlapSaveConvolutionEffect::OverlapSaveConvolutionEffect(const AudioSettings&
 void OverlapSaveConvolutionEffect::reset()
 {
     mDryBlock.zero();
-    mFFTDryBlocks.zero();
+
+    if (mHalfPrecision)
+    {
+        memset(mHalfFFTDryBlocks.flatData(), 0, mHalfFFTDryBlocks.totalSize() * sizeof(complexh_t));
+    }
+    else
+    {
+        mFFTDryBlocks.zero();
+    }
+
     mDryBlockIndex = 0;
     mNumTailBlocksRemaining = 0;
     mPrevFFTIR->reset();
+
+    if (mNumTailBlocks > 0)
+    {
+        mTailInput.zero();
+        mTailDry.zero();
+        if (mHalfPrecision)
+        {
+            memset(mHalfTailFFTDryBlocks.flatData(), 0, mHalfTailFFTDryBlocks.totalSize() * sizeof(complexh_t));
+        }
+        else
+        {
+            mTailFFTDryBlocks.zero();
+        }
+
+        mTailFFTWet.zero();
+        mTailWet.zero();
+        mTailOutput.zero();
+        mTailOutputBlock.zero();
+    }
+
+    mTailDryBlockIndex = 0;
+    mTailStep = 0;
+    mTailNumChannels = mNumChannels;
+    mTailWorkItem = 0;
+    mTailWorkDone = 0;
 }
 
 AudioEffectState OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectParams& params,
@@ -196,18 +423,9 @@ AudioEffectState OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutio
 bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectParams& params,
                                          const AudioBuffer& in)
 {
-    memcpy(&mDryBlock[0], &mDryBlock[mFrameSize], mFrameSize * sizeof(float));
-    memcpy(&mDryBlock[mFrameSize], in[0], mFrameSize * sizeof(float));
+    addDryBlock(in[0]);
 
-    --mDryBlockIndex;
-    if (mDryBlockIndex < 0)
-    {
-        mDryBlockIndex = static_cast<int>(mFFTDryBlocks.size(0)) - 1;
-    }
-
-    mFFT.applyForward(mDryBlock.data(), mFFTDryBlocks[mDryBlockIndex]);
-
-    auto numBlocks = OverlapSaveConvolutionEffect::numBlocks(mFrameSize, mIRSize);
+    auto numBlocks = mNumHeadBlocks;
 
     auto crossfade = params.fftIR->updateReadBuffer();
     if (crossfade)
@@ -217,8 +435,8 @@ bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectParam
         {
             for (auto j = 0; j < numBlocks; ++j)
             {
-                auto index = static_cast<int>((mDryBlockIndex + j) % mFFTDryBlocks.size(0));
-                ArrayMath::multiplyAccumulate(static_cast<int>(mFFTDryBlocks.size(1)), mFFTDryBlocks[index], (*params.fftIR->readBuffer)[i][j], mFFTWet[i]);
+                auto index = (mDryBlockIndex + j) % mNumHeadBlocks;
+                multiplyAccumulate(index, *params.fftIR->readBuffer, i, j, mFFTWet[i]);
             }
         }
 
@@ -227,8 +445,8 @@ bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectParam
         {
             for (auto j = 0; j < numBlocks; ++j)
             {
-                auto index = static_cast<int>((mDryBlockIndex + j) % mFFTDryBlocks.size(0));
-                ArrayMath::multiplyAccumulate(static_cast<int>(mFFTDryBlocks.size(1)), mFFTDryBlocks[index], (*mPrevFFTIR)[i][j], mPrevFFTWet[i]);
+                auto index = (mDryBlockIndex + j) % mNumHeadBlocks;
+                multiplyAccumulate(index, *mPrevFFTIR, i, j, mPrevFFTWet[i]);
             }
         }
 
@@ -241,13 +459,15 @@ bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectParam
         {
             for (auto j = 0; j < numBlocks; ++j)
             {
-                auto index = static_cast<int>((mDryBlockIndex + j) % mFFTDryBlocks.size(0));
-                ArrayMath::multiplyAccumulate(static_cast<int>(mFFTDryBlocks.size(1)), mFFTDryBlocks[index], (*mPrevFFTIR)[i][j], mFFTWet[i]);
+                auto index = (mDryBlockIndex + j) % mNumHeadBlocks;
+                multiplyAccumulate(index, *mPrevFFTIR, i, j, mFFTWet[i]);
             }
         }
     }
 
-    mNumTailBlocksRemaining = numBlocks - 1;
+    applyTail(in[0], params.numChannels, crossfade);
+
+    mNumTailBlocksRemaining = OverlapSaveConvolutionEffect::numBlocks(mFrameSize, mIRSize) - 1;
 
     return crossfade;
 }
@@ -293,18 +513,9 @@ AudioEffectState OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutio
 
 bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectDirectParams& params, const AudioBuffer& in)
 {
-    memcpy(&mDryBlock[0], &mDryBlock[mFrameSize], mFrameSize * sizeof(float));
-    memcpy(&mDryBlock[mFrameSize], in[0], mFrameSize * sizeof(float));
-
-    --mDryBlockIndex;
-    if (mDryBlockIndex < 0)
-    {
-        mDryBlockIndex = static_cast<int>(mFFTDryBlocks.size(0)) - 1;
-    }
-
-    mFFT.applyForward(mDryBlock.data(), mFFTDryBlocks[mDryBlockIndex]);
+    addDryBlock(in[0]);
 
-    auto numBlocks = OverlapSaveConvolutionEffect::numBlocks(mFrameSize, mIRSize);
+    auto numBlocks = mNumHeadBlocks;
 
     auto crossfade = params.fftIRUpdated;
     if (crossfade)
@@ -314,8 +525,8 @@ bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectDirec
         {
             for (auto j = 0; j < numBlocks; ++j)
             {
-                auto index = static_cast<int>((mDryBlockIndex + j) % mFFTDryBlocks.size(0));
-                ArrayMath::multiplyAccumulate(static_cast<int>(mFFTDryBlocks.size(1)), mFFTDryBlocks[index], (*params.fftIR)[i][j], mFFTWet[i]);
+                auto index = (mDryBlockIndex + j) % mNumHeadBlocks;
+                multiplyAccumulate(index, *params.fftIR, i, j, mFFTWet[i]);
             }
         }
 
@@ -324,8 +535,8 @@ bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectDirec
         {
             for (auto j = 0; j < numBlocks; ++j)
             {
-                auto index = static_cast<int>((mDryBlockIndex + j) % mFFTDryBlocks.size(0));
-                ArrayMath::multiplyAccumulate(static_cast<int>(mFFTDryBlocks.size(1)), mFFTDryBlocks[index], (*mPrevFFTIR)[i][j], mPrevFFTWet[i]);
+                auto index = (mDryBlockIndex + j) % mNumHeadBlocks;
+                multiplyAccumulate(index, *mPrevFFTIR, i, j, mPrevFFTWet[i]);
             }
         }
 
@@ -338,13 +549,15 @@ bool OverlapSaveConvolutionEffect::apply(const OverlapSaveConvolutionEffectDirec
         {
             for (auto j = 0; j < numBlocks; ++j)
             {
-                auto index = static_cast<int>((mDryBlockIndex + j) % mFFTDryBlocks.size(0));
-                ArrayMath::multiplyAccumulate(static_cast<int>(mFFTDryBlocks.size(1)), mFFTDryBlocks[index], (*mPrevFFTIR)[i][j], mFFTWet[i]);
+                auto index = (mDryBlockIndex + j) % mNumHeadBlocks;
+                multiplyAccumulate(index, *mPrevFFTIR, i, j, mFFTWet[i]);
             }
         }
     }
 
-    mNumTailBlocksRemaining = numBlocks - 1;
+    applyTail(in[0], params.numChannels, crossfade);
+
+    mNumTailBlocksRemaining = OverlapSaveConvolutionEffect::numBlocks(mFrameSize, mIRSize) - 1;
 
     return crossfade;
 }
@@ -375,22 +588,215 @@ AudioEffectState OverlapSaveConvolutionEffect::tail(OverlapSaveConvolutionMixer&
     return (mNumTailBlocksRemaining > 0) ? AudioEffectState::TailRemaining : AudioEffectState::TailComplete;
 }
 
+void OverlapSaveConvolutionEffect::addDryBlock(const float* in)
+{
+    memcpy(&mDryBlock[0], &mDryBlock[mFrameSize], mFrameSize * sizeof(float));
+
+    if (in)
+    {
+        memcpy(&mDryBlock[mFrameSize], in, mFrameSize * sizeof(float));
+    }
+    else
+    {
+        memset(&mDryBlock[mFrameSize], 0, mFrameSize * sizeof(float));
+    }
+
+    --mDryBlockIndex;
+    if (mDryBlockIndex < 0)
+    {
+        mDryBlockIndex = mNumHeadBlocks - 1;
+    }
+
+    if (mHalfPrecision)
+    {
+        mFFT.applyForward(mDryBlock.data(), mFFTDryBlock.data());
+        ArrayMath::convert(mFFT.numComplexSamples, mFFTDryBlock.data(), mHalfFFTDryBlocks[mDryBlockIndex]);
+    }
+    else
+    {
+        mFFT.applyForward(mDryBlock.data(), mFFTDryBlocks[mDryBlockIndex]);
+    }
+}
+
+void OverlapSaveConvolutionEffect::multiplyAccumulate(int dryBlockIndex,
+                                                      const OverlapSaveFIR& fftIR,
+                                                      int channel,
+                                                      int block,
+                                                      complex_t* accum)
+{
+    auto size = mFFT.numComplexSamples;
+
+    if (mHalfPrecision && fftIR.isHalfPrecision())
+    {
+        ArrayMath::multiplyAccumulate(size, mHalfFFTDryBlocks[dryBlockIndex], fftIR.half(channel)[block], accum);
+    }
+    else if (mHalfPrecision)
+    {
+        ArrayMath::multiplyAccumulate(size, fftIR[channel][block], mHalfFFTDryBlocks[dryBlockIndex], accum);
+    }
+    else if (fftIR.isHalfPrecision())
+    {
+        ArrayMath::multiplyAccumulate(size, mFFTDryBlocks[dryBlockIndex], fftIR.half(channel)[block], accum);
+    }
+    else
+    {
+        ArrayMath::multiplyAccumulate(size, mFFTDryBlocks[dryBlockIndex], fftIR[channel][block], accum);
+    }
+}
+
+void OverlapSaveConvolutionEffect::multiplyAccumulateTail(int dryBlockIndex,
+                                                          const OverlapSaveFIR& fftIR,
+                                                          int channel,
+                                                          int block,
+                                                          complex_t* accum)
+{
+    auto size = mTailFFT->numComplexSamples;
+
+    if (mHalfPrecision && fftIR.isHalfPrecision())
+    {
+        ArrayMath::multiplyAccumulate(size, mHalfTailFFTDryBlocks[dryBlockIndex], fftIR.halfTail(channel)[block], accum);
+    }
+    else if (mHalfPrecision)
+    {
+        ArrayMath::multiplyAccumulate(size, fftIR.tail(channel)[block], mHalfTailFFTDryBlocks[dryBlockIndex], accum);
+    }
+    else if (fftIR.isHalfPrecision())
+    {
+        ArrayMath::multiplyAccumulate(size, mTailFFTDryBlocks[dryBlockIndex], fftIR.halfTail(channel)[block], accum);
+    }
+    else
+    {
+        ArrayMath::multiplyAccumulate(size, mTailFFTDryBlocks[dryBlockIndex], fftIR.tail(channel)[block], accum);
+    }
+}
+
+void OverlapSaveConvolutionEffect::applyTail(const float* in,
+                                             int numChannels,
+                                             bool crossfade)
+{
+    if (mNumTailBlocks <= 0)
+        return;
+
+    PROFILE_FUNCTION();
+
+    if (in)
+    {
+        memcpy(&mTailInput[mPartitionSize + mTailStep * mFrameSize], in, mFrameSize * sizeof(float));
+    }
+    else
+    {
+        memset(&mTailInput[mPartitionSize + mTailStep * mFrameSize], 0, mFrameSize * sizeof(float));
+    }
+
+    // Convolving the previous partition of input with the tail of the IR takes a forward FFT, a multiply-accumulate
+    // for each tail block of each channel, and an inverse FFT for each channel. Do just enough of this work in each
+    // frame that the cost is spread evenly, and everything is done by the last frame of the partition. If the IR
+    // changes partway through, the remaining tail blocks are taken from the new IR.
+    auto numTailBlocks = std::min(mNumTailBlocks, mPrevFFTIR->numTailBlocks());
+    auto numMultiplies = mTailNumChannels * numTailBlocks;
+    auto numWorkItems = 1 + numMultiplies + mTailNumChannels;
+    auto totalCost = (1 + mTailNumChannels) * mTailFFTCost + numMultiplies;
+    auto targetCost = (totalCost * (mTailStep + 1)) / mNumTailSteps;
+    if (mTailStep == mNumTailSteps - 1)
+    {
+        targetCost = totalCost;
+    }
+
+    while (mTailWorkItem < numWorkItems && mTailWorkDone < targetCost)
+    {
+        if (mTailWorkItem == 0)
+        {
+            --mTailDryBlockIndex;
+            if (mTailDryBlockIndex < 0)
+            {
+                mTailDryBlockIndex = mNumTailBlocks - 1;
+            }
+
+            if (mHalfPrecision)
+            {
+                mTailFFT->applyForward(mTailDry.data(), mTailFFTDryBlock.data());
+                ArrayMath::convert(mTailFFT->numComplexSamples, mTailFFTDryBlock.data(), mHalfTailFFTDryBlocks[mTailDryBlockIndex]);
+            }
+            else
+            {
+                mTailFFT->applyForward(mTailDry.data(), mTailFFTDryBlocks[mTailDryBlockIndex]);
+            }
+            mTailWorkDone += mTailFFTCost;
+        }
+        else if (mTailWorkItem <= numMultiplies)
+        {
+            auto i = (mTailWorkItem - 1) / numTailBlocks;
+            auto j = (mTailWorkItem - 1) % numTailBlocks;
+            auto index = (mTailDryBlockIndex + j) % mNumTailBlocks;
+            multiplyAccumulateTail(index, *mPrevFFTIR, i, j, mTailFFTWet[i]);
+            mTailWorkDone += 1;
+        }
+        else
+        {
+            auto i = mTailWorkItem - 1 - numMultiplies;
+            mTailFFT->applyInverse(mTailFFTWet[i], mTailWet[i]);
+            mTailWorkDone += mTailFFTCost;
+        }
+
+        ++mTailWorkItem;
+    }
+
+    // The tail output for this frame is added to the wet spectra as if it had come from one more head block, so it
+    // passes through the same inverse FFT, crossfade, and mixing as the rest of the output.
+    for (auto i = 0; i < numChannels; ++i)
+    {
+        memcpy(&mTailOutputBlock[mFrameSize], &mTailOutput[i][mTailStep * mFrameSize], mFrameSize * sizeof(float));
+        mFFT.applyForward(mTailOutputBlock.data(), mTailFFTOutputBlock.data());
+
+        ArrayMath::add(mFFT.numComplexSamples, mFFTWet[i], mTailFFTOutputBlock.data(), mFFTWet[i]);
+        if (crossfade)
+        {
+            ArrayMath::add(mFFT.numComplexSamples, mPrevFFTWet[i], mTailFFTOutputBlock.data(), mPrevFFTWet[i]);
+        }
+    }
+
+    ++mTailStep;
+    if (mTailStep >= mNumTailSteps)
+    {
+        // The second half of each channel's overlap-save output is played back over the next partition.
+        mTailOutput.zero();
+        for (auto i = 0; i < mTailNumChannels; ++i)
+        {
+            memcpy(mTailOutput[i], &mTailWet[i][mPartitionSize], mPartitionSize * sizeof(float));
+        }
+
+        memcpy(mTailDry.data(), mTailInput.data(), 2 * mPartitionSize * sizeof(float));
+        memcpy(&mTailInput[0], &mTailInput[mPartitionSize], mPartitionSize * sizeof(float));
+
+        mTailFFTWet.zero();
+        mTailNumChannels = numChannels;
+        mTailStep = 0;
+        mTailWorkItem = 0;
+        mTailWorkDone = 0;
+    }
+}
+
 void OverlapSaveConvolutionEffect::tail()
 {
-    mFFTWet.zero();
+    // Keep running silence through the usual processing. Blocks of the delay line that have only ever seen silence
+    // contribute nothing, so their multiply-accumulates are skipped.
+    addDryBlock(nullptr);
 
     auto numBlocks = OverlapSaveConvolutionEffect::numBlocks(mFrameSize, mIRSize);
-    auto offset = numBlocks - mNumTailBlocksRemaining;
+    auto numSilentBlocks = std::max(0, numBlocks - 1 - mNumTailBlocksRemaining);
 
+    mFFTWet.zero();
     for (auto i = 0; i < mNumChannels; ++i)
     {
-        for (auto j = 0; j < mNumTailBlocksRemaining; ++j)
+        for (auto j = numSilentBlocks; j < mNumHeadBlocks; ++j)
         {
-            auto index = static_cast<int>((mDryBlockIndex + j) % mFFTDryBlocks.size(0));
-            ArrayMath::multiplyAccumulate(static_cast<int>(mFFTDryBlocks.size(1)), mFFTDryBlocks[index], (*mPrevFFTIR)[i][j + offset], mFFTWet[i]);
+            auto index = (mDryBlockIndex + j) % mNumHeadBlocks;
+            multiplyAccumulate(index, *mPrevFFTIR, i, j, mFFTWet[i]);
         }
     }
 
+    applyTail(nullptr, mNumChannels, false);
+
     mNumTailBlocksRemaining--;
 }
 
@@ -400,6 +806,45 @@ int OverlapSaveConvolutionEffect::numBlocks(int frameSize,
     return static_cast<int>(ceilf(static_cast<float>(irSize) / static_cast<float>(frameSize)));
 }
 
+int OverlapSaveConvolutionEffect::partitionSize(int frameSize,
+                                                int requestedPartitionSize)
+{
+    if (requestedPartitionSize <= 0)
+    {
+        requestedPartitionSize = kDefaultPartitionSize;
+    }
+
+    auto partitionSize = frameSize;
+    while (partitionSize < requestedPartitionSize)
+    {
+        partitionSize *= 2;
+    }
+
+    return partitionSize;
+}
+
+int OverlapSaveConvolutionEffect::numHeadBlocks(int frameSize,
+                                                int partitionSize,
+                                                int irSize)
+{
+    auto numBlocks = OverlapSaveConvolutionEffect::numBlocks(frameSize, irSize);
+
+    if (partitionSize <= frameSize)
+        return numBlocks;
+
+    return std::min(numBlocks, (2 * partitionSize) / frameSize);
+}
+
+int OverlapSaveConvolutionEffect::numTailBlocks(int frameSize,
+                                                int partitionSize,
+                                                int irSize)
+{
+    if (partitionSize <= frameSize || irSize <= 2 * partitionSize)
+        return 0;
+
+    return OverlapSaveConvolutionEffect::numBlocks(partitionSize, irSize - 2 * partitionSize);
+}
+
 
 // --------------------------------------------------------------------------------------------------------------------
 // OverlapSaveConvolutionMixer
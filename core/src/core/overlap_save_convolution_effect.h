@@ -18,6 +18,7 @@
 
 #include "audio_buffer.h"
 #include "fft.h"
+#include "half.h"
 #include "impulse_response.h"
 #include "triple_buffer.h"
 
@@ -27,26 +28,43 @@ namespace ipl {
 // OverlapSaveFIR
 // --------------------------------------------------------------------------------------------------------------------
 
+// A partitioned IR in the frequency domain. The start of the IR is split into blocks of frameSize samples. If the
+// partition size is larger than the frame size, everything after the first 2 * partitionSize samples is instead
+// split into blocks of partitionSize samples (the "tail" blocks). A partition size of 0 selects a default based on
+// the frame size (see OverlapSaveConvolutionEffect::partitionSize).
+//
+// If half precision is enabled, the spectra are only stored in the half-precision arrays (accessed using half() and
+// halfTail()), and the single-precision arrays are empty.
 class OverlapSaveFIR
 {
 public:
     OverlapSaveFIR(int numChannels,
                    int irSize,
-                   int frameSize);
+                   int frameSize,
+                   int partitionSize = 0,
+                   bool halfPrecision = OverlapSaveFIR::sEnableHalfPrecision);
+
+    // Default storage precision for newly-created OverlapSaveFIR and OverlapSaveConvolutionEffect objects.
+    static bool sEnableHalfPrecision;
+
+    bool isHalfPrecision() const
+    {
+        return mHalfPrecision;
+    }
 
     int numChannels() const
     {
-        return static_cast<int>(mData.size(0));
+        return mNumChannels;
     }
 
     int numBlocks() const
     {
-        return static_cast<int>(mData.size(1));
+        return mNumBlocks;
     }
 
     int numSpectrumSamples() const
     {
-        return static_cast<int>(mData.size(2));
+        return mNumSpectrumSamples;
     }
 
     complex_t* const* const* data()
@@ -69,6 +87,49 @@ public:
         return mData[i];
     }
 
+    complexh_t* const* half(int i)
+    {
+        return mHalfData[i];
+    }
+
+    const complexh_t* const* half(int i) const
+    {
+        return mHalfData[i];
+    }
+
+    int numTailBlocks() const
+    {
+        return mNumTailBlocks;
+    }
+
+    int numTailSpectrumSamples() const
+    {
+        return mNumTailSpectrumSamples;
+    }
+
+    complex_t* const* tail(int i)
+    {
+        return mTailData[i];
+    }
+
+    const complex_t* const* tail(int i) const
+    {
+        return mTailData[i];
+    }
+
+    complexh_t* const* halfTail(int i)
+    {
+        return mHalfTailData[i];
+    }
+
+    const complexh_t* const* halfTail(int i) const
+    {
+        return mHalfTailData[i];
+    }
+
+    // Total size (in bytes) of the stored spectra.
+    size_t sizeInBytes() const;
+
     void reset();
 
     static void copy(const OverlapSaveFIR& src, OverlapSaveFIR& dst);
@@ -76,7 +137,16 @@ public:
     static void swap(OverlapSaveFIR& a, OverlapSaveFIR& b);
 
 private:
-    Array<complex_t, 3> mData;
+    bool mHalfPrecision;
+    int mNumChannels;
+    int mNumBlocks;
+    int mNumSpectrumSamples;
+    int mNumTailBlocks;
+    int mNumTailSpectrumSamples;
+    Array<complex_t, 3> mData; // #channels * #blocks * #spectrumsamples.
+    Array<complex_t, 3> mTailData; // #channels * #tailblocks * #tailspectrumsamples. Empty if there are no tail blocks.
+    Array<complexh_t, 3> mHalfData; // #channels * #blocks * #spectrumsamples.
+    Array<complexh_t, 3> mHalfTailData; // #channels * #tailblocks * #tailspectrumsamples.
 };
 
 
@@ -87,7 +157,8 @@ private:
 class OverlapSavePartitioner
 {
 public:
-    OverlapSavePartitioner(int frameSize);
+    OverlapSavePartitioner(int frameSize,
+                           int partitionSize = 0);
 
     void partition(const ImpulseResponse& ir,
                    int numChannels,
@@ -96,8 +167,12 @@ public:
 
 private:
     int mFrameSize;
+    int mPartitionSize;
     FFT mFFT;
+    FFT mTailFFT;
     Array<float> mTempIRBlock;
+    Array<float> mTempIRTailBlock;
+    Array<complex_t> mTempSpectrum; // Used when partitioning into a half-precision OverlapSaveFIR.
 };
 
 
@@ -109,15 +184,18 @@ struct OverlapSaveConvolutionEffectSettings
 {
     int numChannels = 0;
     int irSize = 0;
+    int partitionSize = 0; // Must match the partition size of the OverlapSaveFIRs passed to the effect.
 
     OverlapSaveConvolutionEffectSettings()
         : numChannels(0)
         , irSize(0)
+        , partitionSize(0)
     {}
 
-    OverlapSaveConvolutionEffectSettings(int numChannels, int irSize)
+    OverlapSaveConvolutionEffectSettings(int numChannels, int irSize, int partitionSize = 0)
         : numChannels(numChannels)
         , irSize(irSize)
+        , partitionSize(partitionSize)
     {}
 };
 
@@ -143,6 +221,12 @@ struct OverlapSaveConvolutionMixerParams
 
 class OverlapSaveConvolutionMixer;
 
+// Uniformly-partitioned overlap-save convolution, with partitions equal to the frame size. When the partition size
+// is larger than the frame size, the IR is instead split into a head of frame-sized partitions, covering the first
+// 2 * partitionSize samples, and a tail of large partitions. The tail is convolved one partition of input at a time,
+// and the FFTs and multiply-accumulates needed for each partition are spread evenly over the partitionSize /
+// frameSize frames that follow it. The result is output exactly on time, so small frame sizes can be used with long
+// IRs without adding latency, and without any one frame having to do all the work for a large partition.
 class OverlapSaveConvolutionEffect
 {
 public:
@@ -172,13 +256,37 @@ public:
     static int numBlocks(int frameSize,
                          int irSize);
 
+    // Partition size to use for the tail of the IR. If requestedPartitionSize is 0, returns kDefaultPartitionSize
+    // for frame sizes smaller than that, and the frame size otherwise. The result is always the frame size times a
+    // power of two.
+    static int partitionSize(int frameSize,
+                             int requestedPartitionSize = 0);
+
+    // Number of frame-sized blocks in the head of the IR.
+    static int numHeadBlocks(int frameSize,
+                             int partitionSize,
+                             int irSize);
+
+    // Number of partition-sized blocks in the tail of the IR.
+    static int numTailBlocks(int frameSize,
+                             int partitionSize,
+                             int irSize);
+
+    static const int kDefaultPartitionSize = 1024;
+
 private:
     int mFrameSize;
     int mIRSize;
     int mNumChannels;
+    int mPartitionSize;
+    int mNumHeadBlocks;
+    int mNumTailBlocks;
+    bool mHalfPrecision; // If true, the delay lines are stored in half precision.
     FFT mFFT;
     Array<float> mDryBlock;
-    Array<complex_t, 2> mFFTDryBlocks;
+    Array<complex_t, 2> mFFTDryBlocks; // #blocks * #spectrumsamples. Empty if using half precision.
+    Array<complexh_t, 2> mHalfFFTDryBlocks; // #blocks * #spectrumsamples. Empty unless using half precision.
+    Array<complex_t> mFFTDryBlock; // #spectrumsamples.
     int mDryBlockIndex;
     Array<complex_t, 2> mFFTWet;
     Array<complex_t, 2> mPrevFFTWet;
@@ -186,10 +294,50 @@ private:
     Array<float, 2> mPrevWet;
     int mNumTailBlocksRemaining;
     unique_ptr<OverlapSaveFIR> mPrevFFTIR;
+    unique_ptr<FFT> mTailFFT; // #2*partitionsize -> #tailspectrumsamples. Null if there are no tail blocks.
+    Array<float> mTailInput; // Previous partition of input, followed by the partition being filled in.
+    Array<float> mTailDry; // Input window for the partition whose convolution is in progress.
+    Array<complex_t, 2> mTailFFTDryBlocks; // #tailblocks * #tailspectrumsamples. Empty if using half precision.
+    Array<complexh_t, 2> mHalfTailFFTDryBlocks; // #tailblocks * #tailspectrumsamples. Empty unless using half precision.
+    Array<complex_t> mTailFFTDryBlock; // #tailspectrumsamples.
+    int mTailDryBlockIndex;
+    Array<complex_t, 2> mTailFFTWet; // #channels * #tailspectrumsamples.
+    Array<float, 2> mTailWet; // #channels * #2*partitionsize.
+    Array<float, 2> mTailOutput; // Tail output being played back. #channels * #partitionsize.
+    Array<float> mTailOutputBlock; // #2*framesize.
+    Array<complex_t> mTailFFTOutputBlock; // #spectrumsamples.
+    int mNumTailSteps; // Number of frames per partition.
+    int mTailStep; // Index of the current frame within the current partition.
+    int mTailNumChannels; // Number of channels being convolved for the partition in progress.
+    int mTailWorkItem; // Index of the next unit of work for the partition in progress.
+    int mTailWorkDone; // Cost of the work done so far for the partition in progress.
+    int mTailFFTCost; // Cost of an FFT of size 2*partitionsize, relative to a multiply-accumulate of a tail block.
 
     bool apply(const OverlapSaveConvolutionEffectParams& params,
                const AudioBuffer& in);
 
+    // Shifts a frame of input (or silence, if in is null) into the head's delay line.
+    void addDryBlock(const float* in);
+
+    // Multiply-accumulates a block of the head's delay line with a block of the head of an IR.
+    void multiplyAccumulate(int dryBlockIndex,
+                            const OverlapSaveFIR& fftIR,
+                            int channel,
+                            int block,
+                            complex_t* accum);
+
+    // Multiply-accumulates a block of the tail's delay line with a block of the tail of an IR.
+    void multiplyAccumulateTail(int dryBlockIndex,
+                                const OverlapSaveFIR& fftIR,
+                                int channel,
+                                int block,
+                                complex_t* accum);
+
+    // Advances the tail convolution by one frame, and adds the tail's output for this frame to the wet spectra.
+    void applyTail(const float* in,
+                   int numChannels,
+                   bool crossfade);
+
     void tail();
 };
 
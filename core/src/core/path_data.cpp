@@ -24,50 +24,77 @@ namespace ipl {
 // SoundPath
 // --------------------------------------------------------------------------------------------------------------------
 
-SoundPath::SoundPath(const ProbePath& probePath,
-                     const ProbeBatch& probes)
-    : SoundPath()
+// Initializes a sound path from a probe path, given a function that returns the center of any probe in the path.
+template <typename CenterFunction>
+static void initSoundPath(const ProbePath& probePath,
+                          CenterFunction center,
+                          SoundPath& soundPath)
 {
     if (probePath.valid)
     {
         if (probePath.nodes.empty())
         {
-            direct = true;
+            soundPath.direct = true;
         }
         else
         {
-            firstProbe = probePath.nodes.front();
-            lastProbe = probePath.nodes.back();
+            soundPath.firstProbe = probePath.nodes.front();
+            soundPath.lastProbe = probePath.nodes.back();
 
             if (probePath.nodes.size() >= 2)
             {
-                probeAfterFirst = probePath.nodes[1];
-                probeBeforeLast = probePath.nodes[probePath.nodes.size() - 2];
+                soundPath.probeAfterFirst = probePath.nodes[1];
+                soundPath.probeBeforeLast = probePath.nodes[probePath.nodes.size() - 2];
             }
 
             for (auto i = 1u; i < probePath.nodes.size(); ++i)
             {
-                const auto& prevPoint = probes[probePath.nodes[i - 1]].influence.center;
-                const auto& curPoint = probes[probePath.nodes[i]].influence.center;
+                const auto& prevPoint = center(probePath.nodes[i - 1]);
+                const auto& curPoint = center(probePath.nodes[i]);
 
-                distanceInternal += (curPoint - prevPoint).length();
+                soundPath.distanceInternal += (curPoint - prevPoint).length();
             }
 
             for (auto i = 1u; i < probePath.nodes.size() - 1; ++i)
             {
-                const auto& prevPoint = probes[probePath.nodes[i - 1]].influence.center;
-                const auto& curPoint = probes[probePath.nodes[i]].influence.center;
-                const auto& nextPoint = probes[probePath.nodes[i + 1]].influence.center;
+                const auto& prevPoint = center(probePath.nodes[i - 1]);
+                const auto& curPoint = center(probePath.nodes[i]);
+                const auto& nextPoint = center(probePath.nodes[i + 1]);
 
                 auto prevDir = Vector3f::unitVector(curPoint - prevPoint);
                 auto nextDir = Vector3f::unitVector(nextPoint - curPoint);
 
-                deviationInternal += Vector3f::angleBetween(prevDir, nextDir);
+                soundPath.deviationInternal += Vector3f::angleBetween(prevDir, nextDir);
             }
         }
     }
 }
 
+// Total distance along a sound path from the start probe to the end probe, given the centers of all probes.
+static float soundPathDistance(const SoundPath& soundPath,
+                               const vector<Vector3f>& probeCenters,
+                               int start,
+                               int end)
+{
+    if (soundPath.direct)
+        return (probeCenters[end] - probeCenters[start]).length();
+
+    auto result = soundPath.distanceInternal;
+    result += (probeCenters[soundPath.firstProbe] - probeCenters[start]).length();
+    result += (probeCenters[end] - probeCenters[soundPath.lastProbe]).length();
+    return result;
+}
+
+SoundPath::SoundPath(const ProbePath& probePath,
+                     const ProbeBatch& probes)
+    : SoundPath()
+{
+    initSoundPath(probePath, [&probes](int index) -> const Vector3f&
+    {
+        return probes[index].influence.center;
+    }, *this);
+}
+
 float SoundPath::distance(const ProbeBatch& probes,
                           int start,
                           int end) const
@@ -189,192 +216,376 @@ Vector3f SoundPath::toVirtualSource(const ProbeBatch& probes,
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-// BakedPathData
+// SoundPathTable
 // --------------------------------------------------------------------------------------------------------------------
 
-BakedPathData::BakedPathData(const IScene& scene,
-                             const ProbeBatch& probes,
-                             int numSamples,
-                             float radius,
-                             float threshold,
-                             float visRange,
-                             float visRangeRealTime,
-                             float pathRange,
-                             bool asymmetricVisRange,
-                             const Vector3f& down,
-                             bool pruneVisGraph,
-                             int numThreads,
-                             ThreadPool& threadPool,
-                             std::atomic<bool>& cancel,
-                             ProgressCallback progressCallback,
-                             void* callbackUserData)
-    : mBakedPathRefs(probes.numProbes(), probes.numProbes())
+SoundPathTable::SoundPathTable()
+    : mNumPaths(0)
 {
-    // First, generate the visibility graph.
-    ProbeVisibilityTester visTester(numSamples, asymmetricVisRange, down);
+    insert(SoundPath{});
+}
 
-    JobGraph jobGraph{};
-    mVisGraph = ipl::make_unique<ProbeVisibilityGraph>(scene, probes, visTester, radius, threshold, visRange,
-                                                       numThreads, jobGraph, cancel, progressCallback, callbackUserData);
+int SoundPathTable::insert(const SoundPath& soundPath)
+{
+    auto& shard = mShards[Hash{}(soundPath) % kNumShards];
 
-    threadPool.process(jobGraph, [progressCallback, callbackUserData](float percentComplete) { progressCallback(percentComplete, callbackUserData); });
+    std::lock_guard<std::mutex> lock(shard.mutex);
 
-    // Next, using multiple threads, calculate shortest paths between every pair of probes.
-    PathFinder pathFinder(probes, numThreads);
-    Array<ProbePath, 2> probePaths(probes.numProbes(), probes.numProbes());
+    auto it = shard.ids.find(soundPath);
+    if (it != shard.ids.end())
+        return it->second;
 
-    if (cancel)
+    auto id = mNumPaths++;
+    shard.ids[soundPath] = id;
+    return id;
+}
+
+void SoundPathTable::finalize(Array<SoundPath>& uniquePaths,
+                              vector<int>& remap) const
+{
+    auto numPaths = static_cast<int>(mNumPaths);
+
+    vector<SoundPath> paths(numPaths);
+    for (const auto& shard : mShards)
     {
-        cancel = false;
-        return;
+        for (const auto& entry : shard.ids)
+        {
+            paths[entry.second] = entry.first;
+        }
     }
 
-    jobGraph.reset();
+    vector<int> order(numPaths);
+    std::iota(order.begin(), order.end(), 0);
 
-    for (auto i = 0; i < probes.numProbes(); i++)
+    std::sort(order.begin(), order.end(), [&paths](int lhsId, int rhsId)
     {
-        jobGraph.addJob([this, i, &scene, &probes, &probePaths, &pathFinder, radius, threshold, pathRange](int threadIndex, std::atomic<bool>&)
-        {
-            PROFILE_ZONE("BakedPathData::bakeJob");
+        const auto& lhs = paths[lhsId];
+        const auto& rhs = paths[rhsId];
 
-            for (auto j = 0; j < probes.numProbes(); ++j)
-            {
-                probePaths[i][j].nodes.clear();
-            }
+        if (lhs.isValid() != rhs.isValid())
+            return !lhs.isValid();
 
-            pathFinder.findAllShortestPaths(scene, probes, *mVisGraph, i, radius, threshold, pathRange, threadIndex, probePaths[i]);
-        });
-    }
+        return std::make_tuple(lhs.direct, lhs.firstProbe, lhs.lastProbe, lhs.probeAfterFirst, lhs.probeBeforeLast,
+                               lhs.distanceInternal, lhs.deviationInternal) <
+               std::make_tuple(rhs.direct, rhs.firstProbe, rhs.lastProbe, rhs.probeAfterFirst, rhs.probeBeforeLast,
+                               rhs.distanceInternal, rhs.deviationInternal);
+    });
 
-    threadPool.process(jobGraph, [progressCallback, callbackUserData](float percentComplete) { progressCallback(percentComplete, callbackUserData); });
+    uniquePaths.resize(numPaths);
+    remap.resize(numPaths);
 
-    // Remove all data with j > i, since they can be reconstructed from the data with j < i due to symmetry.
-    ProbePath invalidProbePath;
-    for (auto i = 0; i < probes.numProbes(); ++i)
+    for (auto i = 0; i < numPaths; ++i)
     {
-        for (auto j = i + 1; j < probes.numProbes(); ++j)
-        {
-            probePaths[i][j] = invalidProbePath;
-        }
+        uniquePaths[i] = paths[order[i]];
+        remap[order[i]] = i;
     }
+}
 
-    if (cancel)
-    {
-        cancel = false;
-        return;
-    }
+size_t SoundPathTable::Hash::operator()(const SoundPath& soundPath) const
+{
+    auto hash = static_cast<size_t>(soundPath.direct);
 
-    // Sort the probe paths.
-    auto compareProbePaths = [](const ProbePath& lhs,
-                                const ProbePath& rhs)
+    auto combine = [&hash](size_t value)
     {
-        if (!lhs.valid && rhs.valid)
-            return true;
-
-        return std::lexicographical_compare(lhs.nodes.begin(), lhs.nodes.end(), rhs.nodes.begin(), rhs.nodes.end());
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
     };
 
-    std::sort(probePaths.flatData(), probePaths.flatData() + probePaths.totalSize(), compareProbePaths);
+    combine(std::hash<int>{}(soundPath.firstProbe));
+    combine(std::hash<int>{}(soundPath.lastProbe));
+    combine(std::hash<int>{}(soundPath.probeAfterFirst));
+    combine(std::hash<int>{}(soundPath.probeBeforeLast));
+    combine(std::hash<float>{}(soundPath.distanceInternal));
+    combine(std::hash<float>{}(soundPath.deviationInternal));
 
-    if (cancel)
+    return hash;
+}
+
+bool SoundPathTable::Equal::operator()(const SoundPath& lhs,
+                                       const SoundPath& rhs) const
+{
+    return (lhs.direct == rhs.direct &&
+            lhs.firstProbe == rhs.firstProbe &&
+            lhs.lastProbe == rhs.lastProbe &&
+            lhs.probeAfterFirst == rhs.probeAfterFirst &&
+            lhs.probeBeforeLast == rhs.probeBeforeLast &&
+            lhs.distanceInternal == rhs.distanceInternal &&
+            lhs.deviationInternal == rhs.deviationInternal);
+}
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// PortalSearch
+// --------------------------------------------------------------------------------------------------------------------
+
+void PortalSearch::reset(int numPortals)
+{
+    if (static_cast<int>(costs.size()) != numPortals)
     {
-        cancel = false;
-        return;
+        costs.assign(numPortals, std::numeric_limits<float>::infinity());
+        parents.assign(numPortals, -1);
     }
-
-    // Extract all the unique sound paths. At the end of this process, mUniqueBakedPaths contains the k unique
-    // sound paths, and mBakedPathRefs are n^2 indices (each between 0 and k-1), into the mUniqueBakedPaths
-    // array.
-    SoundPathRef invalidSoundPathRef;
-    for (auto i = 0; i < probes.numProbes(); ++i)
+    else
     {
-        for (auto j = 0; j < probes.numProbes(); ++j)
+        for (auto portal : visitedPortals)
         {
-            mBakedPathRefs[i][j] = invalidSoundPathRef;
+            costs[portal] = std::numeric_limits<float>::infinity();
+            parents[portal] = -1;
         }
     }
 
-    auto areProbePathsEqual = [](const ProbePath& lhs,
-                                 const ProbePath& rhs)
+    visitedPortals.clear();
+    queue.clear();
+}
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// PathBakeParams
+// --------------------------------------------------------------------------------------------------------------------
+
+bool operator==(const PathBakeParams& lhs,
+                const PathBakeParams& rhs)
+{
+    return (lhs.numSamples == rhs.numSamples &&
+            lhs.radius == rhs.radius &&
+            lhs.threshold == rhs.threshold &&
+            lhs.visRange == rhs.visRange &&
+            lhs.visRangeRealTime == rhs.visRangeRealTime &&
+            lhs.pathRange == rhs.pathRange &&
+            lhs.asymmetricVisRange == rhs.asymmetricVisRange &&
+            lhs.down == rhs.down &&
+            lhs.pruneVisGraph == rhs.pruneVisGraph);
+}
+
+bool operator!=(const PathBakeParams& lhs,
+                const PathBakeParams& rhs)
+{
+    return !(lhs == rhs);
+}
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// BakedPathData
+// --------------------------------------------------------------------------------------------------------------------
+
+// Adds a job to a job graph that finds the shortest paths from probe i to every probe with a lower or equal index,
+// and adds them to a shared table. Until the table is finalized, rows contain path ids rather than indices into the
+// table of unique paths. Paths with j > i are not stored, since they can be reconstructed from the paths with j < i
+// due to symmetry.
+static void addBakePathJob(int i,
+                           const ProbeBatch& probes,
+                           const ProbeVisibilityGraph& visGraph,
+                           const PathFinder& pathFinder,
+                           float pathRange,
+                           Array<ProbePath, 2>& rowPaths,
+                           SoundPathTable& soundPaths,
+                           vector<vector<int32_t>>& rowColumns,
+                           vector<vector<int32_t>>& rowPathIds,
+                           JobGraph& jobGraph)
+{
+    jobGraph.addJob([i, &probes, &visGraph, &pathFinder, pathRange, &rowPaths, &soundPaths, &rowColumns, &rowPathIds](int threadIndex, std::atomic<bool>&)
     {
-        if (lhs.valid ^ rhs.valid)
-            return false;
+        PROFILE_ZONE("BakedPathData::bakeJob");
 
-        if (lhs.nodes.size() != rhs.nodes.size())
-            return false;
+        auto numProbes = probes.numProbes();
+        auto* paths = rowPaths[threadIndex];
 
-        for (auto i = 0u; i < lhs.nodes.size(); ++i)
+        for (auto j = 0; j < numProbes; ++j)
         {
-            if (lhs.nodes[i] != rhs.nodes[i])
-                return false;
+            paths[j].nodes.clear();
         }
 
-        return true;
-    };
-
-    if (cancel)
-    {
-        cancel = false;
-        return;
-    }
+        pathFinder.findAllShortestPaths(probes, visGraph, i, pathRange, threadIndex, paths);
 
-    vector<SoundPath> uniqueSoundPaths;
-    for (auto i = 0, index = 0; i < probes.numProbes(); ++i)
-    {
-        for (auto j = 0; j < probes.numProbes(); ++j, ++index)
+        for (auto j = 0; j <= i; ++j)
         {
-            if (index == 0 || !areProbePathsEqual(probePaths.flatData()[index], probePaths.flatData()[index - 1]))
+            if (paths[j].valid)
             {
-                uniqueSoundPaths.push_back(SoundPath(probePaths.flatData()[index], probes));
+                rowColumns[i].push_back(j);
+                rowPathIds[i].push_back(soundPaths.insert(SoundPath(paths[j], probes)));
             }
+        }
+    });
+}
 
-            if (uniqueSoundPaths.back().isValid())
-            {
-                auto start = probePaths.flatData()[index].start;
-                auto end = probePaths.flatData()[index].end;
+// Builds the sparse matrix of refs to unique paths, from the rows of path ids filled in by bake jobs.
+static void buildPathRefs(const vector<int>& remap,
+                          vector<vector<int32_t>>& rowColumns,
+                          vector<vector<int32_t>>& rowPathIds,
+                          vector<int32_t>& rowStarts,
+                          vector<int32_t>& columns,
+                          vector<SoundPathRef>& refs)
+{
+    auto numProbes = static_cast<int>(rowColumns.size());
 
-                mBakedPathRefs[start][end].index = static_cast<int>(uniqueSoundPaths.size()) - 1;
-            }
-        }
+    rowStarts.resize(numProbes + 1);
+    rowStarts[0] = 0;
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        rowStarts[i + 1] = rowStarts[i] + static_cast<int32_t>(rowColumns[i].size());
+    }
 
-        if (cancel)
-        {
-            cancel = false;
-            return;
-        }
+    columns.resize(rowStarts[numProbes]);
+    refs.resize(rowStarts[numProbes]);
 
-        if (progressCallback)
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        for (auto k = 0u; k < rowColumns[i].size(); ++k)
         {
-            progressCallback(static_cast<float>(index) / probePaths.totalSize(), callbackUserData);
+            columns[rowStarts[i] + k] = rowColumns[i][k];
+            refs[rowStarts[i] + k].index = remap[rowPathIds[i][k]];
         }
+
+        vector<int32_t>().swap(rowColumns[i]);
+        vector<int32_t>().swap(rowPathIds[i]);
     }
+}
 
-    mUniqueBakedPaths.resize(uniqueSoundPaths.size());
-    memcpy(mUniqueBakedPaths.data(), uniqueSoundPaths.data(), uniqueSoundPaths.size() * sizeof(SoundPath));
-    if (progressCallback)
+template <typename T>
+static void loadVector(const flatbuffers::Vector<T>* serializedVector,
+                       vector<T>& values)
+{
+    values.resize(serializedVector->Length());
+    for (auto i = 0u; i < serializedVector->Length(); ++i)
     {
-        progressCallback(1.0f, callbackUserData);
+        values[i] = serializedVector->Get(i);
     }
+}
 
-    if (pruneVisGraph)
+static void loadPathRefs(const flatbuffers::Vector<int32_t>* serializedRowStarts,
+                         const flatbuffers::Vector<int32_t>* serializedColumns,
+                         const flatbuffers::Vector<int32_t>* serializedPaths,
+                         vector<int32_t>& rowStarts,
+                         vector<int32_t>& columns,
+                         vector<SoundPathRef>& refs)
+{
+    assert(serializedRowStarts && serializedColumns && serializedPaths);
+    assert(serializedColumns->Length() == serializedPaths->Length());
+
+    loadVector(serializedRowStarts, rowStarts);
+    loadVector(serializedColumns, columns);
+
+    refs.resize(serializedPaths->Length());
+    for (auto i = 0u; i < serializedPaths->Length(); ++i)
     {
-        mVisGraph->prune(probes, visTester, visRangeRealTime);
+        refs[i].index = serializedPaths->Get(i);
     }
+}
+
+BakedPathData::BakedPathData(const IScene& scene,
+                             const ProbeBatch& probes,
+                             int numSamples,
+                             float radius,
+                             float threshold,
+                             float visRange,
+                             float visRangeRealTime,
+                             float pathRange,
+                             bool asymmetricVisRange,
+                             const Vector3f& down,
+                             bool pruneVisGraph,
+                             int numThreads,
+                             ThreadPool& threadPool,
+                             std::atomic<bool>& cancel,
+                             ProgressCallback progressCallback,
+                             void* callbackUserData,
+                             const BakeShard& shard,
+                             float regionSize)
+    : mShard(shard)
+    , mNeedsUpdate(shard.isPartial())
+    , mRegionSize(regionSize)
+{
+    mParams.numSamples = numSamples;
+    mParams.radius = radius;
+    mParams.threshold = threshold;
+    mParams.visRange = visRange;
+    mParams.visRangeRealTime = visRangeRealTime;
+    mParams.pathRange = pathRange;
+    mParams.asymmetricVisRange = asymmetricVisRange;
+    mParams.down = down;
+    mParams.pruneVisGraph = pruneVisGraph;
+
+    // First, generate the visibility graph.
+    ProbeVisibilityTester visTester(numSamples, asymmetricVisRange, down);
+
+    JobGraph jobGraph{};
+    mVisGraph = ipl::make_unique<ProbeVisibilityGraph>(scene, probes, visTester, radius, threshold, visRange,
+                                                       numThreads, jobGraph, cancel, progressCallback, callbackUserData,
+                                                       shard);
+
+    mInvalidProbes.resize(probes.numProbes());
+    mChangedProbes.resize(probes.numProbes());
+
+    threadPool.process(jobGraph, [progressCallback, callbackUserData](float percentComplete)
+    {
+        if (progressCallback)
+        {
+            progressCallback(percentComplete, callbackUserData);
+        }
+    });
 
     if (cancel)
     {
         cancel = false;
         return;
     }
+
+    // A shard only computes its own rows of the visibility graph. Paths depend on the whole graph, so they are
+    // calculated when the shards are merged.
+    if (shard.isPartial())
+        return;
+
+    findPaths(probes, visTester, visRangeRealTime, pathRange, pruneVisGraph, numThreads, threadPool, cancel,
+              progressCallback, callbackUserData);
+}
+
+BakedPathData::BakedPathData(const ProbeBatch& probes,
+                             unique_ptr<ProbeVisibilityGraph> visGraph,
+                             const PathBakeParams& params,
+                             int numThreads,
+                             ThreadPool& threadPool,
+                             std::atomic<bool>& cancel,
+                             ProgressCallback progressCallback,
+                             void* callbackUserData,
+                             float regionSize)
+    : mVisGraph(std::move(visGraph))
+    , mNeedsUpdate(false)
+    , mParams(params)
+    , mRegionSize(regionSize)
+{
+    mInvalidProbes.resize(probes.numProbes());
+    mChangedProbes.resize(probes.numProbes());
+
+    // The tester is only used for pruning, which doesn't trace any rays.
+    ProbeVisibilityTester visTester(1, params.asymmetricVisRange, params.down);
+
+    findPaths(probes, visTester, params.visRangeRealTime, params.pathRange, params.pruneVisGraph, numThreads,
+              threadPool, cancel, progressCallback, callbackUserData);
 }
 
 BakedPathData::BakedPathData(const Serialized::BakedPathingData* serializedObject)
+    : mRegionSize(0.0f)
 {
     assert(serializedObject);
     assert(serializedObject->vis_graph() && serializedObject->vis_graph()->nodes() && serializedObject->vis_graph()->nodes()->Length() > 0);
-    assert(serializedObject->unique_paths() && serializedObject->unique_paths()->Length() > 0);
-    assert(serializedObject->path_indices() && serializedObject->path_indices()->Length() > 0);
-    assert(serializedObject->paths() && serializedObject->paths()->Length() > 0);
+
+    // shard
+    mShard.index = serializedObject->shard_index();
+    mShard.numShards = serializedObject->num_shards();
+    mNeedsUpdate = mShard.isPartial();
+
+    // bake params
+    mParams.numSamples = serializedObject->num_samples();
+    mParams.radius = serializedObject->radius();
+    mParams.threshold = serializedObject->threshold();
+    mParams.visRange = serializedObject->vis_range();
+    mParams.visRangeRealTime = serializedObject->vis_range_real_time();
+    mParams.pathRange = serializedObject->path_range();
+    mParams.asymmetricVisRange = serializedObject->asymmetric_vis_range();
+    if (serializedObject->down())
+    {
+        const auto* down = serializedObject->down();
+        mParams.down = Vector3f(down->x(), down->y(), down->z());
+    }
+    mParams.pruneVisGraph = serializedObject->prune_vis_graph();
 
     // # probes
     auto numProbes = serializedObject->vis_graph()->nodes()->Length();
@@ -382,6 +593,16 @@ BakedPathData::BakedPathData(const Serialized::BakedPathingData* serializedObjec
     // vis graph
     mVisGraph = ipl::make_unique<ProbeVisibilityGraph>(serializedObject->vis_graph());
 
+    mInvalidProbes.resize(numProbes);
+    mChangedProbes.resize(numProbes);
+
+    // Shards don't contain any paths.
+    if (mShard.isPartial())
+        return;
+
+    assert(serializedObject->unique_paths() && serializedObject->unique_paths()->Length() > 0);
+    assert(serializedObject->paths());
+
     // # valid SoundPaths
     auto numValidPaths = serializedObject->paths()->Length();
 
@@ -392,94 +613,681 @@ BakedPathData::BakedPathData(const Serialized::BakedPathingData* serializedObjec
     // unique SoundPaths
     for (auto i = 0u; i < numUniquePaths; ++i)
     {
-        mUniqueBakedPaths[i].firstProbe = serializedObject->unique_paths()->Get(i)->first_probe();
-        mUniqueBakedPaths[i].lastProbe = serializedObject->unique_paths()->Get(i)->last_probe();
-        mUniqueBakedPaths[i].probeAfterFirst = serializedObject->unique_paths()->Get(i)->probe_after_first();
-        mUniqueBakedPaths[i].probeBeforeLast = serializedObject->unique_paths()->Get(i)->probe_before_last();
+        auto wideProbeIndices = serializedObject->unique_paths()->Get(i)->wide_probe_indices();
+        if (wideProbeIndices && wideProbeIndices->Length() == 4)
+        {
+            mUniqueBakedPaths[i].firstProbe = wideProbeIndices->Get(0);
+            mUniqueBakedPaths[i].lastProbe = wideProbeIndices->Get(1);
+            mUniqueBakedPaths[i].probeAfterFirst = wideProbeIndices->Get(2);
+            mUniqueBakedPaths[i].probeBeforeLast = wideProbeIndices->Get(3);
+        }
+        else
+        {
+            mUniqueBakedPaths[i].firstProbe = serializedObject->unique_paths()->Get(i)->first_probe();
+            mUniqueBakedPaths[i].lastProbe = serializedObject->unique_paths()->Get(i)->last_probe();
+            mUniqueBakedPaths[i].probeAfterFirst = serializedObject->unique_paths()->Get(i)->probe_after_first();
+            mUniqueBakedPaths[i].probeBeforeLast = serializedObject->unique_paths()->Get(i)->probe_before_last();
+        }
         mUniqueBakedPaths[i].direct = serializedObject->unique_paths()->Get(i)->direct();
         mUniqueBakedPaths[i].distanceInternal = serializedObject->unique_paths()->Get(i)->distance_internal();
         mUniqueBakedPaths[i].deviationInternal = serializedObject->unique_paths()->Get(i)->deviation_internal();
     }
 
-    // SoundPathRefs (index/value pair for each valid path)
-    mBakedPathRefs.resize(numProbes, numProbes);
-
-    SoundPathRef invalidSoundPathRef;
-    for (auto i = 0u; i < numProbes; ++i)
+    // regions
+    mRegionSize = serializedObject->region_size();
+    if (isHierarchical())
     {
-        for (auto j = 0u; j < numProbes; ++j)
+        assert(serializedObject->regions());
+        assert(serializedObject->portal_edge_starts() && serializedObject->portal_edge_starts()->Length() == numProbes + 1);
+        assert(serializedObject->portal_edges() && serializedObject->portal_edge_costs());
+
+        auto numRegions = serializedObject->regions()->Length();
+        mRegions.resize(numRegions);
+
+        for (auto i = 0u; i < numRegions; ++i)
         {
-            mBakedPathRefs[i][j] = invalidSoundPathRef;
+            const auto* serializedRegion = serializedObject->regions()->Get(i);
+            auto& region = mRegions[i];
+
+            assert(serializedRegion->probes());
+            loadVector(serializedRegion->probes(), region.probes);
+
+            loadPathRefs(serializedRegion->path_row_starts(), serializedRegion->path_columns(), serializedRegion->paths(),
+                         region.pathRowStarts, region.pathColumns, region.pathRefs);
         }
+
+        loadVector(serializedObject->portal_edge_starts(), mPortalEdgeStarts);
+        loadVector(serializedObject->portal_edges(), mPortalEdges);
+        loadVector(serializedObject->portal_edge_costs(), mPortalEdgeCosts);
+
+        initRegions(numProbes);
+        return;
     }
 
+    // SoundPathRefs
+    mPathRowStarts.resize(numProbes + 1);
+    mPathColumns.resize(numValidPaths);
+    mPathRefs.resize(numValidPaths);
+
     for (auto i = 0u; i < numValidPaths; ++i)
     {
-        auto index = serializedObject->path_indices()->Get(i);
-        mBakedPathRefs.flatData()[index].index = serializedObject->paths()->Get(i);
+        mPathRefs[i].index = serializedObject->paths()->Get(i);
     }
-}
 
-SoundPath BakedPathData::lookupShortestPath(int start,
-                                            int end,
-                                            ProbePath* probePath) const
-{
-    PROFILE_FUNCTION();
+    if (serializedObject->path_row_starts())
+    {
+        assert(serializedObject->path_row_starts()->Length() == numProbes + 1);
+        assert(serializedObject->path_columns() && serializedObject->path_columns()->Length() == numValidPaths);
 
-    SoundPath soundPath;
+        for (auto i = 0u; i <= numProbes; ++i)
+        {
+            mPathRowStarts[i] = serializedObject->path_row_starts()->Get(i);
+        }
 
-    if (start < end)
-    {
-        soundPath = mUniqueBakedPaths[mBakedPathRefs[end][start].index];
-        std::swap(soundPath.firstProbe, soundPath.lastProbe);
-        std::swap(soundPath.probeAfterFirst, soundPath.probeBeforeLast);
+        for (auto i = 0u; i < numValidPaths; ++i)
+        {
+            mPathColumns[i] = serializedObject->path_columns()->Get(i);
+        }
     }
     else
     {
-        soundPath = mUniqueBakedPaths[mBakedPathRefs[start][end].index];
-    }
+        // Older data stores the flattened index of each path, in row-major order.
+        assert(serializedObject->path_indices() && serializedObject->path_indices()->Length() == numValidPaths);
 
-    if (probePath)
-    {
-        reconstructProbePath(start, end, soundPath, *probePath);
+        std::fill(mPathRowStarts.begin(), mPathRowStarts.end(), 0);
+
+        for (auto i = 0u; i < numValidPaths; ++i)
+        {
+            auto index = static_cast<uint32_t>(serializedObject->path_indices()->Get(i));
+            mPathRowStarts[index / numProbes + 1]++;
+            mPathColumns[i] = index % numProbes;
+        }
+
+        for (auto i = 0u; i < numProbes; ++i)
+        {
+            mPathRowStarts[i + 1] += mPathRowStarts[i];
+        }
     }
+}
 
-    return soundPath;
+void BakedPathData::updateProbePosition(int index,
+                                        const Vector3f& position)
+{
+    invalidate(index);
 }
 
-void BakedPathData::reconstructProbePath(int start,
-                                         int end,
-                                         const SoundPath& soundPath,
-                                         ProbePath& probePath) const
+void BakedPathData::addProbe(const Sphere& influence)
 {
-    PROFILE_FUNCTION();
+    mNeedsUpdate = true;
+    mVersion++;
 
-    probePath.valid = (soundPath.isValid());
+    mVisGraph->mAdjacent.emplace_back();
+    mVisGraph->flatten();
+    mInvalidProbes.push_back(true);
+    mChangedProbes.push_back(true);
 
-    if (probePath.valid)
+    if (!mPathRowStarts.empty())
     {
-        probePath.start = start;
-        probePath.end = end;
+        mPathRowStarts.push_back(mPathRowStarts.back());
+    }
+}
 
-        auto current = end;
-        auto prev = (soundPath.direct) ? start : soundPath.lastProbe;
+void BakedPathData::removeProbe(int index)
+{
+    mNeedsUpdate = true;
+    mVersion++;
 
-        while (current != start)
-        {
-            if (current != start && current != end)
-            {
-                probePath.nodes.push_back(current);
-            }
+    // Paths from any probe that could reach the removed probe must be found again.
+    for (const auto& entry : mVisGraph->mAdjacent[index])
+    {
+        mChangedProbes[entry.index] = true;
+    }
 
-            if (prev == start)
-                break;
+    mVisGraph->removeProbe(index);
+    mInvalidProbes.erase(mInvalidProbes.begin() + index);
+    mChangedProbes.erase(mChangedProbes.begin() + index);
 
-            auto nextPath = lookupShortestPath(start, prev, nullptr);
-            if (!nextPath.isValid())
-            {
-                probePath.reset();
-                return;
-            }
+    if (isHierarchical() || mPathRowStarts.empty())
+        return;
+
+    // Remove the row and column of the removed probe from the sparse matrix of paths, and renumber the remaining
+    // probes. Paths that pass through the removed probe are replaced with invalid paths until they are found again,
+    // but their entries are kept, since update uses them to decide which paths to find again.
+    auto numProbes = static_cast<int>(mPathRowStarts.size()) - 1;
+    auto numPaths = 0;
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        auto rowBegin = mPathRowStarts[i];
+        auto rowEnd = mPathRowStarts[i + 1];
+
+        if (i > index)
+        {
+            mPathRowStarts[i] = numPaths;
+        }
+        else if (i == index)
+        {
+            continue;
+        }
+
+        for (auto k = rowBegin; k < rowEnd; ++k)
+        {
+            if (mPathColumns[k] == index)
+                continue;
+
+            mPathColumns[numPaths] = (mPathColumns[k] > index) ? mPathColumns[k] - 1 : mPathColumns[k];
+            mPathRefs[numPaths] = mPathRefs[k];
+            ++numPaths;
+        }
+    }
+
+    mPathRowStarts.erase(mPathRowStarts.begin() + index);
+    mPathRowStarts[numProbes - 1] = numPaths;
+    mPathColumns.resize(numPaths);
+    mPathRefs.resize(numPaths);
+
+    for (auto i = 0u; i < mUniqueBakedPaths.totalSize(); ++i)
+    {
+        auto& soundPath = mUniqueBakedPaths[i];
+
+        if (soundPath.firstProbe == index || soundPath.lastProbe == index ||
+            soundPath.probeAfterFirst == index || soundPath.probeBeforeLast == index)
+        {
+            soundPath = SoundPath{};
+            continue;
+        }
+
+        for (auto* probe : {&soundPath.firstProbe, &soundPath.lastProbe, &soundPath.probeAfterFirst, &soundPath.probeBeforeLast})
+        {
+            if (*probe > index)
+            {
+                (*probe)--;
+            }
+        }
+    }
+}
+
+void BakedPathData::invalidate(int index)
+{
+    mNeedsUpdate = true;
+    mInvalidProbes[index] = true;
+}
+
+bool BakedPathData::update(const IScene& scene,
+                           const ProbeBatch& probes,
+                           const PathBakeParams& params,
+                           int numThreads,
+                           ThreadPool& threadPool,
+                           std::atomic<bool>& cancel,
+                           ProgressCallback progressCallback,
+                           void* callbackUserData)
+{
+    PROFILE_FUNCTION();
+
+    auto numProbes = probes.numProbes();
+
+    if (isHierarchical() || mShard.isPartial() || static_cast<int>(mVisGraph->mAdjacent.size()) != numProbes ||
+        static_cast<int>(mPathRowStarts.size()) != numProbes + 1)
+        return false;
+
+    // Edges and paths that haven't changed were found using the parameters this data was baked with. Data saved by
+    // older versions doesn't record them.
+    if (mParams.numSamples <= 0 || params != mParams)
+        return false;
+
+    // First, update the edges of the visibility graph for probes that have been moved, added, or invalidated.
+    vector<int> invalidProbes;
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        if (mInvalidProbes[i])
+        {
+            invalidProbes.push_back(i);
+        }
+    }
+
+    if (!invalidProbes.empty())
+    {
+        ProbeVisibilityTester visTester(params.numSamples, params.asymmetricVisRange, params.down);
+
+        mVisGraph->updateProbes(scene, probes, visTester, params.radius, params.threshold, params.visRange,
+                                invalidProbes, numThreads, threadPool, cancel, mChangedProbes);
+
+        if (cancel)
+        {
+            cancel = false;
+            return true;
+        }
+
+        std::fill(mInvalidProbes.begin(), mInvalidProbes.end(), 0);
+    }
+
+    // Shortest paths from a probe can only change if the search from that probe reached a probe whose edges have
+    // changed, i.e., if there was a path from the probe to a probe whose edges have changed.
+    vector<uint8_t> rowsToUpdate(mChangedProbes);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        if (!mChangedProbes[i])
+            continue;
+
+        for (auto k = mPathRowStarts[i]; k < mPathRowStarts[i + 1]; ++k)
+        {
+            rowsToUpdate[mPathColumns[k]] = true;
+        }
+
+        for (auto j = i + 1; j < numProbes; ++j)
+        {
+            if (findPathRef(j, i).index != 0)
+            {
+                rowsToUpdate[j] = true;
+            }
+        }
+    }
+
+    // Find paths again for rows that need updating, and copy the existing paths for all other rows. All paths are
+    // added to a new table, so unique paths are numbered in the same way as when baking from scratch.
+    PathFinder pathFinder(probes, numThreads);
+    Array<ProbePath, 2> rowPaths(numThreads, numProbes);
+    SoundPathTable soundPaths;
+
+    vector<vector<int32_t>> rowColumns(numProbes);
+    vector<vector<int32_t>> rowPathIds(numProbes);
+
+    JobGraph jobGraph{};
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        if (rowsToUpdate[i])
+        {
+            addBakePathJob(i, probes, *mVisGraph, pathFinder, params.pathRange, rowPaths, soundPaths, rowColumns,
+                           rowPathIds, jobGraph);
+        }
+        else
+        {
+            jobGraph.addJob([this, i, &soundPaths, &rowColumns, &rowPathIds](int, std::atomic<bool>&)
+            {
+                for (auto k = mPathRowStarts[i]; k < mPathRowStarts[i + 1]; ++k)
+                {
+                    rowColumns[i].push_back(mPathColumns[k]);
+                    rowPathIds[i].push_back(soundPaths.insert(mUniqueBakedPaths[mPathRefs[k].index]));
+                }
+            });
+        }
+    }
+
+    threadPool.process(jobGraph, [progressCallback, callbackUserData](float percentComplete)
+    {
+        if (progressCallback)
+        {
+            progressCallback(percentComplete, callbackUserData);
+        }
+    });
+
+    if (cancel)
+    {
+        cancel = false;
+        return true;
+    }
+
+    vector<int> remap;
+    soundPaths.finalize(mUniqueBakedPaths, remap);
+
+    buildPathRefs(remap, rowColumns, rowPathIds, mPathRowStarts, mPathColumns, mPathRefs);
+
+    std::fill(mChangedProbes.begin(), mChangedProbes.end(), 0);
+    mNeedsUpdate = false;
+    mVersion++;
+
+    if (progressCallback)
+    {
+        progressCallback(1.0f, callbackUserData);
+    }
+
+    return true;
+}
+
+SoundPath BakedPathData::lookupShortestPath(int start,
+                                            int end,
+                                            ProbePath* probePath,
+                                            PortalSearch* search) const
+{
+    PROFILE_FUNCTION();
+
+    if (isHierarchical())
+    {
+        if (search)
+            return lookupHierarchicalPath(start, end, probePath, *search);
+
+        PortalSearch localSearch;
+        return lookupHierarchicalPath(start, end, probePath, localSearch);
+    }
+
+    SoundPath soundPath;
+
+    if (start < end)
+    {
+        soundPath = mUniqueBakedPaths[findPathRef(end, start).index];
+        std::swap(soundPath.firstProbe, soundPath.lastProbe);
+        std::swap(soundPath.probeAfterFirst, soundPath.probeBeforeLast);
+    }
+    else
+    {
+        soundPath = mUniqueBakedPaths[findPathRef(start, end).index];
+    }
+
+    if (probePath)
+    {
+        reconstructProbePath(start, end, soundPath, *probePath);
+    }
+
+    return soundPath;
+}
+
+SoundPathRef BakedPathData::findPathRef(int start,
+                                        int end) const
+{
+    return findPathRef(mPathRowStarts, mPathColumns, mPathRefs, start, end);
+}
+
+SoundPathRef BakedPathData::findPathRef(const vector<int32_t>& rowStarts,
+                                        const vector<int32_t>& columns,
+                                        const vector<SoundPathRef>& refs,
+                                        int start,
+                                        int end)
+{
+    if (start < 0 || start + 1 >= static_cast<int>(rowStarts.size()))
+        return SoundPathRef{};
+
+    auto rowBegin = columns.begin() + rowStarts[start];
+    auto rowEnd = columns.begin() + rowStarts[start + 1];
+
+    auto it = std::lower_bound(rowBegin, rowEnd, end);
+    if (it == rowEnd || *it != end)
+        return SoundPathRef{};
+
+    return refs[it - columns.begin()];
+}
+
+SoundPath BakedPathData::lookupRegionPath(const PathRegion& region,
+                                          int start,
+                                          int end) const
+{
+    SoundPath soundPath;
+
+    if (start < end)
+    {
+        soundPath = mUniqueBakedPaths[findPathRef(region.pathRowStarts, region.pathColumns, region.pathRefs, end, start).index];
+        std::swap(soundPath.firstProbe, soundPath.lastProbe);
+        std::swap(soundPath.probeAfterFirst, soundPath.probeBeforeLast);
+    }
+    else
+    {
+        soundPath = mUniqueBakedPaths[findPathRef(region.pathRowStarts, region.pathColumns, region.pathRefs, start, end).index];
+    }
+
+    return soundPath;
+}
+
+SoundPath BakedPathData::lookupRegionPathGlobal(int start,
+                                                int end) const
+{
+    assert(mProbeRegions[start] == mProbeRegions[end]);
+
+    const auto& region = mRegions[mProbeRegions[start]];
+
+    auto soundPath = lookupRegionPath(region, mProbeLocalIndices[start], mProbeLocalIndices[end]);
+
+    auto toGlobal = [&region](int32_t& probe)
+    {
+        if (probe >= 0)
+        {
+            probe = region.probes[probe];
+        }
+    };
+
+    toGlobal(soundPath.firstProbe);
+    toGlobal(soundPath.lastProbe);
+    toGlobal(soundPath.probeAfterFirst);
+    toGlobal(soundPath.probeBeforeLast);
+
+    return soundPath;
+}
+
+bool BakedPathData::appendRegionPath(int start,
+                                     int end,
+                                     vector<int>& nodes) const
+{
+    const auto& region = mRegions[mProbeRegions[start]];
+
+    auto localStart = mProbeLocalIndices[start];
+    auto current = mProbeLocalIndices[end];
+
+    // Walk backwards from the end probe, using the fact that the second-to-last probe on the shortest path to any
+    // probe is also the last probe on the shortest path to the second-to-last probe.
+    auto firstNode = nodes.size();
+
+    while (current != localStart)
+    {
+        auto soundPath = lookupRegionPath(region, localStart, current);
+        if (!soundPath.isValid() || nodes.size() - firstNode >= region.probes.size())
+        {
+            nodes.resize(firstNode);
+            return false;
+        }
+
+        nodes.push_back(region.probes[current]);
+        current = (soundPath.direct) ? localStart : soundPath.lastProbe;
+    }
+
+    std::reverse(nodes.begin() + firstNode, nodes.end());
+    return true;
+}
+
+SoundPath BakedPathData::lookupHierarchicalPath(int start,
+                                                int end,
+                                                ProbePath* probePath,
+                                                PortalSearch& search) const
+{
+    if (probePath)
+    {
+        probePath->reset();
+    }
+
+    auto numProbes = static_cast<int>(mProbeRegions.size());
+    if (start < 0 || start >= numProbes || end < 0 || end >= numProbes || start == end)
+        return SoundPath{};
+
+    auto startRegion = mProbeRegions[start];
+    auto endRegion = mProbeRegions[end];
+
+    auto& nodes = search.nodes;
+    nodes.clear();
+
+    // Paths between probes in the same region are baked, so the portal graph only needs to be searched if there is
+    // no such path.
+    if (startRegion == endRegion)
+    {
+        auto soundPath = lookupRegionPathGlobal(start, end);
+        if (soundPath.isValid())
+        {
+            if (probePath && appendRegionPath(start, end, nodes))
+            {
+                nodes.pop_back();
+
+                probePath->valid = true;
+                probePath->start = start;
+                probePath->end = end;
+                probePath->nodes.assign(nodes.begin(), nodes.end());
+            }
+
+            return soundPath;
+        }
+    }
+
+    // Distance along the baked path between two probes in the same region.
+    auto regionDistance = [this](int from, int to)
+    {
+        if (from == to)
+            return 0.0f;
+
+        auto soundPath = lookupRegionPathGlobal(from, to);
+        if (!soundPath.isValid())
+            return std::numeric_limits<float>::infinity();
+
+        return soundPathDistance(soundPath, mProbeCenters, from, to);
+    };
+
+    // As when baking paths between every pair of probes, paths longer than the path range are not found.
+    auto pathRange = (mParams.pathRange > 0.0f) ? mParams.pathRange : std::numeric_limits<float>::infinity();
+
+    // Run Dijkstra's algorithm over the portal graph, starting from the portals reachable from the start probe, and
+    // stopping once no portal can lead to a shorter path to the end probe than the best one found so far.
+    search.reset(mNumPortals);
+
+    auto& costs = search.costs;
+    auto& parents = search.parents;
+    auto& queue = search.queue;
+
+    auto visit = [&](int portal, float cost, int parent)
+    {
+        auto index = mPortalIndices[portal];
+        if (cost > pathRange || cost >= costs[index])
+            return;
+
+        if (costs[index] == std::numeric_limits<float>::infinity())
+        {
+            search.visitedPortals.push_back(index);
+        }
+
+        costs[index] = cost;
+        parents[index] = parent;
+
+        queue.push_back(PathFinder::PriorityQueueEntry{portal, cost});
+        std::push_heap(queue.begin(), queue.end());
+    };
+
+    for (auto portal : mRegions[startRegion].portals)
+    {
+        visit(portal, regionDistance(start, portal), -1);
+    }
+
+    auto bestCost = std::numeric_limits<float>::infinity();
+    auto bestPortal = -1;
+
+    while (!queue.empty())
+    {
+        std::pop_heap(queue.begin(), queue.end());
+        auto entry = queue.back();
+        queue.pop_back();
+
+        if (entry.cost >= bestCost)
+            break;
+
+        auto u = entry.nodeIndex;
+        if (entry.cost > costs[mPortalIndices[u]])
+            continue;
+
+        if (mProbeRegions[u] == endRegion)
+        {
+            auto cost = entry.cost + regionDistance(u, end);
+            if (cost <= pathRange && cost < bestCost)
+            {
+                bestCost = cost;
+                bestPortal = u;
+            }
+        }
+
+        for (auto i = mPortalEdgeStarts[u]; i < mPortalEdgeStarts[u + 1]; ++i)
+        {
+            visit(mPortalEdges[i], entry.cost + mPortalEdgeCosts[i], u);
+        }
+    }
+
+    if (bestPortal < 0)
+        return SoundPath{};
+
+    auto& portals = search.portals;
+    portals.clear();
+    for (auto portal = bestPortal; portal >= 0; portal = parents[mPortalIndices[portal]])
+    {
+        portals.push_back(portal);
+    }
+
+    std::reverse(portals.begin(), portals.end());
+    portals.push_back(end);
+
+    // Expand the sequence of portals into the full sequence of probes. Consecutive portals in different regions are
+    // connected by an edge of the visibility graph.
+    auto prev = start;
+    for (auto portal : portals)
+    {
+        if (portal == prev)
+            continue;
+
+        if (mProbeRegions[portal] != mProbeRegions[prev])
+        {
+            nodes.push_back(portal);
+        }
+        else if (!appendRegionPath(prev, portal, nodes))
+        {
+            return SoundPath{};
+        }
+
+        prev = portal;
+    }
+
+    auto& path = search.path;
+    path.valid = true;
+    path.start = start;
+    path.end = end;
+    path.nodes.assign(nodes.begin(), nodes.end() - 1);
+
+    SoundPath soundPath;
+    initSoundPath(path, [this](int index) -> const Vector3f&
+    {
+        return mProbeCenters[index];
+    }, soundPath);
+
+    if (probePath)
+    {
+        *probePath = path;
+    }
+
+    return soundPath;
+}
+
+void BakedPathData::reconstructProbePath(int start,
+                                         int end,
+                                         const SoundPath& soundPath,
+                                         ProbePath& probePath) const
+{
+    PROFILE_FUNCTION();
+
+    probePath.valid = (soundPath.isValid());
+
+    if (probePath.valid)
+    {
+        probePath.start = start;
+        probePath.end = end;
+
+        auto current = end;
+        auto prev = (soundPath.direct) ? start : soundPath.lastProbe;
+
+        while (current != start)
+        {
+            if (current != start && current != end)
+            {
+                probePath.nodes.push_back(current);
+            }
+
+            if (prev == start)
+                break;
+
+            auto nextPath = lookupShortestPath(start, prev, nullptr);
+            if (!nextPath.isValid())
+            {
+                probePath.reset();
+                return;
+            }
 
             current = prev;
             prev = (nextPath.direct) ? start : nextPath.lastProbe;
@@ -489,6 +1297,17 @@ void BakedPathData::reconstructProbePath(int start,
     }
 }
 
+bool BakedPathData::needsWideProbeIndices(const SoundPath& path)
+{
+    auto fitsInt16 = [](int32_t index)
+    {
+        return (std::numeric_limits<int16_t>::min() <= index && index <= std::numeric_limits<int16_t>::max());
+    };
+
+    return !(fitsInt16(path.firstProbe) && fitsInt16(path.lastProbe) && fitsInt16(path.probeAfterFirst) &&
+             fitsInt16(path.probeBeforeLast));
+}
+
 uint64_t BakedPathData::serializedSize() const
 {
     // # probes
@@ -497,6 +1316,12 @@ uint64_t BakedPathData::serializedSize() const
     // vis graph
     size += mVisGraph->serializedSize();
 
+    // shard
+    size += 2 * sizeof(int32_t);
+
+    // bake params
+    size += sizeof(PathBakeParams);
+
     // # valid SoundPaths
     size += sizeof(int32_t);
 
@@ -505,20 +1330,30 @@ uint64_t BakedPathData::serializedSize() const
 
     // unique SoundPaths
     size += mUniqueBakedPaths.totalSize() * sizeof(SoundPath);
-
-    // SoundPathRefs. For valid paths only.
-    auto numProbes = mBakedPathRefs.size(0);
-    for (auto i = 0u; i < numProbes; ++i)
+    for (auto i = 0u; i < mUniqueBakedPaths.totalSize(); ++i)
     {
-        for (auto j = 0u; j < numProbes; ++j)
+        if (needsWideProbeIndices(mUniqueBakedPaths[i]))
         {
-            if (mUniqueBakedPaths[mBakedPathRefs[i][j].index].isValid())
-            {
-                size += sizeof(int32_t) + sizeof(SoundPathRef);
-            }
+            size += 4 * sizeof(int32_t);
         }
     }
 
+    // SoundPathRefs. For valid paths only.
+    size += mPathRowStarts.size() * sizeof(int32_t);
+    size += mPathRefs.size() * (sizeof(int32_t) + sizeof(SoundPathRef));
+
+    // regions
+    size += sizeof(float);
+    for (const auto& region : mRegions)
+    {
+        size += (region.probes.size() + region.pathRowStarts.size()) * sizeof(int32_t);
+        size += region.pathRefs.size() * (sizeof(int32_t) + sizeof(SoundPathRef));
+    }
+
+    // portal graph
+    size += mPortalEdgeStarts.size() * sizeof(int32_t);
+    size += mPortalEdges.size() * (sizeof(int32_t) + sizeof(float));
+
     return size;
 }
 
@@ -531,55 +1366,408 @@ flatbuffers::Offset<Serialized::BakedPathingData> BakedPathData::serialize(Seria
     vector<flatbuffers::Offset<Serialized::SoundPath>> soundPathOffsets(mUniqueBakedPaths.totalSize());
     for (auto i = 0u; i < mUniqueBakedPaths.totalSize(); ++i)
     {
-        soundPathOffsets[i] = Serialized::CreateSoundPath(fbb, mUniqueBakedPaths[i].firstProbe,
-                                                          mUniqueBakedPaths[i].lastProbe,
-                                                          mUniqueBakedPaths[i].probeAfterFirst,
-                                                          mUniqueBakedPaths[i].probeBeforeLast,
-                                                          mUniqueBakedPaths[i].direct,
-                                                          mUniqueBakedPaths[i].distanceInternal,
-                                                          mUniqueBakedPaths[i].deviationInternal);
+        const auto& path = mUniqueBakedPaths[i];
+
+        // Probe indices that don't fit in the 16-bit fields are stored separately, so smaller probe batches don't
+        // pay for them.
+        if (needsWideProbeIndices(path))
+        {
+            int32_t wideProbeIndices[4] = {path.firstProbe, path.lastProbe, path.probeAfterFirst, path.probeBeforeLast};
+            auto wideProbeIndicesOffset = fbb.CreateVector(wideProbeIndices, 4);
+
+            soundPathOffsets[i] = Serialized::CreateSoundPath(fbb, -1, -1, -1, -1, path.direct, path.distanceInternal,
+                                                              path.deviationInternal, wideProbeIndicesOffset);
+        }
+        else
+        {
+            soundPathOffsets[i] = Serialized::CreateSoundPath(fbb, static_cast<int16_t>(path.firstProbe),
+                                                              static_cast<int16_t>(path.lastProbe),
+                                                              static_cast<int16_t>(path.probeAfterFirst),
+                                                              static_cast<int16_t>(path.probeBeforeLast),
+                                                              path.direct, path.distanceInternal,
+                                                              path.deviationInternal);
+        }
     }
 
     auto soundPathsOffset = fbb.CreateVector(soundPathOffsets.data(), soundPathOffsets.size());
 
-    auto numProbes = mBakedPathRefs.size(0);
-    auto numValidPaths = 0;
-    for (auto i = 0u; i < numProbes; ++i)
+    vector<int32_t> paths(mPathRefs.size());
+    for (auto i = 0u; i < mPathRefs.size(); ++i)
+    {
+        paths[i] = mPathRefs[i].index;
+    }
+
+    auto pathsOffset = fbb.CreateVector(paths.data(), paths.size());
+    auto pathRowStartsOffset = fbb.CreateVector(mPathRowStarts.data(), mPathRowStarts.size());
+    auto pathColumnsOffset = fbb.CreateVector(mPathColumns.data(), mPathColumns.size());
+
+    vector<flatbuffers::Offset<Serialized::PathRegion>> regionOffsets(mRegions.size());
+    for (auto i = 0u; i < mRegions.size(); ++i)
+    {
+        const auto& region = mRegions[i];
+
+        vector<int32_t> regionPaths(region.pathRefs.size());
+        for (auto j = 0u; j < region.pathRefs.size(); ++j)
+        {
+            regionPaths[j] = region.pathRefs[j].index;
+        }
+
+        auto probesOffset = fbb.CreateVector(region.probes.data(), region.probes.size());
+        auto regionRowStartsOffset = fbb.CreateVector(region.pathRowStarts.data(), region.pathRowStarts.size());
+        auto regionColumnsOffset = fbb.CreateVector(region.pathColumns.data(), region.pathColumns.size());
+        auto regionPathsOffset = fbb.CreateVector(regionPaths.data(), regionPaths.size());
+
+        regionOffsets[i] = Serialized::CreatePathRegion(fbb, probesOffset, regionRowStartsOffset, regionColumnsOffset,
+                                                        regionPathsOffset);
+    }
+
+    auto regionsOffset = fbb.CreateVector(regionOffsets.data(), regionOffsets.size());
+    auto portalEdgeStartsOffset = fbb.CreateVector(mPortalEdgeStarts.data(), mPortalEdgeStarts.size());
+    auto portalEdgesOffset = fbb.CreateVector(mPortalEdges.data(), mPortalEdges.size());
+    auto portalEdgeCostsOffset = fbb.CreateVector(mPortalEdgeCosts.data(), mPortalEdgeCosts.size());
+
+    Serialized::Vector3 down(mParams.down.x(), mParams.down.y(), mParams.down.z());
+
+    return Serialized::CreateBakedPathingData(fbb, visGraphOffset, soundPathsOffset, 0, pathsOffset, mShard.index,
+                                              mShard.numShards, pathRowStartsOffset, pathColumnsOffset, mRegionSize,
+                                              regionsOffset, portalEdgeStartsOffset, portalEdgesOffset,
+                                              portalEdgeCostsOffset, mParams.pathRange, mParams.numSamples,
+                                              mParams.radius, mParams.threshold, mParams.visRange,
+                                              mParams.visRangeRealTime, mParams.asymmetricVisRange, &down,
+                                              mParams.pruneVisGraph);
+}
+
+bool BakedPathData::findPaths(const ProbeBatch& probes,
+                              const ProbeVisibilityTester& visTester,
+                              float visRangeRealTime,
+                              float pathRange,
+                              bool pruneVisGraph,
+                              int numThreads,
+                              ThreadPool& threadPool,
+                              std::atomic<bool>& cancel,
+                              ProgressCallback progressCallback,
+                              void* callbackUserData)
+{
+    if (isHierarchical())
+    {
+        if (!findHierarchicalPaths(probes, pathRange, numThreads, threadPool, cancel, progressCallback, callbackUserData))
+            return false;
+    }
+    else
     {
-        for (auto j = 0u; j < numProbes; ++j)
+        auto numProbes = probes.numProbes();
+
+        // Using multiple threads, calculate shortest paths between every pair of probes.
+        PathFinder pathFinder(probes, numThreads);
+        Array<ProbePath, 2> rowPaths(numThreads, numProbes);
+        SoundPathTable soundPaths;
+
+        vector<vector<int32_t>> rowColumns(numProbes);
+        vector<vector<int32_t>> rowPathIds(numProbes);
+
+        JobGraph jobGraph{};
+        for (auto i = 0; i < numProbes; ++i)
+        {
+            addBakePathJob(i, probes, *mVisGraph, pathFinder, pathRange, rowPaths, soundPaths, rowColumns, rowPathIds,
+                           jobGraph);
+        }
+
+        threadPool.process(jobGraph, [progressCallback, callbackUserData](float percentComplete)
         {
-            if (mUniqueBakedPaths[mBakedPathRefs[i][j].index].isValid())
+            if (progressCallback)
             {
-                ++numValidPaths;
+                progressCallback(percentComplete, callbackUserData);
             }
+        });
+
+        if (cancel)
+        {
+            cancel = false;
+            return false;
+        }
+
+        vector<int> remap;
+        soundPaths.finalize(mUniqueBakedPaths, remap);
+
+        buildPathRefs(remap, rowColumns, rowPathIds, mPathRowStarts, mPathColumns, mPathRefs);
+    }
+
+    if (progressCallback)
+    {
+        progressCallback(1.0f, callbackUserData);
+    }
+
+    if (pruneVisGraph)
+    {
+        mVisGraph->prune(probes, visTester, visRangeRealTime);
+    }
+
+    if (cancel)
+    {
+        cancel = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool BakedPathData::findHierarchicalPaths(const ProbeBatch& probes,
+                                          float pathRange,
+                                          int numThreads,
+                                          ThreadPool& threadPool,
+                                          std::atomic<bool>& cancel,
+                                          ProgressCallback progressCallback,
+                                          void* callbackUserData)
+{
+    auto numProbes = probes.numProbes();
+
+    mProbeCenters.resize(numProbes);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        mProbeCenters[i] = probes[i].influence.center;
+    }
+
+    // Group probes into regions using a uniform grid. Regions are numbered in order of their lowest-indexed probe.
+    map<std::tuple<int, int, int>, int> cellRegions;
+    mRegions.clear();
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        const auto& center = probes[i].influence.center;
+        auto cell = std::make_tuple(static_cast<int>(floorf(center.x() / mRegionSize)),
+                                    static_cast<int>(floorf(center.y() / mRegionSize)),
+                                    static_cast<int>(floorf(center.z() / mRegionSize)));
+
+        auto it = cellRegions.find(cell);
+        if (it == cellRegions.end())
+        {
+            it = cellRegions.insert(std::make_pair(cell, static_cast<int>(mRegions.size()))).first;
+            mRegions.emplace_back();
+        }
+
+        mRegions[it->second].probes.push_back(i);
+    }
+
+    auto numRegions = static_cast<int>(mRegions.size());
+    auto largestRegion = 0;
+
+    for (auto i = 0; i < numRegions; ++i)
+    {
+        if (mRegions[i].probes.size() > mRegions[largestRegion].probes.size())
+        {
+            largestRegion = i;
         }
     }
 
-    vector<int32_t> pathIndices;
-    vector<int32_t> paths;
-    pathIndices.reserve(numValidPaths);
-    paths.reserve(numValidPaths);
-    for (auto i = 0u; i < numProbes; ++i)
+    mPortalEdgeStarts.clear();
+    initRegions(numProbes);
+
+    // Split the visibility graph into one graph per region. Probes with edges to probes in other regions are portals.
+    vector<unique_ptr<ProbeBatch>> regionProbes(numRegions);
+    vector<unique_ptr<ProbeVisibilityGraph>> regionVisGraphs(numRegions);
+    vector<uint8_t> isPortal(numProbes, 0);
+
+    for (auto i = 0; i < numRegions; ++i)
     {
-        for (auto j = 0u; j < numProbes; ++j)
+        const auto& region = mRegions[i];
+
+        regionProbes[i] = ipl::make_unique<ProbeBatch>();
+        regionVisGraphs[i] = ipl::make_unique<ProbeVisibilityGraph>(static_cast<int>(region.probes.size()));
+
+        for (auto j = 0u; j < region.probes.size(); ++j)
         {
-            if (mUniqueBakedPaths[mBakedPathRefs[i][j].index].isValid())
+            auto probe = region.probes[j];
+
+            regionProbes[i]->addProbe(probes[probe].influence);
+
+            for (const auto& entry : mVisGraph->mAdjacent[probe])
             {
-                pathIndices.push_back(static_cast<int>(i * numProbes + j));
-                paths.push_back(mBakedPathRefs[i][j].index);
+                if (mProbeRegions[entry.index] == i)
+                {
+                    regionVisGraphs[i]->mAdjacent[j].push_back(ProbeVisibilityGraph::AdjacencyListEntry{mProbeLocalIndices[entry.index], entry.cost});
+                }
+                else
+                {
+                    isPortal[probe] = true;
+                }
             }
         }
+
+        regionVisGraphs[i]->flatten();
     }
 
-    auto pathIndicesOffset = fbb.CreateVector(pathIndices.data(), pathIndices.size());
-    auto pathsOffset = fbb.CreateVector(paths.data(), paths.size());
+    // Using multiple threads, calculate shortest paths between every pair of probes in each region. All regions
+    // share the same table of unique paths.
+    auto maxRegionProbes = regionProbes[largestRegion]->numProbes();
+
+    PathFinder pathFinder(*regionProbes[largestRegion], numThreads);
+    Array<ProbePath, 2> rowPaths(numThreads, maxRegionProbes);
+    SoundPathTable soundPaths;
+
+    vector<vector<vector<int32_t>>> rowColumns(numRegions);
+    vector<vector<vector<int32_t>>> rowPathIds(numRegions);
+
+    JobGraph jobGraph{};
+
+    for (auto i = 0; i < numRegions; ++i)
+    {
+        rowColumns[i].resize(regionProbes[i]->numProbes());
+        rowPathIds[i].resize(regionProbes[i]->numProbes());
+
+        for (auto j = 0; j < regionProbes[i]->numProbes(); ++j)
+        {
+            addBakePathJob(j, *regionProbes[i], *regionVisGraphs[i], pathFinder, pathRange, rowPaths, soundPaths,
+                           rowColumns[i], rowPathIds[i], jobGraph);
+        }
+    }
+
+    threadPool.process(jobGraph, [progressCallback, callbackUserData](float percentComplete)
+    {
+        if (progressCallback)
+        {
+            progressCallback(percentComplete, callbackUserData);
+        }
+    });
+
+    if (cancel)
+    {
+        cancel = false;
+        return false;
+    }
+
+    vector<int> remap;
+    soundPaths.finalize(mUniqueBakedPaths, remap);
+
+    for (auto i = 0; i < numRegions; ++i)
+    {
+        auto& region = mRegions[i];
+        buildPathRefs(remap, rowColumns[i], rowPathIds[i], region.pathRowStarts, region.pathColumns, region.pathRefs);
+
+        for (auto probe : region.probes)
+        {
+            if (isPortal[probe])
+            {
+                region.portals.push_back(probe);
+            }
+        }
+    }
+
+    // Build the portal graph. Portals in different regions are connected if they are connected in the visibility
+    // graph, and portals in the same region are connected if there is a baked path between them.
+    mPortalEdgeStarts.resize(numProbes + 1);
+    mPortalEdges.clear();
+    mPortalEdgeCosts.clear();
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        mPortalEdgeStarts[i] = static_cast<int32_t>(mPortalEdges.size());
+
+        if (!isPortal[i])
+            continue;
+
+        for (const auto& entry : mVisGraph->mAdjacent[i])
+        {
+            if (mProbeRegions[entry.index] != mProbeRegions[i])
+            {
+                mPortalEdges.push_back(entry.index);
+                mPortalEdgeCosts.push_back(entry.cost);
+            }
+        }
+
+        for (auto portal : mRegions[mProbeRegions[i]].portals)
+        {
+            if (portal == i)
+                continue;
+
+            auto soundPath = lookupRegionPathGlobal(i, portal);
+            if (soundPath.isValid())
+            {
+                mPortalEdges.push_back(portal);
+                mPortalEdgeCosts.push_back(soundPathDistance(soundPath, mProbeCenters, i, portal));
+            }
+        }
+    }
+
+    mPortalEdgeStarts[numProbes] = static_cast<int32_t>(mPortalEdges.size());
+
+    initPortalIndices(numProbes);
+
+    return true;
+}
+
+void BakedPathData::initRegions(int numProbes)
+{
+    mProbeRegions.assign(numProbes, -1);
+    mProbeLocalIndices.assign(numProbes, -1);
+
+    for (auto i = 0u; i < mRegions.size(); ++i)
+    {
+        for (auto j = 0u; j < mRegions[i].probes.size(); ++j)
+        {
+            mProbeRegions[mRegions[i].probes[j]] = i;
+            mProbeLocalIndices[mRegions[i].probes[j]] = j;
+        }
+    }
+
+    if (mPortalEdgeStarts.empty())
+        return;
+
+    for (auto& region : mRegions)
+    {
+        region.portals.clear();
+
+        for (auto probe : region.probes)
+        {
+            if (mPortalEdgeStarts[probe + 1] > mPortalEdgeStarts[probe])
+            {
+                region.portals.push_back(probe);
+            }
+        }
+    }
+
+    initPortalIndices(numProbes);
+}
+
+void BakedPathData::initPortalIndices(int numProbes)
+{
+    mPortalIndices.assign(numProbes, -1);
+    mNumPortals = 0;
+
+    auto addPortal = [this](int probe)
+    {
+        if (mPortalIndices[probe] < 0)
+        {
+            mPortalIndices[probe] = mNumPortals++;
+        }
+    };
 
-    return Serialized::CreateBakedPathingData(fbb, visGraphOffset, soundPathsOffset, pathIndicesOffset, pathsOffset);
+    for (const auto& region : mRegions)
+    {
+        for (auto portal : region.portals)
+        {
+            addPortal(portal);
+        }
+    }
+
+    for (auto portal : mPortalEdges)
+    {
+        addPortal(portal);
+    }
 }
 
 void BakedPathData::updateVisGraphCosts(const ProbeBatch& probeBatch)
 {
     mVisGraph->updateCosts(probeBatch);
+    mVersion++;
+
+    if (isHierarchical())
+    {
+        mProbeCenters.resize(probeBatch.numProbes());
+        for (auto i = 0; i < probeBatch.numProbes(); ++i)
+        {
+            mProbeCenters[i] = probeBatch[i].influence.center;
+        }
+    }
 }
 
 
@@ -605,7 +1793,10 @@ void PathBaker::bake(const IScene& scene,
                      int numThreads,
                      ProbeBatch& probes,
                      ProgressCallback progressCallback,
-                     void* callbackUserData)
+                     void* callbackUserData,
+                     const BakeShard& shard,
+                     float regionSize,
+                     bool incremental)
 {
     PROFILE_FUNCTION();
 
@@ -618,6 +1809,29 @@ void PathBaker::bake(const IScene& scene,
     ThreadPool threadPool(numThreads);
     sThreadPool = &threadPool;
 
+    // Pruned visibility graphs are missing edges that were used to find paths, so they can't be updated.
+    if (incremental && probes.hasData(identifier) && !pruneVisGraph && !shard.isPartial() && regionSize <= 0.0f)
+    {
+        PathBakeParams params;
+        params.numSamples = numSamples;
+        params.radius = radius;
+        params.threshold = threshold;
+        params.visRange = visRange;
+        params.visRangeRealTime = visRangeRealTime;
+        params.pathRange = pathRange;
+        params.asymmetricVisRange = asymmetricVisRange;
+        params.down = down;
+        params.pruneVisGraph = pruneVisGraph;
+
+        auto& data = static_cast<BakedPathData&>(probes[identifier]);
+        if (data.update(scene, probes, params, numThreads, threadPool, sCancel, progressCallback, callbackUserData))
+        {
+            sThreadPool = nullptr;
+            sBakeInProgress = false;
+            return;
+        }
+    }
+
     if (probes.hasData(identifier))
     {
         probes.removeData(identifier);
@@ -626,10 +1840,108 @@ void PathBaker::bake(const IScene& scene,
     probes.addData(identifier, ipl::make_unique<BakedPathData>(scene, probes, numSamples, radius, threshold, visRange,
                                                           visRangeRealTime, pathRange, asymmetricVisRange, down,
                                                           pruneVisGraph, numThreads, threadPool, sCancel, progressCallback,
-                                                          callbackUserData));
+                                                          callbackUserData, shard, regionSize));
+
+    sThreadPool = nullptr;
+    sBakeInProgress = false;
+}
+
+bool PathBaker::merge(const BakedDataIdentifier& identifier,
+                      int numShards,
+                      ProbeBatch* const* shards,
+                      float visRangeRealTime,
+                      float pathRange,
+                      bool asymmetricVisRange,
+                      const Vector3f& down,
+                      bool pruneVisGraph,
+                      int numThreads,
+                      ProbeBatch& probes,
+                      ProgressCallback progressCallback,
+                      void* callbackUserData,
+                      float regionSize)
+{
+    PROFILE_FUNCTION();
+
+    assert(identifier.type == BakedDataType::Pathing);
+    assert(identifier.variation == BakedDataVariation::Dynamic);
+
+    if (numShards <= 0)
+        return false;
+
+    // Every shard must be present exactly once.
+    vector<uint8_t> shardFound(numShards);
+    for (auto i = 0; i < numShards; ++i)
+    {
+        auto valid = (shards[i] && shards[i]->hasData(identifier) && probes.hasSameProbes(*shards[i]));
+        if (valid)
+        {
+            const auto& shard = static_cast<const BakedPathData&>((*shards[i])[identifier]).shard();
+            valid = (shard.numShards == numShards && 0 <= shard.index && shard.index < numShards && !shardFound[shard.index]);
+            if (valid)
+            {
+                shardFound[shard.index] = true;
+            }
+        }
+
+        if (!valid)
+        {
+            gLog().message(MessageSeverity::Warning, "Pathing bake shard %d does not match the probe batch being merged "
+                "into, or is a duplicate.", i);
+            return false;
+        }
+    }
+
+    // Every shard must have computed its rows of the visibility graph using the same parameters.
+    const auto& shardParams = static_cast<const BakedPathData&>((*shards[0])[identifier]).params();
+    for (auto i = 1; i < numShards; ++i)
+    {
+        const auto& otherParams = static_cast<const BakedPathData&>((*shards[i])[identifier]).params();
+        if (otherParams.numSamples != shardParams.numSamples || otherParams.radius != shardParams.radius ||
+            otherParams.threshold != shardParams.threshold || otherParams.visRange != shardParams.visRange ||
+            otherParams.asymmetricVisRange != shardParams.asymmetricVisRange || otherParams.down != shardParams.down)
+        {
+            gLog().message(MessageSeverity::Warning, "Pathing bake shard %d was baked with different parameters than "
+                "shard 0.", i);
+            return false;
+        }
+    }
+
+    auto params = shardParams;
+    params.visRangeRealTime = visRangeRealTime;
+    params.pathRange = pathRange;
+    params.asymmetricVisRange = asymmetricVisRange;
+    params.down = down;
+    params.pruneVisGraph = pruneVisGraph;
+
+    auto visGraph = ipl::make_unique<ProbeVisibilityGraph>(probes.numProbes());
+    for (auto i = 0; i < numShards; ++i)
+    {
+        const auto& shardData = static_cast<const BakedPathData&>((*shards[i])[identifier]);
+        visGraph->mergeShard(shardData.visGraph(), shardData.shard());
+    }
+
+    visGraph->complete();
+    visGraph->updateCosts(probes);
+
+    sBakeInProgress = true;
+    sCancel = false;
+
+    ThreadPool threadPool(numThreads);
+    sThreadPool = &threadPool;
+
+    if (probes.hasData(identifier))
+    {
+        probes.removeData(identifier);
+    }
+
+    probes.addData(identifier, ipl::make_unique<BakedPathData>(probes, std::move(visGraph), params, numThreads,
+                                                               threadPool, sCancel, progressCallback, callbackUserData,
+                                                               regionSize));
 
     sThreadPool = nullptr;
     sBakeInProgress = false;
+
+    return true;
 }
 
 void PathBaker::cancel()
@@ -32,10 +32,10 @@ namespace ipl {
 class SoundPath
 {
 public:
-    int16_t firstProbe; // The second probe in the sequence of probes from start to end.
-    int16_t lastProbe; // The second-to-last probe in the sequence of probes from start to end.
-    int16_t probeAfterFirst; // Valid if >= 2 probes.
-    int16_t probeBeforeLast; // Valid if >= 2 probes.
+    int32_t firstProbe; // The second probe in the sequence of probes from start to end.
+    int32_t lastProbe; // The second-to-last probe in the sequence of probes from start to end.
+    int32_t probeAfterFirst; // Valid if >= 2 probes.
+    int32_t probeBeforeLast; // Valid if >= 2 probes.
     bool direct; // Is this a direct path?
     float distanceInternal; // Total distance along the path from firstProbe to lastProbe.
     float deviationInternal; // Total deviation angle along the path from firstProbe to lastProbe.
@@ -110,12 +110,137 @@ public:
 };
 
 
+// --------------------------------------------------------------------------------------------------------------------
+// SoundPathTable
+// --------------------------------------------------------------------------------------------------------------------
+
+// Collects the unique SoundPaths found while baking. Paths can be added from multiple threads at once: the table is
+// split into shards, each protected by its own mutex, so threads adding different paths rarely wait for each other.
+// Paths are given ids in the order in which they are first added, which depends on thread timing, so once baking is
+// complete, the ids are remapped to indices into a sorted array of paths. The invalid path is always at index 0.
+class SoundPathTable
+{
+public:
+    SoundPathTable();
+
+    int numPaths() const
+    {
+        return mNumPaths;
+    }
+
+    // Returns the id of the given path, adding it to the table if needed. Thread-safe.
+    int insert(const SoundPath& soundPath);
+
+    // Sorts the unique paths into uniquePaths, and returns the index into uniquePaths of each path id in remap.
+    void finalize(Array<SoundPath>& uniquePaths,
+                  vector<int>& remap) const;
+
+private:
+    static const int kNumShards = 64;
+
+    struct Hash
+    {
+        size_t operator()(const SoundPath& soundPath) const;
+    };
+
+    struct Equal
+    {
+        bool operator()(const SoundPath& lhs,
+                        const SoundPath& rhs) const;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        unordered_map<SoundPath, int, Hash, Equal> ids;
+    };
+
+    Shard mShards[kNumShards];
+    std::atomic<int> mNumPaths;
+};
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// PathRegion
+// --------------------------------------------------------------------------------------------------------------------
+
+// When paths are baked hierarchically, probes are grouped into regions, and paths are only baked between pairs of
+// probes in the same region. SoundPaths for a region refer to probes by their index within the region.
+struct PathRegion
+{
+    vector<int32_t> probes; // Indices of the probes in this region, in ascending order.
+    vector<int32_t> portals; // Indices of the probes in this region that can see probes in other regions.
+
+    // Refs for the paths between probes in this region, in the same format as BakedPathData, using indices into
+    // the probes array.
+    vector<int32_t> pathRowStarts;
+    vector<int32_t> pathColumns;
+    vector<SoundPathRef> pathRefs;
+};
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// PortalSearch
+// --------------------------------------------------------------------------------------------------------------------
+
+// Scratch space for searching the portal graph of hierarchically baked paths. Costs and parents are indexed by
+// portal, and each search only resets the entries of the portals reached by the previous one, so a single
+// PortalSearch can be reused for every lookup made by one thread.
+struct PortalSearch
+{
+    vector<float> costs; // Cost of the best path found so far from the start probe to each portal.
+    vector<int32_t> parents; // The previous portal along that path, or -1.
+    vector<int32_t> visitedPortals; // Portals whose costs were set by the last search.
+    vector<PathFinder::PriorityQueueEntry> queue; // Priority queue, stored as a binary heap.
+    vector<int32_t> portals; // Sequence of portals along the shortest path.
+    vector<int> nodes; // Sequence of probes along the shortest path.
+    ProbePath path; // The shortest path.
+
+    // Resets the entries set by the last search, and resizes the arrays if needed.
+    void reset(int numPortals);
+};
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// PathBakeParams
+// --------------------------------------------------------------------------------------------------------------------
+
+// The parameters used to bake pathing data, other than the shard and region size. Data can only be updated
+// incrementally using the same parameters as were used to bake it. Data saved by older versions has numSamples set
+// to 0, since its parameters are unknown.
+struct PathBakeParams
+{
+    int numSamples = 0;
+    float radius = 0.0f;
+    float threshold = 0.0f;
+    float visRange = 0.0f;
+    float visRangeRealTime = 0.0f;
+    float pathRange = 0.0f;
+    bool asymmetricVisRange = false;
+    Vector3f down{ 0.0f, -1.0f, 0.0f };
+    bool pruneVisGraph = false;
+};
+
+bool operator==(const PathBakeParams& lhs,
+                const PathBakeParams& rhs);
+
+bool operator!=(const PathBakeParams& lhs,
+                const PathBakeParams& rhs);
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // BakedPathData
 // --------------------------------------------------------------------------------------------------------------------
 
 // Represents the baked data used for looking up paths at runtime. This is the data that should be serialized to disk
 // during baking. The data stored is a SoundPath for every pair of probes.
+//
+// If a region size is specified when baking, paths are baked hierarchically instead: probes are grouped into regions
+// using a uniform grid, and SoundPaths are only stored for pairs of probes in the same region. Probes that can see
+// probes in other regions are portals, and are connected by a sparse graph, whose edges are either visibility graph
+// edges between regions, or baked paths within a region. Paths between regions are found at run-time by searching
+// the portal graph, so bake time and memory grow roughly linearly with the number of probes, rather than
+// quadratically.
 class BakedPathData : public IBakedData
 {
 public:
@@ -137,26 +262,31 @@ public:
                   ThreadPool& threadPool,
                   std::atomic<bool>& cancel,
                   ProgressCallback progressCallback = nullptr,
-                  void* callbackUserData = nullptr);
+                  void* callbackUserData = nullptr,
+                  const BakeShard& shard = BakeShard{},
+                  float regionSize = 0.0f);
+
+    // Generates baked data given a complete visibility graph, e.g. one that was merged from several shards, which was
+    // generated using the given parameters. Calculates shortest paths between every pair of probes.
+    BakedPathData(const ProbeBatch& probes,
+                  unique_ptr<ProbeVisibilityGraph> visGraph,
+                  const PathBakeParams& params,
+                  int numThreads,
+                  ThreadPool& threadPool,
+                  std::atomic<bool>& cancel,
+                  ProgressCallback progressCallback = nullptr,
+                  void* callbackUserData = nullptr,
+                  float regionSize = 0.0f);
 
     // Loads baked data from a serialized object.
     BakedPathData(const Serialized::BakedPathingData* serializedObject);
 
     virtual void updateProbePosition(int index,
-                                     const Vector3f& position) override
-    {
-        mNeedsUpdate = true;
-    }
+                                     const Vector3f& position) override;
 
-    virtual void addProbe(const Sphere& influence) override
-    {
-        mNeedsUpdate = true;
-    }
+    virtual void addProbe(const Sphere& influence) override;
 
-    virtual void removeProbe(int index) override
-    {
-        mNeedsUpdate = true;
-    }
+    virtual void removeProbe(int index) override;
 
     virtual void updateEndpoint(const BakedDataIdentifier& identifier,
                                 const Probe* probes,
@@ -174,10 +304,59 @@ public:
         return mNeedsUpdate;
     }
 
-    // Queries the baked data for the shortest path between the start probe and the end probe.
+    // Returns a number that changes whenever probes are added or removed, or paths or visibility graph costs change.
+    uint32_t version() const
+    {
+        return mVersion;
+    }
+
+    // Marks a probe as needing its visibility tested again, e.g. because geometry near it has changed.
+    void invalidate(int index);
+
+    // Updates the visibility graph and paths after probes have been moved, added, removed, or invalidated. Visibility
+    // is only tested for probes that have been moved, added, or invalidated, and paths are only calculated again
+    // from probes that can reach an edge of the visibility graph that has changed. The results are identical to
+    // baking from scratch with the given parameters. Returns false if the data cannot be updated incrementally, e.g.
+    // because it was baked hierarchically, or with different parameters, in which case it must be baked again.
+    bool update(const IScene& scene,
+                const ProbeBatch& probes,
+                const PathBakeParams& params,
+                int numThreads,
+                ThreadPool& threadPool,
+                std::atomic<bool>& cancel,
+                ProgressCallback progressCallback = nullptr,
+                void* callbackUserData = nullptr);
+
+    // If partial, this data was baked by one shard of a sharded bake. It only contains the rows of the visibility
+    // graph computed by the shard, and no paths, so it cannot be used until all the shards have been merged.
+    const BakeShard& shard() const
+    {
+        return mShard;
+    }
+
+    const PathBakeParams& params() const
+    {
+        return mParams;
+    }
+
+    // Returns true if paths were baked hierarchically.
+    bool isHierarchical() const
+    {
+        return (mRegionSize > 0.0f);
+    }
+
+    int numRegions() const
+    {
+        return static_cast<int>(mRegions.size());
+    }
+
+    // Queries the baked data for the shortest path between the start probe and the end probe. If paths were baked
+    // hierarchically, and the probes are in different regions, the path is found by searching the portal graph,
+    // using the given scratch space if it is non-null.
     SoundPath lookupShortestPath(int start,
                                  int end,
-                                 ProbePath* probePath) const;
+                                 ProbePath* probePath,
+                                 PortalSearch* search = nullptr) const;
 
     // Returns the size (in bytes) of the baked data.
     virtual uint64_t serializedSize() const override;
@@ -185,13 +364,107 @@ public:
     // Saves the baked data to a serialized object.
     flatbuffers::Offset<Serialized::BakedPathingData> serialize(SerializedObject& serializedObject) const;
 
+    // Also updates the probe positions used to find paths between regions, if paths were baked hierarchically.
     void updateVisGraphCosts(const ProbeBatch& probeBatch);
 
 private:
     unique_ptr<ProbeVisibilityGraph> mVisGraph; // The visibility graph.
     Array<SoundPath> mUniqueBakedPaths; // The unique SoundPaths.
-    Array<SoundPathRef, 2> mBakedPathRefs; // SoundPathRefs for SoundPaths between every pair of probes.
+    // SoundPathRefs for SoundPaths between every pair of probes (start, end) with end <= start, stored as a sparse
+    // matrix in compressed sparse row format. Only pairs connected by a valid path are stored. The refs for start probe
+    // i are mPathRefs[mPathRowStarts[i]] to mPathRefs[mPathRowStarts[i + 1] - 1], and the corresponding end probes are
+    // in mPathColumns, in ascending order.
+    vector<int32_t> mPathRowStarts;
+    vector<int32_t> mPathColumns;
+    vector<SoundPathRef> mPathRefs;
+    BakeShard mShard; // The shard of the probe batch for which this data was baked.
     bool mNeedsUpdate;
+    uint32_t mVersion = 0;
+    vector<uint8_t> mInvalidProbes; // Probes whose visibility must be tested again.
+    vector<uint8_t> mChangedProbes; // Probes whose edges in the visibility graph have changed since paths were found.
+    PathBakeParams mParams; // The parameters used to bake this data.
+
+    // Hierarchical paths. The portal graph is stored in compressed sparse row format, with one row per probe: the
+    // edges from probe i are mPortalEdges[mPortalEdgeStarts[i]] to mPortalEdges[mPortalEdgeStarts[i + 1] - 1], with
+    // costs (path lengths) in mPortalEdgeCosts.
+    float mRegionSize;
+    vector<PathRegion> mRegions;
+    vector<int32_t> mProbeRegions; // The region containing each probe.
+    vector<int32_t> mProbeLocalIndices; // The index of each probe within its region.
+    vector<int32_t> mPortalIndices; // The index of each probe among all portals, or -1 if it isn't a portal.
+    int mNumPortals = 0;
+    vector<int32_t> mPortalEdgeStarts;
+    vector<int32_t> mPortalEdges;
+    vector<float> mPortalEdgeCosts;
+    vector<Vector3f> mProbeCenters;
+
+    // Calculates shortest paths between every pair of probes using the visibility graph, and extracts the unique
+    // SoundPaths. Each job finds the paths from one probe to every other probe, and adds them to the table of unique
+    // SoundPaths before moving on, so only one row of ProbePaths per thread is stored at any time. Returns false if
+    // cancelled.
+    bool findPaths(const ProbeBatch& probes,
+                   const ProbeVisibilityTester& visTester,
+                   float visRangeRealTime,
+                   float pathRange,
+                   bool pruneVisGraph,
+                   int numThreads,
+                   ThreadPool& threadPool,
+                   std::atomic<bool>& cancel,
+                   ProgressCallback progressCallback,
+                   void* callbackUserData);
+
+    // Groups probes into regions, and bakes paths between probes in each region, followed by the portal graph.
+    // Returns false if cancelled.
+    bool findHierarchicalPaths(const ProbeBatch& probes,
+                               float pathRange,
+                               int numThreads,
+                               ThreadPool& threadPool,
+                               std::atomic<bool>& cancel,
+                               ProgressCallback progressCallback,
+                               void* callbackUserData);
+
+    // Sets up the mappings between probes and regions, and the portals in each region, given the probes in each
+    // region and the portal graph.
+    void initRegions(int numProbes);
+
+    // Numbers the portals, so scratch space for searching the portal graph only needs one entry per portal.
+    void initPortalIndices(int numProbes);
+
+    // Returns the ref for the SoundPath between start and end, where end <= start. If the probes are not connected,
+    // the ref refers to the invalid SoundPath.
+    SoundPathRef findPathRef(int start,
+                             int end) const;
+
+    // Returns true if any of the probe indices in a SoundPath doesn't fit in the 16-bit serialized fields.
+    static bool needsWideProbeIndices(const SoundPath& path);
+
+    static SoundPathRef findPathRef(const vector<int32_t>& rowStarts,
+                                    const vector<int32_t>& columns,
+                                    const vector<SoundPathRef>& refs,
+                                    int start,
+                                    int end);
+
+    // Looks up the path between two probes in the same region, with probe indices relative to the region.
+    SoundPath lookupRegionPath(const PathRegion& region,
+                               int start,
+                               int end) const;
+
+    // Looks up the path between two probes in the same region, and converts probe indices in the path to indices
+    // into the probe batch.
+    SoundPath lookupRegionPathGlobal(int start,
+                                     int end) const;
+
+    // Appends the probes between start and end (which must be in the same region) along the baked path, followed by
+    // end, to nodes. Returns false if there is no path.
+    bool appendRegionPath(int start,
+                          int end,
+                          vector<int>& nodes) const;
+
+    // Finds the shortest path between two probes, by searching the portal graph if needed.
+    SoundPath lookupHierarchicalPath(int start,
+                                     int end,
+                                     ProbePath* probePath,
+                                     PortalSearch& search) const;
 
     void reconstructProbePath(int start,
                               int end,
@@ -207,6 +480,9 @@ private:
 class PathBaker
 {
 public:
+    // If incremental is true, and the probe batch already contains data with the given identifier, only the parts
+    // of the data affected by changes to the probe batch since it was baked are updated, if possible (see
+    // BakedPathData::update).
     static void bake(const IScene& scene,
                      const BakedDataIdentifier& identifier,
                      int numSamples,
@@ -221,7 +497,28 @@ public:
                      int numThreads,
                      ProbeBatch& probes,
                      ProgressCallback progressCallback = nullptr,
-                     void* callbackUserData = nullptr);
+                     void* callbackUserData = nullptr,
+                     const BakeShard& shard = BakeShard{},
+                     float regionSize = 0.0f,
+                     bool incremental = false);
+
+    // Merges the data baked by every shard of a sharded bake, and calculates paths between every pair of probes. The
+    // resulting data is identical to what would have been baked by a single process. Each shard must be a probe
+    // batch containing the same probes, in which a different shard has been baked. Returns false if any shards are
+    // missing or do not match the probe batch.
+    static bool merge(const BakedDataIdentifier& identifier,
+                      int numShards,
+                      ProbeBatch* const* shards,
+                      float visRangeRealTime,
+                      float pathRange,
+                      bool asymmetricVisRange,
+                      const Vector3f& down,
+                      bool pruneVisGraph,
+                      int numThreads,
+                      ProbeBatch& probes,
+                      ProgressCallback progressCallback = nullptr,
+                      void* callbackUserData = nullptr,
+                      float regionSize = 0.0f);
 
     static void cancel();
 
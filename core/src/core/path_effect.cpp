@@ -21,6 +21,52 @@
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// PathHRTFCache
+// --------------------------------------------------------------------------------------------------------------------
+
+float PathHRTFCache::sHRTFUpdateTolerance = 0.01f;
+
+PathHRTFCache::PathHRTFCache(int maxOrder)
+    : mCoeffs(SphericalHarmonics::numCoeffsForOrder(maxOrder))
+    , mHRTFDatabase(nullptr)
+    , mOrder(-1)
+{}
+
+void PathHRTFCache::reset()
+{
+    mHRTFDatabase = nullptr;
+    mOrder = -1;
+}
+
+bool PathHRTFCache::needsUpdate(const HRTFDatabase* hrtf,
+                                int order,
+                                const float* coeffs) const
+{
+    if (hrtf != mHRTFDatabase || order != mOrder)
+        return true;
+
+    auto maxCoeff = 0.0f;
+    auto maxChange = 0.0f;
+    for (auto i = 0; i < SphericalHarmonics::numCoeffsForOrder(order); ++i)
+    {
+        maxCoeff = std::max(maxCoeff, fabsf(coeffs[i]));
+        maxChange = std::max(maxChange, fabsf(coeffs[i] - mCoeffs[i]));
+    }
+
+    return (maxChange > sHRTFUpdateTolerance * maxCoeff);
+}
+
+void PathHRTFCache::update(const HRTFDatabase* hrtf,
+                           int order,
+                           const float* coeffs)
+{
+    mHRTFDatabase = hrtf;
+    mOrder = order;
+    memcpy(mCoeffs.data(), coeffs, SphericalHarmonics::numCoeffsForOrder(order) * sizeof(float));
+}
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // PathEffect
 // --------------------------------------------------------------------------------------------------------------------
@@ -62,6 +108,8 @@ PathEffect::PathEffect(const AudioSettings& audioSettings,
         mSpeakerBuffer = make_unique<AudioBuffer>(effectSettings.speakerLayout->numSpeakers, 1);
 
         mHRTF.resize(2, effectSettings.hrtf->numSpectrumSamples());
+        mRotatedCoeffs.resize(SphericalHarmonics::numCoeffsForOrder(effectSettings.maxOrder));
+        mHRTFCache = make_unique<PathHRTFCache>(effectSettings.maxOrder);
     }
     else
     {
@@ -91,6 +139,7 @@ void PathEffect::reset()
     if (mSpatialize)
     {
         mOverlapAddEffect->reset();
+        mHRTFCache->reset();
     }
 
     mPrevBinaural = false;
@@ -100,6 +149,11 @@ void PathEffect::reset()
 //
 // 1. EQ is applied to the dry audio.
 // 2. The EQ-filtered audio is scaled by each SH coefficient in turn and combined into an Ambisonics buffer.
+//
+// When rendering binaurally, the rotated SH coefficients are instead used to blend the HRTF database's Ambisonics
+// HRTFs into a single HRTF, which is convolved with the EQ-filtered audio. Since the coefficients usually change slowly,
+// the blended HRTF is reused until they change by more than PathHRTFCache::sHRTFUpdateTolerance, so most frames cost about as much
+// as rendering a single HRTF.
 AudioEffectState PathEffect::apply(const PathEffectParams& params,
                                    const AudioBuffer& in,
                                    AudioBuffer& out)
@@ -142,8 +196,15 @@ AudioEffectState PathEffect::apply(const PathEffectParams& params,
 
         mAmbisonicsRotateEffect->apply(ambisonicsRotateParams, *mAmbisonicsBuffer, *mAmbisonicsBuffer);
 
-        if (params.binaural)
+        for (auto i = 0; i < SphericalHarmonics::numCoeffsForOrder(params.order); ++i)
         {
+            mRotatedCoeffs[i] = (*mAmbisonicsBuffer)[i][0];
+        }
+
+        if (params.binaural && mHRTFCache->needsUpdate(params.hrtf, params.order, mRotatedCoeffs.data()))
+        {
+            mHRTFCache->update(params.hrtf, params.order, mRotatedCoeffs.data());
+
             // blend hrtf
             memset(mHRTF.flatData(), 0, mHRTF.totalSize() * sizeof(complex_t));
 
@@ -165,7 +226,10 @@ AudioEffectState PathEffect::apply(const PathEffectParams& params,
                     }
                 }
             }
+        }
 
+        if (params.binaural)
+        {
             // convolve with blended hrtf
             OverlapAddConvolutionEffectParams overlapAddParams{};
             overlapAddParams.fftIR = mHRTF.data();
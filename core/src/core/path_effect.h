@@ -26,6 +26,42 @@
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// PathHRTFCache
+// --------------------------------------------------------------------------------------------------------------------
+
+// Tracks the rotated SH coefficients from which PathEffect last blended an HRTF, so the blended HRTF can be reused
+// while they change slowly.
+class PathHRTFCache
+{
+public:
+    // When rendering binaurally, the HRTF is only derived again from the rotated SH coefficients if any of them has
+    // changed by more than this fraction of the largest coefficient since the HRTF was last derived.
+    static float sHRTFUpdateTolerance;
+
+    PathHRTFCache(int maxOrder);
+
+    // Forces the HRTF to be derived again the next time.
+    void reset();
+
+    // Returns true if coeffs differ enough from the coefficients from which the HRTF was last derived that it must
+    // be derived again.
+    bool needsUpdate(const HRTFDatabase* hrtf,
+                     int order,
+                     const float* coeffs) const;
+
+    // Records that the HRTF has been derived from coeffs.
+    void update(const HRTFDatabase* hrtf,
+                int order,
+                const float* coeffs);
+
+private:
+    Array<float> mCoeffs; // The rotated SH coefficients from which the HRTF was derived.
+    const HRTFDatabase* mHRTFDatabase; // The HRTF database from which the HRTF was derived.
+    int mOrder; // The order of the SH coefficients from which the HRTF was derived, or -1 if it must be derived again.
+};
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // PathEffect
 // --------------------------------------------------------------------------------------------------------------------
@@ -81,6 +117,8 @@ private:
     unique_ptr<AudioBuffer> mAmbisonicsBuffer; // Temp buffer for rotating SH coefficients when spatializing.
     unique_ptr<AudioBuffer> mSpeakerBuffer; // Temp buffer for calculating speaker gains when spatializing.
     Array<complex_t, 2> mHRTF; // Temp buffer for deriving a single HRTF from rotated SH coefficients when spatializing.
+    Array<float> mRotatedCoeffs; // The rotated SH coefficients from mAmbisonicsBuffer, when spatializing.
+    unique_ptr<PathHRTFCache> mHRTFCache; // For deciding when mHRTF must be derived again when spatializing.
     bool mPrevBinaural;
 };
 
@@ -27,54 +27,49 @@ PathFinder::PathFinder(const ProbeBatch& probes,
                        int numThreads)
     : mParents(numThreads, probes.numProbes())
     , mCosts(numThreads, probes.numProbes())
+    , mHeapPositions(numThreads, probes.numProbes())
+    , mPriorityQueue(numThreads)
+    , mVisitedNodes(numThreads)
 {
     for (auto i = 0; i < numThreads; ++i)
     {
-        vector<PriorityQueueEntry> container;
-        container.reserve(2 * probes.numProbes());
-
-        priority_queue<PriorityQueueEntry> priorityQueue(std::less<PriorityQueueEntry>(), std::move(container));
+        for (auto j = 0; j < probes.numProbes(); ++j)
+        {
+            mParents[i][j] = -1;
+            mCosts[i][j] = std::numeric_limits<float>::infinity();
+            mHeapPositions[i][j] = -1;
+        }
 
-        mPriorityQueue.push_back(priorityQueue);
+        mPriorityQueue[i].reserve(probes.numProbes());
+        mVisitedNodes[i].reserve(probes.numProbes());
     }
 }
 
 // Uses Dijkstra's algorithm to find the minimum spanning tree rooted at the start node.
-void PathFinder::findAllShortestPaths(const IScene& scene,
-                                      const ProbeBatch& probes,
+void PathFinder::findAllShortestPaths(const ProbeBatch& probes,
                                       const ProbeVisibilityGraph& visGraph,
                                       int start,
-                                      float radius,
-                                      float threshold,
                                       float pathRange,
                                       int threadIndex,
                                       ProbePath* paths) const
 {
     PROFILE_FUNCTION();
 
-    for (auto i = 0; i < probes.numProbes(); ++i)
-    {
-        mParents[threadIndex][i] = -1;
-        mCosts[threadIndex][i] = std::numeric_limits<float>::infinity();
-    }
+    assert(static_cast<int>(visGraph.mEdgeStarts.size()) == probes.numProbes() + 1);
 
-    mCosts[threadIndex][start] = 0.0f;
+    reset(threadIndex);
 
-    while (!mPriorityQueue[threadIndex].empty())
-    {
-        mPriorityQueue[threadIndex].pop();
-    }
-
-    mPriorityQueue[threadIndex].push(PriorityQueueEntry{start, mCosts[threadIndex][start]});
+    setCost(threadIndex, start, 0.0f);
+    push(threadIndex, start, 0.0f);
 
     while (!mPriorityQueue[threadIndex].empty())
     {
-        auto u = mPriorityQueue[threadIndex].top().nodeIndex;
-
-        mPriorityQueue[threadIndex].pop();
+        auto u = pop(threadIndex);
 
-        for (const auto& entry : visGraph.mAdjacent[u])
+        for (auto e = visGraph.mEdgeStarts[u]; e < visGraph.mEdgeStarts[u + 1]; ++e)
         {
+            const auto& entry = visGraph.mEdges[e];
+
             auto v = entry.index;
             auto newCost = mCosts[threadIndex][u] + entry.cost;
 
@@ -83,10 +78,10 @@ void PathFinder::findAllShortestPaths(const IScene& scene,
 
             if (newCost < mCosts[threadIndex][v])
             {
-                mCosts[threadIndex][v] = newCost;
+                setCost(threadIndex, v, newCost);
                 mParents[threadIndex][v] = u;
 
-                mPriorityQueue[threadIndex].push(PriorityQueueEntry{v, newCost});
+                push(threadIndex, v, newCost);
             }
         }
     }
@@ -136,37 +131,29 @@ ProbePath PathFinder::findShortestPath(const IScene& scene,
     result.start = start;
     result.end = end;
 
-    for (auto i = 0; i < probes.numProbes(); ++i)
-    {
-        mParents[threadIndex][i] = -1;
-        mCosts[threadIndex][i] = std::numeric_limits<float>::infinity();
-    }
+    assert(static_cast<int>(visGraph.mEdgeStarts.size()) == probes.numProbes() + 1);
+
+    reset(threadIndex);
 
     auto ProbeDistance = [&probes](int start, int end) -> float
     {
         return (probes[start].influence.center - probes[end].influence.center).length();
     };
 
-    mCosts[threadIndex][start] = 0;
-
-    while (!mPriorityQueue[threadIndex].empty())
-    {
-        mPriorityQueue[threadIndex].pop();
-    }
-
-    mPriorityQueue[threadIndex].push(PriorityQueueEntry{start, mCosts[threadIndex][start]});
+    setCost(threadIndex, start, 0.0f);
+    push(threadIndex, start, 0.0f);
 
     while (!mPriorityQueue[threadIndex].empty())
     {
-        auto u = mPriorityQueue[threadIndex].top().nodeIndex;
-
-        if (u == end)
+        if (mPriorityQueue[threadIndex][0].nodeIndex == end)
             break;
 
-        mPriorityQueue[threadIndex].pop();
+        auto u = pop(threadIndex);
 
-        for (const auto& entry : visGraph.mAdjacent[u])
+        for (auto e = visGraph.mEdgeStarts[u]; e < visGraph.mEdgeStarts[u + 1]; ++e)
         {
+            const auto& entry = visGraph.mEdges[e];
+
             auto v = entry.index;
 
             auto newCost = mCosts[threadIndex][u] + entry.cost;
@@ -180,10 +167,10 @@ ProbePath PathFinder::findShortestPath(const IScene& scene,
                         continue;
                 }
 
-                mCosts[threadIndex][v] = newCost;
+                setCost(threadIndex, v, newCost);
                 mParents[threadIndex][v] = u;
 
-                mPriorityQueue[threadIndex].push(PriorityQueueEntry{v, newCost + ProbeDistance(v, end)});
+                push(threadIndex, v, newCost + ProbeDistance(v, end));
             }
         }
     }
@@ -251,6 +238,124 @@ void PathFinder::simplifyPath(const IScene& scene,
     }
 }
 
+void PathFinder::reset(int threadIndex) const
+{
+    for (auto i : mVisitedNodes[threadIndex])
+    {
+        mParents[threadIndex][i] = -1;
+        mCosts[threadIndex][i] = std::numeric_limits<float>::infinity();
+        mHeapPositions[threadIndex][i] = -1;
+    }
+
+    mVisitedNodes[threadIndex].clear();
+    mPriorityQueue[threadIndex].clear();
+}
+
+void PathFinder::setCost(int threadIndex,
+                         int nodeIndex,
+                         float cost) const
+{
+    if (mCosts[threadIndex][nodeIndex] == std::numeric_limits<float>::infinity())
+    {
+        mVisitedNodes[threadIndex].push_back(nodeIndex);
+    }
+
+    mCosts[threadIndex][nodeIndex] = cost;
+}
+
+void PathFinder::push(int threadIndex,
+                      int nodeIndex,
+                      float priority) const
+{
+    auto& heap = mPriorityQueue[threadIndex];
+
+    auto position = mHeapPositions[threadIndex][nodeIndex];
+    if (position < 0)
+    {
+        heap.push_back(PriorityQueueEntry{nodeIndex, priority});
+        position = static_cast<int>(heap.size()) - 1;
+    }
+
+    siftUp(threadIndex, position, PriorityQueueEntry{nodeIndex, priority});
+}
+
+int PathFinder::pop(int threadIndex) const
+{
+    auto& heap = mPriorityQueue[threadIndex];
+
+    auto top = heap[0].nodeIndex;
+    mHeapPositions[threadIndex][top] = -1;
+
+    auto last = heap.back();
+    heap.pop_back();
+
+    if (!heap.empty())
+    {
+        siftDown(threadIndex, 0, last);
+    }
+
+    return top;
+}
+
+void PathFinder::siftUp(int threadIndex,
+                        int position,
+                        const PriorityQueueEntry& entry) const
+{
+    auto& heap = mPriorityQueue[threadIndex];
+    auto* heapPositions = mHeapPositions[threadIndex];
+
+    while (position > 0)
+    {
+        auto parent = (position - 1) / kHeapArity;
+        if (heap[parent].cost <= entry.cost)
+            break;
+
+        heap[position] = heap[parent];
+        heapPositions[heap[position].nodeIndex] = position;
+        position = parent;
+    }
+
+    heap[position] = entry;
+    heapPositions[entry.nodeIndex] = position;
+}
+
+void PathFinder::siftDown(int threadIndex,
+                          int position,
+                          const PriorityQueueEntry& entry) const
+{
+    auto& heap = mPriorityQueue[threadIndex];
+    auto* heapPositions = mHeapPositions[threadIndex];
+    auto size = static_cast<int>(heap.size());
+
+    while (true)
+    {
+        auto firstChild = position * kHeapArity + 1;
+        if (firstChild >= size)
+            break;
+
+        auto lastChild = std::min(firstChild + kHeapArity, size);
+
+        auto smallestChild = firstChild;
+        for (auto child = firstChild + 1; child < lastChild; ++child)
+        {
+            if (heap[child].cost < heap[smallestChild].cost)
+            {
+                smallestChild = child;
+            }
+        }
+
+        if (heap[smallestChild].cost >= entry.cost)
+            break;
+
+        heap[position] = heap[smallestChild];
+        heapPositions[heap[position].nodeIndex] = position;
+        position = smallestChild;
+    }
+
+    heap[position] = entry;
+    heapPositions[entry.nodeIndex] = position;
+}
+
 bool operator<(const PathFinder::PriorityQueueEntry& lhs,
                const PathFinder::PriorityQueueEntry& rhs)
 {
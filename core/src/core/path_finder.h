@@ -72,13 +72,10 @@ public:
                int numThreads);
 
     // Finds shortest paths from the start probe to every other probe. Intended for use when baking paths as a
-    // preprocess.
-    void findAllShortestPaths(const IScene& scene,
-                              const ProbeBatch& probes,
+    // preprocess. Only the visibility graph is used, so no rays are traced.
+    void findAllShortestPaths(const ProbeBatch& probes,
                               const ProbeVisibilityGraph& visGraph,
                               int start,
-                              float radius,
-                              float threshold,
                               float pathRange,
                               int threadIndex,
                               ProbePath* paths) const;
@@ -99,9 +96,40 @@ public:
                                int threadIndex = 0) const;
 
 private:
+    // Number of children of each node in the priority queue's heap. A 4-ary heap is shallower than a binary heap,
+    // and the children of a node are adjacent in memory.
+    static const int kHeapArity = 4;
+
     Array<int, 2> mParents; // Per-thread array indicating the predecessor of each node, used during path finding.
     Array<float, 2> mCosts; // Per-thread array indicating the cost of each node, used during path finding.
-    mutable vector<priority_queue<PriorityQueueEntry>> mPriorityQueue; // Per-thread priority queues for use during path finding.
+    Array<int, 2> mHeapPositions; // Per-thread array indicating where each node is in the priority queue, or -1.
+    mutable vector<vector<PriorityQueueEntry>> mPriorityQueue; // Per-thread priority queues, stored as d-ary heaps.
+    mutable vector<vector<int>> mVisitedNodes; // Per-thread list of nodes whose costs were set by the last search.
+
+    // Resets the costs, parents, and priority queue entries of the nodes visited by the last search on the given
+    // thread. This way, each search only touches the nodes it reaches, instead of every probe.
+    void reset(int threadIndex) const;
+
+    // Sets the cost of a node, marking it as visited if needed.
+    void setCost(int threadIndex,
+                 int nodeIndex,
+                 float cost) const;
+
+    // Adds a node to the priority queue, or decreases its priority if it is already in the queue.
+    void push(int threadIndex,
+              int nodeIndex,
+              float priority) const;
+
+    // Removes the node with the lowest priority from the priority queue, and returns its index.
+    int pop(int threadIndex) const;
+
+    void siftUp(int threadIndex,
+                int position,
+                const PriorityQueueEntry& entry) const;
+
+    void siftDown(int threadIndex,
+                  int position,
+                  const PriorityQueueEntry& entry) const;
 
     // Simplifies paths computed by findShortestPath. Typically, the visGraph passed to findShortestPath will have a
     // shorter visibility range than what was used for baking, for perf reasons. This can cause paths to be jagged.
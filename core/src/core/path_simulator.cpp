@@ -25,6 +25,69 @@
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// PathCache
+// --------------------------------------------------------------------------------------------------------------------
+
+void PathCache::begin(const IScene& scene,
+                      const BakedPathData& bakedPathData,
+                      float radius,
+                      float threshold,
+                      float visRange,
+                      bool enableValidation,
+                      bool findAlternatePaths,
+                      bool simplifyPaths,
+                      bool realTimeVis)
+{
+    if (mScene != &scene || mSceneVersion != scene.version() || mBakedPathData != &bakedPathData ||
+        mBakedPathDataVersion != bakedPathData.version() || mRadius != radius || mThreshold != threshold ||
+        mVisRange != visRange || mEnableValidation != enableValidation || mFindAlternatePaths != findAlternatePaths ||
+        mSimplifyPaths != simplifyPaths || mRealTimeVis != realTimeVis)
+    {
+        mScene = &scene;
+        mSceneVersion = scene.version();
+        mBakedPathData = &bakedPathData;
+        mBakedPathDataVersion = bakedPathData.version();
+        mRadius = radius;
+        mThreshold = threshold;
+        mVisRange = visRange;
+        mEnableValidation = enableValidation;
+        mFindAlternatePaths = findAlternatePaths;
+        mSimplifyPaths = simplifyPaths;
+        mRealTimeVis = realTimeVis;
+
+        mEntries.clear();
+    }
+
+    std::swap(mPrevEntries, mEntries);
+    mEntries.clear();
+}
+
+bool PathCache::find(int start,
+                     int end,
+                     SoundPath& path)
+{
+    for (const auto& entry : mPrevEntries)
+    {
+        if (entry.start == start && entry.end == end)
+        {
+            path = entry.path;
+            mEntries.push_back(entry);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PathCache::add(int start,
+                    int end,
+                    const SoundPath& path)
+{
+    mEntries.push_back(Entry{start, end, path});
+}
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // PathSimulator
 // --------------------------------------------------------------------------------------------------------------------
@@ -48,7 +111,7 @@ bool PathSimulator::isPathOccluded(const SoundPath& path,
                                    int end,
                                    bool enableValidation,
                                    ValidationRayVisualizationCallback validationRayVisualization,
-                                   void* userData) const
+                                   void* userData)
 {
     PROFILE_FUNCTION();
 
@@ -60,50 +123,180 @@ bool PathSimulator::isPathOccluded(const SoundPath& path,
 
         const auto& bakedPathData = static_cast<const BakedPathData&>(probes[identifier]);
 
-        auto current = end;
-        auto prev = (path.direct) ? start : path.lastProbe;
+        mValidationEdges.clear();
+        if (!addValidationEdges(path, bakedPathData, start, end))
+            return true;
 
-        while (current != start)
-        {
-            bool probeVisible = enableValidation ? mVisTester.areProbesVisible(scene, probes, current, prev, radius, threshold) : true;
-            if (!probeVisible)
-            {
-                if (validationRayVisualization)
-                {
-                    validationRayVisualization(probes[prev].influence.center,
-                                               probes[current].influence.center, true, userData);
-                }
-
-                return true;
-            }
-            else
-            {
-                if (validationRayVisualization)
-                {
-                    validationRayVisualization(probes[prev].influence.center,
-                                               probes[current].influence.center, false, userData);
-                }
-            }
+        testValidationEdges(scene, probes, radius, threshold, enableValidation, validationRayVisualization, userData);
 
-            if (prev == start)
-                break;
+        return !areValidationEdgesVisible(0, static_cast<int>(mValidationEdges.size()));
+    }
+    else
+    {
+        return false;
+    }
+}
 
-            auto nextPath = bakedPathData.lookupShortestPath(start, prev, nullptr);
-            if (!nextPath.isValid())
-            {
-                return true;
-            }
+bool PathSimulator::addValidationEdges(const SoundPath& path,
+                                       const BakedPathData& bakedPathData,
+                                       int start,
+                                       int end)
+{
+    // Paths between regions of hierarchically baked data can't be reconstructed by looking up paths from the
+    // start probe to each probe along the path, so look up the full sequence of probes instead.
+    if (bakedPathData.isHierarchical())
+    {
+        ProbePath probePath;
+        bakedPathData.lookupShortestPath(start, end, &probePath, &mPortalSearch);
+        if (!probePath.valid)
+            return false;
 
+        auto current = end;
+        for (auto i = static_cast<int>(probePath.nodes.size()) - 1; i >= -1; --i)
+        {
+            auto prev = (i >= 0) ? probePath.nodes[i] : start;
+            mValidationEdges.push_back(std::make_pair(current, prev));
             current = prev;
-            prev = (nextPath.direct) ? start : nextPath.lastProbe;
         }
 
-        return false;
+        return true;
+    }
+
+    auto current = end;
+    auto prev = (path.direct) ? start : path.lastProbe;
+
+    while (current != start)
+    {
+        mValidationEdges.push_back(std::make_pair(current, prev));
+
+        if (prev == start)
+            break;
+
+        auto nextPath = bakedPathData.lookupShortestPath(start, prev, nullptr, &mPortalSearch);
+        if (!nextPath.isValid())
+            return false;
+
+        current = prev;
+        prev = (nextPath.direct) ? start : nextPath.lastProbe;
+    }
+
+    return true;
+}
+
+// Paths from the same source probe often share edges, so each edge is only tested once.
+void PathSimulator::testValidationEdges(const IScene& scene,
+                                        const ProbeBatch& probes,
+                                        float radius,
+                                        float threshold,
+                                        bool enableValidation,
+                                        ValidationRayVisualizationCallback validationRayVisualization,
+                                        void* userData)
+{
+    PROFILE_FUNCTION();
+
+    mUniqueValidationEdges = mValidationEdges;
+    std::sort(mUniqueValidationEdges.begin(), mUniqueValidationEdges.end());
+    mUniqueValidationEdges.erase(std::unique(mUniqueValidationEdges.begin(), mUniqueValidationEdges.end()), mUniqueValidationEdges.end());
+
+    auto numEdges = static_cast<int>(mUniqueValidationEdges.size());
+
+    mValidationFrom.resize(numEdges);
+    mValidationTo.resize(numEdges);
+    if (mValidationVisible.size(0) < static_cast<size_t>(numEdges))
+    {
+        mValidationVisible.resize(numEdges);
+    }
+
+    for (auto i = 0; i < numEdges; ++i)
+    {
+        mValidationFrom[i] = mUniqueValidationEdges[i].first;
+        mValidationTo[i] = mUniqueValidationEdges[i].second;
+    }
+
+    if (enableValidation)
+    {
+        mVisTester.areProbePairsVisible(scene, probes, numEdges, mValidationFrom.data(), mValidationTo.data(), radius,
+                                        threshold, mRayBatch, mValidationVisible.data());
     }
     else
     {
-        return false;
+        for (auto i = 0; i < numEdges; ++i)
+        {
+            mValidationVisible[i] = true;
+        }
+    }
+
+    if (validationRayVisualization)
+    {
+        for (auto i = 0; i < numEdges; ++i)
+        {
+            validationRayVisualization(probes[mValidationTo[i]].influence.center,
+                                       probes[mValidationFrom[i]].influence.center, !mValidationVisible[i], userData);
+        }
+    }
+}
+
+bool PathSimulator::areValidationEdgesVisible(int firstEdge,
+                                              int numEdges) const
+{
+    for (auto i = firstEdge; i < firstEdge + numEdges; ++i)
+    {
+        auto it = std::lower_bound(mUniqueValidationEdges.begin(), mUniqueValidationEdges.end(), mValidationEdges[i]);
+        if (!mValidationVisible[static_cast<int>(it - mUniqueValidationEdges.begin())])
+            return false;
+    }
+
+    return true;
+}
+
+void PathSimulator::validatePaths(const IScene& scene,
+                                  const ProbeBatch& probes,
+                                  const BakedPathData& bakedPathData,
+                                  float radius,
+                                  float threshold,
+                                  float visRange,
+                                  bool enableValidation,
+                                  bool findAlternatePaths,
+                                  bool simplifyPaths,
+                                  bool realTimeVis,
+                                  ValidationRayVisualizationCallback validationRayVisualization,
+                                  void* userData,
+                                  PathCache* cache,
+                                  SoundPath* paths,
+                                  const int* starts,
+                                  const int* ends)
+{
+    PROFILE_FUNCTION();
+
+    if (mPendingValidations.empty())
+        return;
+
+    testValidationEdges(scene, probes, radius, threshold, enableValidation, validationRayVisualization, userData);
+
+    for (const auto& pending : mPendingValidations)
+    {
+        auto i = pending.pathIndex;
+
+        auto occluded = pending.broken || !areValidationEdgesVisible(pending.firstEdge, pending.numEdges);
+
+        // Paths that are still invalid after this are skipped when calculating the sound field.
+        if (occluded && findAlternatePaths)
+        {
+            auto probePath = mPathFinder.findShortestPath(scene, probes, bakedPathData.visGraph(), mVisTester,
+                                                          starts[i], ends[i], radius, threshold, visRange,
+                                                          simplifyPaths, realTimeVis);
+
+            paths[i] = SoundPath(probePath, probes);
+        }
+
+        if (cache)
+        {
+            cache->add(starts[i], ends[i], paths[i]);
+        }
     }
+
+    mPendingValidations.clear();
+    mValidationEdges.clear();
 }
 
 // First, find the source-probe (the probe nearest to the source), and the listener-probes (all probes which influence
@@ -113,7 +306,8 @@ bool PathSimulator::isPathOccluded(const SoundPath& path,
 // Weights are calculated for the paths reaching each listener-probe, such that if the listener is closer to a given
 // listener-probe, its corresponding weight is larger.
 //
-// Optionally, we validate paths, by testing rays between every consecutive pair of probes.
+// Optionally, we validate paths, by testing rays between every consecutive pair of probes. The rays for all the paths
+// are traced together, once all the paths have been looked up.
 //
 // Optionally, if a baked path is found to be invalid (typically due to the presence of dynamic occluders), we search
 // for alternate paths.
@@ -121,6 +315,10 @@ bool PathSimulator::isPathOccluded(const SoundPath& path,
 // Optionally, if the source and listener are in line of sight (this visibility check is a single ray cast), we create
 // a SoundPath describing this.
 //
+// If a cache is specified, the paths from source-probes to listener-probes (after validation and rerouting) are only
+// found for pairs of probes that were not used in the previous call, or if the scene, baked data, or settings have
+// changed since then.
+//
 // Finally, all the paths that haven't been discarded are weighted and summed into a set of SH and EQ coefficients.
 bool PathSimulator::findPaths(const Vector3f& source,
                               const Vector3f& listener,
@@ -145,7 +343,8 @@ bool PathSimulator::findPaths(const Vector3f& source,
                               float* totalDeviation,
                               ValidationRayVisualizationCallback validationRayVisualization,
                               void* userData,
-                              bool forceDirectOcclusion)
+                              bool forceDirectOcclusion,
+                              PathCache* cache)
 {
     PROFILE_FUNCTION();
 
@@ -169,21 +368,40 @@ bool PathSimulator::findPaths(const Vector3f& source,
             {
                 const auto& bakedPathData = static_cast<const BakedPathData&>(probes[identifier]);
 
+                // Validation rays are only visualized when they are traced.
+                if (validationRayVisualization)
+                {
+                    cache = nullptr;
+                }
+
+                if (cache)
+                {
+                    cache->begin(scene, bakedPathData, radius, threshold, visRange, enableValidation, findAlternatePaths,
+                                 simplifyPaths, realTimeVis);
+                }
+
+                mPendingValidations.clear();
+                mValidationEdges.clear();
+
                 if (sEnablePathsFromAllSourceProbes)
                 {
                     for (auto i = 0; i < sourceProbes.numProbes(); ++i)
                     {
                         findPathsFromSourceProbe(scene, probes, sourceProbes, listenerProbes, bakedPathData, i, sourceProbes.weights[i],
                                                  radius, threshold, visRange, enableValidation, findAlternatePaths, simplifyPaths, realTimeVis,
-                                                 validationRayVisualization, userData, numPaths, paths, pathWeights, starts, ends);
+                                                 validationRayVisualization, userData, cache, numPaths, paths, pathWeights, starts, ends);
                     }
                 }
                 else
                 {
                     findPathsFromSourceProbe(scene, probes, sourceProbes, listenerProbes, bakedPathData, sourceProbes.findNearest(source), 1.0f,
                                              radius, threshold, visRange, enableValidation, findAlternatePaths, simplifyPaths, realTimeVis,
-                                             validationRayVisualization, userData, numPaths, paths, pathWeights, starts, ends);
+                                             validationRayVisualization, userData, cache, numPaths, paths, pathWeights, starts, ends);
                 }
+
+                validatePaths(scene, probes, bakedPathData, radius, threshold, visRange, enableValidation,
+                              findAlternatePaths, simplifyPaths, realTimeVis, validationRayVisualization, userData, cache,
+                              paths, starts, ends);
             }
         }
         else
@@ -230,6 +448,7 @@ void PathSimulator::findPathsFromSourceProbe(const IScene& scene,
                                              bool realTimeVis,
                                              ValidationRayVisualizationCallback validationRayVisualization,
                                              void* userData,
+                                             PathCache* cache,
                                              int& numPaths,
                                              SoundPath* paths,
                                              float* pathWeights,
@@ -245,7 +464,7 @@ void PathSimulator::findPathsFromSourceProbe(const IScene& scene,
     {
         findPathsFromSourceProbeToListenerProbe(scene, probes, listenerProbes, bakedPathData, sourceProbeIndex, sourceProbeWeight, i,
                                                 radius, threshold, visRange, enableValidation, findAlternatePaths,
-                                                simplifyPaths, realTimeVis, validationRayVisualization, userData,
+                                                simplifyPaths, realTimeVis, validationRayVisualization, userData, cache,
                                                 numPaths, paths, pathWeights, starts, ends);
     }
 }
@@ -266,6 +485,7 @@ void PathSimulator::findPathsFromSourceProbeToListenerProbe(const IScene& scene,
                                                             bool realTimeVis,
                                                             ValidationRayVisualizationCallback validationRayVisualization,
                                                             void* userData,
+                                                            PathCache* cache,
                                                             int& numPaths,
                                                             SoundPath* paths,
                                                             float* pathWeights,
@@ -278,33 +498,35 @@ void PathSimulator::findPathsFromSourceProbeToListenerProbe(const IScene& scene,
     auto listenerProbeIndex = listenerProbes.probeIndices[listenerProbeNeighborhoodIndex];
 
     SoundPath soundPath;
-    auto tryRealTime = false;
+    auto needsValidation = false;
 
-    soundPath = bakedPathData.lookupShortestPath(sourceProbeIndex, listenerProbeIndex, nullptr);
-    if (soundPath.isValid())
+    if (!cache || !cache->find(sourceProbeIndex, listenerProbeIndex, soundPath))
     {
-        if (isPathOccluded(soundPath, scene, probes, radius, threshold, sourceProbeIndex,
-            listenerProbeIndex, enableValidation, validationRayVisualization, userData))
+        soundPath = bakedPathData.lookupShortestPath(sourceProbeIndex, listenerProbeIndex, nullptr, &mPortalSearch);
+
+        // Valid paths are validated (and replaced with alternate paths if needed) by validatePaths, once all the paths
+        // have been looked up.
+        needsValidation = soundPath.isValid() && (enableValidation || validationRayVisualization);
+
+        if (cache && !needsValidation)
         {
-            if (findAlternatePaths)
-            {
-                tryRealTime = true;
-            }
+            cache->add(sourceProbeIndex, listenerProbeIndex, soundPath);
         }
     }
 
-    if (tryRealTime)
+    if (soundPath.isValid())
     {
-        ProbePath probePath;
-        probePath = mPathFinder.findShortestPath(scene, probes, bakedPathData.visGraph(),
-                                                 mVisTester, sourceProbeIndex, listenerProbeIndex, radius,
-                                                 threshold, visRange, simplifyPaths, realTimeVis);
+        if (needsValidation)
+        {
+            PendingValidation pending;
+            pending.pathIndex = numPaths;
+            pending.firstEdge = static_cast<int>(mValidationEdges.size());
+            pending.broken = !addValidationEdges(soundPath, bakedPathData, sourceProbeIndex, listenerProbeIndex);
+            pending.numEdges = static_cast<int>(mValidationEdges.size()) - pending.firstEdge;
 
-        soundPath = SoundPath(probePath, probes);
-    }
+            mPendingValidations.push_back(pending);
+        }
 
-    if (soundPath.isValid())
-    {
         paths[numPaths] = soundPath;
         pathWeights[numPaths] = sourceProbeWeight * listenerProbes.weights[listenerProbeNeighborhoodIndex];
         starts[numPaths] = sourceProbeIndex;
@@ -327,7 +549,7 @@ SoundPath PathSimulator::findShortestPathFromSourceProbeToListenerProbe(const IS
     }
 
     auto tryRealTime = false;
-    auto soundPath = bakedPathData.lookupShortestPath(sourceProbeIndex, listenerProbeIndex, &probePath);
+    auto soundPath = bakedPathData.lookupShortestPath(sourceProbeIndex, listenerProbeIndex, &probePath, &mPortalSearch);
     if (soundPath.isValid())
     {
         if (isPathOccluded(soundPath, scene, probes, radius, threshold, sourceProbeIndex,
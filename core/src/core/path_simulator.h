@@ -23,6 +23,65 @@
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// PathCache
+// --------------------------------------------------------------------------------------------------------------------
+
+// The paths found by PathSimulator::findPaths for one source, between pairs of source and listener probes, after
+// validation and rerouting. From one simulation update to the next, the source and listener usually remain near the
+// same probes, so these paths are reused for as long as the scene, the baked data, and the settings that affect
+// validation and rerouting remain unchanged. Each source should have its own cache. Changes to the scene are detected
+// using its version, so no cache should be used with scenes whose version does not change when they do.
+class PathCache
+{
+public:
+    // Discards all cached paths if any of the inputs have changed since the previous call, and otherwise makes the
+    // paths found during the previous call available for lookup.
+    void begin(const IScene& scene,
+               const BakedPathData& bakedPathData,
+               float radius,
+               float threshold,
+               float visRange,
+               bool enableValidation,
+               bool findAlternatePaths,
+               bool simplifyPaths,
+               bool realTimeVis);
+
+    // Looks up the path between a pair of probes found during the previous call. If found, it is kept for the next
+    // call as well.
+    bool find(int start,
+              int end,
+              SoundPath& path);
+
+    // Stores the path found between a pair of probes.
+    void add(int start,
+             int end,
+             const SoundPath& path);
+
+private:
+    struct Entry
+    {
+        int start;
+        int end;
+        SoundPath path;
+    };
+
+    const IScene* mScene = nullptr;
+    uint32_t mSceneVersion = 0;
+    const BakedPathData* mBakedPathData = nullptr;
+    uint32_t mBakedPathDataVersion = 0;
+    float mRadius = 0.0f;
+    float mThreshold = 0.0f;
+    float mVisRange = 0.0f;
+    bool mEnableValidation = false;
+    bool mFindAlternatePaths = false;
+    bool mSimplifyPaths = false;
+    bool mRealTimeVis = false;
+    vector<Entry> mPrevEntries; // Paths found during the previous call.
+    vector<Entry> mEntries; // Paths found, or reused, during the current call.
+};
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // PathSimulator
 // --------------------------------------------------------------------------------------------------------------------
@@ -46,7 +105,10 @@ public:
 
     // Calculates an Ambisonics sound field describing one or more paths from the source to the listener. The sound
     // field is described using two components: SH coefficients describing the directional distribution of sound, and
-    // EQ coefficients describing the overall low-pass filtering effect due to diffraction.
+    // EQ coefficients describing the overall low-pass filtering effect due to diffraction. If a cache is specified,
+    // paths between pairs of probes that were found by the previous call are reused, and only the parts of the
+    // simulation that depend on the source and listener positions are calculated again. The cache is not used when
+    // visualizing validation rays.
     bool findPaths(const Vector3f& source,
                    const Vector3f& listener,
                    const IScene& scene,
@@ -70,7 +132,8 @@ public:
                    float* totalDeviation = nullptr,
                    ValidationRayVisualizationCallback validationRayVisualization = nullptr,
                    void* userData = nullptr,
-                   bool forceDirectOcclusion = false);
+                   bool forceDirectOcclusion = false,
+                   PathCache* cache = nullptr);
 
     SoundPath findShortestPathFromSourceProbeToListenerProbe(const IScene& scene, const ProbeBatch& probes,
         int sourceProbeIndex, int listenerProbeIndex, const BakedPathData& bakedPathData, float radius, float threshold,
@@ -78,8 +141,26 @@ public:
         ProbePath& probePath, ValidationRayVisualizationCallback validationRayVisualization, void* userData);
 
 private:
+    // A baked path that was found by findPathsFromSourceProbeToListenerProbe, and must be validated before it can be
+    // used. The edges of the path are mValidationEdges[firstEdge] to mValidationEdges[firstEdge + numEdges - 1].
+    struct PendingValidation
+    {
+        int pathIndex;
+        int firstEdge;
+        int numEdges;
+        bool broken; // True if the path could not be reconstructed from the baked data.
+    };
+
     ProbeVisibilityTester mVisTester; // A visibility tester.
     PathFinder mPathFinder; // A path finder, used to find alternate paths at run-time if needed.
+    PortalSearch mPortalSearch; // Scratch space for looking up paths in hierarchically baked data.
+    ProbeVisibilityRayBatch mRayBatch; // Scratch space for tracing validation rays.
+    vector<PendingValidation> mPendingValidations; // Baked paths waiting to be validated.
+    vector<std::pair<int, int>> mValidationEdges; // Edges (from, to) of the baked paths waiting to be validated.
+    vector<std::pair<int, int>> mUniqueValidationEdges; // Sorted edges, each of which is tested once.
+    vector<int> mValidationFrom;
+    vector<int> mValidationTo;
+    Array<bool> mValidationVisible; // Results of testing each of the unique edges.
 
     void findPathsFromSourceProbe(const IScene& scene,
                                   const ProbeBatch& probes,
@@ -97,6 +178,7 @@ private:
                                   bool realTimeVis,
                                   ValidationRayVisualizationCallback validationRayVisualization,
                                   void* userData,
+                                  PathCache* cache,
                                   int& numPaths,
                                   SoundPath* paths,
                                   float* pathWeights,
@@ -119,11 +201,32 @@ private:
                                                  bool realTimeVis,
                                                  ValidationRayVisualizationCallback validationRayVisualization,
                                                  void* userData,
+                                                 PathCache* cache,
                                                  int& numPaths,
                                                  SoundPath* paths,
                                                  float* pathWeights,
                                                  int* starts,
                                                  int* ends);
+
+    // Validates all the baked paths found since the previous call, by tracing the rays for all their edges in one
+    // batch. Occluded paths are replaced with alternate paths if needed, and the results are stored in the cache.
+    void validatePaths(const IScene& scene,
+                       const ProbeBatch& probes,
+                       const BakedPathData& bakedPathData,
+                       float radius,
+                       float threshold,
+                       float visRange,
+                       bool enableValidation,
+                       bool findAlternatePaths,
+                       bool simplifyPaths,
+                       bool realTimeVis,
+                       ValidationRayVisualizationCallback validationRayVisualization,
+                       void* userData,
+                       PathCache* cache,
+                       SoundPath* paths,
+                       const int* starts,
+                       const int* ends);
+
     // Validates a baked path.
     bool isPathOccluded(const SoundPath& path,
                         const IScene& scene,
@@ -134,7 +237,27 @@ private:
                         int end,
                         bool enableValidation,
                         ValidationRayVisualizationCallback validationRayVisualization,
-                        void* userData) const;
+                        void* userData);
+
+    // Appends the edges of a baked path to mValidationEdges, from the end probe back to the start probe. Returns
+    // false if the path cannot be reconstructed from the baked data.
+    bool addValidationEdges(const SoundPath& path,
+                            const BakedPathData& bakedPathData,
+                            int start,
+                            int end);
+
+    // Tests each edge in mValidationEdges once, and stores the results in mValidationVisible.
+    void testValidationEdges(const IScene& scene,
+                             const ProbeBatch& probes,
+                             float radius,
+                             float threshold,
+                             bool enableValidation,
+                             ValidationRayVisualizationCallback validationRayVisualization,
+                             void* userData);
+
+    // Returns true if all the given edges in mValidationEdges were found to be visible by testValidationEdges.
+    bool areValidationEdgesVisible(int firstEdge,
+                                   int numEdges) const;
 
     // Given a set of SoundPaths describing multiple paths that reach the listener, and corresponding weights,
     // calculates the SH coefficients describing the total sound field.
@@ -23,6 +23,30 @@
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// ProbeVisibilityRayBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+void ProbeVisibilityRayBatch::resize(int numRays,
+                                     int numSamples)
+{
+    if (rays.size(0) < static_cast<size_t>(numRays))
+    {
+        rays.resize(numRays);
+        minDistances.resize(numRays);
+        maxDistances.resize(numRays);
+        occluded.resize(numRays);
+    }
+
+    if (fromSamples.size(0) < static_cast<size_t>(numSamples))
+    {
+        fromSamples.resize(numSamples);
+        toSamples.resize(numSamples);
+        toSamplesValid.resize(numSamples);
+    }
+}
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // ProbeVisibilityTester
 // --------------------------------------------------------------------------------------------------------------------
@@ -90,6 +114,161 @@ bool ProbeVisibilityTester::areProbesVisible(const IScene& scene,
     }
 }
 
+// Rays from each probe center to its own samples are traced once per probe rather than once per pair, and rays between
+// samples are traced one row (all samples of the to probe, for one sample of the from probe) at a time, so we can
+// still stop as soon as enough rays are unoccluded.
+void ProbeVisibilityTester::areProbesVisible(const IScene& scene,
+                                             const ProbeBatch& probes,
+                                             int from,
+                                             int numTo,
+                                             const int* to,
+                                             float radius,
+                                             float threshold,
+                                             ProbeVisibilityRayBatch& rayBatch,
+                                             bool* visible) const
+{
+    auto fromProbe = probes[from].influence.center;
+
+    if (mSamples.size(0) > 0 && radius > 0.0f)
+    {
+        auto numSamples = static_cast<int>(mSamples.size(0));
+        rayBatch.resize(numSamples, numSamples);
+
+        // Samples in the from probe that cannot be seen from its center are replaced by a sample whose ray is
+        // always skipped.
+        auto numFromSamples = 0;
+        for (auto i = 0; i < numSamples; ++i)
+        {
+            rayBatch.fromSamples[i] = Sampling::transformSphereVolumeSample(mSamples[i], Sphere(fromProbe, radius));
+            rayBatch.setRay(i, fromProbe, rayBatch.fromSamples[i]);
+        }
+
+        scene.anyHits(numSamples, rayBatch.rays.data(), rayBatch.minDistances.data(), rayBatch.maxDistances.data(),
+                      rayBatch.occluded.data());
+
+        for (auto i = 0; i < numSamples; ++i)
+        {
+            if (!rayBatch.occluded[i])
+            {
+                rayBatch.fromSamples[numFromSamples++] = rayBatch.fromSamples[i];
+            }
+        }
+
+        for (auto k = 0; k < numTo; ++k)
+        {
+            visible[k] = false;
+
+            auto toProbe = probes[to[k]].influence.center;
+
+            auto numToSamples = 0;
+            for (auto j = 0; j < numSamples; ++j)
+            {
+                rayBatch.toSamples[j] = Sampling::transformSphereVolumeSample(mSamples[j], Sphere(toProbe, radius));
+                rayBatch.setRay(j, toProbe, rayBatch.toSamples[j]);
+            }
+
+            scene.anyHits(numSamples, rayBatch.rays.data(), rayBatch.minDistances.data(),
+                          rayBatch.maxDistances.data(), rayBatch.occluded.data());
+
+            for (auto j = 0; j < numSamples; ++j)
+            {
+                if (!rayBatch.occluded[j])
+                {
+                    rayBatch.toSamples[numToSamples++] = rayBatch.toSamples[j];
+                }
+            }
+
+            auto numVisibleSamples = 0;
+            for (auto i = 0; i < numFromSamples && !visible[k]; ++i)
+            {
+                for (auto j = 0; j < numToSamples; ++j)
+                {
+                    rayBatch.setRay(j, rayBatch.fromSamples[i], rayBatch.toSamples[j]);
+                }
+
+                scene.anyHits(numToSamples, rayBatch.rays.data(), rayBatch.minDistances.data(),
+                              rayBatch.maxDistances.data(), rayBatch.occluded.data());
+
+                for (auto j = 0; j < numToSamples; ++j)
+                {
+                    if (!rayBatch.occluded[j])
+                    {
+                        ++numVisibleSamples;
+                    }
+                }
+
+                if ((static_cast<float>(numVisibleSamples) / static_cast<float>(numSamples)) >= threshold)
+                {
+                    visible[k] = true;
+                }
+            }
+        }
+    }
+    else
+    {
+        rayBatch.resize(numTo, 0);
+
+        for (auto k = 0; k < numTo; ++k)
+        {
+            rayBatch.setRay(k, fromProbe, probes[to[k]].influence.center);
+        }
+
+        scene.anyHits(numTo, rayBatch.rays.data(), rayBatch.minDistances.data(), rayBatch.maxDistances.data(),
+                      rayBatch.occluded.data());
+
+        for (auto k = 0; k < numTo; ++k)
+        {
+            visible[k] = !rayBatch.occluded[k];
+        }
+    }
+}
+
+// With point-to-point visibility, the rays for all pairs are traced in a single batch. With volumetric visibility, pairs
+// are tested using batches of sample rays, as above, so sorting the pairs by from probe saves the most time.
+void ProbeVisibilityTester::areProbePairsVisible(const IScene& scene,
+                                                 const ProbeBatch& probes,
+                                                 int numPairs,
+                                                 const int* from,
+                                                 const int* to,
+                                                 float radius,
+                                                 float threshold,
+                                                 ProbeVisibilityRayBatch& rayBatch,
+                                                 bool* visible) const
+{
+    if (mSamples.size(0) > 0 && radius > 0.0f)
+    {
+        // Consecutive pairs with the same from probe are tested together.
+        for (auto k = 0; k < numPairs;)
+        {
+            auto numTo = 1;
+            while (k + numTo < numPairs && from[k + numTo] == from[k])
+            {
+                ++numTo;
+            }
+
+            areProbesVisible(scene, probes, from[k], numTo, &to[k], radius, threshold, rayBatch, &visible[k]);
+            k += numTo;
+        }
+    }
+    else
+    {
+        rayBatch.resize(numPairs, 0);
+
+        for (auto k = 0; k < numPairs; ++k)
+        {
+            rayBatch.setRay(k, probes[from[k]].influence.center, probes[to[k]].influence.center);
+        }
+
+        scene.anyHits(numPairs, rayBatch.rays.data(), rayBatch.minDistances.data(), rayBatch.maxDistances.data(),
+                      rayBatch.occluded.data());
+
+        for (auto k = 0; k < numPairs; ++k)
+        {
+            visible[k] = !rayBatch.occluded[k];
+        }
+    }
+}
+
 // To save time, all pairs of probes whose distance from each other is at least visRange can be considered mutually
 // invisible.
 bool ProbeVisibilityTester::areProbesTooFar(const ProbeBatch& probes,
@@ -108,6 +287,109 @@ bool ProbeVisibilityTester::areProbesTooFar(const ProbeBatch& probes,
 }
 
 
+// --------------------------------------------------------------------------------------------------------------------
+// ProbeRangeGrid
+// --------------------------------------------------------------------------------------------------------------------
+
+ProbeRangeGrid::ProbeRangeGrid(const ProbeBatch& probes,
+                               const ProbeVisibilityTester& visTester,
+                               float visRange)
+{
+    auto numProbes = probes.numProbes();
+
+    vector<Vector3f> coordinates(numProbes);
+
+    Box bounds{};
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        coordinates[i] = visTester.rangeCoordinates(probes[i].influence.center);
+
+        for (auto axis = 0; axis < 3; ++axis)
+        {
+            bounds.minCoordinates[axis] = std::min(bounds.minCoordinates[axis], coordinates[i][axis]);
+            bounds.maxCoordinates[axis] = std::max(bounds.maxCoordinates[axis], coordinates[i][axis]);
+        }
+    }
+
+    auto extent = (numProbes > 0) ? bounds.extents() : Vector3f::kZero;
+    auto maxExtent = extent.maxComponent();
+
+    // Cells must be at least visRange wide, but we limit the number of cells, so they may be wider.
+    mCellSize = std::max(visRange, maxExtent / kMaxGridResolution);
+    if (!(mCellSize > 0.0f) || std::isinf(mCellSize))
+    {
+        mCellSize = std::max(maxExtent, 1.0f);
+    }
+
+    mMinCoordinates = (numProbes > 0) ? bounds.minCoordinates : Vector3f::kZero;
+
+    for (auto axis = 0; axis < 3; ++axis)
+    {
+        mGridResolution[axis] = std::min(std::max(static_cast<int>(ceilf(extent[axis] / mCellSize)), 1), kMaxGridResolution);
+    }
+
+    auto numCells = mGridResolution[0] * mGridResolution[1] * mGridResolution[2];
+
+    mProbeCells.resize(numProbes);
+    mCellStarts.assign(numCells + 1, 0);
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        int cell[3];
+        for (auto axis = 0; axis < 3; ++axis)
+        {
+            cell[axis] = static_cast<int>(floorf((coordinates[i][axis] - mMinCoordinates[axis]) / mCellSize));
+            cell[axis] = std::min(std::max(cell[axis], 0), mGridResolution[axis] - 1);
+        }
+
+        mProbeCells[i] = cellIndex(cell[0], cell[1], cell[2]);
+        mCellStarts[mProbeCells[i] + 1]++;
+    }
+
+    for (auto i = 0; i < numCells; ++i)
+    {
+        mCellStarts[i + 1] += mCellStarts[i];
+    }
+
+    // Probes are added in ascending order, so each cell's list is sorted.
+    mCellProbes.resize(numProbes);
+    vector<int> cellOffsets(mCellStarts.begin(), mCellStarts.end() - 1);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        mCellProbes[cellOffsets[mProbeCells[i]]++] = i;
+    }
+}
+
+void ProbeRangeGrid::findCandidates(int index,
+                                    int maxIndex,
+                                    vector<int>& candidates) const
+{
+    candidates.clear();
+
+    auto cell = mProbeCells[index];
+    int x = cell % mGridResolution[0];
+    int y = (cell / mGridResolution[0]) % mGridResolution[1];
+    int z = cell / (mGridResolution[0] * mGridResolution[1]);
+
+    for (auto k = std::max(z - 1, 0); k <= std::min(z + 1, mGridResolution[2] - 1); ++k)
+    {
+        for (auto j = std::max(y - 1, 0); j <= std::min(y + 1, mGridResolution[1] - 1); ++j)
+        {
+            for (auto i = std::max(x - 1, 0); i <= std::min(x + 1, mGridResolution[0] - 1); ++i)
+            {
+                auto neighbor = cellIndex(i, j, k);
+                for (auto p = mCellStarts[neighbor]; p < mCellStarts[neighbor + 1] && mCellProbes[p] < maxIndex; ++p)
+                {
+                    candidates.push_back(mCellProbes[p]);
+                }
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+}
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // ProbeVisibilityGraph
 // --------------------------------------------------------------------------------------------------------------------
@@ -122,22 +404,30 @@ ProbeVisibilityGraph::ProbeVisibilityGraph(const IScene& scene,
                                            JobGraph& jobGraph,
                                            std::atomic<bool>& cancel,
                                            ProgressCallback progressCallback,
-                                           void* callbackUserData)
+                                           void* callbackUserData,
+                                           const BakeShard& shard)
     : mAdjacent(probes.numProbes())
     , mNumJobsRemaining(0)
 {
     PROFILE_FUNCTION();
 
-    // For any 2 probe indices (i, j), we will only check visibility if i > j.
+    // For any 2 probe indices (i, j), we will only check visibility if i > j, and i and j are in the same or
+    // adjacent cells of the range grid.
     // We will divide the work of constructing the visibility graph into a set of jobs, where each job involves
     // constructing one or more rows of the adjacency list (mAdjacent[i]). A given row will never be processed by
-    // multiple threads concurrently.
+    // multiple threads concurrently. Only rows for probes in the shard are constructed.
     auto numProbes = probes.numProbes();
     auto numProbesPerJob = 1;
 
+    // Shared by all the jobs, and destroyed along with the last job that uses it.
+    auto buildState = make_shared<BuildState>(probes, visTester, visRange, numThreads);
+
+    auto stride = shard.numShards;
+    auto completeGraph = !shard.isPartial();
+
     auto numProbesThisJob = 0;
     auto firstProbeThisJob = 0;
-    for (auto i = 0; i < numProbes; i++)
+    for (auto i = shard.index; i < numProbes; i += stride)
     {
         numProbesThisJob++;
         if (numProbesThisJob == 1)
@@ -146,20 +436,31 @@ ProbeVisibilityGraph::ProbeVisibilityGraph(const IScene& scene,
         }
 
         if (numProbesThisJob == numProbesPerJob ||
-            i == numProbes - 1)
+            i + stride >= numProbes)
         {
-            jobGraph.addJob([this, firstProbeThisJob, numProbesThisJob, radius, threshold, visRange, &scene, &probes, &visTester](int threadIndex, std::atomic<bool>& cancel)
+            jobGraph.addJob([this, firstProbeThisJob, numProbesThisJob, stride, completeGraph, radius, threshold, visRange, buildState, &scene, &probes, &visTester](int threadIndex, std::atomic<bool>& cancel)
             {
-                for (auto i = firstProbeThisJob; i < firstProbeThisJob + numProbesThisJob; i++)
+                auto& candidates = buildState->candidates[threadIndex];
+                auto* visible = buildState->visible[threadIndex];
+
+                for (auto i = firstProbeThisJob, n = 0; n < numProbesThisJob; i += stride, ++n)
                 {
-                    for (auto j = 0; j < i; ++j)
+                    buildState->grid.findCandidates(i, i, candidates);
+
+                    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](int j)
                     {
-                        if (visTester.areProbesTooFar(probes, i, j, visRange))
-                            continue;
+                        return visTester.areProbesTooFar(probes, i, j, visRange);
+                    }), candidates.end());
 
-                        if (!visTester.areProbesVisible(scene, probes, i, j, radius, threshold))
+                    visTester.areProbesVisible(scene, probes, i, static_cast<int>(candidates.size()), candidates.data(),
+                                               radius, threshold, buildState->rayBatches[threadIndex], visible);
+
+                    for (auto k = 0u; k < candidates.size(); ++k)
+                    {
+                        if (!visible[k])
                             continue;
 
+                        auto j = candidates[k];
                         auto cost = (probes[i].influence.center - probes[j].influence.center).length();
 
                         mAdjacent[i].push_back(AdjacencyListEntry{j, cost});
@@ -167,16 +468,11 @@ ProbeVisibilityGraph::ProbeVisibilityGraph(const IScene& scene,
                 }
 
                 // The last job we process "completes" the adjacency list, by making sure that if we have an edge from
-                // i to j, we also have an edge from j to i.
-                if (std::atomic_fetch_sub_explicit(&mNumJobsRemaining, 1, std::memory_order_seq_cst) == 1)
+                // i to j, we also have an edge from j to i. Partial graphs are completed after all shards have been
+                // merged.
+                if (std::atomic_fetch_sub_explicit(&mNumJobsRemaining, 1, std::memory_order_seq_cst) == 1 && completeGraph)
                 {
-                    for (auto i = 0; i < probes.numProbes(); i++)
-                    {
-                        for (const auto& entry : mAdjacent[i])
-                        {
-                            mAdjacent[entry.index].push_back(AdjacencyListEntry{i, entry.cost});
-                        }
-                    }
+                    complete();
                 }
             });
 
@@ -186,6 +482,23 @@ ProbeVisibilityGraph::ProbeVisibilityGraph(const IScene& scene,
     }
 }
 
+ProbeVisibilityGraph::BuildState::BuildState(const ProbeBatch& probes,
+                                             const ProbeVisibilityTester& visTester,
+                                             float visRange,
+                                             int numThreads)
+    : grid(probes, visTester, visRange)
+    , rayBatches(numThreads)
+    , candidates(numThreads)
+    , visible(numThreads, std::max(probes.numProbes(), 1))
+{}
+
+ProbeVisibilityGraph::ProbeVisibilityGraph(int numProbes)
+    : mAdjacent(numProbes)
+    , mNumJobsRemaining(0)
+{
+    flatten();
+}
+
 ProbeVisibilityGraph::ProbeVisibilityGraph(const Serialized::VisibilityGraph* serializedObject)
     : mNumJobsRemaining(0)
 {
@@ -209,29 +522,232 @@ ProbeVisibilityGraph::ProbeVisibilityGraph(const Serialized::VisibilityGraph* se
         }
     }
 
-    for (auto i = 0; i < static_cast<int>(numProbes); ++i)
+    complete();
+}
+
+void ProbeVisibilityGraph::updateCosts(const ProbeBatch& probeBatch)
+{
+    for (auto i = 0; i < mAdjacent.size(); i++)
     {
-        for (const auto& entry : mAdjacent[i])
+        for (auto& entry : mAdjacent[i])
         {
             auto j = entry.index;
-            if (j < i)
+            entry.cost = (probeBatch[i].influence.center - probeBatch[j].influence.center).length();
+        }
+    }
+
+    flatten();
+}
+
+void ProbeVisibilityGraph::mergeShard(const ProbeVisibilityGraph& other,
+                                      const BakeShard& shard)
+{
+    assert(other.mAdjacent.size() == mAdjacent.size());
+
+    for (auto i = shard.index; i < static_cast<int>(mAdjacent.size()); i += shard.numShards)
+    {
+        for (const auto& entry : other.mAdjacent[i])
+        {
+            if (entry.index < i)
             {
-                mAdjacent[j].push_back(AdjacencyListEntry{i, 0.0f});
+                mAdjacent[i].push_back(entry);
             }
         }
     }
 }
 
-void ProbeVisibilityGraph::updateCosts(const ProbeBatch& probeBatch)
+void ProbeVisibilityGraph::complete()
 {
-    for (auto i = 0; i < mAdjacent.size(); i++)
+    for (auto i = 0; i < static_cast<int>(mAdjacent.size()); i++)
     {
-        for (auto& entry : mAdjacent[i])
+        for (const auto& entry : mAdjacent[i])
         {
-            auto j = entry.index;
-            entry.cost = (probeBatch[i].influence.center - probeBatch[j].influence.center).length();
+            if (entry.index < i)
+            {
+                mAdjacent[entry.index].push_back(AdjacencyListEntry{i, entry.cost});
+            }
         }
     }
+
+    flatten();
+}
+
+void ProbeVisibilityGraph::updateProbes(const IScene& scene,
+                                        const ProbeBatch& probes,
+                                        const ProbeVisibilityTester& visTester,
+                                        float radius,
+                                        float threshold,
+                                        float visRange,
+                                        const vector<int>& probesToUpdate,
+                                        int numThreads,
+                                        ThreadPool& threadPool,
+                                        std::atomic<bool>& cancel,
+                                        vector<uint8_t>& changedProbes)
+{
+    PROFILE_FUNCTION();
+
+    auto numProbes = probes.numProbes();
+    assert(static_cast<int>(mAdjacent.size()) == numProbes);
+
+    BuildState buildState(probes, visTester, visRange, numThreads);
+    vector<vector<AdjacencyListEntry>> updatedRows(probesToUpdate.size());
+
+    JobGraph jobGraph{};
+
+    for (auto n = 0u; n < probesToUpdate.size(); ++n)
+    {
+        jobGraph.addJob([n, radius, threshold, visRange, &buildState, &updatedRows, &probesToUpdate, &scene, &probes, &visTester](int threadIndex, std::atomic<bool>&)
+        {
+            auto& candidates = buildState.candidates[threadIndex];
+            auto* visible = buildState.visible[threadIndex];
+            auto& rayBatch = buildState.rayBatches[threadIndex];
+
+            auto i = probesToUpdate[n];
+
+            buildState.grid.findCandidates(i, static_cast<int>(probes.numProbes()), candidates);
+
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](int j)
+            {
+                return (j == i || visTester.areProbesTooFar(probes, std::max(i, j), std::min(i, j), visRange));
+            }), candidates.end());
+
+            // Always test visibility from the probe with the higher index, as when constructing the graph, so the
+            // results don't depend on which probes were updated.
+            auto numLower = static_cast<int>(std::lower_bound(candidates.begin(), candidates.end(), i) - candidates.begin());
+
+            visTester.areProbesVisible(scene, probes, i, numLower, candidates.data(), radius, threshold, rayBatch, visible);
+
+            for (auto k = numLower; k < static_cast<int>(candidates.size()); ++k)
+            {
+                visTester.areProbesVisible(scene, probes, candidates[k], 1, &i, radius, threshold, rayBatch, &visible[k]);
+            }
+
+            for (auto k = 0u; k < candidates.size(); ++k)
+            {
+                if (!visible[k])
+                    continue;
+
+                auto j = candidates[k];
+                auto cost = (probes[std::max(i, j)].influence.center - probes[std::min(i, j)].influence.center).length();
+
+                updatedRows[n].push_back(AdjacencyListEntry{j, cost});
+            }
+        });
+    }
+
+    threadPool.process(jobGraph);
+
+    if (cancel)
+        return;
+
+    vector<uint8_t> isUpdated(numProbes, false);
+    for (auto i : probesToUpdate)
+    {
+        isUpdated[i] = true;
+    }
+
+    auto findEntry = [](vector<AdjacencyListEntry>& row, int index)
+    {
+        return std::lower_bound(row.begin(), row.end(), index, [](const AdjacencyListEntry& entry, int value)
+        {
+            return entry.index < value;
+        });
+    };
+
+    // Flag the endpoints of edges that were removed, or whose costs changed, and remove them from the rows of probes
+    // that were not updated.
+    for (auto n = 0u; n < probesToUpdate.size(); ++n)
+    {
+        auto i = probesToUpdate[n];
+
+        for (const auto& entry : mAdjacent[i])
+        {
+            auto it = findEntry(updatedRows[n], entry.index);
+            if (it == updatedRows[n].end() || it->index != entry.index || it->cost != entry.cost)
+            {
+                changedProbes[i] = true;
+                changedProbes[entry.index] = true;
+            }
+
+            if (!isUpdated[entry.index])
+            {
+                auto& row = mAdjacent[entry.index];
+                row.erase(findEntry(row, i));
+            }
+        }
+    }
+
+    // Flag the endpoints of edges that were added, and add them to the rows of probes that were not updated. Rows are
+    // kept sorted by probe index, as they are when constructing the graph.
+    for (auto n = 0u; n < probesToUpdate.size(); ++n)
+    {
+        auto i = probesToUpdate[n];
+
+        for (const auto& entry : updatedRows[n])
+        {
+            auto it = findEntry(mAdjacent[i], entry.index);
+            if (it == mAdjacent[i].end() || it->index != entry.index)
+            {
+                changedProbes[i] = true;
+                changedProbes[entry.index] = true;
+            }
+
+            if (!isUpdated[entry.index])
+            {
+                auto& row = mAdjacent[entry.index];
+                row.insert(findEntry(row, i), AdjacencyListEntry{i, entry.cost});
+            }
+        }
+    }
+
+    for (auto n = 0u; n < probesToUpdate.size(); ++n)
+    {
+        mAdjacent[probesToUpdate[n]] = std::move(updatedRows[n]);
+    }
+
+    flatten();
+}
+
+void ProbeVisibilityGraph::removeProbe(int index)
+{
+    mAdjacent.erase(mAdjacent.begin() + index);
+
+    for (auto& row : mAdjacent)
+    {
+        row.erase(std::remove_if(row.begin(), row.end(), [index](const AdjacencyListEntry& entry)
+        {
+            return (entry.index == index);
+        }), row.end());
+
+        for (auto& entry : row)
+        {
+            if (entry.index > index)
+            {
+                entry.index--;
+            }
+        }
+    }
+
+    flatten();
+}
+
+void ProbeVisibilityGraph::flatten()
+{
+    auto numProbes = static_cast<int>(mAdjacent.size());
+
+    mEdgeStarts.resize(numProbes + 1);
+    mEdgeStarts[0] = 0;
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        mEdgeStarts[i + 1] = mEdgeStarts[i] + static_cast<int>(mAdjacent[i].size());
+    }
+
+    mEdges.clear();
+    mEdges.reserve(mEdgeStarts[numProbes]);
+    for (const auto& row : mAdjacent)
+    {
+        mEdges.insert(mEdges.end(), row.begin(), row.end());
+    }
 }
 
 bool ProbeVisibilityGraph::hasEdge(int from,
@@ -253,6 +769,8 @@ void ProbeVisibilityGraph::prune(const ProbeBatch& probes,
 
         mAdjacent[i].erase(std::remove_if(mAdjacent[i].begin(), mAdjacent[i].end(), isProbeTooFar), mAdjacent[i].end());
     }
+
+    flatten();
 }
 
 uint64_t ProbeVisibilityGraph::serializedSize() const
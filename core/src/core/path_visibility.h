@@ -19,11 +19,45 @@
 #include "job_graph.h"
 #include "probe_batch.h"
 #include "scene.h"
+#include "thread_pool.h"
 
 #include "path_visibility.fbs.h"
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// ProbeVisibilityRayBatch
+// --------------------------------------------------------------------------------------------------------------------
+
+// Scratch space for testing visibility between probes using batches of rays. Each thread that tests visibility needs
+// its own instance.
+class ProbeVisibilityRayBatch
+{
+public:
+    Array<Ray> rays;
+    Array<float> minDistances;
+    Array<float> maxDistances;
+    Array<bool> occluded;
+    Array<Vector3f> fromSamples;
+    Array<Vector3f> toSamples;
+    Array<bool> toSamplesValid;
+
+    // Only reallocates if the arrays are too small.
+    void resize(int numRays,
+                int numSamples);
+
+    // Sets up a ray between two points, with the same parameters as IScene::isOccluded.
+    void setRay(int index,
+                const Vector3f& from,
+                const Vector3f& to)
+    {
+        rays[index] = Ray{from, Vector3f::unitVector(to - from)};
+        minDistances[index] = 0.0f;
+        maxDistances[index] = (to - from).length();
+    }
+};
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // ProbeVisibilityTester
 // --------------------------------------------------------------------------------------------------------------------
@@ -47,12 +81,43 @@ public:
                           float radius,
                           float threshold) const;
 
+    // Tests whether the from probe is visible from each of several other probes. Gives the same results as calling
+    // the single-pair version for each probe, but traces rays in batches.
+    void areProbesVisible(const IScene& scene,
+                          const ProbeBatch& probes,
+                          int from,
+                          int numTo,
+                          const int* to,
+                          float radius,
+                          float threshold,
+                          ProbeVisibilityRayBatch& rayBatch,
+                          bool* visible) const;
+
+    // Tests whether each of several pairs of probes (from[k], to[k]) are mutually visible. Gives the same results as
+    // calling the single-pair version for each pair, but traces rays in batches.
+    void areProbePairsVisible(const IScene& scene,
+                              const ProbeBatch& probes,
+                              int numPairs,
+                              const int* from,
+                              const int* to,
+                              float radius,
+                              float threshold,
+                              ProbeVisibilityRayBatch& rayBatch,
+                              bool* visible) const;
+
     // Tests whether two probes are farther apart than a given range.
     bool areProbesTooFar(const ProbeBatch& probes,
                          int from,
                          int to,
                          float visRange) const;
 
+    // Returns the point at which a probe center should be placed, so that the distances used by areProbesTooFar are
+    // the straight-line distances between such points.
+    Vector3f rangeCoordinates(const Vector3f& point) const
+    {
+        return (mAsymmetricVisRange) ? Vector3f(point - Vector3f::dot(point, mDown) * mDown) : point;
+    }
+
 private:
     Array<Vector3f> mSamples; // Point samples used for visibility checks.
     bool mAsymmetricVisRange;
@@ -60,6 +125,47 @@ private:
 };
 
 
+// --------------------------------------------------------------------------------------------------------------------
+// ProbeRangeGrid
+// --------------------------------------------------------------------------------------------------------------------
+
+// A uniform grid whose cells are at least visRange wide, used to find the probes that may be within visRange of a
+// given probe without looking at every other probe. Probes are placed in the grid according to their range
+// coordinates (see ProbeVisibilityTester::rangeCoordinates), so any two probes within visRange of each other are in
+// the same or adjacent cells.
+class ProbeRangeGrid
+{
+public:
+    ProbeRangeGrid(const ProbeBatch& probes,
+                   const ProbeVisibilityTester& visTester,
+                   float visRange);
+
+    // Replaces the contents of candidates with the indices, in ascending order, of all probes with index less than
+    // maxIndex that are in the same cell as the given probe or an adjacent cell.
+    void findCandidates(int index,
+                        int maxIndex,
+                        vector<int>& candidates) const;
+
+private:
+    // Maximum number of grid cells along each axis.
+    static const int kMaxGridResolution = 128;
+
+    Vector3f mMinCoordinates;
+    float mCellSize;
+    int mGridResolution[3];
+    vector<int> mProbeCells; // The cell containing each probe.
+    vector<int> mCellStarts; // The probes in cell i are mCellProbes[mCellStarts[i]] to mCellProbes[mCellStarts[i + 1] - 1].
+    vector<int> mCellProbes;
+
+    int cellIndex(int x,
+                  int y,
+                  int z) const
+    {
+        return (z * mGridResolution[1] + y) * mGridResolution[0] + x;
+    }
+};
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // ProbeVisibilityGraph
 // --------------------------------------------------------------------------------------------------------------------
@@ -76,8 +182,13 @@ public:
     };
 
     vector<vector<AdjacencyListEntry>> mAdjacent; // The graph, represented as an adjacency list.
+    vector<int> mEdgeStarts; // The edges from probe i are mEdges[mEdgeStarts[i]] to mEdges[mEdgeStarts[i + 1] - 1].
+    vector<AdjacencyListEntry> mEdges; // The adjacency list, flattened into a single array for use when finding paths.
 
-    // Computes a visibility graph given an array of probes (more precisely, pointers to probes).
+    // Computes a visibility graph given an array of probes (more precisely, pointers to probes). Only pairs of probes
+    // in the same or adjacent cells of a ProbeRangeGrid are tested for visibility. If the shard is partial, only the
+    // rows of the adjacency list for probes in the shard are computed, and only edges to probes with lower indices are
+    // stored in each row. Such a graph must be merged with the other shards, and completed, before it can be used.
     ProbeVisibilityGraph(const IScene& scene,
                          const ProbeBatch& probes,
                          const ProbeVisibilityTester& visTester,
@@ -88,13 +199,48 @@ public:
                          JobGraph& jobGraph,
                          std::atomic<bool>& cancel,
                          ProgressCallback progressCallback = nullptr,
-                         void* callbackUserData = nullptr);
+                         void* callbackUserData = nullptr,
+                         const BakeShard& shard = BakeShard{});
+
+    // Creates a graph with no edges, into which shards can be merged.
+    ProbeVisibilityGraph(int numProbes);
 
     // Deserializes a visibility graph.
     ProbeVisibilityGraph(const Serialized::VisibilityGraph* serializedObject);
 
     void updateCosts(const ProbeBatch& probeBatch);
 
+    // Copies the rows of the adjacency list computed by the given shard of a sharded bake.
+    void mergeShard(const ProbeVisibilityGraph& other,
+                    const BakeShard& shard);
+
+    // Adds an edge from j to i for every edge from i to j, where j < i.
+    void complete();
+
+    // Tests visibility again between each of the given probes and every other probe, after they have been moved or
+    // added, or after geometry near them has changed. The graph must be complete. Both endpoints of every edge that
+    // is added, removed, or whose cost changes, are flagged in changedProbes. Edges are left unchanged if the update
+    // is cancelled. The resulting graph is identical to one constructed from scratch.
+    void updateProbes(const IScene& scene,
+                      const ProbeBatch& probes,
+                      const ProbeVisibilityTester& visTester,
+                      float radius,
+                      float threshold,
+                      float visRange,
+                      const vector<int>& probesToUpdate,
+                      int numThreads,
+                      ThreadPool& threadPool,
+                      std::atomic<bool>& cancel,
+                      vector<uint8_t>& changedProbes);
+
+    // Removes a probe, and all edges to it. Probes with higher indices are renumbered.
+    void removeProbe(int index);
+
+    // Copies the adjacency list into mEdgeStarts and mEdges, which are what PathFinder traverses. Member functions
+    // that change a complete graph do this automatically; code that modifies mAdjacent directly must call it
+    // afterwards.
+    void flatten();
+
     // Tests whether an edge exists between two probes, i.e., whether the graph indicates that the two probes are
     // mutually visible.
     bool hasEdge(int from,
@@ -112,6 +258,20 @@ public:
     flatbuffers::Offset<Serialized::VisibilityGraph> serialize(SerializedObject& serializedObject) const;
 
 private:
+    // Data shared by the jobs that construct the graph.
+    struct BuildState
+    {
+        ProbeRangeGrid grid;
+        Array<ProbeVisibilityRayBatch> rayBatches;
+        Array<vector<int>> candidates;
+        Array<bool, 2> visible;
+
+        BuildState(const ProbeBatch& probes,
+                   const ProbeVisibilityTester& visTester,
+                   float visRange,
+                   int numThreads);
+    };
+
     std::atomic<int> mNumJobsRemaining;
 };
 
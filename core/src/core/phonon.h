@@ -1422,6 +1422,14 @@ typedef struct {
 
     /** Normalization setting. No normalization will be applied when choosing \c IPL_HRTFNORMTYPE_NONE. */
     IPLHRTFNormType normType;
+
+    /** If greater than zero, bilinearly interpolated HRTFs are precomputed when the HRTF is created, for a grid of
+        directions spaced this many degrees apart. Binaural effects that use \c IPL_HRTFINTERPOLATION_BILINEAR then
+        use the precomputed HRTF for the nearest grid direction, which costs about as much as
+        \c IPL_HRTFINTERPOLATION_NEAREST. Smaller values are more precise, but use more memory and take longer to
+        precompute. Spatial blend values less than 1 are not precomputed, and are always interpolated on the fly.
+        Set to 0 to disable precomputation. */
+    float interpolationGridResolution;
 } IPLHRTFSettings;
 
 /** Creates an HRTF.
@@ -2800,6 +2808,131 @@ IPLAPI IPLAudioEffectState IPLCALL iplPathEffectGetTail(IPLPathEffect effect, IP
 /** \} */
 
 
+/*********************************************************************************************************************/
+
+/** \defgroup audioeffectbatch Audio Effect Batch
+    \{
+*/
+
+/** Applies many binaural, direct, reflection, and path effects in parallel. Each call to
+    \c iplAudioEffectBatchApply processes a list of work items on a pool of worker threads owned by the batch
+    object, together with the calling thread, and returns once every work item has been processed. */
+DECLARE_OPAQUE_HANDLE(IPLAudioEffectBatch);
+
+/** The type of effect to apply in a work item of an audio effect batch. */
+typedef enum {
+    /** Apply a binaural effect. */
+    IPL_AUDIOEFFECTBATCHITEMTYPE_BINAURAL,
+
+    /** Apply a direct effect. */
+    IPL_AUDIOEFFECTBATCHITEMTYPE_DIRECT,
+
+    /** Apply a reflection effect. */
+    IPL_AUDIOEFFECTBATCHITEMTYPE_REFLECTION,
+
+    /** Apply a path effect. */
+    IPL_AUDIOEFFECTBATCHITEMTYPE_PATH,
+} IPLAudioEffectBatchItemType;
+
+/** Settings used to create an audio effect batch. */
+typedef struct {
+    /** Number of worker threads to create, in addition to the thread that calls \c iplAudioEffectBatchApply. If
+        this is 0, all work items are processed on the calling thread. */
+    IPLint32 numThreads;
+} IPLAudioEffectBatchSettings;
+
+/** A single effect to apply as part of an audio effect batch. Only the effect and parameters that correspond to
+    \c type need to be specified. */
+typedef struct {
+    /** The type of effect to apply. */
+    IPLAudioEffectBatchItemType type;
+
+    /** The binaural effect to apply. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_BINAURAL. */
+    IPLBinauralEffect binauralEffect;
+
+    /** Parameters for applying the binaural effect. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_BINAURAL. */
+    IPLBinauralEffectParams* binauralParams;
+
+    /** The direct effect to apply. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_DIRECT. */
+    IPLDirectEffect directEffect;
+
+    /** Parameters for applying the direct effect. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_DIRECT. */
+    IPLDirectEffectParams* directParams;
+
+    /** The reflection effect to apply. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_REFLECTION. */
+    IPLReflectionEffect reflectionEffect;
+
+    /** Parameters for applying the reflection effect. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_REFLECTION. */
+    IPLReflectionEffectParams* reflectionParams;
+
+    /** If non-null, the output of the reflection effect is mixed into this reflection mixer instead of being
+        returned in \c out. Work items that share a reflection mixer are processed one after the other, in the
+        order in which they appear in the batch, after all other work items. For
+        \c IPL_AUDIOEFFECTBATCHITEMTYPE_REFLECTION. */
+    IPLReflectionMixer reflectionMixer;
+
+    /** The path effect to apply. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_PATH. */
+    IPLPathEffect pathEffect;
+
+    /** Parameters for applying the path effect. For \c IPL_AUDIOEFFECTBATCHITEMTYPE_PATH. */
+    IPLPathEffectParams* pathParams;
+
+    /** The input audio buffer. */
+    IPLAudioBuffer* in;
+
+    /** The output audio buffer. Must not be shared with any other work item in the batch. */
+    IPLAudioBuffer* out;
+
+    /** If non-null, once every work item in the batch has been processed, the contents of \c out are mixed into
+        this audio buffer. Any number of work items may share the same mix buffer. Mixing is performed on the
+        calling thread, in the order in which work items appear in the batch, so the result does not depend on how
+        work items were distributed across threads. */
+    IPLAudioBuffer* mix;
+
+    /** [out] The value returned by the effect's apply function. */
+    IPLAudioEffectState state;
+} IPLAudioEffectBatchItem;
+
+/** Creates an audio effect batch.
+
+    \param  context     The context used to initialize Steam Audio.
+    \param  settings    The settings to use when creating the audio effect batch.
+    \param  batch       [out] The created audio effect batch.
+
+    \return Status code indicating whether or not the operation succeeded.
+*/
+IPLAPI IPLerror IPLCALL iplAudioEffectBatchCreate(IPLContext context, IPLAudioEffectBatchSettings* settings, IPLAudioEffectBatch* batch);
+
+/** Retains an additional reference to an audio effect batch.
+
+    \param  batch   The audio effect batch to retain a reference to.
+
+    \return The additional reference to the audio effect batch.
+*/
+IPLAPI IPLAudioEffectBatch IPLCALL iplAudioEffectBatchRetain(IPLAudioEffectBatch batch);
+
+/** Releases a reference to an audio effect batch.
+
+    \param  batch   The audio effect batch to release a reference to.
+*/
+IPLAPI void IPLCALL iplAudioEffectBatchRelease(IPLAudioEffectBatch* batch);
+
+/** Applies a list of effects in parallel, and returns once all of them have been applied.
+
+    Each effect must appear at most once in the list. All work items are processed before any output is mixed
+    into mix buffers, so a mix buffer may not be used as the input or output of any work item in the same batch.
+    This function may only be called from one thread at a time for a given audio effect batch.
+
+    \param  batch       The audio effect batch.
+    \param  numItems    The number of work items.
+    \param  items       Array containing \c numItems work items. The \c state field of each work item is
+                        filled in with the result of applying its effect.
+*/
+IPLAPI void IPLCALL iplAudioEffectBatchApply(IPLAudioEffectBatch batch, IPLint32 numItems, IPLAudioEffectBatchItem* items);
+
+/** \} */
+
+
 /*********************************************************************************************************************/
 
 /** \defgroup energyfield Energy Field
@@ -3246,7 +3379,16 @@ typedef enum {
         terrain, and generate probes that are a fixed height above the floor or terrain, and uniformly-spaced along
         the horizontal plane. This algorithm is not suitable for scenarios where the listener may fly into a region
         with no probes; if this happens, the listener will not be influenced by any of the baked data. */
-    IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR
+    IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR,
+
+    /** Generates probes at a fixed height above solid geometry, like \c IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR, but with
+        spacing that adapts to the acoustics of the scene. Probes are first generated with a coarse spacing, and a
+        quick, low-quality reverb bake is run at each probe. Wherever the reverb times of neighboring probes differ
+        by more than a tolerance, probes are generated with half the spacing, and so on, down to the specified
+        spacing. Large open areas and large rooms end up with few probes, while transitions between acoustically
+        different spaces (doorways, corridors, etc.) are sampled densely. Generating probes this way takes longer
+        than uniform spacing. */
+    IPL_PROBEGENERATIONTYPE_ADAPTIVE
 } IPLProbeGenerationType;
 
 /** The different ways in which the source and listener positions used to generate baked data can vary as a function
@@ -3287,17 +3429,30 @@ typedef struct {
     /** The algorithm to use for generating probes. */
     IPLProbeGenerationType type;
 
-    /** Spacing (in meters) between two neighboring probes. Only for \c IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR. */
+    /** Spacing (in meters) between two neighboring probes. Only for \c IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR and
+        \c IPL_PROBEGENERATIONTYPE_ADAPTIVE. For \c IPL_PROBEGENERATIONTYPE_ADAPTIVE, this is the smallest spacing
+        that will be used. */
     IPLfloat32 spacing;
 
     /** Height (in meters) above the floor at which probes will be generated. Only for
-        \c IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR. */
+        \c IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR and \c IPL_PROBEGENERATIONTYPE_ADAPTIVE. */
     IPLfloat32 height;
 
     /** A transformation matrix that transforms an axis-aligned unit cube, with minimum and maximum vertices
         at (0, 0, 0) and (1, 1, 1), into a parallelopiped volume. Probes will be generated within this
         volume. */
     IPLMatrix4x4 transform;
+
+    /** The number of times the spacing between probes can be halved. The coarsest spacing is \c spacing multiplied
+        by 2 to the power of \c numSubdivisions. Only for \c IPL_PROBEGENERATIONTYPE_ADAPTIVE. If 0 or less, a
+        default value of 2 is used. */
+    IPLint32 numSubdivisions;
+
+    /** The largest relative difference in reverb time (in any frequency band) between two neighboring probes for
+        which the region between them is not subdivided further. For example, 0.1 means neighboring probes may
+        differ in reverb time by up to 10%. Only for \c IPL_PROBEGENERATIONTYPE_ADAPTIVE. If 0 or less, a default
+        value of 0.1 is used. */
+    IPLfloat32 tolerance;
 } IPLProbeGenerationParams;
 
 /** Identifies a "layer" of data stored in a probe batch. Each probe batch may store multiple layers of data,
@@ -3393,6 +3548,31 @@ IPLAPI void IPLCALL iplProbeBatchRelease(IPLProbeBatch* probeBatch);
 */
 IPLAPI IPLerror IPLCALL iplProbeBatchLoad(IPLContext context, IPLSerializedObject serializedObject, IPLProbeBatch* probeBatch);
 
+/** Settings used to load a probe batch whose baked data is streamed on demand. */
+typedef struct {
+    /** Maximum number of bytes of baked convolution data to keep in memory for each baked data layer. Data for
+        probes near the listener is decoded when first needed, and the least recently used data is discarded once
+        this limit is reached. */
+    IPLsize cacheSize;
+} IPLProbeBatchStreamingSettings;
+
+/** Loads a probe batch from a serialized object, without loading all of its baked convolution data up front. Instead,
+    baked data is read directly from the serialized object as it is needed, so memory usage depends on the number
+    of probes around the listener rather than the total size of the probe batch.
+
+    The probe batch retains the serialized object, and the buffer that the serialized object was created from must
+    remain valid until the probe batch is released. To avoid reading the entire probe batch into memory, create the
+    serialized object from a memory-mapped file.
+
+    \param  context             The context used to initialize Steam Audio.
+    \param  serializedObject    The serialized object from which to load the probe batch.
+    \param  settings            The settings to use when loading the probe batch.
+    \param  probeBatch          [out] The created probe batch.
+
+    \return Status code indicating whether or not the operation succeeded.
+*/
+IPLAPI IPLerror IPLCALL iplProbeBatchLoadStreaming(IPLContext context, IPLSerializedObject serializedObject, IPLProbeBatchStreamingSettings* settings, IPLProbeBatch* probeBatch);
+
 /** Saves a probe batch to a serialized object. Typically, the serialized object will then be saved to disk.
 
     \param  probeBatch          The probe batch to save.
@@ -3442,6 +3622,23 @@ IPLAPI void IPLCALL iplProbeBatchCommit(IPLProbeBatch probeBatch);
 */
 IPLAPI void IPLCALL iplProbeBatchRemoveData(IPLProbeBatch probeBatch, IPLBakedDataIdentifier* identifier);
 
+/** Marks baked reflections data as needing to be baked again for all probes near a region of the scene in which
+    geometry has changed. Subsequent bakes with \c IPL_REFLECTIONSBAKEFLAGS_INCREMENTAL will only bake these probes.
+    The existing data for these probes continues to be used until then.
+
+    For baked pathing data, subsequent bakes with \c IPL_PATHBAKEFLAGS_INCREMENTAL test visibility again between
+    these probes and all other probes. Since visibility is only tested between probes that are at most \c visRange
+    apart, \c radius should be at least the \c visRange used for baking.
+
+    \param  probeBatch      The probe batch.
+    \param  identifier      The identifier of the baked data layer.
+    \param  changedBounds   A bounding box containing all the geometry that has been added, removed, or modified.
+    \param  radius          Probes whose centers are within this distance (in meters) of \c changedBounds are
+                            invalidated. If the data layer was baked for a static source or listener that is within
+                            this distance, all probes are invalidated.
+*/
+IPLAPI void IPLCALL iplProbeBatchInvalidateBakedData(IPLProbeBatch probeBatch, IPLBakedDataIdentifier* identifier, IPLBox changedBounds, IPLfloat32 radius);
+
 /** \return The size (in bytes) of a specific baked data layer in a probe batch.
 
     \param  probeBatch  The probe batch.
@@ -3485,6 +3682,25 @@ typedef enum {
 
     /** Bake parametric reverb for \c IPL_REFLECTIONEFFECTTYPE_PARAMETRIC or \c IPL_REFLECTIONEFFECTTYPE_HYBRID. */
     IPL_REFLECTIONSBAKEFLAGS_BAKEPARAMETRIC = 1 << 1,
+
+    /** Store baked impulse responses in a compressed form. Values are quantized to 16 bits in the log domain,
+        trailing silent portions are discarded, and higher-order Ambisonics channels that contain negligible energy
+        are dropped. This typically reduces the size of baked convolution data several-fold, with no audible
+        difference. Only used with \c IPL_REFLECTIONSBAKEFLAGS_BAKECONVOLUTION. */
+    IPL_REFLECTIONSBAKEFLAGS_COMPRESSCONVOLUTION = 1 << 2,
+
+    /** If compressing baked impulse responses, quantize values to 8 bits instead of 16 bits. This halves the size of
+        compressed data again, at the cost of slightly lower accuracy. */
+    IPL_REFLECTIONSBAKEFLAGS_COMPRESSCONVOLUTIONLOWPRECISION = 1 << 3,
+
+    /** Only bake probes whose data has not been baked yet, or has been invalidated using
+        \c iplProbeBatchInvalidateBakedData. Probes with valid data are left unchanged. */
+    IPL_REFLECTIONSBAKEFLAGS_INCREMENTAL = 1 << 4,
+
+    /** Periodically save baked probes to \c checkpointFileName while baking. If the bake is cancelled, or the
+        process exits before the bake completes, a subsequent bake with the same checkpoint file resumes from where
+        it left off, as long as the probe batch and bake settings are unchanged. */
+    IPL_REFLECTIONSBAKEFLAGS_CHECKPOINT = 1 << 5,
 } IPLReflectionsBakeFlags;
 
 /** Parameters used to control how reflections data is baked. */
@@ -3556,8 +3772,37 @@ typedef struct {
 
     /** The Radeon Rays device, if using Radeon Rays. */
     IPLRadeonRaysDevice radeonRaysDevice;
+
+    /** If \c IPL_REFLECTIONSBAKEFLAGS_CHECKPOINT is set, the UTF-8 encoded name of the file in which to save baked
+        probes. The file is deleted once the bake completes. */
+    IPLstring checkpointFileName;
+
+    /** If \c IPL_REFLECTIONSBAKEFLAGS_CHECKPOINT is set, the number of probes to bake between saves to the
+        checkpoint file. If 0, the checkpoint file is only saved if the bake is cancelled. */
+    IPLint32 checkpointInterval;
+
+    /** If greater than 1, the bake is split into this many shards, which can be baked by separate processes or on
+        separate machines, and combined using \c iplReflectionsBakerMerge. Probes are assigned to shards round-robin.
+        Set to 0 or 1 to bake every probe. */
+    IPLint32 numShards;
+
+    /** If \c numShards is greater than 1, the index of the shard to bake, between 0 and \c numShards - 1. Only the
+        probes in this shard are baked. */
+    IPLint32 shardIndex;
 } IPLReflectionsBakeParams;
 
+/** Flags for specifying how pathing data is baked. */
+typedef enum {
+    /** If the probe batch already contains pathing data with the same identifier, only test visibility for probes
+        that have been moved or added since it was baked, or invalidated using \c iplProbeBatchInvalidateBakedData,
+        and only find paths again from probes whose paths may pass through any part of the visibility graph that has
+        changed as a result. The result is the same as baking from scratch. If any other bake parameters differ from
+        those used to bake the existing data, or the existing data was saved by an older version of Steam Audio, the
+        data is baked from scratch. Not supported with \c regionSize or \c numShards, in which case the data is also
+        baked from scratch. */
+    IPL_PATHBAKEFLAGS_INCREMENTAL = 1 << 0,
+} IPLPathBakeFlags;
+
 /** Parameters used to control how pathing data is baked. */
 typedef struct {
     /** The scene in which the probes exist. */
@@ -3595,6 +3840,24 @@ typedef struct {
 
     /** Number of threads to use for baking. */
     IPLint32                numThreads;
+
+    /** If greater than 1, the bake is split into this many shards, which can be baked by separate processes or on
+        separate machines, and combined using \c iplPathBakerMerge. Each shard tests visibility from its own subset
+        of probes, which is where almost all of the time is spent. Set to 0 or 1 to bake every probe. */
+    IPLint32                numShards;
+
+    /** If \c numShards is greater than 1, the index of the shard to bake, between 0 and \c numShards - 1. */
+    IPLint32                shardIndex;
+
+    /** If greater than 0, probes are grouped into cubic regions of this size (in meters), and paths are only baked
+        between probes in the same region. Paths between regions are found at run-time, by searching a much smaller
+        graph of the probes that can see probes in other regions. This reduces bake times and memory usage for
+        large probe batches, at the cost of increased CPU usage at run-time. Set to 0 to bake paths between every pair
+        of probes. */
+    IPLfloat32              regionSize;
+
+    /** Flags for specifying how pathing data is baked. */
+    IPLPathBakeFlags        bakeFlags;
 } IPLPathBakeParams;
 
 /** Bakes a single layer of reflections data in a probe batch.
@@ -3617,6 +3880,24 @@ IPLAPI void IPLCALL iplReflectionsBakerBake(IPLContext context, IPLReflectionsBa
 */
 IPLAPI void IPLCALL iplReflectionsBakerCancelBake(IPLContext context);
 
+/** Combines the results of a sharded reflections bake.
+
+    Each shard is a probe batch that was baked by calling \c iplReflectionsBakerBake with \c numShards greater than 1
+    and a different \c shardIndex, and then saved and loaded using \c iplProbeBatchSave and \c iplProbeBatchLoad.
+    All shards must contain the same probes as \c params->probeBatch. The baked data is moved from the shards into
+    the data layer with identifier \c params->identifier in \c params->probeBatch. The result is the same as if all
+    the probes had been baked by a single process.
+
+    \param  context             The context used to initialize Steam Audio.
+    \param  params              The parameters that were used for baking the shards. Only \c probeBatch and
+                                \c identifier are used.
+    \param  numShards           The number of shards.
+    \param  shards              Array containing the probe batch for each shard.
+
+    \return Status code indicating whether or not the operation succeeded.
+*/
+IPLAPI IPLerror IPLCALL iplReflectionsBakerMerge(IPLContext context, IPLReflectionsBakeParams* params, IPLint32 numShards, IPLProbeBatch* shards);
+
 /** Bakes a single layer of pathing data in a probe batch.
 
     Only one bake can be in progress at any point in time.
@@ -3637,6 +3918,28 @@ IPLAPI void IPLCALL iplPathBakerBake(IPLContext context, IPLPathBakeParams* para
 */
 IPLAPI void IPLCALL iplPathBakerCancelBake(IPLContext context);
 
+/** Combines the results of a sharded pathing bake, and finds paths between every pair of probes.
+
+    Each shard is a probe batch that was baked by calling \c iplPathBakerBake with \c numShards greater than 1
+    and a different \c shardIndex, and then saved and loaded using \c iplProbeBatchSave and \c iplProbeBatchLoad.
+    Shard data cannot be used for simulation until it has been merged. All shards must contain the same probes as
+    \c params->probeBatch, and every shard must be present exactly once. The result is identical to the data that
+    would have been baked by a single process.
+
+    \param  context             The context used to initialize Steam Audio.
+    \param  params              The parameters that were used for baking the shards. \c scene and the visibility
+                                testing parameters are not used.
+    \param  numShards           The number of shards.
+    \param  shards              Array containing the probe batch for each shard.
+    \param  progressCallback    (Optional) This function will be called by Steam Audio to notify your application
+                                as the merge progresses.
+    \param  userData            (Optional) Pointer to arbitrary data that will be sent to the progress callback
+                                when Steam Audio calls it.
+
+    \return Status code indicating whether or not the operation succeeded.
+*/
+IPLAPI IPLerror IPLCALL iplPathBakerMerge(IPLContext context, IPLPathBakeParams* params, IPLint32 numShards, IPLProbeBatch* shards, IPLProgressCallback progressCallback, void* userData);
+
 /** \} */
 
 
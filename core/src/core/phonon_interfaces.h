@@ -44,6 +44,7 @@ class IDirectEffect;
 class IReflectionEffect;
 class IReflectionMixer;
 class IPathEffect;
+class IAudioEffectBatch;
 class IProbeArray;
 class IProbeBatch;
 class ISimulator;
@@ -167,6 +168,9 @@ public:
                                       IPLPathEffectSettings* effectSettings,
                                       IPathEffect** effect) = 0;
 
+    virtual IPLerror createAudioEffectBatch(IPLAudioEffectBatchSettings* settings,
+                                            IAudioEffectBatch** batch) = 0;
+
     virtual IPLerror createProbeArray(IProbeArray** probeArray) = 0;
 
     virtual IPLerror createProbeBatch(IProbeBatch** probeBatch) = 0;
@@ -174,18 +178,32 @@ public:
     virtual IPLerror loadProbeBatch(ISerializedObject* serializedObject,
                                     IProbeBatch** probeBatch) = 0;
 
+    virtual IPLerror loadProbeBatchStreaming(ISerializedObject* serializedObject,
+                                             IPLProbeBatchStreamingSettings* settings,
+                                             IProbeBatch** probeBatch) = 0;
+
     virtual void bakeReflections(IPLReflectionsBakeParams* params,
                                  IPLProgressCallback progressCallback,
                                  void* userData) = 0;
 
     virtual void cancelBakeReflections() = 0;
 
+    virtual IPLerror mergeReflections(IPLReflectionsBakeParams* params,
+                                      IPLint32 numShards,
+                                      IProbeBatch** shards) = 0;
+
     virtual void bakePaths(IPLPathBakeParams* params,
                            IPLProgressCallback progressCallback,
                            void* userData) = 0;
 
     virtual void cancelBakePaths() = 0;
 
+    virtual IPLerror mergePaths(IPLPathBakeParams* params,
+                                IPLint32 numShards,
+                                IProbeBatch** shards,
+                                IPLProgressCallback progressCallback,
+                                void* userData) = 0;
+
     virtual IPLerror createSimulator(IPLSimulationSettings* settings,
                                      ISimulator** simulator) = 0;
 
@@ -554,6 +572,17 @@ public:
     virtual IPLAudioEffectState getTail(IPLAudioBuffer* out) = 0;
 };
 
+class IAudioEffectBatch
+{
+public:
+    virtual IAudioEffectBatch* retain() = 0;
+
+    virtual void release() = 0;
+
+    virtual void apply(IPLint32 numItems,
+                       IPLAudioEffectBatchItem* items) = 0;
+};
+
 class IProbeArray
 {
 public:
@@ -590,6 +619,8 @@ public:
 
     virtual void removeData(IPLBakedDataIdentifier* identifier) = 0;
 
+    virtual void invalidateData(IPLBakedDataIdentifier* identifier, IPLBox changedBounds, IPLfloat32 radius) = 0;
+
     virtual IPLsize getDataSize(IPLBakedDataIdentifier* identifier) = 0;
 
     virtual void getEnergyField(IPLBakedDataIdentifier* identifier, int probeIndex, IEnergyField* energyField) = 0;
@@ -2062,6 +2093,44 @@ IPLAudioEffectState IPLCALL iplPathEffectGetTail(IPLPathEffect effect, IPLAudioB
     return _effect->getTail(out);
 }
 
+IPLerror IPLCALL iplAudioEffectBatchCreate(IPLContext context,
+                                   IPLAudioEffectBatchSettings* settings,
+                                   IPLAudioEffectBatch* batch)
+{
+    if (!context)
+        return IPL_STATUS_FAILURE;
+
+    return reinterpret_cast<api::IContext*>(context)->createAudioEffectBatch(settings, reinterpret_cast<api::IAudioEffectBatch**>(batch));
+}
+
+IPLAudioEffectBatch IPLCALL iplAudioEffectBatchRetain(IPLAudioEffectBatch batch)
+{
+    if (!batch)
+        return nullptr;
+
+    return reinterpret_cast<IPLAudioEffectBatch>(reinterpret_cast<api::IAudioEffectBatch*>(batch)->retain());
+}
+
+void IPLCALL iplAudioEffectBatchRelease(IPLAudioEffectBatch* batch)
+{
+    if (!batch || !*batch)
+        return;
+
+    reinterpret_cast<api::IAudioEffectBatch*>(*batch)->release();
+
+    *batch = nullptr;
+}
+
+void IPLCALL iplAudioEffectBatchApply(IPLAudioEffectBatch batch,
+                              IPLint32 numItems,
+                              IPLAudioEffectBatchItem* items)
+{
+    if (!batch)
+        return;
+
+    reinterpret_cast<api::IAudioEffectBatch*>(batch)->apply(numItems, items);
+}
+
 IPLerror IPLCALL iplProbeArrayCreate(IPLContext context,
                              IPLProbeArray* probeArray)
 {
@@ -2151,6 +2220,17 @@ IPLerror IPLCALL iplProbeBatchLoad(IPLContext context,
     return reinterpret_cast<api::IContext*>(context)->loadProbeBatch(reinterpret_cast<api::ISerializedObject*>(serializedObject), reinterpret_cast<api::IProbeBatch**>(probeBatch));
 }
 
+IPLerror IPLCALL iplProbeBatchLoadStreaming(IPLContext context,
+                                    IPLSerializedObject serializedObject,
+                                    IPLProbeBatchStreamingSettings* settings,
+                                    IPLProbeBatch* probeBatch)
+{
+    if (!context)
+        return IPL_STATUS_FAILURE;
+
+    return reinterpret_cast<api::IContext*>(context)->loadProbeBatchStreaming(reinterpret_cast<api::ISerializedObject*>(serializedObject), settings, reinterpret_cast<api::IProbeBatch**>(probeBatch));
+}
+
 void IPLCALL iplProbeBatchSave(IPLProbeBatch probeBatch,
                        IPLSerializedObject serializedObject)
 {
@@ -2212,6 +2292,17 @@ void IPLCALL iplProbeBatchRemoveData(IPLProbeBatch probeBatch,
     reinterpret_cast<api::IProbeBatch*>(probeBatch)->removeData(identifier);
 }
 
+void IPLCALL iplProbeBatchInvalidateBakedData(IPLProbeBatch probeBatch,
+                                              IPLBakedDataIdentifier* identifier,
+                                              IPLBox changedBounds,
+                                              IPLfloat32 radius)
+{
+    if (!probeBatch)
+        return;
+
+    reinterpret_cast<api::IProbeBatch*>(probeBatch)->invalidateData(identifier, changedBounds, radius);
+}
+
 IPLsize IPLCALL iplProbeBatchGetDataSize(IPLProbeBatch probeBatch,
                                   IPLBakedDataIdentifier* identifier)
 {
@@ -2256,6 +2347,17 @@ void IPLCALL iplReflectionsBakerCancelBake(IPLContext context)
     reinterpret_cast<api::IContext*>(context)->cancelBakeReflections();
 }
 
+IPLerror IPLCALL iplReflectionsBakerMerge(IPLContext context,
+                                          IPLReflectionsBakeParams* params,
+                                          IPLint32 numShards,
+                                          IPLProbeBatch* shards)
+{
+    if (!context)
+        return IPL_STATUS_FAILURE;
+
+    return reinterpret_cast<api::IContext*>(context)->mergeReflections(params, numShards, reinterpret_cast<api::IProbeBatch**>(shards));
+}
+
 void IPLCALL iplPathBakerBake(IPLContext context,
                       IPLPathBakeParams* params,
                       IPLProgressCallback progressCallback,
@@ -2275,6 +2377,19 @@ void IPLCALL iplPathBakerCancelBake(IPLContext context)
     reinterpret_cast<api::IContext*>(context)->cancelBakePaths();
 }
 
+IPLerror IPLCALL iplPathBakerMerge(IPLContext context,
+                                   IPLPathBakeParams* params,
+                                   IPLint32 numShards,
+                                   IPLProbeBatch* shards,
+                                   IPLProgressCallback progressCallback,
+                                   void* userData)
+{
+    if (!context)
+        return IPL_STATUS_FAILURE;
+
+    return reinterpret_cast<api::IContext*>(context)->mergePaths(params, numShards, reinterpret_cast<api::IProbeBatch**>(shards), progressCallback, userData);
+}
+
 IPLerror IPLCALL iplSimulatorCreate(IPLContext context,
                             IPLSimulationSettings* settings,
                             IPLSimulator* simulator)
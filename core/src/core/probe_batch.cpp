@@ -26,6 +26,24 @@ namespace ipl {
 // ---------------------------------------------------------------------------------------------------------------------
 
 ProbeBatch::ProbeBatch(const Serialized::ProbeBatch* serializedObject)
+{
+    load(serializedObject, false, 0);
+}
+
+ProbeBatch::ProbeBatch(SerializedObject& serializedObject)
+    : ProbeBatch(Serialized::GetProbeBatch(serializedObject.data()))
+{}
+
+ProbeBatch::ProbeBatch(shared_ptr<SerializedObject> serializedObject,
+                       uint64_t cacheSize)
+    : mSerializedObject(serializedObject)
+{
+    load(Serialized::GetProbeBatch(serializedObject->data()), true, cacheSize);
+}
+
+void ProbeBatch::load(const Serialized::ProbeBatch* serializedObject,
+                      bool streaming,
+                      uint64_t cacheSize)
 {
     assert(serializedObject);
     assert(serializedObject->probes() && serializedObject->probes()->Length() > 0);
@@ -48,7 +66,14 @@ ProbeBatch::ProbeBatch(const Serialized::ProbeBatch* serializedObject)
 
         if (identifier.type == BakedDataType::Reflections)
         {
-            data = ipl::make_unique<BakedReflectionsData>(identifier, numProbes, serializedObject->data_layers()->Get(i)->reflections_data());
+            if (streaming)
+            {
+                data = ipl::make_unique<BakedReflectionsData>(identifier, numProbes, serializedObject->data_layers()->Get(i)->reflections_data(), cacheSize);
+            }
+            else
+            {
+                data = ipl::make_unique<BakedReflectionsData>(identifier, numProbes, serializedObject->data_layers()->Get(i)->reflections_data());
+            }
         }
         else if (identifier.type == BakedDataType::Pathing)
         {
@@ -60,10 +85,6 @@ ProbeBatch::ProbeBatch(const Serialized::ProbeBatch* serializedObject)
     }
 }
 
-ProbeBatch::ProbeBatch(SerializedObject& serializedObject)
-    : ProbeBatch(Serialized::GetProbeBatch(serializedObject.data()))
-{}
-
 void ProbeBatch::toProbeArray(ProbeArray& probeArray) const
 {
     probeArray.probes.resize(mProbes.size());
@@ -130,6 +151,16 @@ void ProbeBatch::updateEndpoint(const BakedDataIdentifier& identifier,
 void ProbeBatch::commit()
 {
     mProbeTree = make_unique<ProbeTree>(static_cast<int>(mProbes.size()), mProbes.data());
+
+    mBounds = Box{};
+    for (const auto& probe : mProbes)
+    {
+        auto extents = Vector3f(probe.influence.radius, probe.influence.radius, probe.influence.radius);
+        mBounds.minCoordinates = Vector3f::min(mBounds.minCoordinates, probe.influence.center - extents);
+        mBounds.maxCoordinates = Vector3f::max(mBounds.maxCoordinates, probe.influence.center + extents);
+    }
+
+    ++mVersion;
 }
 
 void ProbeBatch::addData(const BakedDataIdentifier& identifier,
@@ -157,7 +188,73 @@ void ProbeBatch::getInfluencingProbes(const Vector3f& point,
     }
 }
 
-flatbuffers::Offset<Serialized::ProbeBatch> ProbeBatch::serialize(SerializedObject& serializedObject) const
+void ProbeBatch::getInfluencingProbes(int numPoints,
+                                      const Vector3f* points,
+                                      BatchedProbeNeighborhood& neighborhood)
+{
+    assert(mProbeTree);
+
+    neighborhood.resize(numPoints, ProbeNeighborhood::kMaxProbesPerBatch);
+
+    mProbeTree->getInfluencingProbes(numPoints, points, mProbes.data(), ProbeNeighborhood::kMaxProbesPerBatch,
+                                     neighborhood.probeIndices.data(), neighborhood.distances.data());
+}
+
+void ProbeBatch::invalidateBakedData(const BakedDataIdentifier& identifier,
+                                     const Box& changedBounds,
+                                     float radius)
+{
+    if (!hasData(identifier))
+        return;
+
+    if (identifier.type == BakedDataType::Pathing)
+    {
+        auto& pathData = static_cast<BakedPathData&>(*mData[identifier]);
+
+        for (auto i = 0; i < numProbes(); ++i)
+        {
+            if (changedBounds.distanceTo(mProbes[i].influence.center) <= radius)
+            {
+                pathData.invalidate(i);
+            }
+        }
+
+        return;
+    }
+
+    auto& data = static_cast<BakedReflectionsData&>(*mData[identifier]);
+
+    auto endpointChanged = (identifier.variation == BakedDataVariation::StaticSource ||
+                            identifier.variation == BakedDataVariation::StaticListener) &&
+                           (changedBounds.distanceTo(identifier.endpointInfluence.center) <= radius);
+
+    for (auto i = 0; i < numProbes(); ++i)
+    {
+        if (endpointChanged || changedBounds.distanceTo(mProbes[i].influence.center) <= radius)
+        {
+            data.invalidate(i);
+        }
+    }
+}
+
+bool ProbeBatch::hasSameProbes(const ProbeBatch& other) const
+{
+    if (other.numProbes() != numProbes())
+        return false;
+
+    for (auto i = 0; i < numProbes(); ++i)
+    {
+        const auto& lhs = other[i].influence;
+        const auto& rhs = mProbes[i].influence;
+        if (lhs.center != rhs.center || lhs.radius != rhs.radius)
+            return false;
+    }
+
+    return true;
+}
+
+flatbuffers::Offset<Serialized::ProbeBatch> ProbeBatch::serialize(SerializedObject& serializedObject,
+                                                                  const BakedDataIdentifier* identifier) const
 {
     auto& fbb = serializedObject.fbb();
 
@@ -174,6 +271,9 @@ flatbuffers::Offset<Serialized::ProbeBatch> ProbeBatch::serialize(SerializedObje
 
     for (const auto& data : mData)
     {
+        if (identifier && !(data.first == *identifier))
+            continue;
+
         auto identifierOffset = Serialized::CreateBakedDataIdentifier(fbb,
                                                                       static_cast<Serialized::BakedDataVariation>(data.first.variation),
                                                                       static_cast<Serialized::BakedDataType>(data.first.type),
@@ -199,9 +299,10 @@ flatbuffers::Offset<Serialized::ProbeBatch> ProbeBatch::serialize(SerializedObje
     return Serialized::CreateProbeBatch(fbb, probesOffset, dataLayersOffset);
 }
 
-void ProbeBatch::serializeAsRoot(SerializedObject& serializedObject) const
+void ProbeBatch::serializeAsRoot(SerializedObject& serializedObject,
+                                 const BakedDataIdentifier* identifier) const
 {
-    serializedObject.fbb().Finish(serialize(serializedObject));
+    serializedObject.fbb().Finish(serialize(serializedObject, identifier));
     serializedObject.commit();
 }
 
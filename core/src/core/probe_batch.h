@@ -25,6 +25,7 @@
 namespace ipl {
 
 class ProbeBatch;
+class ProbeOcclusionCache;
 
 // ---------------------------------------------------------------------------------------------------------------------
 // ProbeNeighborhood
@@ -83,6 +84,12 @@ public:
     void checkOcclusion(const IScene& scene,
         const Vector3f& point);
 
+    // Same as above, but reuses occlusion results stored in the cache where possible, and only traces rays to probes
+    // that are not in the cache.
+    void checkOcclusion(const IScene& scene,
+                        const Vector3f& point,
+                        ProbeOcclusionCache& cache);
+
     int findNearest(const Vector3f& point) const;
 
     void getProbe(int neighborProbeIndex, int* probeIndex, float* weight);
@@ -91,6 +98,118 @@ public:
 };
 
 
+// ---------------------------------------------------------------------------------------------------------------------
+// BatchedProbeNeighborhood
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The probes in a single probe batch that influence each of several points. Data is stored as flat arrays, with the
+// entries for point i starting at index i * maxProbesPerPoint, so weights for all points can be calculated using SIMD
+// instructions. Unused entries have a probe index of -1.
+class BatchedProbeNeighborhood
+{
+public:
+    int numPoints = 0;
+    int maxProbesPerPoint = 0;
+    Array<int> probeIndices;
+    Array<float> distances;
+    Array<float> weights;
+
+    // Only reallocates if the arrays are too small.
+    void resize(int numPoints,
+                int maxProbesPerPoint);
+
+    // Calculates inverse distance weights, normalized so the weights for each point sum to 1.
+    void calcWeights();
+};
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// ProbeOcclusionCache
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Stores whether probes are occluded from endpoints (sources or the listener), so occlusion checks for endpoints that
+// are static or move slowly don't need to trace rays every simulation tick. Endpoints are quantized to a grid, and
+// results are shared by all endpoints in the same grid cell: each result is the visibility of a probe from the first
+// endpoint in the cell for which it was checked. All results are discarded when the scene's version changes, so this
+// must not be used with scenes whose version stays the same when they change.
+class ProbeOcclusionCache
+{
+public:
+    static const float kDefaultCellSize;
+
+    ProbeOcclusionCache(float cellSize = kDefaultCellSize);
+
+    float cellSize() const
+    {
+        return mCellSize;
+    }
+
+    int numCachedResults() const
+    {
+        return mNumResults;
+    }
+
+    // Discards all results if the scene has changed since the last call.
+    void update(const IScene& scene);
+
+    // Returns a pointer to the cached result for the given probe as seen from the given point, or nullptr if no
+    // result is cached.
+    const bool* find(const Vector3f& point,
+                     const ProbeBatch& batch,
+                     int probeIndex) const;
+
+    void add(const Vector3f& point,
+             const ProbeBatch& batch,
+             int probeIndex,
+             bool occluded);
+
+    void reset();
+
+private:
+    // Upper limit on the number of results stored. The cache is reset when this is exceeded.
+    static const int kMaxResults = 65536;
+
+    struct CellKey
+    {
+        int32_t x;
+        int32_t y;
+        int32_t z;
+
+        bool operator==(const CellKey& other) const
+        {
+            return (x == other.x && y == other.y && z == other.z);
+        }
+    };
+
+    struct CellKeyHash
+    {
+        size_t operator()(const CellKey& key) const
+        {
+            return (static_cast<size_t>(key.x) * 73856093u) ^ (static_cast<size_t>(key.y) * 19349663u) ^
+                   (static_cast<size_t>(key.z) * 83492791u);
+        }
+    };
+
+    // The probe center is stored so that results for a probe that has been moved, or for a probe batch that has
+    // been replaced by another at the same address, are not used.
+    struct Result
+    {
+        const ProbeBatch* batch;
+        int probeIndex;
+        Vector3f probeCenter;
+        bool occluded;
+    };
+
+    float mCellSize;
+    const IScene* mScene;
+    uint32_t mSceneVersion;
+    int mNumResults;
+    unordered_map<CellKey, vector<Result>, CellKeyHash> mCells;
+
+    CellKey cellKey(const Vector3f& point) const;
+};
+
+
 // ---------------------------------------------------------------------------------------------------------------------
 // ProbeBatch
 // ---------------------------------------------------------------------------------------------------------------------
@@ -105,6 +224,12 @@ public:
 
     ProbeBatch(SerializedObject& serializedObject);
 
+    // Loads baked reflections data lazily: energy fields are decoded from the serialized object when first looked up,
+    // and at most cacheSize bytes of them are kept in memory for each data layer. The serialized object is retained,
+    // and the buffer it wraps (typically a memory-mapped file) must remain valid for the lifetime of the probe batch.
+    ProbeBatch(shared_ptr<SerializedObject> serializedObject,
+               uint64_t cacheSize);
+
     virtual int numProbes() const
     {
         return static_cast<int>(mProbes.size());
@@ -183,13 +308,54 @@ public:
                                       ProbeNeighborhood& neighborhood,
                                       int offset = 0);
 
-    flatbuffers::Offset<Serialized::ProbeBatch> serialize(SerializedObject& serializedObject) const;
+    // Looks up the nearest (up to ProbeNeighborhood::kMaxProbesPerBatch) probes that influence each of several points.
+    void getInfluencingProbes(int numPoints,
+                              const Vector3f* points,
+                              BatchedProbeNeighborhood& neighborhood);
+
+    // Returns the bounding box of the influence spheres of all probes, as of the last call to commit(). Points outside
+    // this box are not influenced by any probe in the batch.
+    const Box& bounds() const
+    {
+        return mBounds;
+    }
+
+    // Incremented every time commit() is called.
+    uint32_t version() const
+    {
+        return mVersion;
+    }
+
+    // Marks baked reflections data as needing to be baked again for every probe whose center is within the given
+    // distance of a region in which geometry has changed. If the data was baked for a static source or listener
+    // close to the changed region, all probes are invalidated. For baked pathing data, visibility is tested again
+    // between these probes and all other probes.
+    void invalidateBakedData(const BakedDataIdentifier& identifier,
+                             const Box& changedBounds,
+                             float radius);
+
+    // Returns true if the other probe batch contains probes with exactly the same influence spheres, in the same
+    // order. Baked data from one can then be used with the other.
+    bool hasSameProbes(const ProbeBatch& other) const;
+
+    // If identifier is non-null, only the corresponding data layer is serialized.
+    flatbuffers::Offset<Serialized::ProbeBatch> serialize(SerializedObject& serializedObject,
+                                                          const BakedDataIdentifier* identifier = nullptr) const;
+
+    void serializeAsRoot(SerializedObject& serializedObject,
+                         const BakedDataIdentifier* identifier = nullptr) const;
 
-    void serializeAsRoot(SerializedObject& serializedObject) const;
+private:
+    void load(const Serialized::ProbeBatch* serializedObject,
+              bool streaming,
+              uint64_t cacheSize);
 
 protected:
+    shared_ptr<SerializedObject> mSerializedObject;
     vector<Probe> mProbes;
     unique_ptr<ProbeTree> mProbeTree;
+    Box mBounds;
+    uint32_t mVersion = 0;
     map<BakedDataIdentifier, unique_ptr<IBakedData>> mData;
 };
 
@@ -86,6 +86,30 @@ inline bool operator!=(const BakedDataIdentifier& lhs,
 }
 
 
+// ---------------------------------------------------------------------------------------------------------------------
+// BakeShard
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Selects a subset of the probes in a probe batch, so a bake can be split between several processes or machines.
+// Probes are assigned to shards round-robin, which spreads expensive parts of the scene across all the shards.
+struct BakeShard
+{
+    int index = 0;
+    int numShards = 1;
+
+    // Returns true if this shard covers only some of the probes.
+    bool isPartial() const
+    {
+        return (numShards > 1);
+    }
+
+    bool contains(int probeIndex) const
+    {
+        return (probeIndex % numShards == index);
+    }
+};
+
+
 // ---------------------------------------------------------------------------------------------------------------------
 // IBakedData
 // ---------------------------------------------------------------------------------------------------------------------
@@ -16,6 +16,10 @@
 
 #include "probe_generator.h"
 
+#include "reflection_simulator.h"
+#include "reverb_estimator.h"
+#include "thread_pool.h"
+
 namespace ipl {
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -23,13 +27,18 @@ namespace ipl {
 // ---------------------------------------------------------------------------------------------------------------------
 
 const float ProbeGenerator::kDownwardOffset = 0.01f;
+const int ProbeGenerator::kAdaptiveNumDiffuseSamples = 32;
+const int ProbeGenerator::kAdaptiveNumBounces = 16;
+const float ProbeGenerator::kAdaptiveDuration = 1.0f;
+const float ProbeGenerator::kAdaptiveIrradianceMinDistance = 1.0f;
 
 void ProbeGenerator::generateProbes(const IScene& scene,
                                     const Matrix4x4f& obbTransform,
                                     ProbeGenerationType type,
                                     float spacing,
                                     float height,
-                                    ProbeArray& probes)
+                                    ProbeArray& probes,
+                                    const AdaptiveProbeGenerationSettings& adaptive /* = AdaptiveProbeGenerationSettings{} */)
 {
     switch (type)
     {
@@ -41,6 +50,10 @@ void ProbeGenerator::generateProbes(const IScene& scene,
         generateUniformFloorProbes(scene, obbTransform, spacing, height, probes);
         break;
 
+    case ProbeGenerationType::Adaptive:
+        generateAdaptiveProbes(scene, obbTransform, spacing, height, adaptive, probes);
+        break;
+
     default:
         throw Exception(Status::Initialization);
     }
@@ -109,6 +122,236 @@ void ProbeGenerator::generateUniformFloorProbes(const IScene& scene,
     memcpy(probes.probes.data(), _probes.data(), _probes.size() * sizeof(Probe));
 }
 
+void ProbeGenerator::generateAdaptiveProbes(const IScene& scene,
+                                            const Matrix4x4f& obbTransform,
+                                            float spacing,
+                                            float height,
+                                            const AdaptiveProbeGenerationSettings& settings,
+                                            ProbeArray& probes)
+{
+    auto sx = Vector3f(obbTransform(0, 0), obbTransform(1, 0), obbTransform(2, 0)).length();
+    auto sy = Vector3f(obbTransform(0, 1), obbTransform(1, 1), obbTransform(2, 1)).length();
+    auto sz = Vector3f(obbTransform(0, 2), obbTransform(1, 2), obbTransform(2, 2)).length();
+
+    if (sx < std::numeric_limits<float>::min() ||
+        sy < std::numeric_limits<float>::min() ||
+        sz < std::numeric_limits<float>::min())
+    {
+        return;
+    }
+
+    // Columns of probes are placed on a grid with the finest spacing, and identified by their indices along x and z.
+    // At subdivision level l, probes are placed on every (2^(numSubdivisions - l))th column.
+    auto numSubdivisions = std::min(std::max(settings.numSubdivisions, 0), kMaxSubdivisions);
+    auto coarseStep = 1 << numSubdivisions;
+
+    auto numColumnsX = static_cast<int>(floorf(sx / spacing)) + 1;
+    auto numColumnsZ = static_cast<int>(floorf(sz / spacing)) + 1;
+    auto residualX = (sx - (numColumnsX - 1) * spacing) / 2;
+    auto residualZ = (sz - (numColumnsZ - 1) * spacing) / 2;
+
+    auto downVector4f = Vector4f(obbTransform * Vector4f(0, -1, 0, 0));
+    auto downVector = Vector3f::unitVector(Vector3f(downVector4f.x(), downVector4f.y(), downVector4f.z()));
+
+    auto columnKey = [numColumnsZ](int i, int j)
+    {
+        return static_cast<int64_t>(i) * numColumnsZ + j;
+    };
+
+    // Each column is traced at most once, and may contain several probes, one for each floor.
+    unordered_map<int64_t, vector<Probe>> columns;
+    auto traceColumn = [&](int i, int j) -> const vector<Probe>&
+    {
+        auto column = columns.find(columnKey(i, j));
+        if (column != columns.end())
+            return column->second;
+
+        auto xPos = -.5f + (i * spacing + residualX) / sx;
+        auto yPos = .5f;
+        auto zPos = -.5f + (j * spacing + residualZ) / sz;
+
+        auto probePoint4f = Vector4f(obbTransform * Vector4f(xPos, yPos, zPos, 1));
+        auto probePoint = Vector3f(probePoint4f.x(), probePoint4f.y(), probePoint4f.z());
+
+        auto& floorProbes = columns[columnKey(i, j)];
+        computeFloorProbesBelow(scene, probePoint, downVector, obbTransform, spacing, height, floorProbes);
+        return floorProbes;
+    };
+
+    struct AdaptiveProbe
+    {
+        Vector3f center;
+        int column[2];
+        int step;
+        Reverb reverb;
+    };
+
+    vector<AdaptiveProbe> adaptiveProbes;
+    unordered_map<int64_t, vector<int>> probesInColumn;
+
+    auto addProbe = [&](int i, int j, int step, const Vector3f& center)
+    {
+        auto& columnProbes = probesInColumn[columnKey(i, j)];
+        for (auto index : columnProbes)
+        {
+            if ((adaptiveProbes[index].center - center).length() < 0.5f * spacing)
+                return false;
+        }
+
+        columnProbes.push_back(static_cast<int>(adaptiveProbes.size()));
+        adaptiveProbes.push_back(AdaptiveProbe{center, {i, j}, step, Reverb{}});
+        return true;
+    };
+
+    vector<int> frontier;
+
+    for (auto i = 0; i < numColumnsX; i += coarseStep)
+    {
+        for (auto j = 0; j < numColumnsZ; j += coarseStep)
+        {
+            for (const auto& floorProbe : traceColumn(i, j))
+            {
+                if (addProbe(i, j, coarseStep, floorProbe.influence.center))
+                {
+                    frontier.push_back(static_cast<int>(adaptiveProbes.size()) - 1);
+                }
+            }
+        }
+    }
+
+    auto numThreads = std::max(settings.numThreads, 1);
+    ReflectionSimulator simulator(settings.numRays, kAdaptiveNumDiffuseSamples, kAdaptiveDuration, 0, 1, numThreads);
+    ThreadPool threadPool(numThreads);
+    JobGraph jobGraph;
+
+    // Runs a quick, low-order reverb bake at each newly-added probe.
+    auto estimateReverb = [&](const vector<int>& indices)
+    {
+        EnergyField energyField(kAdaptiveDuration, 0);
+        auto energyFieldPtr = &energyField;
+        auto directivity = Directivity{};
+        auto airAbsorption = AirAbsorptionModel{};
+
+        for (auto index : indices)
+        {
+            auto& probe = adaptiveProbes[index];
+            CoordinateSpace3f endpoint = probe.center;
+
+            energyField.reset();
+
+            jobGraph.reset();
+            simulator.simulate(scene, 1, &endpoint, 1, &endpoint, &directivity, settings.numRays, kAdaptiveNumBounces,
+                               kAdaptiveDuration, 0, kAdaptiveIrradianceMinDistance, &energyFieldPtr, jobGraph);
+            threadPool.process(jobGraph);
+
+            ReverbEstimator::estimate(energyField, airAbsorption, probe.reverb);
+        }
+    };
+
+    auto isDifferent = [&](const Reverb& lhs, const Reverb& rhs)
+    {
+        for (auto band = 0; band < Bands::kNumBands; ++band)
+        {
+            auto maxReverbTime = std::max(lhs.reverbTimes[band], rhs.reverbTimes[band]);
+            if (fabsf(lhs.reverbTimes[band] - rhs.reverbTimes[band]) > settings.tolerance * maxReverbTime)
+                return true;
+        }
+
+        return false;
+    };
+
+    estimateReverb(frontier);
+
+    for (auto level = 0; level < numSubdivisions && !frontier.empty(); ++level)
+    {
+        const int neighborOffsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+        // Compare each probe added at the previous level against probes in the neighboring columns at the same
+        // spacing. Probes more than one step away (diagonally, or on a different floor) are not compared.
+        vector<uint8_t> subdivide(adaptiveProbes.size(), 0);
+        for (auto index : frontier)
+        {
+            const auto& probe = adaptiveProbes[index];
+            auto maxDistance = 1.5f * probe.step * spacing;
+
+            for (const auto& offset : neighborOffsets)
+            {
+                auto i = probe.column[0] + offset[0] * probe.step;
+                auto j = probe.column[1] + offset[1] * probe.step;
+                if (i < 0 || i >= numColumnsX || j < 0 || j >= numColumnsZ)
+                    continue;
+
+                auto neighbors = probesInColumn.find(columnKey(i, j));
+                if (neighbors == probesInColumn.end())
+                    continue;
+
+                for (auto neighborIndex : neighbors->second)
+                {
+                    const auto& neighbor = adaptiveProbes[neighborIndex];
+                    if ((neighbor.center - probe.center).length() > maxDistance)
+                        continue;
+
+                    if (isDifferent(probe.reverb, neighbor.reverb))
+                    {
+                        subdivide[index] = 1;
+
+                        if (neighbor.step == probe.step)
+                        {
+                            subdivide[neighborIndex] = 1;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Add probes at half the spacing around each probe that needs to be subdivided, on the same floor.
+        vector<int> newFrontier;
+        for (auto index = 0; index < static_cast<int>(subdivide.size()); ++index)
+        {
+            if (!subdivide[index])
+                continue;
+
+            auto step = adaptiveProbes[index].step;
+            auto halfStep = step / 2;
+            if (halfStep < 1)
+                continue;
+
+            for (auto di = -1; di <= 1; ++di)
+            {
+                for (auto dj = -1; dj <= 1; ++dj)
+                {
+                    auto i = adaptiveProbes[index].column[0] + di * halfStep;
+                    auto j = adaptiveProbes[index].column[1] + dj * halfStep;
+                    if ((di == 0 && dj == 0) || i < 0 || i >= numColumnsX || j < 0 || j >= numColumnsZ)
+                        continue;
+
+                    for (const auto& floorProbe : traceColumn(i, j))
+                    {
+                        auto center = floorProbe.influence.center;
+                        if ((center - adaptiveProbes[index].center).length() > step * spacing)
+                            continue;
+
+                        if (addProbe(i, j, halfStep, center))
+                        {
+                            newFrontier.push_back(static_cast<int>(adaptiveProbes.size()) - 1);
+                        }
+                    }
+                }
+            }
+        }
+
+        estimateReverb(newFrontier);
+        frontier = std::move(newFrontier);
+    }
+
+    probes.probes.resize(adaptiveProbes.size());
+    for (auto i = 0u; i < adaptiveProbes.size(); ++i)
+    {
+        probes.probes[i].influence.center = adaptiveProbes[i].center;
+        probes.probes[i].influence.radius = adaptiveProbes[i].step * spacing;
+    }
+}
+
 void ProbeGenerator::computeFloorProbesBelow(const IScene& scene,
                                              const Vector3f& origin,
                                              const Vector3f& downVector,
@@ -54,18 +54,38 @@ enum class ProbeGenerationType
 {
     Centroid,
     UniformFloor,
+    Adaptive,
     Octree
 };
 
+// Settings for ProbeGenerationType::Adaptive.
+struct AdaptiveProbeGenerationSettings
+{
+    // Probes are first generated with a spacing of spacing * 2^numSubdivisions.
+    int numSubdivisions = 2;
+
+    // Largest relative difference in reverb time between neighboring probes that does not cause subdivision.
+    float tolerance = 0.1f;
+
+    // Number of rays traced for the quick bake at each probe.
+    int numRays = 4096;
+
+    // Number of threads used for the quick bakes.
+    int numThreads = 1;
+};
+
 class ProbeGenerator
 {
 public:
+    static const int kMaxSubdivisions = 8;
+
     static void generateProbes(const IScene& scene,
                                const Matrix4x4f& obbTransform,
                                ProbeGenerationType type,
                                float spacing,
                                float height,
-                               ProbeArray& probes);
+                               ProbeArray& probes,
+                               const AdaptiveProbeGenerationSettings& adaptive = AdaptiveProbeGenerationSettings{});
 
     static void generateCentroidProbe(const IScene& scene,
                                       const Matrix4x4f& obbTransform,
@@ -77,8 +97,22 @@ public:
                                            float height,
                                            ProbeArray& probes);
 
+    // Generates floor probes like generateUniformFloorProbes, starting with a coarse spacing and repeatedly halving it
+    // around probes whose reverb times differ from those of their neighbors. spacing is the finest spacing used. Each
+    // probe's radius of influence is the spacing at which it was generated.
+    static void generateAdaptiveProbes(const IScene& scene,
+                                       const Matrix4x4f& obbTransform,
+                                       float spacing,
+                                       float height,
+                                       const AdaptiveProbeGenerationSettings& settings,
+                                       ProbeArray& probes);
+
 private:
     static const float kDownwardOffset;
+    static const int kAdaptiveNumDiffuseSamples;
+    static const int kAdaptiveNumBounces;
+    static const float kAdaptiveDuration;
+    static const float kAdaptiveIrradianceMinDistance;
 
     static void computeFloorProbesBelow(const IScene& scene,
                                         const Vector3f& origin,
@@ -15,6 +15,8 @@
 //
 
 #include "probe_manager.h"
+
+#include "float4.h"
 #include "profiler.h"
 
 namespace ipl {
@@ -81,6 +83,59 @@ void ProbeNeighborhood::checkOcclusion(const IScene& scene,
     }
 }
 
+void ProbeNeighborhood::checkOcclusion(const IScene& scene,
+                                       const Vector3f& point,
+                                       ProbeOcclusionCache& cache)
+{
+    PROFILE_FUNCTION();
+
+    cache.update(scene);
+
+    int nProbes = numProbes();
+
+    auto numRays = 0;
+    for (auto i = 0; i < nProbes; ++i)
+    {
+        if (!batches[i] || probeIndices[i] < 0)
+            continue;
+
+        const auto* occluded = cache.find(point, *batches[i], probeIndices[i]);
+        if (occluded)
+        {
+            if (*occluded)
+            {
+                batches[i] = nullptr;
+                probeIndices[i] = -1;
+            }
+
+            continue;
+        }
+
+        Vector3f dir = (*batches[i])[probeIndices[i]].influence.center - point;
+        rays[numRays] = { point, Vector3f::unitVector(dir) };
+        minDistances[numRays] = 0.0f;
+        maxDistances[numRays] = dir.length();
+        rayMapping[numRays] = i;
+        ++numRays;
+    }
+
+    if (numRays == 0)
+        return;
+
+    scene.anyHits(numRays, rays.data(), minDistances.data(), maxDistances.data(), isOccluded.data());
+
+    for (auto j = 0; j < numRays; ++j)
+    {
+        cache.add(point, *batches[rayMapping[j]], probeIndices[rayMapping[j]], isOccluded[j]);
+
+        if (isOccluded[j])
+        {
+            batches[rayMapping[j]] = nullptr;
+            probeIndices[rayMapping[j]] = -1;
+        }
+    }
+}
+
 int ProbeNeighborhood::findNearest(const Vector3f& point) const
 {
     auto minDistance = std::numeric_limits<float>::infinity();
@@ -141,6 +196,153 @@ void ProbeNeighborhood::calcWeights(const Vector3f& point)
 }
 
 
+// ---------------------------------------------------------------------------------------------------------------------
+// BatchedProbeNeighborhood
+// ---------------------------------------------------------------------------------------------------------------------
+
+void BatchedProbeNeighborhood::resize(int numPoints,
+                                      int maxProbesPerPoint)
+{
+    auto size = static_cast<size_t>(numPoints * maxProbesPerPoint);
+    if (probeIndices.size(0) < size)
+    {
+        probeIndices.resize(size);
+        distances.resize(size);
+        weights.resize(size);
+    }
+
+    this->numPoints = numPoints;
+    this->maxProbesPerPoint = maxProbesPerPoint;
+}
+
+void BatchedProbeNeighborhood::calcWeights()
+{
+    PROFILE_FUNCTION();
+
+    auto size = numPoints * maxProbesPerPoint;
+    auto simdSize = size & ~3;
+
+    // Unused entries have infinite distance, and therefore zero weight.
+    auto offset = float4::set1(1e-4f);
+    auto one = float4::set1(1.0f);
+    for (auto i = 0; i < simdSize; i += 4)
+    {
+        float4::storeu(&weights[i], float4::div(one, float4::add(float4::loadu(&distances[i]), offset)));
+    }
+
+    for (auto i = simdSize; i < size; ++i)
+    {
+        weights[i] = 1.0f / (distances[i] + 1e-4f);
+    }
+
+    for (auto i = 0; i < numPoints; ++i)
+    {
+        auto* pointWeights = &weights[i * maxProbesPerPoint];
+
+        auto totalWeight = 0.0f;
+        for (auto j = 0; j < maxProbesPerPoint; ++j)
+        {
+            totalWeight += pointWeights[j];
+        }
+
+        if (totalWeight <= 0.0f)
+            continue;
+
+        for (auto j = 0; j < maxProbesPerPoint; ++j)
+        {
+            pointWeights[j] /= totalWeight;
+        }
+    }
+}
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// ProbeOcclusionCache
+// ---------------------------------------------------------------------------------------------------------------------
+
+const float ProbeOcclusionCache::kDefaultCellSize = 0.25f;
+
+ProbeOcclusionCache::ProbeOcclusionCache(float cellSize /* = kDefaultCellSize */)
+    : mCellSize(cellSize)
+    , mScene(nullptr)
+    , mSceneVersion(0)
+    , mNumResults(0)
+{}
+
+void ProbeOcclusionCache::update(const IScene& scene)
+{
+    if (&scene != mScene || scene.version() != mSceneVersion)
+    {
+        reset();
+
+        mScene = &scene;
+        mSceneVersion = scene.version();
+    }
+}
+
+const bool* ProbeOcclusionCache::find(const Vector3f& point,
+                                      const ProbeBatch& batch,
+                                      int probeIndex) const
+{
+    auto cell = mCells.find(cellKey(point));
+    if (cell == mCells.end())
+        return nullptr;
+
+    const auto& probeCenter = batch[probeIndex].influence.center;
+
+    for (const auto& result : cell->second)
+    {
+        if (result.batch == &batch && result.probeIndex == probeIndex && result.probeCenter == probeCenter)
+            return &result.occluded;
+    }
+
+    return nullptr;
+}
+
+void ProbeOcclusionCache::add(const Vector3f& point,
+                              const ProbeBatch& batch,
+                              int probeIndex,
+                              bool occluded)
+{
+    if (mNumResults >= kMaxResults)
+    {
+        mCells.clear();
+        mNumResults = 0;
+    }
+
+    auto& results = mCells[cellKey(point)];
+
+    // Replace any result for an earlier position of the same probe.
+    for (auto& result : results)
+    {
+        if (result.batch == &batch && result.probeIndex == probeIndex)
+        {
+            result.probeCenter = batch[probeIndex].influence.center;
+            result.occluded = occluded;
+            return;
+        }
+    }
+
+    results.push_back(Result{&batch, probeIndex, batch[probeIndex].influence.center, occluded});
+    ++mNumResults;
+}
+
+void ProbeOcclusionCache::reset()
+{
+    mCells.clear();
+    mNumResults = 0;
+    mScene = nullptr;
+    mSceneVersion = 0;
+}
+
+ProbeOcclusionCache::CellKey ProbeOcclusionCache::cellKey(const Vector3f& point) const
+{
+    return CellKey{static_cast<int32_t>(floorf(point.x() / mCellSize)),
+                   static_cast<int32_t>(floorf(point.y() / mCellSize)),
+                   static_cast<int32_t>(floorf(point.z() / mCellSize))};
+}
+
+
 // ---------------------------------------------------------------------------------------------------------------------
 // ProbeManager
 // ---------------------------------------------------------------------------------------------------------------------
@@ -158,6 +360,8 @@ void ProbeManager::removeProbeBatch(shared_ptr<ProbeBatch> probeBatch)
 void ProbeManager::commit()
 {
     mProbeBatches[0] = mProbeBatches[1];
+
+    buildGrid();
 }
 
 void ProbeManager::getInfluencingProbes(const Vector3f& point,
@@ -165,7 +369,12 @@ void ProbeManager::getInfluencingProbes(const Vector3f& point,
 {
     PROFILE_FUNCTION();
 
-    auto numProbes = static_cast<int>(mProbeBatches[0].size() * ProbeNeighborhood::kMaxProbesPerBatch);
+    if (haveProbeBatchesChanged())
+    {
+        buildGrid();
+    }
+
+    auto numProbes = mMaxBatchesPerPoint * ProbeNeighborhood::kMaxProbesPerBatch;
     if (neighborhood.numProbes() != numProbes)
     {
         neighborhood.resize(numProbes);
@@ -176,11 +385,297 @@ void ProbeManager::getInfluencingProbes(const Vector3f& point,
     }
 
     auto offset = 0;
+
+    for (auto batchIndex : mLargeBatches)
+    {
+        if (mBatches[batchIndex]->bounds().contains(point))
+        {
+            mBatches[batchIndex]->getInfluencingProbes(point, neighborhood, offset);
+            offset += ProbeNeighborhood::kMaxProbesPerBatch;
+        }
+    }
+
+    auto cell = findCell(point);
+    if (cell < 0)
+        return;
+
+    for (auto i = mCellStarts[cell]; i < mCellStarts[cell + 1]; ++i)
+    {
+        auto* batch = mBatches[mCellBatches[i]];
+        if (batch->bounds().contains(point))
+        {
+            batch->getInfluencingProbes(point, neighborhood, offset);
+            offset += ProbeNeighborhood::kMaxProbesPerBatch;
+        }
+    }
+}
+
+void ProbeManager::getInfluencingProbes(int numPoints,
+                                        const Vector3f* points,
+                                        ProbeNeighborhood* neighborhoods)
+{
+    PROFILE_FUNCTION();
+
+    if (haveProbeBatchesChanged())
+    {
+        buildGrid();
+    }
+
+    auto numProbes = mMaxBatchesPerPoint * ProbeNeighborhood::kMaxProbesPerBatch;
+    auto numBatches = static_cast<int>(mBatches.size());
+
+    mQueries.clear();
+
+    for (auto i = 0; i < numPoints; ++i)
+    {
+        if (neighborhoods[i].numProbes() != numProbes)
+        {
+            neighborhoods[i].resize(numProbes);
+        }
+        else
+        {
+            neighborhoods[i].reset();
+        }
+
+        const auto& point = points[i];
+        auto offset = 0;
+
+        for (auto batchIndex : mLargeBatches)
+        {
+            if (mBatches[batchIndex]->bounds().contains(point))
+            {
+                mQueries.push_back(BatchQuery{batchIndex, i, offset});
+                offset += ProbeNeighborhood::kMaxProbesPerBatch;
+            }
+        }
+
+        auto cell = findCell(point);
+        if (cell < 0)
+            continue;
+
+        for (auto j = mCellStarts[cell]; j < mCellStarts[cell + 1]; ++j)
+        {
+            auto batchIndex = mCellBatches[j];
+            if (mBatches[batchIndex]->bounds().contains(point))
+            {
+                mQueries.push_back(BatchQuery{batchIndex, i, offset});
+                offset += ProbeNeighborhood::kMaxProbesPerBatch;
+            }
+        }
+    }
+
+    // Group the queries by probe batch, using a counting sort.
+    mQueryStarts.assign(numBatches + 1, 0);
+    for (const auto& query : mQueries)
+    {
+        mQueryStarts[query.batchIndex + 1]++;
+    }
+
+    for (auto i = 0; i < numBatches; ++i)
+    {
+        mQueryStarts[i + 1] += mQueryStarts[i];
+    }
+
+    mSortedQueries.resize(mQueries.size());
+    for (const auto& query : mQueries)
+    {
+        mSortedQueries[mQueryStarts[query.batchIndex]++] = query;
+    }
+
+    for (auto i = numBatches; i > 0; --i)
+    {
+        mQueryStarts[i] = mQueryStarts[i - 1];
+    }
+    mQueryStarts[0] = 0;
+
+    for (auto batchIndex = 0; batchIndex < numBatches; ++batchIndex)
+    {
+        auto start = mQueryStarts[batchIndex];
+        auto numQueries = mQueryStarts[batchIndex + 1] - start;
+        if (numQueries == 0)
+            continue;
+
+        mQueryPoints.resize(numQueries);
+        for (auto i = 0; i < numQueries; ++i)
+        {
+            mQueryPoints[i] = points[mSortedQueries[start + i].pointIndex];
+        }
+
+        auto* batch = mBatches[batchIndex];
+        batch->getInfluencingProbes(numQueries, mQueryPoints.data(), mBatchedNeighborhood);
+
+        for (auto i = 0; i < numQueries; ++i)
+        {
+            const auto& query = mSortedQueries[start + i];
+            auto& neighborhood = neighborhoods[query.pointIndex];
+
+            for (auto j = 0; j < ProbeNeighborhood::kMaxProbesPerBatch; ++j)
+            {
+                neighborhood.batches[query.offset + j] = batch;
+                neighborhood.probeIndices[query.offset + j] = mBatchedNeighborhood.probeIndices[i * ProbeNeighborhood::kMaxProbesPerBatch + j];
+            }
+        }
+    }
+}
+
+void ProbeManager::buildGrid()
+{
+    mBatches.clear();
+    mLargeBatches.clear();
+    mCellStarts.clear();
+    mCellBatches.clear();
+    mGridBounds = Box{};
+    mMaxBatchesPerPoint = 0;
+
+    mBatchVersions.clear();
     for (const auto& batch : mProbeBatches[0])
     {
-        batch->getInfluencingProbes(point, neighborhood, offset);
-        offset += ProbeNeighborhood::kMaxProbesPerBatch;
+        mBatchVersions.push_back(batch->version());
     }
+
+    for (const auto& batch : mProbeBatches[0])
+    {
+        // Batches with no probes cannot influence any point.
+        if (batch->numProbes() > 0)
+        {
+            mBatches.push_back(batch.get());
+        }
+    }
+
+    if (mBatches.empty())
+    {
+        mGridResolution[0] = mGridResolution[1] = mGridResolution[2] = 0;
+        return;
+    }
+
+    vector<float> batchExtents(mBatches.size());
+    for (auto i = 0u; i < mBatches.size(); ++i)
+    {
+        batchExtents[i] = mBatches[i]->bounds().extents().maxComponent();
+    }
+
+    auto sortedExtents = batchExtents;
+    std::nth_element(sortedExtents.begin(), sortedExtents.begin() + sortedExtents.size() / 2, sortedExtents.end());
+    auto medianExtent = sortedExtents[sortedExtents.size() / 2];
+
+    vector<int> gridBatches;
+    for (auto i = 0; i < static_cast<int>(mBatches.size()); ++i)
+    {
+        if (!std::isfinite(batchExtents[i]) || batchExtents[i] > kLargeBatchExtentRatio * medianExtent)
+        {
+            mLargeBatches.push_back(i);
+        }
+        else
+        {
+            gridBatches.push_back(i);
+            mGridBounds.minCoordinates = Vector3f::min(mGridBounds.minCoordinates, mBatches[i]->bounds().minCoordinates);
+            mGridBounds.maxCoordinates = Vector3f::max(mGridBounds.maxCoordinates, mBatches[i]->bounds().maxCoordinates);
+        }
+    }
+
+    if (gridBatches.empty())
+    {
+        mGridResolution[0] = mGridResolution[1] = mGridResolution[2] = 0;
+        mMaxBatchesPerPoint = static_cast<int>(mLargeBatches.size());
+        return;
+    }
+
+    // Cells are roughly the size of a typical probe batch, so each point overlaps only a few batches.
+    auto gridExtents = mGridBounds.extents();
+    for (auto axis = 0; axis < 3; ++axis)
+    {
+        auto resolution = (medianExtent > 0.0f) ? ceilf(gridExtents[axis] / medianExtent) : 1.0f;
+        mGridResolution[axis] = static_cast<int>(std::min(std::max(resolution, 1.0f), static_cast<float>(kMaxGridResolution)));
+        mCellSize[axis] = std::max(gridExtents[axis] / mGridResolution[axis], std::numeric_limits<float>::min());
+    }
+
+    auto numCells = mGridResolution[0] * mGridResolution[1] * mGridResolution[2];
+    mCellStarts.assign(numCells + 1, 0);
+
+    // Count the batches overlapping each cell, then store them in a single flat array.
+    for (auto pass = 0; pass < 2; ++pass)
+    {
+        for (auto batchIndex : gridBatches)
+        {
+            const auto& bounds = mBatches[batchIndex]->bounds();
+
+            int minCell[3], maxCell[3];
+            for (auto axis = 0; axis < 3; ++axis)
+            {
+                minCell[axis] = gridCoordinate(bounds.minCoordinates, axis);
+                maxCell[axis] = gridCoordinate(bounds.maxCoordinates, axis);
+            }
+
+            for (auto z = minCell[2]; z <= maxCell[2]; ++z)
+            {
+                for (auto y = minCell[1]; y <= maxCell[1]; ++y)
+                {
+                    for (auto x = minCell[0]; x <= maxCell[0]; ++x)
+                    {
+                        auto cell = cellIndex(x, y, z);
+                        if (pass == 0)
+                        {
+                            ++mCellStarts[cell + 1];
+                        }
+                        else
+                        {
+                            mCellBatches[mCellStarts[cell]++] = batchIndex;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (auto cell = 0; cell < numCells; ++cell)
+            {
+                mMaxBatchesPerPoint = std::max(mMaxBatchesPerPoint, mCellStarts[cell + 1]);
+                mCellStarts[cell + 1] += mCellStarts[cell];
+            }
+
+            mCellBatches.resize(mCellStarts[numCells]);
+        }
+        else
+        {
+            // Filling each cell advanced its start to the start of the next cell.
+            for (auto cell = numCells; cell > 0; --cell)
+            {
+                mCellStarts[cell] = mCellStarts[cell - 1];
+            }
+
+            mCellStarts[0] = 0;
+        }
+    }
+
+    mMaxBatchesPerPoint += static_cast<int>(mLargeBatches.size());
+}
+
+bool ProbeManager::haveProbeBatchesChanged() const
+{
+    auto i = 0;
+    for (const auto& batch : mProbeBatches[0])
+    {
+        if (batch->version() != mBatchVersions[i++])
+            return true;
+    }
+
+    return false;
+}
+
+int ProbeManager::gridCoordinate(const Vector3f& point,
+                                 int axis) const
+{
+    auto coordinate = floorf((point[axis] - mGridBounds.minCoordinates[axis]) / mCellSize[axis]);
+    return static_cast<int>(std::min(std::max(coordinate, 0.0f), static_cast<float>(mGridResolution[axis] - 1)));
+}
+
+int ProbeManager::findCell(const Vector3f& point) const
+{
+    if (mCellStarts.empty() || !mGridBounds.contains(point))
+        return -1;
+
+    return cellIndex(gridCoordinate(point, 0), gridCoordinate(point, 1), gridCoordinate(point, 2));
 }
 
 }
@@ -48,11 +48,76 @@ public:
 
     void commit();
 
+    // Looks up the probes that influence a point. Only probe batches whose bounds contain the point are searched. The
+    // neighborhood is sized for the largest number of probe batches that can influence any one point, so it does not
+    // need to be reallocated as the point moves around. If any probe batch has been committed since the grid was
+    // built, the grid is rebuilt first.
     void getInfluencingProbes(const Vector3f& point,
                               ProbeNeighborhood& neighborhood);
 
+    // Looks up the probes that influence each of several points. Points are grouped by the probe batches that can
+    // influence them, and each probe batch is searched for all of its points at once. Neighborhoods have the same
+    // layout as with the single-point version, but the probes found in each probe batch are the nearest ones to the
+    // point, sorted by distance.
+    void getInfluencingProbes(int numPoints,
+                              const Vector3f* points,
+                              ProbeNeighborhood* neighborhoods);
+
 private:
+    // Probe batches whose bounds are this many times larger than the median probe batch are not inserted into the
+    // grid, and are instead searched for every point.
+    static const int kLargeBatchExtentRatio = 16;
+
+    // Maximum number of grid cells along each axis.
+    static const int kMaxGridResolution = 32;
+
     list<shared_ptr<ProbeBatch>> mProbeBatches[2];
+
+    // Uniform grid over the bounds of the committed probe batches. Each cell stores the indices (into mBatches) of the
+    // probe batches whose bounds overlap it, in mCellBatches[mCellStarts[i]] to mCellBatches[mCellStarts[i + 1] - 1].
+    vector<ProbeBatch*> mBatches;
+    vector<uint32_t> mBatchVersions; // Version of each probe batch in mProbeBatches[0] when the grid was built.
+    vector<int> mLargeBatches;
+    Box mGridBounds;
+    int mGridResolution[3] = {0, 0, 0};
+    Vector3f mCellSize;
+    vector<int> mCellStarts;
+    vector<int> mCellBatches;
+    int mMaxBatchesPerPoint = 0;
+
+    // A point that must be searched for in a probe batch, and where the results go in the point's neighborhood.
+    struct BatchQuery
+    {
+        int batchIndex;
+        int pointIndex;
+        int offset;
+    };
+
+    // Scratch space for batched lookups, grouped by probe batch.
+    vector<BatchQuery> mQueries;
+    vector<BatchQuery> mSortedQueries;
+    vector<int> mQueryStarts;
+    vector<Vector3f> mQueryPoints;
+    BatchedProbeNeighborhood mBatchedNeighborhood;
+
+    void buildGrid();
+
+    // Returns true if any probe batch has been committed since the grid was built, e.g. after adding probes to it,
+    // which may change its bounds.
+    bool haveProbeBatchesChanged() const;
+
+    int cellIndex(int x,
+                  int y,
+                  int z) const
+    {
+        return (z * mGridResolution[1] + y) * mGridResolution[0] + x;
+    }
+
+    int gridCoordinate(const Vector3f& point,
+                       int axis) const;
+
+    // Returns -1 if the point is outside the grid.
+    int findCell(const Vector3f& point) const;
 };
 
 }
@@ -19,6 +19,7 @@
 #include <numeric>
 
 #include "bvh.h"
+#include "float4.h"
 #include "profiler.h"
 #include "stack.h"
 
@@ -139,14 +140,31 @@ void ProbeTree::getInfluencingProbes(const Vector3f& point,
 {
     PROFILE_FUNCTION();
 
+    assert(maxInfluencingProbes <= kMaxInfluencingProbes);
+
     for (auto i = 0; i < maxInfluencingProbes; ++i)
     {
         probeIndices[i] = -1;
     }
 
-    auto numInfluencingProbes = 0;
+    if (mNodes.size(0) == 0 || maxInfluencingProbes <= 0)
+        return;
+
+    maxInfluencingProbes = std::min(maxInfluencingProbes, kMaxInfluencingProbes);
+
+    auto numFound = 0;
+    float distancesSquared[kMaxInfluencingProbes];
 
-    Stack<const ProbeTreeNode*, kProbeLookupStackSize> stack;
+    // Probe centers in the far child of a node are on the other side of the node's split plane, so they are at least
+    // as far from the point as the split plane is. Far children are pushed along with this bound, and skipped if the
+    // list of nearest probes is full and they can't contain any nearer probes.
+    struct StackEntry
+    {
+        const ProbeTreeNode* node;
+        float minDistanceSquared;
+    };
+
+    Stack<StackEntry, kProbeLookupStackSize> stack;
     const auto* node = &mNodes[0];
 
     while (true)
@@ -155,12 +173,31 @@ void ProbeTree::getInfluencingProbes(const Vector3f& point,
         {
             if (node->isLeaf())
             {
-                if (probes[node->getProbeIndex()].influence.contains(point))
+                auto probeIndex = node->getProbeIndex();
+                const auto& influence = probes[probeIndex].influence;
+
+                auto distanceSquared = ProbeTree::distanceSquared(point, influence.center);
+                if (distanceSquared <= influence.radius * influence.radius)
                 {
-                    probeIndices[numInfluencingProbes] = node->getProbeIndex();
-                    ++numInfluencingProbes;
-                    if (numInfluencingProbes >= maxInfluencingProbes)
-                        break;
+                    // Insert into the list of nearest probes, which is kept sorted by distance.
+                    auto position = numFound;
+                    while (position > 0 && isNearer(probeIndex, distanceSquared, probeIndices[position - 1], distancesSquared[position - 1]))
+                    {
+                        if (position < maxInfluencingProbes)
+                        {
+                            probeIndices[position] = probeIndices[position - 1];
+                            distancesSquared[position] = distancesSquared[position - 1];
+                        }
+
+                        --position;
+                    }
+
+                    if (position < maxInfluencingProbes)
+                    {
+                        probeIndices[position] = probeIndex;
+                        distancesSquared[position] = distanceSquared;
+                        numFound = std::min(numFound + 1, maxInfluencingProbes);
+                    }
                 }
             }
             else
@@ -172,16 +209,155 @@ void ProbeTree::getInfluencingProbes(const Vector3f& point,
                     std::swap(nearChild, farChild);
                 }
 
-                stack.push(farChild);
+                auto distanceToSplit = point.elements[node->getSplitAxis()] - node->getSplitCoordinate();
+
+                stack.push(StackEntry{farChild, distanceToSplit * distanceToSplit});
                 node = nearChild;
                 continue;
             }
         }
 
-        if (stack.isEmpty())
+        // A probe at the same distance as the farthest one in the list may still be listed before it, if its index
+        // is lower, so only subtrees that are strictly farther away are skipped.
+        auto found = false;
+        while (!stack.isEmpty())
+        {
+            auto entry = stack.pop();
+            if (numFound < maxInfluencingProbes || entry.minDistanceSquared <= distancesSquared[numFound - 1])
+            {
+                node = entry.node;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
             break;
+    }
+}
+
+void ProbeTree::getInfluencingProbes(int numPoints,
+                                     const Vector3f* points,
+                                     const Probe* probes,
+                                     int maxInfluencingProbes,
+                                     int* probeIndices,
+                                     float* distances) const
+{
+    PROFILE_FUNCTION();
+
+    for (auto i = 0; i < numPoints * maxInfluencingProbes; ++i)
+    {
+        probeIndices[i] = -1;
+        distances[i] = std::numeric_limits<float>::infinity();
+    }
+
+    if (mNodes.size(0) == 0 || maxInfluencingProbes <= 0)
+        return;
 
-        node = stack.pop();
+    for (auto start = 0; start < numPoints; start += 4)
+    {
+        auto numPointsInPacket = std::min(numPoints - start, 4);
+
+        // Unused lanes repeat the last point, and are masked out.
+        alignas(float4_t) float px[4];
+        alignas(float4_t) float py[4];
+        alignas(float4_t) float pz[4];
+        for (auto lane = 0; lane < 4; ++lane)
+        {
+            const auto& point = points[start + std::min(lane, numPointsInPacket - 1)];
+            px[lane] = point.x();
+            py[lane] = point.y();
+            pz[lane] = point.z();
+        }
+
+        auto x = float4::load(px);
+        auto y = float4::load(py);
+        auto z = float4::load(pz);
+        auto activeLanes = (1 << numPointsInPacket) - 1;
+
+        int numFound[4] = {0, 0, 0, 0};
+        alignas(float4_t) float distancesSquared[4];
+
+        Stack<const ProbeTreeNode*, kProbeLookupStackSize> stack;
+        const auto* node = &mNodes[0];
+
+        while (true)
+        {
+            const auto& box = node->box;
+            auto inside = float4::andbits(float4::cmpge(x, float4::set1(box.minCoordinates.x())), float4::cmple(x, float4::set1(box.maxCoordinates.x())));
+            inside = float4::andbits(inside, float4::andbits(float4::cmpge(y, float4::set1(box.minCoordinates.y())), float4::cmple(y, float4::set1(box.maxCoordinates.y()))));
+            inside = float4::andbits(inside, float4::andbits(float4::cmpge(z, float4::set1(box.minCoordinates.z())), float4::cmple(z, float4::set1(box.maxCoordinates.z()))));
+
+            auto lanes = float4::movemask(inside) & activeLanes;
+            if (lanes)
+            {
+                if (node->isLeaf())
+                {
+                    auto probeIndex = node->getProbeIndex();
+                    const auto& influence = probes[probeIndex].influence;
+
+                    auto dx = float4::sub(x, float4::set1(influence.center.x()));
+                    auto dy = float4::sub(y, float4::set1(influence.center.y()));
+                    auto dz = float4::sub(z, float4::set1(influence.center.z()));
+                    auto d2 = float4::add(float4::mul(dx, dx), float4::add(float4::mul(dy, dy), float4::mul(dz, dz)));
+
+                    lanes &= float4::movemask(float4::cmple(d2, float4::set1(influence.radius * influence.radius)));
+                    if (lanes)
+                    {
+                        float4::store(distancesSquared, d2);
+
+                        for (auto lane = 0; lane < numPointsInPacket; ++lane)
+                        {
+                            if (!(lanes & (1 << lane)))
+                                continue;
+
+                            // Insert into this point's list of nearest probes, which is kept sorted by distance.
+                            auto* laneIndices = &probeIndices[(start + lane) * maxInfluencingProbes];
+                            auto* laneDistances = &distances[(start + lane) * maxInfluencingProbes];
+
+                            auto position = numFound[lane];
+                            while (position > 0 && isNearer(probeIndex, distancesSquared[lane], laneIndices[position - 1], laneDistances[position - 1]))
+                            {
+                                if (position < maxInfluencingProbes)
+                                {
+                                    laneIndices[position] = laneIndices[position - 1];
+                                    laneDistances[position] = laneDistances[position - 1];
+                                }
+
+                                --position;
+                            }
+
+                            if (position < maxInfluencingProbes)
+                            {
+                                laneIndices[position] = probeIndex;
+                                laneDistances[position] = distancesSquared[lane];
+                                numFound[lane] = std::min(numFound[lane] + 1, maxInfluencingProbes);
+                            }
+                        }
+                    }
+                }
+                else
+                {
+                    stack.push(&node->getRightChild());
+                    node = &node->getLeftChild();
+                    continue;
+                }
+            }
+
+            if (stack.isEmpty())
+                break;
+
+            node = stack.pop();
+        }
+
+        for (auto lane = 0; lane < numPointsInPacket; ++lane)
+        {
+            auto* laneDistances = &distances[(start + lane) * maxInfluencingProbes];
+            for (auto i = 0; i < numFound[lane]; ++i)
+            {
+                laneDistances[i] = sqrtf(laneDistances[i]);
+            }
+        }
     }
 }
 
@@ -99,14 +99,50 @@ public:
 
     const ProbeTreeNode& getRootNode() const { return mNodes[0]; }
 
+    // Maximum number of probes that can be looked up for a single point.
+    static const int kMaxInfluencingProbes = 64;
+
+    // Looks up the maxInfluencingProbes nearest probes that influence a point, sorted by distance. Probes at the same
+    // distance are sorted by index. Unused entries have a probe index of -1.
     void getInfluencingProbes(const Vector3f& point,
                               const Probe* probes,
                               int maxInfluencingProbes,
                               int* probeIndices);
 
+    // Looks up the probes that influence each of several points. Points are passed through the tree 4 at a time, and
+    // each node's bounding box is tested against all 4 points using SIMD instructions. The probes found for each
+    // point are the same, and in the same order, as with the single-point version. The results for point i are stored
+    // in probeIndices and distances, starting at i * maxInfluencingProbes. Unused entries have a probe index of -1
+    // and a distance of +infinity.
+    void getInfluencingProbes(int numPoints,
+                              const Vector3f* points,
+                              const Probe* probes,
+                              int maxInfluencingProbes,
+                              int* probeIndices,
+                              float* distances) const;
+
 private:
     static const int kProbeLookupStackSize;
 
+    // Summed in the same order as the batched lookup, so both find exactly the same distances.
+    static float distanceSquared(const Vector3f& point,
+                                 const Vector3f& center)
+    {
+        auto dx = point.x() - center.x();
+        auto dy = point.y() - center.y();
+        auto dz = point.z() - center.z();
+        return dx * dx + (dy * dy + dz * dz);
+    }
+
+    // Returns true if probe a, at the given squared distance from a point, should be listed before probe b.
+    static bool isNearer(int a,
+                         float distanceSquaredA,
+                         int b,
+                         float distanceSquaredB)
+    {
+        return (distanceSquaredA < distanceSquaredB || (distanceSquaredA == distanceSquaredB && a < b));
+    }
+
     Array<ProbeTreeNode> mNodes;
 };
 
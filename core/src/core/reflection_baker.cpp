@@ -30,6 +30,8 @@ namespace ipl {
 
 std::atomic<bool> ReflectionBaker::sCancel(false);
 std::atomic<bool> ReflectionBaker::sBakeInProgress(false);
+bool ReflectionBaker::sEnableProbeParallelBaking = true;
+const int ReflectionBaker::kMinProbesPerThreadForProbeParallelBaking = 4;
 
 void ReflectionBaker::bake(const IScene& scene,
                            IReflectionSimulator& simulator,
@@ -48,7 +50,9 @@ void ReflectionBaker::bake(const IScene& scene,
                            shared_ptr<OpenCLDevice> openCL,
                            ProbeBatch& probeBatch,
                            ProgressCallback callback,
-                           void* userData)
+                           void* userData,
+                           const EnergyFieldCompressionSettings& compression,
+                           const ReflectionBakeCheckpointSettings& checkpoint)
 {
     PROFILE_FUNCTION();
 
@@ -63,22 +67,12 @@ void ReflectionBaker::bake(const IScene& scene,
         bakeBatchSize = 1;
     }
 
-    BakedReflectionsData* reflectionsData = nullptr;
-
-    if (!probeBatch.hasData(identifier))
-    {
-        probeBatch.addData(identifier, make_unique<BakedReflectionsData>(identifier, probeBatch.numProbes(), bakeConvolution, bakeParametric));
-    }
-
-    reflectionsData = static_cast<BakedReflectionsData*>(&probeBatch[identifier]);
-
-    reflectionsData->setHasConvolution(bakeConvolution);
-    reflectionsData->setHasParametric(bakeParametric);
+    auto& reflectionsData = prepareData(identifier, bakeConvolution, bakeParametric, compression, checkpoint.shard, probeBatch);
+    auto probesToBake = findProbesToBake(identifier, checkpoint, probeBatch, reflectionsData);
 
     JobGraph jobGraph;
     ThreadPool threadPool(numThreads);
 
-    AirAbsorptionModel airAbsorption{};
     Array<CoordinateSpace3f> sources(bakeBatchSize);
     Array<CoordinateSpace3f> listeners(bakeBatchSize);
     Array<Directivity> directivities(bakeBatchSize);
@@ -86,35 +80,13 @@ void ReflectionBaker::bake(const IScene& scene,
     Array<EnergyField*> energyFieldPtrs(bakeBatchSize);
     Array<int> indices(bakeBatchSize);
     auto numValidInBatch = 0;
+    auto numBakedSinceCheckpoint = 0;
+    auto cancelled = false;
 
     for (auto i = 0; i < probeBatch.numProbes(); ++i)
     {
-        auto probeValid = false;
-
-        if (identifier.variation == BakedDataVariation::Reverb)
-        {
-            probeValid = true;
-            sources[numValidInBatch] = probeBatch[i].influence.center;
-            listeners[numValidInBatch] = probeBatch[i].influence.center;
-        }
-        else if (identifier.variation == BakedDataVariation::StaticSource)
-        {
-            if (identifier.endpointInfluence.contains(probeBatch[i].influence.center))
-            {
-                probeValid = true;
-                sources[numValidInBatch] = identifier.endpointInfluence.center;
-                listeners[numValidInBatch] = probeBatch[i].influence.center;
-            }
-        }
-        else if (identifier.variation == BakedDataVariation::StaticListener)
-        {
-            if (identifier.endpointInfluence.contains(probeBatch[i].influence.center))
-            {
-                probeValid = true;
-                sources[numValidInBatch] = probeBatch[i].influence.center;
-                listeners[numValidInBatch] = identifier.endpointInfluence.center;
-            }
-        }
+        auto probeValid = probesToBake[i] &&
+                          probeEndpoints(identifier, probeBatch, i, sources[numValidInBatch], listeners[numValidInBatch]);
 
         if (probeValid)
         {
@@ -125,7 +97,7 @@ void ReflectionBaker::bake(const IScene& scene,
             ++numValidInBatch;
         }
 
-        if (numValidInBatch == bakeBatchSize || i == probeBatch.numProbes() - 1)
+        if (numValidInBatch > 0 && (numValidInBatch == bakeBatchSize || i == probeBatch.numProbes() - 1))
         {
             auto numSources = numValidInBatch;
             auto numListeners = 1;
@@ -168,39 +140,21 @@ void ReflectionBaker::bake(const IScene& scene,
             }
 #endif
 
-            if (bakeParametric)
+            for (auto j = 0; j < numValidInBatch; ++j)
             {
-                for (auto j = 0; j < numValidInBatch; ++j)
-                {
-                    Reverb reverb;
-                    ReverbEstimator::estimate(*energyFields[j], airAbsorption, reverb);
-
-                    static_cast<BakedReflectionsData&>(probeBatch[identifier]).set(indices[j], reverb);
-                }
+                storeProbe(indices[j], std::move(energyFields[j]), bakeConvolution, bakeParametric, simDuration,
+                           bakeDuration, order, reflectionsData);
             }
 
-            if (bakeConvolution)
+            numBakedSinceCheckpoint += numValidInBatch;
+            numValidInBatch = 0;
+
+            if (checkpoint.interval > 0 && numBakedSinceCheckpoint >= checkpoint.interval)
             {
-                for (auto j = 0; j < numValidInBatch; ++j)
-                {
-                    unique_ptr<EnergyField> energyField;
-
-                    if (simDuration == bakeDuration)
-                    {
-                        energyField = std::move(energyFields[j]);
-                    }
-                    else
-                    {
-                        energyField = make_unique<EnergyField>(bakeDuration, order);
-                        energyField->copyFrom(*energyFields[j]);
-                    }
-
-                    static_cast<BakedReflectionsData&>(probeBatch[identifier]).set(indices[j], std::move(energyField));
-                }
+                saveCheckpoint(identifier, checkpoint, probeBatch);
+                numBakedSinceCheckpoint = 0;
             }
 
-            numValidInBatch = 0;
-
             if (callback)
             {
                 callback((i + 1.0f) / probeBatch.numProbes(), userData);
@@ -209,14 +163,202 @@ void ReflectionBaker::bake(const IScene& scene,
             if (sCancel)
             {
                 sCancel = false;
+                cancelled = true;
                 break;
             }
         }
     }
 
+    finishCheckpoint(identifier, checkpoint, probeBatch, cancelled);
+
+    sBakeInProgress = false;
+}
+
+bool ReflectionBaker::isProbeParallelBakingSupported(SceneType sceneType,
+                                                     const BakedDataIdentifier& identifier,
+                                                     int bakeBatchSize,
+                                                     int numProbes,
+                                                     int numThreads)
+{
+    if (!sEnableProbeParallelBaking)
+        return false;
+
+    if (sceneType == SceneType::RadeonRays)
+        return false;
+
+    // Static listener bakes on the CPU share rays between all the probes in a batch, which is cheaper than tracing
+    // each probe separately.
+    if (identifier.variation == BakedDataVariation::StaticListener && bakeBatchSize > 1)
+        return false;
+
+    // With only a few probes per thread, most threads would sit idle while the last few probes are being traced.
+    return (numThreads > 1 && numProbes >= numThreads * kMinProbesPerThreadForProbeParallelBaking);
+}
+
+void ReflectionBaker::bakeProbeParallel(const IScene& scene,
+                                        Array<unique_ptr<IReflectionSimulator>>& simulators,
+                                        const BakedDataIdentifier& identifier,
+                                        bool bakeConvolution,
+                                        bool bakeParametric,
+                                        int numRays,
+                                        int numBounces,
+                                        float simDuration,
+                                        float bakeDuration,
+                                        int order,
+                                        float irradianceMinDistance,
+                                        ProbeBatch& probeBatch,
+                                        ProgressCallback callback,
+                                        void* userData,
+                                        const EnergyFieldCompressionSettings& compression,
+                                        const ReflectionBakeCheckpointSettings& checkpoint)
+{
+    PROFILE_FUNCTION();
+
+    assert(bakeConvolution || bakeParametric);
+    assert(identifier.type == BakedDataType::Reflections);
+    assert(identifier.variation != BakedDataVariation::Dynamic);
+    assert(simulators.size(0) > 0);
+
+    sBakeInProgress = true;
+
+    auto& reflectionsData = prepareData(identifier, bakeConvolution, bakeParametric, compression, checkpoint.shard, probeBatch);
+    auto probesToBake = findProbesToBake(identifier, checkpoint, probeBatch, reflectionsData);
+
+    auto numThreads = static_cast<int>(simulators.size(0));
+
+    // Storing baked data is not thread-safe, but takes very little time compared to tracing a probe. Checkpoints are
+    // also saved while holding this lock, so they never see a partially-stored probe.
+    std::mutex storeMutex;
+    auto numBakedSinceCheckpoint = 0;
+
+    JobGraph jobGraph;
+
+    for (auto i = 0; i < probeBatch.numProbes(); ++i)
+    {
+        CoordinateSpace3f source{};
+        CoordinateSpace3f listener{};
+        if (!probesToBake[i] || !probeEndpoints(identifier, probeBatch, i, source, listener))
+            continue;
+
+        // Each job traces every ray for a single probe on the thread that runs it, using that thread's simulator,
+        // so no synchronization or reduction is needed within a probe. Threads pick up new probes as soon as they
+        // finish with the previous one.
+        jobGraph.addJob([&, i, source, listener](int threadId, std::atomic<bool>& cancel)
+        {
+            // Once the bake is cancelled, the remaining jobs return immediately.
+            if (sCancel)
+                return;
+
+            auto directivity = Directivity{};
+            auto energyField = make_unique<EnergyField>(simDuration, order);
+            auto energyFieldPtr = energyField.get();
+
+            JobGraph probeJobGraph;
+            simulators[threadId]->simulate(scene, 1, &source, 1, &listener, &directivity, numRays, numBounces,
+                                           simDuration, order, irradianceMinDistance, &energyFieldPtr, probeJobGraph);
+
+            while (probeJobGraph.processNextJob(0, sCancel))
+            {}
+
+            if (sCancel)
+                return;
+
+            std::lock_guard<std::mutex> lock(storeMutex);
+            storeProbe(i, std::move(energyField), bakeConvolution, bakeParametric, simDuration, bakeDuration, order,
+                       reflectionsData);
+
+            if (checkpoint.interval > 0 && ++numBakedSinceCheckpoint >= checkpoint.interval)
+            {
+                saveCheckpoint(identifier, checkpoint, probeBatch);
+                numBakedSinceCheckpoint = 0;
+            }
+        });
+    }
+
+    ThreadPool threadPool(numThreads);
+
+    if (!jobGraph.isEmpty())
+    {
+        threadPool.process(jobGraph, [callback, userData](float progress)
+        {
+            if (callback)
+            {
+                callback(progress, userData);
+            }
+        });
+    }
+
+    finishCheckpoint(identifier, checkpoint, probeBatch, sCancel);
+
+    sCancel = false;
     sBakeInProgress = false;
 }
 
+bool ReflectionBaker::merge(const BakedDataIdentifier& identifier,
+                            int numShards,
+                            ProbeBatch* const* shards,
+                            ProbeBatch& probeBatch)
+{
+    PROFILE_FUNCTION();
+
+    assert(identifier.type == BakedDataType::Reflections);
+
+    // Every shard must be present exactly once.
+    vector<uint8_t> shardFound(numShards);
+    for (auto i = 0; i < numShards; ++i)
+    {
+        auto valid = (shards[i] && isCompatible(identifier, *shards[i], probeBatch) &&
+                      !static_cast<const BakedReflectionsData&>((*shards[i])[identifier]).isStreaming());
+        if (valid)
+        {
+            const auto& shard = static_cast<const BakedReflectionsData&>((*shards[i])[identifier]).shard();
+            valid = (shard.numShards == numShards && 0 <= shard.index && shard.index < numShards && !shardFound[shard.index]);
+            if (valid)
+            {
+                shardFound[shard.index] = true;
+            }
+        }
+
+        if (!valid)
+        {
+            gLog().message(MessageSeverity::Warning, "Reflections bake shard %d does not match the probe batch being "
+                "merged into, or is a duplicate.", i);
+            return false;
+        }
+    }
+
+    if (numShards == 0)
+        return true;
+
+    if (!probeBatch.hasData(identifier))
+    {
+        const auto& firstShardData = static_cast<const BakedReflectionsData&>((*shards[0])[identifier]);
+        probeBatch.addData(identifier, make_unique<BakedReflectionsData>(identifier, probeBatch.numProbes(),
+                                                                         firstShardData.hasConvolution(),
+                                                                         firstShardData.hasParametric()));
+    }
+
+    auto& reflectionsData = static_cast<BakedReflectionsData&>(probeBatch[identifier]);
+
+    for (auto i = 0; i < numShards; ++i)
+    {
+        auto& shardData = static_cast<BakedReflectionsData&>((*shards[i])[identifier]);
+        const auto& shard = shardData.shard();
+
+        // A shard may have been baked into a probe batch that already contained baked data for every probe, so
+        // probes outside the shard may hold stale data that must not overwrite what other shards have baked.
+        for (auto j = 0; j < probeBatch.numProbes(); ++j)
+        {
+            if (shard.contains(j) && !shardData.needsUpdate(j))
+            {
+                reflectionsData.takeProbe(j, shardData);
+            }
+        }
+    }
+
+    return true;
+}
+
 void ReflectionBaker::cancel()
 {
     if (sBakeInProgress)
@@ -225,4 +367,277 @@ void ReflectionBaker::cancel()
     }
 }
 
+BakedReflectionsData& ReflectionBaker::prepareData(const BakedDataIdentifier& identifier,
+                                                   bool bakeConvolution,
+                                                   bool bakeParametric,
+                                                   const EnergyFieldCompressionSettings& compression,
+                                                   const BakeShard& shard,
+                                                   ProbeBatch& probeBatch)
+{
+    if (!probeBatch.hasData(identifier))
+    {
+        probeBatch.addData(identifier, make_unique<BakedReflectionsData>(identifier, probeBatch.numProbes(), bakeConvolution, bakeParametric));
+    }
+
+    auto& reflectionsData = static_cast<BakedReflectionsData&>(probeBatch[identifier]);
+
+    reflectionsData.setHasConvolution(bakeConvolution);
+    reflectionsData.setHasParametric(bakeParametric);
+    reflectionsData.setCompression(compression);
+    reflectionsData.setShard(shard);
+
+    return reflectionsData;
+}
+
+// Opens a file given its UTF-8 encoded name.
+static FILE* openFile(const string& fileName,
+                      const char* mode)
+{
+#if defined(IPL_OS_WINDOWS)
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::wstring utf16FileName{ converter.from_bytes(fileName.c_str()) };
+    std::wstring utf16Mode{ converter.from_bytes(mode) };
+    return _wfopen(utf16FileName.c_str(), utf16Mode.c_str());
+#else
+    return fopen(fileName.c_str(), mode);
+#endif
+}
+
+// Replaces a file with another, given their UTF-8 encoded names. If the file being replaced exists, it is either
+// replaced completely or left untouched.
+static bool replaceFile(const string& fileName,
+                        const string& replacementFileName)
+{
+#if defined(IPL_OS_WINDOWS)
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::wstring utf16FileName{ converter.from_bytes(fileName.c_str()) };
+    std::wstring utf16ReplacementFileName{ converter.from_bytes(replacementFileName.c_str()) };
+    return (MoveFileExW(utf16ReplacementFileName.c_str(), utf16FileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+    return (rename(replacementFileName.c_str(), fileName.c_str()) == 0);
+#endif
+}
+
+// Deletes a file given its UTF-8 encoded name.
+static void removeFile(const string& fileName)
+{
+#if defined(IPL_OS_WINDOWS)
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::wstring utf16FileName{ converter.from_bytes(fileName.c_str()) };
+    _wremove(utf16FileName.c_str());
+#else
+    remove(fileName.c_str());
+#endif
+}
+
+bool ReflectionBaker::isCompatible(const BakedDataIdentifier& identifier,
+                                   const ProbeBatch& other,
+                                   const ProbeBatch& probeBatch)
+{
+    if (!other.hasData(identifier) || !probeBatch.hasSameProbes(other))
+        return false;
+
+    if (!probeBatch.hasData(identifier))
+        return true;
+
+    const auto& lhs = static_cast<const BakedReflectionsData&>(other[identifier]);
+    const auto& rhs = static_cast<const BakedReflectionsData&>(probeBatch[identifier]);
+    return (lhs.hasConvolution() == rhs.hasConvolution() && lhs.hasParametric() == rhs.hasParametric());
+}
+
+vector<uint8_t> ReflectionBaker::findProbesToBake(const BakedDataIdentifier& identifier,
+                                                  const ReflectionBakeCheckpointSettings& checkpoint,
+                                                  ProbeBatch& probeBatch,
+                                                  BakedReflectionsData& reflectionsData)
+{
+    auto numProbes = probeBatch.numProbes();
+
+    vector<uint8_t> probesToBake(numProbes);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        probesToBake[i] = checkpoint.shard.contains(i) && (!checkpoint.skipValidProbes || reflectionsData.needsUpdate(i));
+    }
+
+    if (checkpoint.fileName.empty())
+        return probesToBake;
+
+    auto file = openFile(checkpoint.fileName, "rb");
+    if (!file)
+        return probesToBake;
+
+    vector<byte_t> buffer;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        auto size = ftell(file);
+        if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+        {
+            buffer.resize(size);
+            if (fread(buffer.data(), 1, buffer.size(), file) != buffer.size())
+            {
+                buffer.clear();
+            }
+        }
+    }
+
+    fclose(file);
+
+    if (buffer.empty())
+    {
+        gLog().message(MessageSeverity::Warning, "Unable to read reflections bake checkpoint %s.", checkpoint.fileName.c_str());
+        return probesToBake;
+    }
+
+    // A checkpoint that was truncated or otherwise damaged on disk could cause reads out of bounds while loading it.
+    flatbuffers::Verifier verifier(buffer.data(), buffer.size());
+    if (!Serialized::VerifyProbeBatchBuffer(verifier) ||
+        !Serialized::GetProbeBatch(buffer.data())->probes() ||
+        Serialized::GetProbeBatch(buffer.data())->probes()->Length() == 0)
+    {
+        gLog().message(MessageSeverity::Warning, "Reflections bake checkpoint %s is corrupt, and will be ignored.",
+            checkpoint.fileName.c_str());
+        return probesToBake;
+    }
+
+    SerializedObject serializedObject(buffer.size(), buffer.data());
+    ProbeBatch checkpointBatch(serializedObject);
+
+    // The checkpoint is only usable if it was saved for exactly the same probes and settings.
+    if (!isCompatible(identifier, checkpointBatch, probeBatch))
+    {
+        gLog().message(MessageSeverity::Warning, "Reflections bake checkpoint %s does not match the probe batch being "
+            "baked, and will be ignored.", checkpoint.fileName.c_str());
+        return probesToBake;
+    }
+
+    auto& checkpointData = static_cast<BakedReflectionsData&>(checkpointBatch[identifier]);
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        if (probesToBake[i] && !checkpointData.needsUpdate(i))
+        {
+            reflectionsData.takeProbe(i, checkpointData);
+            probesToBake[i] = false;
+        }
+    }
+
+    return probesToBake;
+}
+
+void ReflectionBaker::saveCheckpoint(const BakedDataIdentifier& identifier,
+                                     const ReflectionBakeCheckpointSettings& checkpoint,
+                                     const ProbeBatch& probeBatch)
+{
+    PROFILE_FUNCTION();
+
+    if (checkpoint.fileName.empty())
+        return;
+
+    SerializedObject serializedObject;
+    probeBatch.serializeAsRoot(serializedObject, &identifier);
+
+    // Write to a temporary file first, and then replace the previous checkpoint with it, so a crash while saving never
+    // leaves behind a truncated checkpoint, or no checkpoint at all.
+    auto tempFileName = checkpoint.fileName + ".tmp";
+
+    auto file = openFile(tempFileName, "wb");
+    auto written = false;
+    if (file)
+    {
+        written = (fwrite(serializedObject.data(), 1, serializedObject.size(), file) == serializedObject.size());
+        written = (fclose(file) == 0) && written;
+    }
+
+    if (!written || !replaceFile(checkpoint.fileName, tempFileName))
+    {
+        removeFile(tempFileName);
+        gLog().message(MessageSeverity::Warning, "Unable to save reflections bake checkpoint %s.", checkpoint.fileName.c_str());
+    }
+}
+
+void ReflectionBaker::finishCheckpoint(const BakedDataIdentifier& identifier,
+                                       const ReflectionBakeCheckpointSettings& checkpoint,
+                                       const ProbeBatch& probeBatch,
+                                       bool cancelled)
+{
+    if (checkpoint.fileName.empty())
+        return;
+
+    if (cancelled)
+    {
+        saveCheckpoint(identifier, checkpoint, probeBatch);
+    }
+    else
+    {
+        removeFile(checkpoint.fileName);
+    }
+}
+
+bool ReflectionBaker::probeEndpoints(const BakedDataIdentifier& identifier,
+                                     const ProbeBatch& probeBatch,
+                                     int index,
+                                     CoordinateSpace3f& source,
+                                     CoordinateSpace3f& listener)
+{
+    const auto& probe = probeBatch[index];
+
+    if (identifier.variation == BakedDataVariation::Reverb)
+    {
+        source = probe.influence.center;
+        listener = probe.influence.center;
+        return true;
+    }
+    else if (identifier.variation == BakedDataVariation::StaticSource)
+    {
+        if (identifier.endpointInfluence.contains(probe.influence.center))
+        {
+            source = identifier.endpointInfluence.center;
+            listener = probe.influence.center;
+            return true;
+        }
+    }
+    else if (identifier.variation == BakedDataVariation::StaticListener)
+    {
+        if (identifier.endpointInfluence.contains(probe.influence.center))
+        {
+            source = probe.influence.center;
+            listener = identifier.endpointInfluence.center;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ReflectionBaker::storeProbe(int index,
+                                 unique_ptr<EnergyField> energyField,
+                                 bool bakeConvolution,
+                                 bool bakeParametric,
+                                 float simDuration,
+                                 float bakeDuration,
+                                 int order,
+                                 BakedReflectionsData& reflectionsData)
+{
+    if (bakeParametric)
+    {
+        AirAbsorptionModel airAbsorption{};
+
+        Reverb reverb;
+        ReverbEstimator::estimate(*energyField, airAbsorption, reverb);
+
+        reflectionsData.set(index, reverb);
+    }
+
+    if (bakeConvolution)
+    {
+        if (simDuration != bakeDuration)
+        {
+            auto bakedEnergyField = make_unique<EnergyField>(bakeDuration, order);
+            bakedEnergyField->copyFrom(*energyField);
+            energyField = std::move(bakedEnergyField);
+        }
+
+        reflectionsData.set(index, std::move(energyField));
+    }
+}
+
 }
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include "baked_reflection_data.h"
+#include "compressed_energy_field.h"
 #include "energy_field.h"
 #include "opencl_device.h"
 #include "probe_batch.h"
@@ -26,6 +28,28 @@
 
 namespace ipl {
 
+// ---------------------------------------------------------------------------------------------------------------------
+// ReflectionBakeCheckpointSettings
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Settings for incremental, resumable, and sharded bakes.
+struct ReflectionBakeCheckpointSettings
+{
+    // Only probes in this shard are baked. Data for all other probes is left unchanged.
+    BakeShard shard;
+
+    // If true, probes whose baked data is still valid are not baked again.
+    bool skipValidProbes = false;
+
+    // If non-empty, baked probes are periodically saved to this file. If the file exists when a bake starts, probes
+    // saved in it are restored instead of being baked again. The file is deleted once the bake completes.
+    string fileName;
+
+    // Number of probes to bake between saves. If 0, the file is only written when the bake is cancelled.
+    int interval = 0;
+};
+
+
 // ---------------------------------------------------------------------------------------------------------------------
 // ReflectionBaker
 // ---------------------------------------------------------------------------------------------------------------------
@@ -50,13 +74,103 @@ public:
                      shared_ptr<OpenCLDevice> openCL,
                      ProbeBatch& probeBatch,
                      ProgressCallback callback = nullptr,
-                     void* userData = nullptr);
+                     void* userData = nullptr,
+                     const EnergyFieldCompressionSettings& compression = EnergyFieldCompressionSettings{},
+                     const ReflectionBakeCheckpointSettings& checkpoint = ReflectionBakeCheckpointSettings{});
+
+    // Returns true if bakeProbeParallel can be used instead of bake, and is likely to be faster.
+    static bool isProbeParallelBakingSupported(SceneType sceneType,
+                                               const BakedDataIdentifier& identifier,
+                                               int bakeBatchSize,
+                                               int numProbes,
+                                               int numThreads);
+
+    // Bakes reflections on the CPU by tracing many probes concurrently, instead of parallelizing each probe across
+    // rays. One thread is created per simulator, and each thread traces probes using its own simulator, which must
+    // have been created with a single thread and a single source. Probes are handed out to threads one at a time,
+    // so threads that finish cheap probes early go on to pick up more work.
+    static void bakeProbeParallel(const IScene& scene,
+                                  Array<unique_ptr<IReflectionSimulator>>& simulators,
+                                  const BakedDataIdentifier& identifier,
+                                  bool bakeConvolution,
+                                  bool bakeParametric,
+                                  int numRays,
+                                  int numBounces,
+                                  float simDuration,
+                                  float bakeDuration,
+                                  int order,
+                                  float irradianceMinDistance,
+                                  ProbeBatch& probeBatch,
+                                  ProgressCallback callback = nullptr,
+                                  void* userData = nullptr,
+                                  const EnergyFieldCompressionSettings& compression = EnergyFieldCompressionSettings{},
+                                  const ReflectionBakeCheckpointSettings& checkpoint = ReflectionBakeCheckpointSettings{});
+
+    // Moves the data baked by each shard into the corresponding data layer of the probe batch. Each shard must be a
+    // probe batch containing the same probes, in which a different shard of the probes has been baked. Only probes
+    // that belong to a shard are taken from it, so any other data the shard holds is ignored. Probes that have not been
+    // baked by their shard are left unchanged. Returns false if any shard does not match the probe batch, or is a
+    // duplicate.
+    static bool merge(const BakedDataIdentifier& identifier,
+                      int numShards,
+                      ProbeBatch* const* shards,
+                      ProbeBatch& probeBatch);
 
     static void cancel();
 
+    // If true, CPU bakes with enough probes will trace probes in parallel instead of rays.
+    static bool sEnableProbeParallelBaking;
+
+    static const int kMinProbesPerThreadForProbeParallelBaking;
+
 private:
     static std::atomic<bool> sCancel;
     static std::atomic<bool> sBakeInProgress;
+
+    static BakedReflectionsData& prepareData(const BakedDataIdentifier& identifier,
+                                             bool bakeConvolution,
+                                             bool bakeParametric,
+                                             const EnergyFieldCompressionSettings& compression,
+                                             const BakeShard& shard,
+                                             ProbeBatch& probeBatch);
+
+    // Returns true if baked data for the given identifier can be moved from the other probe batch into this one.
+    static bool isCompatible(const BakedDataIdentifier& identifier,
+                             const ProbeBatch& other,
+                             const ProbeBatch& probeBatch);
+
+    // Returns a flag for each probe, indicating whether it needs to be baked. Restores probes from the checkpoint
+    // file, if there is one.
+    static vector<uint8_t> findProbesToBake(const BakedDataIdentifier& identifier,
+                                            const ReflectionBakeCheckpointSettings& checkpoint,
+                                            ProbeBatch& probeBatch,
+                                            BakedReflectionsData& reflectionsData);
+
+    static void saveCheckpoint(const BakedDataIdentifier& identifier,
+                               const ReflectionBakeCheckpointSettings& checkpoint,
+                               const ProbeBatch& probeBatch);
+
+    // Called at the end of a bake. Keeps the checkpoint file if the bake was cancelled, deletes it otherwise.
+    static void finishCheckpoint(const BakedDataIdentifier& identifier,
+                                 const ReflectionBakeCheckpointSettings& checkpoint,
+                                 const ProbeBatch& probeBatch,
+                                 bool cancelled);
+
+    // Returns false if the probe should not be baked for this identifier.
+    static bool probeEndpoints(const BakedDataIdentifier& identifier,
+                               const ProbeBatch& probeBatch,
+                               int index,
+                               CoordinateSpace3f& source,
+                               CoordinateSpace3f& listener);
+
+    static void storeProbe(int index,
+                           unique_ptr<EnergyField> energyField,
+                           bool bakeConvolution,
+                           bool bakeParametric,
+                           float simDuration,
+                           float bakeDuration,
+                           int order,
+                           BakedReflectionsData& reflectionsData);
 };
 
 }
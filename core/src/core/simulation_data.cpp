@@ -71,6 +71,9 @@ SimulationData::SimulationData(bool enableIndirect,
         reflectionState.energyField->reset();
         reflectionState.accumEnergyField->reset();
         reflectionState.numFramesAccumulated = 0;
+        reflectionState.bakedImpulseResponseKeyValid = false;
+        reflectionState.reuseImpulseResponse = false;
+        reflectionState.impulseResponsePublished = false;
 
         if (indirectType != IndirectEffectType::Parametric)
         {
@@ -75,6 +75,10 @@ struct ReflectionSimulationState
     unique_ptr<ImpulseResponse> impulseResponseCopy;
     std::atomic<bool> impulseResponseUpdated;
     bool validSimulationData;
+    BakedImpulseResponseKey bakedImpulseResponseKey;
+    bool bakedImpulseResponseKeyValid;
+    bool reuseImpulseResponse;
+    bool impulseResponsePublished;
 };
 
 struct ReflectionSimulationOutputs
@@ -113,6 +117,7 @@ struct PathingSimulationState
     Vector3f direction;
     float distanceRatio;
     float totalDeviation;
+    PathCache pathCache;
 };
 
 struct PathingSimulationOutputs
@@ -27,11 +27,60 @@
 
 namespace ipl {
 
+// --------------------------------------------------------------------------------------------------------------------
+// BakedImpulseResponseKey
+// --------------------------------------------------------------------------------------------------------------------
+
+bool operator==(const BakedImpulseResponseKey& lhs,
+                const BakedImpulseResponseKey& rhs)
+{
+    if (!(lhs.identifier == rhs.identifier) ||
+        lhs.reconstructionType != rhs.reconstructionType ||
+        lhs.duration != rhs.duration ||
+        lhs.order != rhs.order ||
+        !(lhs.airAbsorptionModel == rhs.airAbsorptionModel) ||
+        !(lhs.distanceAttenuationModel == rhs.distanceAttenuationModel) ||
+        lhs.transitionTime != rhs.transitionTime ||
+        lhs.overlapFraction != rhs.overlapFraction)
+    {
+        return false;
+    }
+
+    for (auto i = 0; i < Bands::kNumBands; ++i)
+    {
+        if (lhs.reverbScale[i] != rhs.reverbScale[i])
+            return false;
+    }
+
+    if (lhs.probes.size() != rhs.probes.size())
+        return false;
+
+    for (auto i = 0u; i < lhs.probes.size(); ++i)
+    {
+        const auto& lhsProbe = lhs.probes[i];
+        const auto& rhsProbe = rhs.probes[i];
+
+        if (lhsProbe.data != rhsProbe.data ||
+            lhsProbe.version != rhsProbe.version ||
+            lhsProbe.probeIndex != rhsProbe.probeIndex ||
+            lhsProbe.quantizedWeight != rhsProbe.quantizedWeight)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 // --------------------------------------------------------------------------------------------------------------------
 // SimulationManager
 // --------------------------------------------------------------------------------------------------------------------
 
 bool SimulationManager::sEnableProbeCachingForMissingProbes = false;
+bool SimulationManager::sEnableBakedImpulseResponseReuse = true;
+bool SimulationManager::sEnableProbeOcclusionCaching = true;
+const int SimulationManager::kNumWeightQuantizationSteps = 1024;
 
 SimulationManager::SimulationManager(bool enableDirect,
                                      bool enableIndirect,
@@ -202,6 +251,12 @@ void SimulationManager::simulateIndirect()
     for (auto& source : mSourceData[0])
     {
         source->reflectionState.validSimulationData = true;
+        source->reflectionState.reuseImpulseResponse = false;
+
+        if (!source->reflectionInputs.enabled || !source->reflectionInputs.baked)
+        {
+            source->reflectionState.bakedImpulseResponseKeyValid = false;
+        }
     }
 
     simulateRealTimeReflections();
@@ -335,18 +390,63 @@ void SimulationManager::accumulateEnergyFields()
     resetSceneChanged();
 }
 
+void SimulationManager::checkOcclusion(ProbeNeighborhood& probes,
+                                       const Vector3f& point,
+                                       ProbeOcclusionCache& cache)
+{
+    if (sEnableProbeOcclusionCaching && hasSceneVersion())
+    {
+        probes.checkOcclusion(*mScene, point, cache);
+    }
+    else
+    {
+        probes.checkOcclusion(*mScene, point);
+    }
+}
+
 void SimulationManager::lookupBakedReflections()
 {
     PROFILE_FUNCTION();
 
-    ProbeNeighborhood sourceProbes;
     ProbeNeighborhood listenerProbes;
-    ProbeNeighborhood* probes = &listenerProbes;
+
+    auto usesSourceProbes = [](const SimulationData& source)
+    {
+        return (source.reflectionInputs.enabled && source.reflectionInputs.baked &&
+                source.reflectionInputs.bakedDataIdentifier.type == BakedDataType::Reflections &&
+                source.reflectionInputs.bakedDataIdentifier.variation == BakedDataVariation::StaticListener);
+    };
+
+    // Look up the probes around every source that needs them in a single pass.
+    mStaticListenerSourcePositions.clear();
+    for (const auto& source : mSourceData[0])
+    {
+        if (usesSourceProbes(*source))
+        {
+            mStaticListenerSourcePositions.push_back(source->reflectionInputs.source.origin);
+        }
+    }
+
+    auto numStaticListenerSources = static_cast<int>(mStaticListenerSourcePositions.size());
+    if (static_cast<int>(mStaticListenerSourceProbes.size(0)) < numStaticListenerSources)
+    {
+        mStaticListenerSourceProbes.resize(numStaticListenerSources);
+    }
+
+    mProbeManager->getInfluencingProbes(numStaticListenerSources, mStaticListenerSourcePositions.data(), mStaticListenerSourceProbes.data());
 
     mProbeManager->getInfluencingProbes(mSharedData->reflection.listener.origin, listenerProbes);
-    listenerProbes.checkOcclusion(*mScene, mSharedData->reflection.listener.origin);
+    checkOcclusion(listenerProbes, mSharedData->reflection.listener.origin, mReflectionsOcclusionCache);
     listenerProbes.calcWeights(mSharedData->reflection.listener.origin);
 
+    // Decode streamed energy fields around the listener once, rather than on demand for each source.
+    if (mIndirectType != IndirectEffectType::Parametric)
+    {
+        BakedReflectionSimulator::findUniqueProbeBatches(listenerProbes, mProbeBatchesForLookup);
+        BakedReflectionSimulator::prefetchEnergyFields(listenerProbes, mProbeBatchesForLookup);
+    }
+
+    auto staticListenerSourceIndex = 0;
     for (auto& source : mSourceData[0])
     {
         PROFILE_ZONE("lookupBakedReflections::source");
@@ -357,10 +457,11 @@ void SimulationManager::lookupBakedReflections()
         if (!source->reflectionInputs.baked || source->reflectionInputs.bakedDataIdentifier.type != BakedDataType::Reflections)
             continue;
 
-        if (source->reflectionInputs.bakedDataIdentifier.variation == BakedDataVariation::StaticListener)
+        auto* probes = &listenerProbes;
+        if (usesSourceProbes(*source))
         {
-            mProbeManager->getInfluencingProbes(source->reflectionInputs.source.origin, sourceProbes);
-            sourceProbes.checkOcclusion(*mScene, source->reflectionInputs.source.origin);
+            auto& sourceProbes = mStaticListenerSourceProbes[staticListenerSourceIndex++];
+            checkOcclusion(sourceProbes, source->reflectionInputs.source.origin, mReflectionsOcclusionCache);
             sourceProbes.calcWeights(source->reflectionInputs.source.origin);
 
             probes = &sourceProbes;
@@ -368,13 +469,17 @@ void SimulationManager::lookupBakedReflections()
 
         source->reflectionState.validSimulationData = sEnableProbeCachingForMissingProbes ? probes->hasValidProbes() : true;
         if (!source->reflectionState.validSimulationData)
+        {
+            source->reflectionState.bakedImpulseResponseKeyValid = false;
             continue;
+        }
 
         BakedReflectionSimulator::findUniqueProbeBatches(*probes, mProbeBatchesForLookup);
 
         if (mIndirectType != IndirectEffectType::Parametric)
         {
             BakedReflectionSimulator::lookupEnergyField(source->reflectionInputs.bakedDataIdentifier, *probes, mProbeBatchesForLookup, *source->reflectionState.accumEnergyField);
+            updateBakedImpulseResponseKey(*source, *probes);
         }
 
         if (mIndirectType == IndirectEffectType::Parametric || mIndirectType == IndirectEffectType::Hybrid)
@@ -384,6 +489,62 @@ void SimulationManager::lookupBakedReflections()
     }
 }
 
+void SimulationManager::updateBakedImpulseResponseKey(SimulationData& source,
+                                                       const ProbeNeighborhood& probes)
+{
+    auto& key = mBakedImpulseResponseKey;
+    const auto& identifier = source.reflectionInputs.bakedDataIdentifier;
+
+    key.identifier = identifier;
+    key.probes.clear();
+
+    for (auto i = 0; i < probes.numProbes(); ++i)
+    {
+        if (!probes.batches[i] || probes.probeIndices[i] < 0)
+            continue;
+
+        BakedImpulseResponseKey::ProbeEntry entry{};
+        if (probes.batches[i]->hasData(identifier))
+        {
+            const auto& data = (*probes.batches[i])[identifier];
+            entry.data = &data;
+            entry.version = static_cast<const BakedReflectionsData&>(data).version();
+        }
+
+        entry.probeIndex = probes.probeIndices[i];
+        entry.quantizedWeight = static_cast<int>(roundf(probes.weights[i] * kNumWeightQuantizationSteps));
+
+        key.probes.push_back(entry);
+    }
+
+    key.reconstructionType = mSharedData->reflection.reconstructionType;
+    key.duration = mSharedData->reflection.duration;
+    key.order = mSharedData->reflection.order;
+    key.airAbsorptionModel = source.reflectionInputs.airAbsorptionModel;
+    key.distanceAttenuationModel = source.reflectionInputs.distanceAttenuationModel;
+    memcpy(key.reverbScale, source.reflectionInputs.reverbScale, Bands::kNumBands * sizeof(float));
+    key.transitionTime = source.reflectionInputs.transitionTime;
+    key.overlapFraction = source.reflectionInputs.overlapFraction;
+
+    auto& state = source.reflectionState;
+
+    // Callbacks may return different values without any of their parameters changing, so impulse responses
+    // that depend on callbacks are never reused, unless the distance attenuation callback is known to be unchanged.
+    auto canReuse = sEnableBakedImpulseResponseReuse &&
+                    state.bakedImpulseResponseKeyValid &&
+                    !key.airAbsorptionModel.callback &&
+                    !key.distanceAttenuationModel.dirty &&
+                    key == state.bakedImpulseResponseKey;
+
+    state.reuseImpulseResponse = canReuse;
+
+    if (!canReuse)
+    {
+        std::swap(state.bakedImpulseResponseKey, key);
+        state.bakedImpulseResponseKeyValid = true;
+    }
+}
+
 void SimulationManager::copyEnergyFieldsFromDeviceToHost()
 {
 #if defined(IPL_USES_OPENCL)
@@ -411,6 +572,9 @@ void SimulationManager::generateDistanceCorrectionCurves(int numSamples)
         if (!source->reflectionInputs.enabled)
             continue;
 
+        if (source->reflectionState.reuseImpulseResponse)
+            continue;
+
         if (source->reflectionState.prevDistanceAttenuationModel != source->reflectionInputs.distanceAttenuationModel ||
             source->reflectionInputs.distanceAttenuationModel.dirty)
         {
@@ -453,6 +617,9 @@ void SimulationManager::reconstructImpulseResponses()
         if (!source->reflectionInputs.enabled)
             continue;
 
+        if (source->reflectionState.reuseImpulseResponse)
+            continue;
+
         if (mSceneType == SceneType::RadeonRays &&
             mIndirectType == IndirectEffectType::TrueAudioNext &&
             source->reflectionInputs.baked)
@@ -538,6 +705,11 @@ void SimulationManager::estimateHybridReverb()
         if (!source->reflectionState.validSimulationData)
             continue;
 
+        // The impulse response has already been windowed, and the outputs are unchanged from the previous
+        // simulation.
+        if (source->reflectionState.reuseImpulseResponse)
+            continue;
+
         mHybridReverbEstimator->estimate(source->reflectionState.accumEnergyField.get(), source->reflectionOutputs.reverb, *source->reflectionState.impulseResponse,
                                          source->reflectionInputs.transitionTime, source->reflectionInputs.overlapFraction,
                                          mSharedData->reflection.order, source->reflectionOutputs.hybridEQ, source->reflectionOutputs.hybridDelay);
@@ -575,7 +747,7 @@ void SimulationManager::partitionImpulseResponses(int numChannels, int numSample
         if (mIndirectType == IndirectEffectType::TrueAudioNext)
         {
 #if defined(IPL_USES_TRUEAUDIONEXT)
-            if (source->reflectionOutputs.tanSlot >= 0)
+            if (source->reflectionOutputs.tanSlot >= 0 && !source->reflectionState.reuseImpulseResponse)
             {
                 mTAN->setIR(source->reflectionOutputs.tanSlot, static_cast<OpenCLImpulseResponse*>(source->reflectionState.impulseResponse.get())->channelBuffers());
             }
@@ -583,9 +755,21 @@ void SimulationManager::partitionImpulseResponses(int numChannels, int numSample
         }
         else if (mIndirectType != IndirectEffectType::Parametric)
         {
+            // If the previous impulse response was partitioned but could not be committed, the write buffer still
+            // contains it, so just try to commit it again.
+            if (source->reflectionState.reuseImpulseResponse)
+            {
+                if (!source->reflectionState.impulseResponsePublished)
+                {
+                    source->reflectionState.impulseResponsePublished = source->reflectionOutputs.overlapSaveFIR.commitWriteBuffer();
+                }
+
+                continue;
+            }
+
             mPartitioner->partition(*source->reflectionState.impulseResponse, numChannels, numSamples, *source->reflectionOutputs.overlapSaveFIR.writeBuffer);
 
-            source->reflectionOutputs.overlapSaveFIR.commitWriteBuffer();
+            source->reflectionState.impulseResponsePublished = source->reflectionOutputs.overlapSaveFIR.commitWriteBuffer();
             source->reflectionOutputs.numChannels = numChannels;
             source->reflectionOutputs.numSamples = numSamples;
         }
@@ -619,7 +803,7 @@ void SimulationManager::simulatePathing()
 
             sourceProbes.reset();
             probeBatch->getInfluencingProbes(source->pathingInputs.source.origin, sourceProbes);
-            sourceProbes.checkOcclusion(*mScene, source->pathingInputs.source.origin);
+            checkOcclusion(sourceProbes, source->pathingInputs.source.origin, mPathingOcclusionCache);
             sourceProbes.calcWeights(source->pathingInputs.source.origin);
 
             if (prevListenerProbeBatch != probeBatch)
@@ -628,7 +812,7 @@ void SimulationManager::simulatePathing()
 
                 listenerProbes.reset();
                 probeBatch->getInfluencingProbes(mSharedData->pathing.listener.origin, listenerProbes);
-                listenerProbes.checkOcclusion(*mScene, mSharedData->pathing.listener.origin);
+                checkOcclusion(listenerProbes, mSharedData->pathing.listener.origin, mPathingOcclusionCache);
                 listenerProbes.calcWeights(mSharedData->pathing.listener.origin);
             }
 
@@ -637,7 +821,8 @@ void SimulationManager::simulatePathing()
                                 source->pathingInputs.order, source->pathingInputs.enableValidation, source->pathingInputs.findAlternatePaths,
                                 source->pathingInputs.simplifyPaths, source->pathingInputs.realTimeVis,
                                 source->pathingState.eq, source->pathingState.sh.data(), source->pathingInputs.distanceAttenuationModel, source->pathingInputs.deviationModel, &source->pathingState.direction, &source->pathingState.distanceRatio, 
-                                &source->pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData);
+                                &source->pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData, false,
+                                pathCache(*source));
 
             memcpy(source->pathingOutputs.eq, source->pathingState.eq, Bands::kNumBands * sizeof(float));
             memcpy(source->pathingOutputs.sh.data(), source->pathingState.sh.data(), source->pathingOutputs.sh.totalSize() * sizeof(float));
@@ -671,11 +856,11 @@ void SimulationManager::simulatePathing(SimulationData& source)
         auto& simulator = *mPathSimulators[0][source.pathingInputs.probes.get()];
 
         probeBatch->getInfluencingProbes(source.pathingInputs.source.origin, sourceProbes);
-        sourceProbes.checkOcclusion(*mScene, source.pathingInputs.source.origin);
+        checkOcclusion(sourceProbes, source.pathingInputs.source.origin, mPathingOcclusionCache);
         sourceProbes.calcWeights(source.pathingInputs.source.origin);
 
         probeBatch->getInfluencingProbes(mSharedData->pathing.listener.origin, listenerProbes);
-        listenerProbes.checkOcclusion(*mScene, mSharedData->pathing.listener.origin);
+        checkOcclusion(listenerProbes, mSharedData->pathing.listener.origin, mPathingOcclusionCache);
         listenerProbes.calcWeights(mSharedData->pathing.listener.origin);
 
         simulator.findPaths(source.pathingInputs.source.origin, mSharedData->pathing.listener.origin, *mScene, *probeBatch, sourceProbes,
@@ -683,7 +868,8 @@ void SimulationManager::simulatePathing(SimulationData& source)
             source.pathingInputs.order, source.pathingInputs.enableValidation, source.pathingInputs.findAlternatePaths,
             source.pathingInputs.simplifyPaths, source.pathingInputs.realTimeVis,
             source.pathingState.eq, source.pathingState.sh.data(), source.pathingInputs.distanceAttenuationModel, source.pathingInputs.deviationModel, &source.pathingState.direction, &source.pathingState.distanceRatio, 
-            &source.pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData);
+            &source.pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData, false,
+            pathCache(source));
 
         memcpy(source.pathingOutputs.eq, source.pathingState.eq, Bands::kNumBands * sizeof(float));
         memcpy(source.pathingOutputs.sh.data(), source.pathingState.sh.data(), source.pathingOutputs.sh.totalSize() * sizeof(float));
@@ -710,7 +896,7 @@ void SimulationManager::simulatePathing(SimulationData& source, ProbeNeighborhoo
         auto& simulator = *mPathSimulators[0][source.pathingInputs.probes.get()];
 
         probeBatch->getInfluencingProbes(source.pathingInputs.source.origin, sourceProbes);
-        sourceProbes.checkOcclusion(*mScene, source.pathingInputs.source.origin);
+        checkOcclusion(sourceProbes, source.pathingInputs.source.origin, mPathingOcclusionCache);
         sourceProbes.calcWeights(source.pathingInputs.source.origin);
 
         simulator.findPaths(source.pathingInputs.source.origin, mSharedData->pathing.listener.origin, *mScene, *probeBatch, sourceProbes,
@@ -718,7 +904,8 @@ void SimulationManager::simulatePathing(SimulationData& source, ProbeNeighborhoo
             source.pathingInputs.order, source.pathingInputs.enableValidation, source.pathingInputs.findAlternatePaths,
             source.pathingInputs.simplifyPaths, source.pathingInputs.realTimeVis,
             source.pathingState.eq, source.pathingState.sh.data(), source.pathingInputs.distanceAttenuationModel, source.pathingInputs.deviationModel, &source.pathingState.direction, &source.pathingState.distanceRatio, 
-            &source.pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData);
+            &source.pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData, false,
+            pathCache(source));
 
         memcpy(source.pathingOutputs.eq, source.pathingState.eq, Bands::kNumBands * sizeof(float));
         memcpy(source.pathingOutputs.sh.data(), source.pathingState.sh.data(), source.pathingOutputs.sh.totalSize() * sizeof(float));
@@ -742,7 +929,8 @@ void SimulationManager::simulatePathing(SimulationData& source, ProbeNeighborhoo
             source.pathingInputs.order, source.pathingInputs.enableValidation, source.pathingInputs.findAlternatePaths,
             source.pathingInputs.simplifyPaths, source.pathingInputs.realTimeVis,
             source.pathingState.eq, source.pathingState.sh.data(), source.pathingInputs.distanceAttenuationModel, source.pathingInputs.deviationModel, &source.pathingState.direction, &source.pathingState.distanceRatio, 
-            &source.pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData, true);
+            &source.pathingState.totalDeviation, mSharedData->pathing.visCallback, mSharedData->pathing.userData, true,
+            pathCache(source));
 
         memcpy(source.pathingOutputs.eq, source.pathingState.eq, Bands::kNumBands * sizeof(float));
         memcpy(source.pathingOutputs.sh.data(), source.pathingState.sh.data(), source.pathingOutputs.sh.totalSize() * sizeof(float));
@@ -783,4 +971,14 @@ void SimulationManager::resetSceneChanged()
     mSceneVersion = mScene->version();
 }
 
+bool SimulationManager::hasSceneVersion() const
+{
+    return (mSceneType != SceneType::Custom && mSceneType != SceneType::RadeonRays);
+}
+
+PathCache* SimulationManager::pathCache(SimulationData& source)
+{
+    return (hasSceneVersion()) ? &source.pathingState.pathCache : nullptr;
+}
+
 }
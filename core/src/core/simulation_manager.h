@@ -61,6 +61,33 @@ struct SharedPathingSimulationInputs
     void* userData = nullptr;
 };
 
+// Everything that the impulse response reconstructed for a baked source depends on. If this is unchanged from one
+// simulation to the next, the previous impulse response can be reused instead of being reconstructed.
+struct BakedImpulseResponseKey
+{
+    struct ProbeEntry
+    {
+        const IBakedData* data;
+        uint64_t version;
+        int probeIndex;
+        int quantizedWeight;
+    };
+
+    BakedDataIdentifier identifier;
+    vector<ProbeEntry> probes;
+    ReconstructionType reconstructionType;
+    float duration;
+    int order;
+    AirAbsorptionModel airAbsorptionModel;
+    DistanceAttenuationModel distanceAttenuationModel;
+    float reverbScale[Bands::kNumBands];
+    float transitionTime;
+    float overlapFraction;
+};
+
+bool operator==(const BakedImpulseResponseKey& lhs,
+                const BakedImpulseResponseKey& rhs);
+
 struct SharedSimulationData
 {
     SharedDirectSimulationInputs direct;
@@ -73,6 +100,20 @@ class SimulationManager
 public:
     static bool sEnableProbeCachingForMissingProbes;
 
+    // If true, baked sources whose probe weights and reconstruction settings are unchanged since the previous
+    // simulation reuse the previous impulse response, instead of reconstructing and partitioning it again.
+    static bool sEnableBakedImpulseResponseReuse;
+
+    // Probe weights are rounded to multiples of 1 / kNumWeightQuantizationSteps when checking whether a baked
+    // impulse response can be reused.
+    static const int kNumWeightQuantizationSteps;
+
+    // If true, the results of checking whether probes are occluded from the listener and from sources are cached,
+    // and reused until the scene changes or the endpoint moves to a different cell of a grid with spacing
+    // ProbeOcclusionCache::kDefaultCellSize. Has no effect for Custom and Radeon Rays scenes, which cannot report
+    // when they change.
+    static bool sEnableProbeOcclusionCaching;
+
     SimulationManager(bool enableDirect,
                       bool enableIndirect,
                       bool enablePathing,
@@ -232,6 +273,11 @@ private:
     ProbeNeighborhood mTempSourcePathingProbes;
     ProbeNeighborhood mTempListenerPathingProbes;
     unordered_set<const ProbeBatch*> mProbeBatchesForLookup;
+    vector<Vector3f> mStaticListenerSourcePositions;
+    Array<ProbeNeighborhood> mStaticListenerSourceProbes;
+    ProbeOcclusionCache mReflectionsOcclusionCache;
+    ProbeOcclusionCache mPathingOcclusionCache;
+    BakedImpulseResponseKey mBakedImpulseResponseKey;
 
     // Version number of the scene when simulateIndirect() was last called.
     uint32_t mSceneVersion;
@@ -244,9 +290,23 @@ private:
     // Records that we have used the latest version of the scene.
     void resetSceneChanged();
 
+    // Returns false if the scene's version number does not change when the scene does, as with Custom and Radeon Rays
+    // scenes. Results that depend on the scene cannot be cached across simulations for such scenes.
+    bool hasSceneVersion() const;
+
+    // Returns the path cache to use for a source, or nullptr if the scene has no version, in which case paths are
+    // found from scratch in every simulation.
+    PathCache* pathCache(SimulationData& source);
+
+    void checkOcclusion(ProbeNeighborhood& probes,
+                        const Vector3f& point,
+                        ProbeOcclusionCache& cache);
+
     void simulateRealTimeReflections();
     void accumulateEnergyFields();
     void lookupBakedReflections();
+    void updateBakedImpulseResponseKey(SimulationData& source,
+                                       const ProbeNeighborhood& probes);
     void copyEnergyFieldsFromDeviceToHost();
     void generateDistanceCorrectionCurves(int numSamples);
     void reconstructImpulseResponses();
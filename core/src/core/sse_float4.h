@@ -230,6 +230,12 @@ namespace float4
     {
         return _mm_cvtss_f32(in);
     }
+
+    // Returns a 4-bit integer whose bit i is set if the mask in lane i is set.
+    inline int movemask(float4_t mask)
+    {
+        return _mm_movemask_ps(mask);
+    }
 }
 
 }
\ No newline at end of file
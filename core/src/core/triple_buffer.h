@@ -44,13 +44,18 @@ public:
         readBuffer  = ipl::make_unique<T>(std::forward<Args>(args)...);
     }
 
-    void commitWriteBuffer()
+    // Returns false if the reader has not yet picked up previously committed data, in which case nothing is
+    // committed, and the contents of the write buffer are left as-is.
+    bool commitWriteBuffer()
     {
         if (!mNewDataWritten)
         {
             shareBuffer.swap(writeBuffer);
             mNewDataWritten = true;
+            return true;
         }
+
+        return false;
     }
 
     bool updateReadBuffer()
@@ -117,6 +117,7 @@ DEFINE_OPAQUE_HANDLE(IPLDirectEffect, DirectEffect);
 DEFINE_OPAQUE_HANDLE(IPLReflectionEffect, IndirectEffect);
 DEFINE_OPAQUE_HANDLE(IPLReflectionMixer, IndirectMixer);
 DEFINE_OPAQUE_HANDLE(IPLPathEffect, PathEffect);
+DEFINE_OPAQUE_HANDLE(IPLAudioEffectBatch, AudioThreadPool);
 DEFINE_OPAQUE_HANDLE(IPLProbeArray, ProbeArray);
 DEFINE_OPAQUE_HANDLE(IPLProbeBatch, ProbeBatch);
 DEFINE_OPAQUE_HANDLE(IPLSource, SimulationData);
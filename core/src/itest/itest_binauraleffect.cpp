@@ -28,6 +28,8 @@ struct HRTFContainer
 	std::string shortName;
 	shared_ptr<HRTFDatabase> hrtf;
 	shared_ptr<HRTFDatabase> hrtfVis;
+	shared_ptr<HRTFQueryState> queryState;
+	shared_ptr<HRTFQueryState> queryStateVis;
 };
 
 ITEST(binauraleffect)
@@ -60,7 +62,11 @@ ITEST(binauraleffect)
 
 	std::vector<const char*> hrtfShortNames;
 	for (auto i = 0; i < hrtfs.size(); ++i)
+	{
 		hrtfShortNames.push_back(hrtfs[i].shortName.c_str());
+		hrtfs[i].queryState = make_shared<HRTFQueryState>(*hrtfs[i].hrtf);
+		hrtfs[i].queryStateVis = make_shared<HRTFQueryState>(*hrtfs[i].hrtfVis);
+	}
 
 	BinauralEffectSettings effectSettings{};
 	effectSettings.hrtf = hrtfs[0].hrtf.get();
@@ -130,7 +136,7 @@ ITEST(binauraleffect)
 			std::vector< const complex_t* > hrtfData;
 			hrtfData.push_back(leftHrtf.data());
 			hrtfData.push_back(rightHrtf.data());
-			hrtfs[selectedHRTF].hrtf->nearestHRTF(ipl::Vector3f(.0f, .0f, -1.0f), hrtfData.data(), 1.0f, HRTFPhaseType::None, nullptr);
+			hrtfs[selectedHRTF].hrtf->nearestHRTF(ipl::Vector3f(.0f, .0f, -1.0f), hrtfData.data(), 1.0f, HRTFPhaseType::None, *hrtfs[selectedHRTF].queryState);
 			if (loudnessType == HRTFNormType::RMS)
 			{
 				referenceLoudness = Loudness::calculateRMSLoudness(hrtfs[selectedHRTF].hrtf->numSpectrumSamples(), audioSettings.samplingRate, hrtfData.data() );
@@ -147,12 +153,12 @@ ITEST(binauraleffect)
 		if (bilinear)
 		{
 			complex_t* hrtfData[] = {leftHrtf.data(), rightHrtf.data()};
-			hrtfs[selectedHRTF].hrtfVis->interpolatedHRTF(direction, hrtfData, spatialBlend, phaseType);
+			hrtfs[selectedHRTF].hrtfVis->interpolatedHRTF(direction, hrtfData, spatialBlend, phaseType, *hrtfs[selectedHRTF].queryStateVis);
 		}
 		else
 		{
 			complex_t const* hrtfData[] = {nullptr, nullptr};
-			hrtfs[selectedHRTF].hrtfVis->nearestHRTF(direction, hrtfData, spatialBlend, phaseType, mInterpolatedHRTF.data());
+			hrtfs[selectedHRTF].hrtfVis->nearestHRTF(direction, hrtfData, spatialBlend, phaseType, *hrtfs[selectedHRTF].queryStateVis, mInterpolatedHRTF.data());
 
 			if (spatialBlend < 1.0f)
 			{
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <phonon.h>
+
+// Bakes reflections or pathing data for a probe batch using several worker processes, each of which bakes one shard
+// of the probe batch. Once all the workers have finished, their results are merged into a single probe batch.
+//
+// Usage:
+//
+//  sample_shardedbake <scene file> <probe batch file> <output file> <reflections|pathing> <num shards>
+//
+// The scene and probe batch files must have been saved using iplSceneSave and iplProbeBatchSave. Each worker is
+// started by running this program again, with the index of its shard as an additional argument. Workers save their
+// results to <output file>.<shard index>, which are deleted once they have been merged.
+
+std::vector<IPLbyte> load_file(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file)
+        return std::vector<IPLbyte>{};
+
+    file.seekg(0, std::ios::end);
+    auto filesize = static_cast<size_t>(file.tellg());
+
+    std::vector<IPLbyte> data(filesize);
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(data.data()), filesize);
+
+    return data;
+}
+
+bool save_probe_batch(IPLContext context, IPLProbeBatch probeBatch, const std::string& filename)
+{
+    IPLSerializedObjectSettings serializedObjectSettings{};
+
+    IPLSerializedObject serializedObject = nullptr;
+    if (iplSerializedObjectCreate(context, &serializedObjectSettings, &serializedObject) != IPL_STATUS_SUCCESS)
+        return false;
+
+    iplProbeBatchSave(probeBatch, serializedObject);
+
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    file.write(reinterpret_cast<char*>(iplSerializedObjectGetData(serializedObject)), iplSerializedObjectGetSize(serializedObject));
+    auto saved = file.good();
+
+    iplSerializedObjectRelease(&serializedObject);
+    return saved;
+}
+
+IPLProbeBatch load_probe_batch(IPLContext context, const std::string& filename)
+{
+    auto data = load_file(filename);
+    if (data.empty())
+        return nullptr;
+
+    IPLSerializedObjectSettings serializedObjectSettings{};
+    serializedObjectSettings.data = data.data();
+    serializedObjectSettings.size = data.size();
+
+    IPLSerializedObject serializedObject = nullptr;
+    if (iplSerializedObjectCreate(context, &serializedObjectSettings, &serializedObject) != IPL_STATUS_SUCCESS)
+        return nullptr;
+
+    IPLProbeBatch probeBatch = nullptr;
+    iplProbeBatchLoad(context, serializedObject, &probeBatch);
+    iplSerializedObjectRelease(&serializedObject);
+
+    if (probeBatch)
+    {
+        iplProbeBatchCommit(probeBatch);
+    }
+
+    return probeBatch;
+}
+
+IPLScene load_scene(IPLContext context, const std::string& filename)
+{
+    auto data = load_file(filename);
+    if (data.empty())
+        return nullptr;
+
+    IPLSerializedObjectSettings serializedObjectSettings{};
+    serializedObjectSettings.data = data.data();
+    serializedObjectSettings.size = data.size();
+
+    IPLSerializedObject serializedObject = nullptr;
+    if (iplSerializedObjectCreate(context, &serializedObjectSettings, &serializedObject) != IPL_STATUS_SUCCESS)
+        return nullptr;
+
+    IPLSceneSettings sceneSettings{};
+    sceneSettings.type = IPL_SCENETYPE_DEFAULT;
+
+    IPLScene scene = nullptr;
+    iplSceneLoad(context, &sceneSettings, serializedObject, nullptr, nullptr, &scene);
+    iplSerializedObjectRelease(&serializedObject);
+
+    if (scene)
+    {
+        iplSceneCommit(scene);
+    }
+
+    return scene;
+}
+
+IPLReflectionsBakeParams reflections_bake_params(IPLScene scene, IPLProbeBatch probeBatch, int numThreads)
+{
+    IPLReflectionsBakeParams params{};
+    params.scene = scene;
+    params.probeBatch = probeBatch;
+    params.sceneType = IPL_SCENETYPE_DEFAULT;
+    params.identifier.type = IPL_BAKEDDATATYPE_REFLECTIONS;
+    params.identifier.variation = IPL_BAKEDDATAVARIATION_REVERB;
+    params.bakeFlags = static_cast<IPLReflectionsBakeFlags>(IPL_REFLECTIONSBAKEFLAGS_BAKECONVOLUTION | IPL_REFLECTIONSBAKEFLAGS_BAKEPARAMETRIC);
+    params.numRays = 32768;
+    params.numDiffuseSamples = 1024;
+    params.numBounces = 64;
+    params.simulatedDuration = 2.0f;
+    params.savedDuration = 2.0f;
+    params.order = 1;
+    params.numThreads = numThreads;
+    params.irradianceMinDistance = 1.0f;
+    params.bakeBatchSize = 1;
+    return params;
+}
+
+IPLPathBakeParams path_bake_params(IPLScene scene, IPLProbeBatch probeBatch, int numThreads)
+{
+    IPLPathBakeParams params{};
+    params.scene = scene;
+    params.probeBatch = probeBatch;
+    params.identifier.type = IPL_BAKEDDATATYPE_PATHING;
+    params.identifier.variation = IPL_BAKEDDATAVARIATION_DYNAMIC;
+    params.numSamples = 16;
+    params.radius = 1.0f;
+    params.threshold = 0.1f;
+    params.visRange = 50.0f;
+    params.pathRange = 100.0f;
+    params.numThreads = numThreads;
+    return params;
+}
+
+std::string shard_filename(const std::string& outputFilename, int shardIndex)
+{
+    return outputFilename + "." + std::to_string(shardIndex);
+}
+
+// Bakes a single shard, and saves the probe batch containing it.
+int run_worker(IPLContext context, const std::string& sceneFilename, const std::string& probeBatchFilename,
+               const std::string& outputFilename, bool pathing, int numShards, int shardIndex, int numThreads)
+{
+    auto scene = load_scene(context, sceneFilename);
+    auto probeBatch = load_probe_batch(context, probeBatchFilename);
+    if (!scene || !probeBatch)
+    {
+        std::cerr << "Unable to load scene or probe batch." << std::endl;
+        return 1;
+    }
+
+    if (pathing)
+    {
+        auto params = path_bake_params(scene, probeBatch, numThreads);
+        params.numShards = numShards;
+        params.shardIndex = shardIndex;
+        iplPathBakerBake(context, &params, nullptr, nullptr);
+    }
+    else
+    {
+        auto params = reflections_bake_params(scene, probeBatch, numThreads);
+        params.numShards = numShards;
+        params.shardIndex = shardIndex;
+        iplReflectionsBakerBake(context, &params, nullptr, nullptr);
+    }
+
+    auto saved = save_probe_batch(context, probeBatch, shard_filename(outputFilename, shardIndex));
+
+    iplProbeBatchRelease(&probeBatch);
+    iplSceneRelease(&scene);
+
+    return (saved) ? 0 : 1;
+}
+
+// Starts one worker process per shard, waits for all of them to finish, and merges their results.
+int run_coordinator(IPLContext context, const std::string& program, const std::string& sceneFilename,
+                    const std::string& probeBatchFilename, const std::string& outputFilename, bool pathing,
+                    int numShards, int numThreads)
+{
+    std::vector<int> exitCodes(numShards);
+    std::vector<std::thread> workers;
+
+    for (auto i = 0; i < numShards; ++i)
+    {
+        auto command = "\"" + program + "\" \"" + sceneFilename + "\" \"" + probeBatchFilename + "\" \"" +
+                       outputFilename + "\" " + (pathing ? "pathing" : "reflections") + " " +
+                       std::to_string(numShards) + " " + std::to_string(i);
+
+        workers.emplace_back([command, i, &exitCodes]()
+        {
+            exitCodes[i] = std::system(command.c_str());
+        });
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    for (auto i = 0; i < numShards; ++i)
+    {
+        if (exitCodes[i] != 0)
+        {
+            std::cerr << "Shard " << i << " failed." << std::endl;
+            return 1;
+        }
+    }
+
+    auto probeBatch = load_probe_batch(context, probeBatchFilename);
+
+    std::vector<IPLProbeBatch> shards(numShards);
+    for (auto i = 0; i < numShards; ++i)
+    {
+        shards[i] = load_probe_batch(context, shard_filename(outputFilename, i));
+    }
+
+    auto status = IPL_STATUS_FAILURE;
+    if (pathing)
+    {
+        auto params = path_bake_params(nullptr, probeBatch, numThreads);
+        status = iplPathBakerMerge(context, &params, numShards, shards.data(), nullptr, nullptr);
+    }
+    else
+    {
+        auto params = reflections_bake_params(nullptr, probeBatch, numThreads);
+        status = iplReflectionsBakerMerge(context, &params, numShards, shards.data());
+    }
+
+    auto saved = (status == IPL_STATUS_SUCCESS) && save_probe_batch(context, probeBatch, outputFilename);
+
+    for (auto i = 0; i < numShards; ++i)
+    {
+        iplProbeBatchRelease(&shards[i]);
+        std::remove(shard_filename(outputFilename, i).c_str());
+    }
+
+    iplProbeBatchRelease(&probeBatch);
+
+    if (!saved)
+    {
+        std::cerr << "Unable to merge shards." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 6)
+    {
+        std::cerr << "Usage: " << argv[0] << " <scene file> <probe batch file> <output file> <reflections|pathing> <num shards>" << std::endl;
+        return 1;
+    }
+
+    std::string sceneFilename = argv[1];
+    std::string probeBatchFilename = argv[2];
+    std::string outputFilename = argv[3];
+    auto pathing = (std::string(argv[4]) == "pathing");
+    auto numShards = std::max(std::stoi(argv[5]), 1);
+
+    // Split the available cores between the workers.
+    auto numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()) / numShards, 1);
+
+    IPLContextSettings contextSettings{};
+    contextSettings.version = STEAMAUDIO_VERSION;
+
+    IPLContext context{};
+    iplContextCreate(&contextSettings, &context);
+
+    auto result = 0;
+    if (argc > 6)
+    {
+        result = run_worker(context, sceneFilename, probeBatchFilename, outputFilename, pathing, numShards, std::stoi(argv[6]), numThreads);
+    }
+    else
+    {
+        result = run_coordinator(context, argv[0], sceneFilename, probeBatchFilename, outputFilename, pathing, numShards, numThreads);
+    }
+
+    iplContextRelease(&context);
+    return result;
+}
@@ -0,0 +1,92 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <catch.hpp>
+
+#include <audio_thread_pool.h>
+
+TEST_CASE("AudioThreadPool runs every task exactly once per batch.", "[AudioThreadPool]")
+{
+    const auto kNumTasks = 300;
+    const auto kNumBatches = 100;
+
+    for (auto numThreads : { 0, 1, 3 })
+    {
+        ipl::AudioThreadPool threadPool(numThreads);
+        REQUIRE(threadPool.numThreads() == numThreads);
+
+        std::vector<std::atomic<int>> counts(kNumTasks);
+        for (auto& count : counts)
+        {
+            count = 0;
+        }
+
+        for (auto i = 0; i < kNumBatches; ++i)
+        {
+            // Vary the batch size, so workers finishing one batch have to cope with the next one being smaller.
+            auto numTasks = (i % 2 == 0) ? kNumTasks : kNumTasks / 3;
+
+            threadPool.process(numTasks, [&](int index)
+            {
+                counts[index]++;
+            });
+        }
+
+        for (auto i = 0; i < kNumTasks; ++i)
+        {
+            auto expected = (i < kNumTasks / 3) ? kNumBatches : kNumBatches / 2;
+            REQUIRE(counts[i] == expected);
+        }
+    }
+}
+
+TEST_CASE("AudioThreadPool runs every task exactly once across many short back-to-back batches.", "[AudioThreadPool]")
+{
+    const auto kMaxNumTasks = 16;
+    const auto kNumBatches = 50000;
+
+    ipl::AudioThreadPool threadPool(3);
+
+    std::vector<std::atomic<int>> counts(kMaxNumTasks);
+    auto numFailures = 0;
+
+    for (auto i = 0; i < kNumBatches; ++i)
+    {
+        for (auto& count : counts)
+        {
+            count = 0;
+        }
+
+        // Alternate between tiny and larger batches, so workers still finishing a tiny batch are likely to look at
+        // the task index while the next, larger batch is being set up.
+        auto numTasks = (i % 2 == 0) ? 1 : kMaxNumTasks;
+
+        threadPool.process(numTasks, [&](int index)
+        {
+            counts[index]++;
+        });
+
+        for (auto j = 0; j < kMaxNumTasks; ++j)
+        {
+            if (counts[j] != ((j < numTasks) ? 1 : 0))
+            {
+                ++numFailures;
+            }
+        }
+    }
+
+    REQUIRE(numFailures == 0);
+}
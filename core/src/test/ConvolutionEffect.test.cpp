@@ -14,6 +14,10 @@
 // limitations under the License.
 //
 
+#include <array_math.h>
+#include <overlap_save_convolution_effect.h>
+using namespace ipl;
+
 #include <catch.hpp>
 
 TEST_CASE("ConvolutionMixer", "[ConvolutionMixer]")
@@ -23,3 +27,212 @@ TEST_CASE("ConvolutionMixer", "[ConvolutionMixer]")
 TEST_CASE("ConvolutionEffect", "[ConvolutionEffect]")
 {
 }
+
+// Runs numFrames frames of input through an overlap-save convolution effect with the given partition size, followed
+// by the effect's tail, and checks the output against direct convolution.
+static void testOverlapSaveConvolution(int frameSize,
+                                       int partitionSize,
+                                       int samplingRate,
+                                       int numFrames)
+{
+    ImpulseResponse ir(1.0f, 0, samplingRate);
+    for (auto i = 0; i < ir.numSamples(); ++i)
+    {
+        ir[0][i] = (rand() / static_cast<float>(RAND_MAX) - 0.5f) * expf(-4.0f * i / ir.numSamples());
+    }
+
+    OverlapSaveFIR fftIR(1, ir.numSamples(), frameSize, partitionSize);
+    OverlapSavePartitioner partitioner(frameSize, partitionSize);
+    partitioner.partition(ir, 1, ir.numSamples(), fftIR);
+
+    AudioSettings audioSettings{};
+    audioSettings.samplingRate = samplingRate;
+    audioSettings.frameSize = frameSize;
+
+    OverlapSaveConvolutionEffect effect(audioSettings, OverlapSaveConvolutionEffectSettings{1, ir.numSamples(), partitionSize});
+
+    std::vector<float> input(numFrames * frameSize);
+    for (auto& sample : input)
+    {
+        sample = rand() / static_cast<float>(RAND_MAX) - 0.5f;
+    }
+
+    std::vector<float> expected(input.size() + ir.numSamples() - 1, 0.0f);
+    for (auto i = 0u; i < input.size(); ++i)
+    {
+        for (auto j = 0; j < ir.numSamples(); ++j)
+        {
+            expected[i + j] += input[i] * ir[0][j];
+        }
+    }
+
+    AudioBuffer in(1, frameSize);
+    AudioBuffer out(1, frameSize);
+    std::vector<float> output;
+
+    for (auto i = 0; i < numFrames; ++i)
+    {
+        memcpy(in[0], &input[i * frameSize], frameSize * sizeof(float));
+
+        OverlapSaveConvolutionEffectDirectParams params{};
+        params.fftIR = &fftIR;
+        params.fftIRUpdated = (i == 0);
+        params.numChannels = 1;
+
+        effect.apply(params, in, out);
+        output.insert(output.end(), out[0], out[0] + frameSize);
+    }
+
+    while (effect.tail(out) == AudioEffectState::TailRemaining)
+    {
+        output.insert(output.end(), out[0], out[0] + frameSize);
+    }
+    output.insert(output.end(), out[0], out[0] + frameSize);
+
+    // The effect stops once the last IR block has been applied to the last frame of input, without waiting for the
+    // final partial frame.
+    REQUIRE(output.size() + frameSize >= expected.size());
+
+    // The first frame is crossfaded in from silence.
+    auto numSamples = static_cast<int>(std::min(output.size(), expected.size()));
+    auto maxError = 0.0f;
+    for (auto i = frameSize; i < numSamples; ++i)
+    {
+        maxError = std::max(maxError, fabsf(output[i] - expected[i]));
+    }
+
+    REQUIRE(maxError < 1e-3f);
+}
+
+TEST_CASE("Overlap-save convolution with a uniform partition matches direct convolution.", "[ConvolutionEffect]")
+{
+    testOverlapSaveConvolution(64, 64, 4000, 80);
+}
+
+TEST_CASE("Overlap-save convolution with tail partitions matches direct convolution.", "[ConvolutionEffect]")
+{
+    SECTION("Explicit partition size")
+    {
+        testOverlapSaveConvolution(64, 256, 4000, 80);
+    }
+
+    SECTION("Default partition size")
+    {
+        testOverlapSaveConvolution(64, 0, 4000, 80);
+    }
+
+    SECTION("Frame size does not divide IR size")
+    {
+        testOverlapSaveConvolution(32, 128, 3001, 100);
+    }
+}
+
+// Convolves a random signal with a random exponentially-decaying IR, and returns the output.
+static std::vector<float> overlapSaveConvolve(int frameSize,
+                                              int samplingRate,
+                                              int numFrames,
+                                              bool halfPrecision)
+{
+    srand(0);
+
+    ImpulseResponse ir(1.0f, 0, samplingRate);
+    for (auto i = 0; i < ir.numSamples(); ++i)
+    {
+        ir[0][i] = (rand() / static_cast<float>(RAND_MAX) - 0.5f) * expf(-4.0f * i / ir.numSamples());
+    }
+
+    auto prevEnableHalfPrecision = OverlapSaveFIR::sEnableHalfPrecision;
+    OverlapSaveFIR::sEnableHalfPrecision = halfPrecision;
+
+    OverlapSaveFIR fftIR(1, ir.numSamples(), frameSize);
+    OverlapSavePartitioner partitioner(frameSize);
+    partitioner.partition(ir, 1, ir.numSamples(), fftIR);
+
+    AudioSettings audioSettings{};
+    audioSettings.samplingRate = samplingRate;
+    audioSettings.frameSize = frameSize;
+
+    OverlapSaveConvolutionEffect effect(audioSettings, OverlapSaveConvolutionEffectSettings{1, ir.numSamples()});
+
+    OverlapSaveFIR::sEnableHalfPrecision = prevEnableHalfPrecision;
+
+    REQUIRE(fftIR.isHalfPrecision() == halfPrecision);
+
+    AudioBuffer in(1, frameSize);
+    AudioBuffer out(1, frameSize);
+    std::vector<float> output;
+
+    for (auto i = 0; i < numFrames; ++i)
+    {
+        for (auto j = 0; j < frameSize; ++j)
+        {
+            in[0][j] = rand() / static_cast<float>(RAND_MAX) - 0.5f;
+        }
+
+        OverlapSaveConvolutionEffectDirectParams params{};
+        params.fftIR = &fftIR;
+        params.fftIRUpdated = (i == 0);
+        params.numChannels = 1;
+
+        effect.apply(params, in, out);
+        output.insert(output.end(), out[0], out[0] + frameSize);
+    }
+
+    return output;
+}
+
+TEST_CASE("Half-precision values round-trip correctly.", "[ConvolutionEffect]")
+{
+    const float values[] = { 0.0f, 1.0f, -2.5f, 65504.0f, 6.103515625e-5f, 5.9604645e-8f, 0.333251953125f };
+    for (auto value : values)
+    {
+        REQUIRE(Half::toFloat(Half::fromFloat(value)) == value);
+    }
+
+    REQUIRE(Half::fromFloat(1e6f) == 0x7c00);
+    REQUIRE(Half::fromFloat(1e-9f) == 0);
+    REQUIRE(fabsf(Half::toFloat(Half::fromFloat(0.1f)) - 0.1f) < 1e-4f);
+
+    Array<complex_t> spectrum(13);
+    for (auto i = 0u; i < spectrum.size(0); ++i)
+    {
+        spectrum[i] = complex_t(0.1f * i, -0.05f * i);
+    }
+
+    Array<complexh_t> halfSpectrum(13);
+    Array<complex_t> roundTripped(13);
+    ArrayMath::convert(13, spectrum.data(), halfSpectrum.data());
+    ArrayMath::convert(13, halfSpectrum.data(), roundTripped.data());
+
+    for (auto i = 0u; i < spectrum.size(0); ++i)
+    {
+        REQUIRE(roundTripped[i].real() == Half::toFloat(Half::fromFloat(spectrum[i].real())));
+        REQUIRE(roundTripped[i].imag() == Half::toFloat(Half::fromFloat(spectrum[i].imag())));
+    }
+}
+
+TEST_CASE("Half-precision overlap-save convolution is close to single precision.", "[ConvolutionEffect]")
+{
+    const auto frameSize = 256;
+    const auto samplingRate = 24000;
+
+    OverlapSaveFIR fullIR(9, samplingRate, frameSize, 0, false);
+    OverlapSaveFIR halfIR(9, samplingRate, frameSize, 0, true);
+    REQUIRE(2 * halfIR.sizeInBytes() == fullIR.sizeInBytes());
+
+    auto full = overlapSaveConvolve(frameSize, samplingRate, 200, false);
+    auto half = overlapSaveConvolve(frameSize, samplingRate, 200, true);
+
+    auto signalPower = 0.0;
+    auto noisePower = 0.0;
+    for (auto i = frameSize; i < static_cast<int>(full.size()); ++i)
+    {
+        signalPower += full[i] * full[i];
+        noisePower += (full[i] - half[i]) * (full[i] - half[i]);
+    }
+
+    auto snr = 10.0 * log10(signalPower / noisePower);
+    printf("Half-precision overlap-save convolution SNR: %.1f dB\n", snr);
+
+    REQUIRE(snr > 50.0);
+}
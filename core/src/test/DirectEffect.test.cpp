@@ -0,0 +1,107 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <direct_effect.h>
+using namespace ipl;
+
+#include <catch.hpp>
+
+// Returns parameters for the given voice and frame. Voices cycle through different combinations of flags, and some of
+// them switch the EQ on or off partway through, so crossfading and bypassing are both exercised.
+static DirectEffectParams directEffectParams(int voice,
+                                             int frame)
+{
+    DirectEffectParams params{};
+    params.directPath.distanceAttenuation = 1.0f / (1.0f + 0.1f * voice + 0.05f * frame);
+    params.directPath.directivity = 0.8f;
+    params.directPath.occlusion = (frame % 3 == 0) ? 0.25f : 0.5f;
+    for (auto i = 0; i < Bands::kNumBands; ++i)
+    {
+        params.directPath.airAbsorption[i] = 1.0f - 0.05f * (i + 1) * ((voice + frame / 2) % 4);
+        params.directPath.transmission[i] = 0.1f + 0.2f * i;
+    }
+
+    auto flags = ApplyDistanceAttenuation | ApplyOcclusion;
+    if (voice % 3 != 2 && !(voice % 3 == 1 && frame >= 4))
+        flags |= ApplyAirAbsorption;
+    if (voice % 2 == 0)
+        flags |= ApplyTransmission | ApplyDirectivity;
+
+    params.flags = static_cast<DirectEffectFlags>(flags);
+    params.transmissionType = (voice % 4 == 0) ? TransmissionType::FreqIndependent : TransmissionType::FreqDependent;
+
+    return params;
+}
+
+TEST_CASE("DirectEffectBatch produces the same output as one DirectEffect per voice.", "[DirectEffect]")
+{
+    const auto kNumVoices = 11;
+    const auto kNumFrames = 10;
+
+    AudioSettings audioSettings{};
+    audioSettings.samplingRate = 48000;
+    audioSettings.frameSize = 256;
+
+    DirectEffectBatch batch(audioSettings, kNumVoices);
+
+    std::vector<unique_ptr<DirectEffect>> effects;
+    std::vector<unique_ptr<AudioBuffer>> inBuffers;
+    std::vector<unique_ptr<AudioBuffer>> outBuffers;
+    std::vector<std::vector<float>> batchOut(kNumVoices, std::vector<float>(audioSettings.frameSize));
+    for (auto i = 0; i < kNumVoices; ++i)
+    {
+        effects.push_back(make_unique<DirectEffect>(audioSettings, DirectEffectSettings{1}));
+        inBuffers.push_back(make_unique<AudioBuffer>(1, audioSettings.frameSize));
+        outBuffers.push_back(make_unique<AudioBuffer>(1, audioSettings.frameSize));
+    }
+
+    std::vector<const float*> in(kNumVoices);
+    std::vector<float*> out(kNumVoices);
+    for (auto i = 0; i < kNumVoices; ++i)
+    {
+        in[i] = (*inBuffers[i])[0];
+        out[i] = batchOut[i].data();
+    }
+
+    for (auto frame = 0; frame < kNumFrames; ++frame)
+    {
+        // Only some of the voices are active in one of the frames.
+        auto numVoices = (frame == 6) ? 5 : kNumVoices;
+
+        std::vector<DirectEffectParams> params(numVoices);
+        for (auto i = 0; i < numVoices; ++i)
+        {
+            params[i] = directEffectParams(i, frame);
+
+            for (auto j = 0; j < audioSettings.frameSize; ++j)
+            {
+                (*inBuffers[i])[0][j] = rand() / static_cast<float>(RAND_MAX) - 0.5f;
+            }
+
+            effects[i]->apply(params[i], *inBuffers[i], *outBuffers[i]);
+        }
+
+        batch.apply(numVoices, params.data(), in.data(), out.data());
+
+        for (auto i = 0; i < numVoices; ++i)
+        {
+            for (auto j = 0; j < audioSettings.frameSize; ++j)
+            {
+                REQUIRE(batchOut[i][j] == Approx((*outBuffers[i])[0][j]).margin(1e-4f));
+            }
+        }
+    }
+}
@@ -14,6 +14,12 @@
 // limitations under the License.
 //
 
+#include <compressed_energy_field.h>
+#include <energy_field_cache.h>
+#include <reconstructor.h>
+#include <sh.h>
+using namespace ipl;
+
 #include <catch.hpp>
 
 TEST_CASE("Histogram", "[Histogram]")
@@ -31,3 +37,219 @@ TEST_CASE("EnergyField", "[EnergyField]")
 TEST_CASE("EnergyFieldReconstructor", "[EnergyFieldReconstructor]")
 {
 }
+
+// Fills an energy field with exponentially-decaying noise that goes silent after the given duration. Higher-order
+// channels have progressively less energy, and the highest order is negligible.
+static void makeDecayingEnergyField(float duration,
+                                    EnergyField& energyField)
+{
+    srand(0);
+
+    const float decayRates[Bands::kNumBands] = { 3.0f, 4.0f, 6.0f };
+    const float orderGains[] = { 1.0f, 0.3f, 1e-6f };
+
+    auto numActiveBins = static_cast<int>(duration / EnergyField::kBinDuration);
+
+    energyField.reset();
+
+    for (auto i = 0; i < energyField.numChannels(); ++i)
+    {
+        auto order = static_cast<int>(sqrtf(static_cast<float>(i)));
+
+        for (auto j = 0; j < Bands::kNumBands; ++j)
+        {
+            for (auto k = 0; k < std::min(numActiveBins, energyField.numBins()); ++k)
+            {
+                auto noise = rand() / static_cast<float>(RAND_MAX);
+                auto energy = 1e-2f * expf(-decayRates[j] * k * EnergyField::kBinDuration) * (0.5f + noise);
+                energyField[i][j][k] = (i == 0) ? energy : orderGains[order] * (2.0f * noise - 1.0f) * energy;
+            }
+        }
+    }
+}
+
+// Compresses an energy field, and reports the size ratio and the error in the energy field and in the impulse response
+// reconstructed from it. Returns the SNR of the reconstructed impulse response in dB.
+static double testCompressedEnergyField(const EnergyField& energyField,
+                                        const EnergyFieldCompressionSettings& settings)
+{
+    const auto samplingRate = 48000;
+    const auto duration = energyField.numBins() * EnergyField::kBinDuration;
+    const auto order = 2;
+
+    CompressedEnergyField compressedEnergyField(energyField, settings);
+
+    EnergyField decodedEnergyField(duration, order);
+    compressedEnergyField.decode(decodedEnergyField);
+
+    auto maxError = 0.0f;
+    for (auto i = 0; i < compressedEnergyField.numChannels(); ++i)
+    {
+        for (auto j = 0; j < Bands::kNumBands; ++j)
+        {
+            auto peak = 0.0f;
+            for (auto k = 0; k < energyField.numBins(); ++k)
+            {
+                peak = std::max(peak, fabsf(energyField[i][j][k]));
+            }
+
+            for (auto k = 0; k < energyField.numBins(); ++k)
+            {
+                maxError = std::max(maxError, fabsf(decodedEnergyField[i][j][k] - energyField[i][j][k]) / peak);
+            }
+        }
+    }
+
+    Reconstructor reconstructor(duration, order, samplingRate);
+    ImpulseResponse impulseResponse(duration, order, samplingRate);
+    ImpulseResponse decodedImpulseResponse(duration, order, samplingRate);
+
+    const EnergyField* energyFields[] = { &energyField, &decodedEnergyField };
+    ImpulseResponse* impulseResponses[] = { &impulseResponse, &decodedImpulseResponse };
+    const float* distanceAttenuationCorrectionCurves[] = { nullptr, nullptr };
+    AirAbsorptionModel airAbsorptionModels[2];
+
+    reconstructor.reconstruct(2, energyFields, distanceAttenuationCorrectionCurves, airAbsorptionModels,
+                              impulseResponses, ReconstructionType::Linear, duration, order);
+
+    auto signalPower = 0.0;
+    auto noisePower = 0.0;
+    for (auto i = 0; i < impulseResponse.numChannels(); ++i)
+    {
+        for (auto j = 0; j < impulseResponse.numSamples(); ++j)
+        {
+            auto error = decodedImpulseResponse[i][j] - impulseResponse[i][j];
+            signalPower += impulseResponse[i][j] * impulseResponse[i][j];
+            noisePower += error * error;
+        }
+    }
+
+    auto snr = 10.0 * log10(signalPower / noisePower);
+    auto sizeRatio = static_cast<double>(energyField.serializedSize()) / compressedEnergyField.serializedSize();
+
+    printf("%d-bit compressed energy field: %d channels, %d bins, size ratio %.1fx, max energy error %.2f%%, reconstructed IR SNR %.1f dB\n",
+           settings.numBits, compressedEnergyField.numChannels(), compressedEnergyField.numBins(), sizeRatio,
+           100.0f * maxError, snr);
+
+    REQUIRE(sizeRatio > 32.0 / settings.numBits);
+
+    return snr;
+}
+
+TEST_CASE("Compressed energy fields are close to uncompressed energy fields.", "[EnergyField]")
+{
+    EnergyField energyField(2.0f, 2);
+    makeDecayingEnergyField(1.5f, energyField);
+
+    EnergyFieldCompressionSettings settings{};
+    settings.enabled = true;
+
+    SECTION("16-bit")
+    {
+        settings.numBits = 16;
+        REQUIRE(testCompressedEnergyField(energyField, settings) > 60.0);
+    }
+
+    SECTION("8-bit")
+    {
+        settings.numBits = 8;
+        REQUIRE(testCompressedEnergyField(energyField, settings) > 25.0);
+    }
+
+    SECTION("Order reduction")
+    {
+        settings.orderReductionThreshold = CompressedEnergyField::kDefaultOrderReductionThreshold;
+
+        CompressedEnergyField compressedEnergyField(energyField, settings);
+        REQUIRE(compressedEnergyField.numChannels() == SphericalHarmonics::numCoeffsForOrder(1));
+
+        REQUIRE(testCompressedEnergyField(energyField, settings) > 60.0);
+    }
+}
+
+TEST_CASE("Silent energy fields compress to nothing.", "[EnergyField]")
+{
+    EnergyField energyField(1.0f, 1);
+
+    EnergyFieldCompressionSettings settings{};
+    settings.enabled = true;
+
+    CompressedEnergyField compressedEnergyField(energyField, settings);
+    REQUIRE(compressedEnergyField.numBins() == 0);
+
+    EnergyField decodedEnergyField(1.0f, 1);
+    decodedEnergyField[0][0][0] = 1.0f;
+    compressedEnergyField.decode(decodedEnergyField);
+    REQUIRE(decodedEnergyField[0][0][0] == 0.0f);
+}
+
+TEST_CASE("Malformed compressed energy fields are loaded as silence.", "[EnergyField]")
+{
+    const auto kNumChannels = 4;
+    const auto kNumBins = 10;
+
+    // The data array holds fewer values than the header says.
+    std::vector<float> scales(kNumChannels * Bands::kNumBands, 1.0f);
+    std::vector<uint16_t> data16(kNumChannels * Bands::kNumBands * kNumBins / 2, 1);
+
+    flatbuffers::FlatBufferBuilder builder;
+    auto scalesOffset = builder.CreateVector(scales);
+    auto data16Offset = builder.CreateVector(data16);
+    builder.Finish(Serialized::CreateCompressedEnergyField(builder, kNumChannels, kNumBins, 16, scalesOffset, 0, data16Offset));
+
+    CompressedEnergyField compressedEnergyField(flatbuffers::GetRoot<Serialized::CompressedEnergyField>(builder.GetBufferPointer()));
+    REQUIRE(compressedEnergyField.numBins() == 0);
+
+    EnergyField decodedEnergyField(1.0f, 1);
+    decodedEnergyField[0][0][0] = 1.0f;
+    compressedEnergyField.decode(decodedEnergyField);
+    REQUIRE(decodedEnergyField[0][0][0] == 0.0f);
+}
+
+TEST_CASE("Energy field cache evicts least recently used entries.", "[EnergyField]")
+{
+    auto makeEntry = []()
+    {
+        EnergyFieldCache::Entry entry;
+        entry.energyField = ipl::make_unique<EnergyField>(1.0f, 1);
+        return entry;
+    };
+
+    auto entrySize = 4 * Bands::kNumBands * 100 * sizeof(float);
+
+    EnergyFieldCache cache(3 * entrySize);
+
+    cache.insert(0, makeEntry());
+    cache.insert(1, makeEntry());
+    cache.insert(2, makeEntry());
+    REQUIRE(cache.numEntries() == 3);
+    REQUIRE(cache.size() == 3 * entrySize);
+
+    REQUIRE(cache.find(0) != nullptr);
+
+    cache.insert(3, makeEntry());
+    REQUIRE(cache.numEntries() == 3);
+    REQUIRE(cache.find(1) == nullptr);
+    REQUIRE(cache.find(0) != nullptr);
+    REQUIRE(cache.find(2) != nullptr);
+    REQUIRE(cache.find(3) != nullptr);
+
+    SECTION("Replacing an entry does not change the size")
+    {
+        cache.insert(2, makeEntry());
+        REQUIRE(cache.numEntries() == 3);
+        REQUIRE(cache.size() == 3 * entrySize);
+    }
+
+    SECTION("Entries larger than the capacity are still inserted")
+    {
+        EnergyFieldCache::Entry entry;
+        entry.energyField = ipl::make_unique<EnergyField>(5.0f, 1);
+        REQUIRE(cache.insert(4, std::move(entry))->energyField != nullptr);
+        REQUIRE(cache.numEntries() == 1);
+    }
+
+    cache.clear();
+    REQUIRE(cache.numEntries() == 0);
+    REQUIRE(cache.size() == 0);
+}
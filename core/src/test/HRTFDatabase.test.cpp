@@ -14,11 +14,14 @@
 // limitations under the License.
 //
 
+#include <thread>
+
 #include <catch.hpp>
 
 #include <array.h>
 #include <audio_buffer.h>
 #include <hrtf_database.h>
+#include <polar_vector.h>
 
 
 TEST_CASE("HRTF database is loaded and parsed correctly.", "[HRTFDatabase]")
@@ -29,3 +32,118 @@ TEST_CASE("HRTF database is loaded and parsed correctly.", "[HRTFDatabase]")
     REQUIRE(hrtfDatabase.numHRIRs() == 1250);
     REQUIRE(hrtfDatabase.numSamples() == 200);
 }
+
+TEST_CASE("Interpolation grid matches bilinear interpolation at grid directions.", "[HRTFDatabase]")
+{
+    ipl::HRTFSettings hrtfSettings{};
+    ipl::HRTFDatabase hrtfDatabase(hrtfSettings, 44100, 1024);
+
+    ipl::HRTFSettings gridHRTFSettings{};
+    gridHRTFSettings.interpolationGridResolution = 10.0f;
+    ipl::HRTFDatabase gridHRTFDatabase(gridHRTFSettings, 44100, 1024);
+
+    REQUIRE(!hrtfDatabase.hasInterpolationGrid());
+    REQUIRE(gridHRTFDatabase.hasInterpolationGrid());
+
+    // Directions that lie on the 10 degree grid.
+    const ipl::Vector3f directions[] = {
+        ipl::Vector3f(0.0f, 0.0f, -1.0f),
+        ipl::SphericalVector3f(1.0f, 20.0f * ipl::Math::kDegreesToRadians, 40.0f * ipl::Math::kDegreesToRadians).toCartesian(),
+        ipl::SphericalVector3f(1.0f, -30.0f * ipl::Math::kDegreesToRadians, 120.0f * ipl::Math::kDegreesToRadians).toCartesian(),
+        ipl::SphericalVector3f(1.0f, 10.0f * ipl::Math::kDegreesToRadians, 250.0f * ipl::Math::kDegreesToRadians).toCartesian(),
+    };
+
+    ipl::Array<ipl::complex_t, 2> interpolatedHRTF(2, hrtfDatabase.numSpectrumSamples());
+    ipl::HRTFQueryState queryState(hrtfDatabase);
+
+    for (const auto& direction : directions)
+    {
+        int peakDelays[2] = { 0, 0 };
+        hrtfDatabase.interpolatedHRTF(direction, interpolatedHRTF.data(), 1.0f, ipl::HRTFPhaseType::None, queryState, peakDelays);
+
+        const ipl::complex_t* gridHRTF[2] = { nullptr, nullptr };
+        int gridPeakDelays[2] = { 0, 0 };
+        gridHRTFDatabase.gridInterpolatedHRTF(direction, gridHRTF, gridPeakDelays);
+
+        for (auto i = 0; i < 2; ++i)
+        {
+            REQUIRE(gridPeakDelays[i] == peakDelays[i]);
+
+            for (auto j = 0; j < hrtfDatabase.numSpectrumSamples(); ++j)
+            {
+                REQUIRE(std::abs(gridHRTF[i][j] - interpolatedHRTF[i][j]) == Approx(0.0f).margin(1e-4f));
+            }
+        }
+    }
+
+    // Directions that lie slightly off the grid snap to the nearest grid direction.
+    const ipl::complex_t* frontHRTF[2] = { nullptr, nullptr };
+    gridHRTFDatabase.gridInterpolatedHRTF(ipl::Vector3f(0.0f, 0.0f, -1.0f), frontHRTF);
+
+    const ipl::complex_t* nearFrontHRTF[2] = { nullptr, nullptr };
+    gridHRTFDatabase.gridInterpolatedHRTF(ipl::Vector3f::unitVector(ipl::Vector3f(0.05f, 0.0f, -1.0f)), nearFrontHRTF);
+
+    REQUIRE(frontHRTF[0] == nearFrontHRTF[0]);
+    REQUIRE(frontHRTF[1] == nearFrontHRTF[1]);
+}
+
+TEST_CASE("HRTF queries with separate query states can run concurrently.", "[HRTFDatabase]")
+{
+    ipl::HRTFSettings hrtfSettings{};
+    ipl::HRTFDatabase hrtfDatabase(hrtfSettings, 44100, 1024);
+
+    const auto kNumThreads = 4;
+    const auto kNumQueries = 64;
+
+    auto query = [&](int queryIndex, ipl::HRTFQueryState& queryState, ipl::Array<ipl::complex_t, 2>& hrtf)
+    {
+        auto azimuth = (360.0f * queryIndex) / kNumQueries;
+        auto direction = ipl::SphericalVector3f(1.0f, 0.0f, azimuth * ipl::Math::kDegreesToRadians).toCartesian();
+        hrtfDatabase.interpolatedHRTF(direction, hrtf.data(), 0.5f, ipl::HRTFPhaseType::SphereITD, queryState);
+    };
+
+    std::vector<ipl::Array<ipl::complex_t, 2>> expected(kNumQueries);
+    ipl::HRTFQueryState expectedQueryState(hrtfDatabase);
+    for (auto i = 0; i < kNumQueries; ++i)
+    {
+        expected[i].resize(2, hrtfDatabase.numSpectrumSamples());
+        query(i, expectedQueryState, expected[i]);
+    }
+
+    std::vector<int> matches(kNumThreads, 1);
+    std::vector<std::thread> threads;
+    for (auto i = 0; i < kNumThreads; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            ipl::HRTFQueryState queryState(hrtfDatabase);
+            ipl::Array<ipl::complex_t, 2> hrtf(2, hrtfDatabase.numSpectrumSamples());
+
+            for (auto j = 0; j < kNumQueries; ++j)
+            {
+                query(j, queryState, hrtf);
+
+                for (auto k = 0; k < 2; ++k)
+                {
+                    for (auto l = 0; l < hrtfDatabase.numSpectrumSamples(); ++l)
+                    {
+                        if (hrtf[k][l] != expected[j][k][l])
+                        {
+                            matches[i] = 0;
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto i = 0; i < kNumThreads; ++i)
+    {
+        REQUIRE(matches[i] == 1);
+    }
+}
@@ -0,0 +1,941 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <catch.hpp>
+
+#include <random>
+#include <thread>
+
+#include <path_data.h>
+#include <path_simulator.h>
+#include <scene_factory.h>
+#include <sh.h>
+#include <thread_pool.h>
+using namespace ipl;
+
+// Returns a scene containing a 10m x 4m wall along the z axis, with a 2m wide gap at one end. The gap can be closed
+// by moving the end of the wall.
+static shared_ptr<IScene> createWallScene(float wallEnd = 3.0f)
+{
+    Vector3f vertices[] = {
+        Vector3f(0.0f, -1.0f, -5.0f), Vector3f(0.0f, -1.0f, wallEnd), Vector3f(0.0f, 3.0f, wallEnd), Vector3f(0.0f, 3.0f, -5.0f)
+    };
+
+    Triangle triangles[] = {
+        {{0, 1, 2}}, {{0, 2, 3}}
+    };
+
+    int materialIndices[2] = {};
+
+    Material material{};
+
+    auto scene = shared_ptr<IScene>(SceneFactory::create(SceneType::Default, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+    scene->addStaticMesh(scene->createStaticMesh(4, 2, 1, vertices, triangles, materialIndices, &material));
+    scene->commit();
+
+    return scene;
+}
+
+static void addProbes(ProbeBatch& probeBatch)
+{
+    for (auto x = -3; x <= 3; x += 2)
+    {
+        for (auto z = -4; z <= 4; z += 2)
+        {
+            probeBatch.addProbe(Sphere(Vector3f(static_cast<float>(x), 1.0f, static_cast<float>(z)), 1.0f));
+        }
+    }
+
+    probeBatch.commit();
+}
+
+static void bakePaths(const IScene& scene,
+                      const BakedDataIdentifier& identifier,
+                      ProbeBatch& probeBatch,
+                      const BakeShard& shard = BakeShard{},
+                      int numThreads = 2,
+                      bool incremental = false)
+{
+    PathBaker::bake(scene, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, 50.0f, false, Vector3f(0.0f, -1.0f, 0.0f), false,
+                    numThreads, probeBatch, nullptr, nullptr, shard, 0.0f, incremental);
+}
+
+TEST_CASE("Sharded path bakes merge into data identical to a single bake.", "[PathBaker]")
+{
+    const auto numShards = 3;
+
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+    bakePaths(*scene, identifier, probeBatch);
+
+    ProbeBatch mergedProbeBatch;
+    addProbes(mergedProbeBatch);
+
+    ProbeBatch shards[numShards];
+    ProbeBatch* shardPtrs[numShards] = {};
+    for (auto i = 0; i < numShards; ++i)
+    {
+        addProbes(shards[i]);
+        shardPtrs[i] = &shards[i];
+
+        BakeShard shard{};
+        shard.index = i;
+        shard.numShards = numShards;
+        bakePaths(*scene, identifier, shards[i], shard);
+
+        const auto& shardData = static_cast<const BakedPathData&>(shards[i][identifier]);
+        REQUIRE(shardData.shard().isPartial());
+        REQUIRE(shardData.needsUpdate());
+    }
+
+    // Every shard must be merged at once.
+    REQUIRE(!PathBaker::merge(identifier, numShards - 1, shardPtrs, 20.0f, 50.0f, false, Vector3f(0.0f, -1.0f, 0.0f),
+                              false, 2, mergedProbeBatch));
+
+    REQUIRE(PathBaker::merge(identifier, numShards, shardPtrs, 20.0f, 50.0f, false, Vector3f(0.0f, -1.0f, 0.0f), false,
+                             2, mergedProbeBatch));
+
+    const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+    const auto& mergedData = static_cast<const BakedPathData&>(mergedProbeBatch[identifier]);
+
+    REQUIRE(!mergedData.shard().isPartial());
+    REQUIRE(mergedData.serializedSize() == data.serializedSize());
+
+    auto numIndirectPaths = 0;
+    for (auto i = 0; i < probeBatch.numProbes(); ++i)
+    {
+        const auto& adjacent = data.visGraph().mAdjacent[i];
+        const auto& mergedAdjacent = mergedData.visGraph().mAdjacent[i];
+
+        REQUIRE(mergedAdjacent.size() == adjacent.size());
+        for (auto j = 0u; j < adjacent.size(); ++j)
+        {
+            REQUIRE(mergedAdjacent[j].index == adjacent[j].index);
+            REQUIRE(mergedAdjacent[j].cost == adjacent[j].cost);
+        }
+
+        for (auto j = 0; j < probeBatch.numProbes(); ++j)
+        {
+            auto path = data.lookupShortestPath(i, j, nullptr);
+            auto mergedPath = mergedData.lookupShortestPath(i, j, nullptr);
+
+            REQUIRE(mergedPath.isValid() == path.isValid());
+            REQUIRE(mergedPath.direct == path.direct);
+            REQUIRE(mergedPath.firstProbe == path.firstProbe);
+            REQUIRE(mergedPath.lastProbe == path.lastProbe);
+            REQUIRE(mergedPath.probeAfterFirst == path.probeAfterFirst);
+            REQUIRE(mergedPath.probeBeforeLast == path.probeBeforeLast);
+            REQUIRE(mergedPath.distanceInternal == path.distanceInternal);
+            REQUIRE(mergedPath.deviationInternal == path.deviationInternal);
+
+            if (path.isValid() && !path.direct)
+            {
+                ++numIndirectPaths;
+            }
+        }
+    }
+
+    // Probes on opposite sides of the wall can only reach each other through the gap.
+    REQUIRE(numIndirectPaths > 0);
+}
+
+TEST_CASE("SoundPathTable assigns one id to each unique path.", "[PathBaker]")
+{
+    SoundPathTable table;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+
+    auto makePath = [&probeBatch](int a, int b)
+    {
+        ProbePath probePath;
+        probePath.valid = true;
+        probePath.nodes.push_back(a);
+        probePath.nodes.push_back(b);
+        return SoundPath(probePath, probeBatch);
+    };
+
+    vector<std::thread> threads;
+    vector<vector<int>> ids(4);
+    for (auto i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            for (auto j = 0; j < 100; ++j)
+            {
+                ids[i].push_back(table.insert(makePath(j % 10, (j + 1) % 10)));
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // The invalid path, plus 10 unique paths.
+    REQUIRE(table.numPaths() == 11);
+
+    for (auto i = 1; i < 4; ++i)
+    {
+        REQUIRE(ids[i] == ids[0]);
+    }
+
+    Array<SoundPath> uniquePaths;
+    vector<int> remap;
+    table.finalize(uniquePaths, remap);
+
+    REQUIRE(uniquePaths.size(0) == 11);
+    REQUIRE(!uniquePaths[0].isValid());
+    REQUIRE(remap[0] == 0);
+
+    for (auto j = 0; j < 10; ++j)
+    {
+        const auto& soundPath = uniquePaths[remap[ids[0][j]]];
+        REQUIRE(soundPath.firstProbe == j);
+        REQUIRE(soundPath.lastProbe == (j + 1) % 10);
+    }
+}
+
+TEST_CASE("Baked paths do not depend on the number of threads.", "[PathBaker]")
+{
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+    bakePaths(*scene, identifier, probeBatch, BakeShard{}, 1);
+
+    ProbeBatch multiThreadedProbeBatch;
+    addProbes(multiThreadedProbeBatch);
+    bakePaths(*scene, identifier, multiThreadedProbeBatch, BakeShard{}, 4);
+
+    const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+    const auto& multiThreadedData = static_cast<const BakedPathData&>(multiThreadedProbeBatch[identifier]);
+
+    REQUIRE(multiThreadedData.serializedSize() == data.serializedSize());
+
+    for (auto i = 0; i < probeBatch.numProbes(); ++i)
+    {
+        for (auto j = 0; j < probeBatch.numProbes(); ++j)
+        {
+            auto path = data.lookupShortestPath(i, j, nullptr);
+            auto multiThreadedPath = multiThreadedData.lookupShortestPath(i, j, nullptr);
+
+            REQUIRE(multiThreadedPath.isValid() == path.isValid());
+            REQUIRE(multiThreadedPath.direct == path.direct);
+            REQUIRE(multiThreadedPath.firstProbe == path.firstProbe);
+            REQUIRE(multiThreadedPath.lastProbe == path.lastProbe);
+            REQUIRE(multiThreadedPath.distanceInternal == path.distanceInternal);
+
+            // Every path must be at least as long as the straight line between its endpoints.
+            if (path.isValid())
+            {
+                const auto& start = probeBatch[i].influence.center;
+                const auto& end = probeBatch[j].influence.center;
+                REQUIRE(path.distance(probeBatch, i, j) >= (end - start).length() - 1e-4f);
+            }
+        }
+    }
+}
+
+// Builds a visibility graph using the range grid, and checks it against testing every pair of probes.
+static void testVisibilityGraph(int numSamples,
+                                float radius,
+                                bool asymmetricVisRange)
+{
+    const auto numThreads = 2;
+    const auto visRange = 3.0f;
+    const auto threshold = 0.1f;
+
+    auto scene = createWallScene();
+
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> horizontal(-6.0f, 6.0f);
+    std::uniform_real_distribution<float> vertical(-0.5f, 8.0f);
+
+    ProbeBatch probeBatch;
+    for (auto i = 0; i < 150; ++i)
+    {
+        probeBatch.addProbe(Sphere(Vector3f(horizontal(rng), vertical(rng), horizontal(rng)), 1.0f));
+    }
+    probeBatch.commit();
+
+    ProbeVisibilityTester visTester(numSamples, asymmetricVisRange, Vector3f(0.0f, -1.0f, 0.0f));
+
+    std::atomic<bool> cancel(false);
+    ThreadPool threadPool(numThreads);
+    JobGraph jobGraph{};
+    ProbeVisibilityGraph visGraph(*scene, probeBatch, visTester, radius, threshold, visRange, numThreads, jobGraph,
+                                  cancel);
+    threadPool.process(jobGraph);
+
+    auto numEdges = 0;
+    for (auto i = 0; i < probeBatch.numProbes(); ++i)
+    {
+        vector<int> expected;
+        for (auto j = 0; j < probeBatch.numProbes(); ++j)
+        {
+            if (i == j || visTester.areProbesTooFar(probeBatch, i, j, visRange))
+                continue;
+
+            // Visibility is only tested from the probe with the larger index.
+            auto from = std::max(i, j);
+            auto to = std::min(i, j);
+            if (visTester.areProbesVisible(*scene, probeBatch, from, to, radius, threshold))
+            {
+                expected.push_back(j);
+            }
+        }
+
+        vector<int> found;
+        for (const auto& entry : visGraph.mAdjacent[i])
+        {
+            found.push_back(entry.index);
+        }
+
+        std::sort(found.begin(), found.end());
+        REQUIRE(found == expected);
+
+        numEdges += static_cast<int>(found.size());
+    }
+
+    // Some, but not all, pairs of probes are connected.
+    REQUIRE(numEdges > 0);
+    REQUIRE(numEdges < probeBatch.numProbes() * (probeBatch.numProbes() - 1));
+}
+
+TEST_CASE("Visibility graphs built using the range grid match testing every pair of probes.", "[PathBaker]")
+{
+    SECTION("Point-to-point visibility")
+    {
+        testVisibilityGraph(1, 0.0f, false);
+    }
+
+    SECTION("Volumetric visibility")
+    {
+        testVisibilityGraph(4, 0.5f, false);
+    }
+
+    SECTION("Asymmetric visibility range")
+    {
+        testVisibilityGraph(1, 0.0f, true);
+    }
+}
+
+TEST_CASE("Batched visibility tests between pairs of probes match testing each pair.", "[PathBaker]")
+{
+    auto numSamples = 1;
+    auto radius = 0.0f;
+
+    SECTION("Point-to-point visibility")
+    {}
+
+    SECTION("Volumetric visibility")
+    {
+        numSamples = 4;
+        radius = 0.5f;
+    }
+
+    auto scene = createWallScene();
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+
+    ProbeVisibilityTester visTester(numSamples, false, Vector3f(0.0f, -1.0f, 0.0f));
+
+    // Pairs are grouped by from probe, with some from probes appearing in several groups.
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<int> probeIndex(0, probeBatch.numProbes() - 1);
+
+    vector<int> from;
+    vector<int> to;
+    for (auto i = 0; i < 200; ++i)
+    {
+        from.push_back((i / 5) % probeBatch.numProbes());
+        to.push_back(probeIndex(rng));
+    }
+
+    ProbeVisibilityRayBatch rayBatch;
+    std::unique_ptr<bool[]> visible(new bool[from.size()]);
+    visTester.areProbePairsVisible(*scene, probeBatch, static_cast<int>(from.size()), from.data(), to.data(), radius,
+                                   0.1f, rayBatch, visible.get());
+
+    auto numVisible = 0;
+    for (auto i = 0u; i < from.size(); ++i)
+    {
+        REQUIRE(visible[i] == visTester.areProbesVisible(*scene, probeBatch, from[i], to[i], radius, 0.1f));
+        numVisible += (visible[i]) ? 1 : 0;
+    }
+
+    REQUIRE(numVisible > 0);
+    REQUIRE(numVisible < static_cast<int>(from.size()));
+}
+
+TEST_CASE("Baked paths are only stored for connected pairs of probes.", "[PathBaker]")
+{
+    const auto pathRange = 6.0f;
+
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+    PathBaker::bake(*scene, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, pathRange, false, Vector3f(0.0f, -1.0f, 0.0f),
+                    false, 2, probeBatch);
+
+    const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+
+    PathFinder pathFinder(probeBatch, 1);
+    vector<ProbePath> paths(probeBatch.numProbes());
+
+    auto numValidPaths = 0;
+    auto numInvalidPaths = 0;
+    for (auto i = 0; i < probeBatch.numProbes(); ++i)
+    {
+        pathFinder.findAllShortestPaths(probeBatch, data.visGraph(), i, pathRange, 0, paths.data());
+
+        for (auto j = 0; j < probeBatch.numProbes(); ++j)
+        {
+            auto path = data.lookupShortestPath(i, j, nullptr);
+            REQUIRE(path.isValid() == paths[j].valid);
+
+            if (paths[j].valid)
+            {
+                REQUIRE(path.direct == paths[j].nodes.empty());
+                ++numValidPaths;
+            }
+            else
+            {
+                ++numInvalidPaths;
+            }
+
+            paths[j].reset();
+        }
+    }
+
+    REQUIRE(numValidPaths > 0);
+    REQUIRE(numInvalidPaths > probeBatch.numProbes());
+}
+
+TEST_CASE("Baked paths between probes with indices beyond 16 bits survive serialization.", "[PathBaker]")
+{
+    const auto numIsolatedProbes = 32767;
+
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    // Probes far enough apart that none of them can see each other, followed by three probes around the wall, so
+    // the path between the first and last of them goes through the gap, via probe 32768.
+    ProbeBatch probeBatch;
+    for (auto i = 0; i < numIsolatedProbes; ++i)
+    {
+        probeBatch.addProbe(Sphere(Vector3f(100.0f * ((i % 256) + 1), 1.0f, 100.0f * (i / 256)), 1.0f));
+    }
+
+    probeBatch.addProbe(Sphere(Vector3f(-2.0f, 1.0f, 0.0f), 1.0f));
+    probeBatch.addProbe(Sphere(Vector3f(0.0f, 1.0f, 4.0f), 1.0f));
+    probeBatch.addProbe(Sphere(Vector3f(2.0f, 1.0f, 0.0f), 1.0f));
+    probeBatch.commit();
+
+    bakePaths(*scene, identifier, probeBatch);
+
+    const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+
+    auto path = data.lookupShortestPath(numIsolatedProbes, numIsolatedProbes + 2, nullptr);
+    REQUIRE(path.isValid());
+    REQUIRE(!path.direct);
+    REQUIRE((path.firstProbe == numIsolatedProbes + 1 || path.lastProbe == numIsolatedProbes + 1));
+
+    SerializedObject serializedObject;
+    probeBatch.serializeAsRoot(serializedObject);
+
+    ProbeBatch loadedProbeBatch(serializedObject);
+    const auto& loadedData = static_cast<const BakedPathData&>(loadedProbeBatch[identifier]);
+
+    REQUIRE(loadedData.serializedSize() == data.serializedSize());
+
+    for (auto i = numIsolatedProbes; i < probeBatch.numProbes(); ++i)
+    {
+        for (auto j = numIsolatedProbes; j < probeBatch.numProbes(); ++j)
+        {
+            auto expectedPath = data.lookupShortestPath(i, j, nullptr);
+            auto loadedPath = loadedData.lookupShortestPath(i, j, nullptr);
+
+            REQUIRE(loadedPath.isValid() == expectedPath.isValid());
+            REQUIRE(loadedPath.direct == expectedPath.direct);
+            REQUIRE(loadedPath.firstProbe == expectedPath.firstProbe);
+            REQUIRE(loadedPath.lastProbe == expectedPath.lastProbe);
+            REQUIRE(loadedPath.probeAfterFirst == expectedPath.probeAfterFirst);
+            REQUIRE(loadedPath.probeBeforeLast == expectedPath.probeBeforeLast);
+        }
+    }
+}
+
+TEST_CASE("Dijkstra and A* searches find shortest paths through the visibility graph.", "[PathFinder]")
+{
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+    bakePaths(*scene, identifier, probeBatch);
+
+    const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+    const auto& visGraph = data.visGraph();
+    auto numProbes = probeBatch.numProbes();
+
+    // Floyd-Warshall over the adjacency list gives the expected shortest path lengths.
+    vector<float> distances(numProbes * numProbes, std::numeric_limits<float>::infinity());
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        distances[i * numProbes + i] = 0.0f;
+        for (const auto& entry : visGraph.mAdjacent[i])
+        {
+            distances[i * numProbes + entry.index] = entry.cost;
+        }
+    }
+
+    for (auto k = 0; k < numProbes; ++k)
+    {
+        for (auto i = 0; i < numProbes; ++i)
+        {
+            for (auto j = 0; j < numProbes; ++j)
+            {
+                distances[i * numProbes + j] = std::min(distances[i * numProbes + j], distances[i * numProbes + k] + distances[k * numProbes + j]);
+            }
+        }
+    }
+
+    auto pathLength = [&](int start, int end, const vector<int>& nodes)
+    {
+        auto length = 0.0f;
+        auto prev = start;
+        for (auto node : nodes)
+        {
+            REQUIRE(visGraph.hasEdge(prev, node));
+            length += (probeBatch[prev].influence.center - probeBatch[node].influence.center).length();
+            prev = node;
+        }
+
+        REQUIRE(visGraph.hasEdge(prev, end));
+        return length + (probeBatch[prev].influence.center - probeBatch[end].influence.center).length();
+    };
+
+    ProbeVisibilityTester visTester(1, false, Vector3f(0.0f, -1.0f, 0.0f));
+    PathFinder pathFinder(probeBatch, 1);
+    vector<ProbePath> paths(numProbes);
+
+    // Searches from every probe, in an order that reuses the path finder's scratch space in different ways.
+    for (auto n = 0; n < numProbes; ++n)
+    {
+        auto i = (n * 7) % numProbes;
+
+        for (auto& path : paths)
+        {
+            path.reset();
+        }
+
+        pathFinder.findAllShortestPaths(probeBatch, visGraph, i, std::numeric_limits<float>::infinity(), 0, paths.data());
+
+        for (auto j = 0; j < numProbes; ++j)
+        {
+            if (j == i)
+                continue;
+
+            auto expected = distances[i * numProbes + j];
+            REQUIRE(paths[j].valid == (expected < std::numeric_limits<float>::infinity()));
+
+            auto path = pathFinder.findShortestPath(*scene, probeBatch, visGraph, visTester, i, j, 0.0f, 1.0f, 20.0f,
+                                                    false, false);
+            REQUIRE(path.valid == paths[j].valid);
+
+            if (paths[j].valid)
+            {
+                // Paths found using A* include the start probe.
+                REQUIRE(path.nodes.front() == i);
+                path.nodes.erase(path.nodes.begin());
+
+                REQUIRE(pathLength(i, j, paths[j].nodes) == Approx(expected).epsilon(1e-4f));
+                REQUIRE(pathLength(i, j, path.nodes) == Approx(expected).epsilon(1e-4f));
+            }
+        }
+    }
+}
+
+TEST_CASE("Hierarchical path bakes find paths between regions through portals.", "[PathBaker]")
+{
+    const auto regionSize = 3.0f;
+
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+    bakePaths(*scene, identifier, probeBatch);
+
+    ProbeBatch hierarchicalProbeBatch;
+    addProbes(hierarchicalProbeBatch);
+    PathBaker::bake(*scene, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, 50.0f, false, Vector3f(0.0f, -1.0f, 0.0f), false,
+                    2, hierarchicalProbeBatch, nullptr, nullptr, BakeShard{}, regionSize);
+
+    const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+    const auto& hierarchicalData = static_cast<const BakedPathData&>(hierarchicalProbeBatch[identifier]);
+
+    REQUIRE(!data.isHierarchical());
+    REQUIRE(hierarchicalData.isHierarchical());
+    REQUIRE(hierarchicalData.numRegions() > 1);
+
+    auto numPathsBetweenRegions = 0;
+    for (auto i = 0; i < probeBatch.numProbes(); ++i)
+    {
+        for (auto j = 0; j < probeBatch.numProbes(); ++j)
+        {
+            if (i == j)
+                continue;
+
+            ProbePath probePath;
+            auto path = data.lookupShortestPath(i, j, nullptr);
+            auto hierarchicalPath = hierarchicalData.lookupShortestPath(i, j, &probePath);
+            REQUIRE(hierarchicalPath.isValid() == path.isValid());
+
+            if (!path.isValid())
+                continue;
+
+            // Paths between regions must pass through portals, so they can't be shorter than the shortest path.
+            REQUIRE(hierarchicalPath.distance(probeBatch, i, j) >= path.distance(probeBatch, i, j) - 1e-4f);
+
+            REQUIRE(probePath.valid);
+            REQUIRE(hierarchicalPath.direct == probePath.nodes.empty());
+
+            auto prev = i;
+            for (auto node : probePath.nodes)
+            {
+                REQUIRE(hierarchicalData.visGraph().hasEdge(prev, node));
+                prev = node;
+            }
+
+            REQUIRE(hierarchicalData.visGraph().hasEdge(prev, j));
+
+            auto regionI = floorf(probeBatch[i].influence.center.x() / regionSize);
+            auto regionJ = floorf(probeBatch[j].influence.center.x() / regionSize);
+            if (regionI != regionJ)
+            {
+                ++numPathsBetweenRegions;
+            }
+        }
+    }
+
+    REQUIRE(numPathsBetweenRegions > 0);
+}
+
+TEST_CASE("Hierarchical path lookups respect the path range, and can reuse scratch space.", "[PathBaker]")
+{
+    const auto regionSize = 3.0f;
+    const auto pathRange = 6.0f;
+
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+    PathBaker::bake(*scene, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, pathRange, false, Vector3f(0.0f, -1.0f, 0.0f),
+                    false, 2, probeBatch);
+
+    ProbeBatch hierarchicalProbeBatch;
+    addProbes(hierarchicalProbeBatch);
+    PathBaker::bake(*scene, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, pathRange, false, Vector3f(0.0f, -1.0f, 0.0f),
+                    false, 2, hierarchicalProbeBatch, nullptr, nullptr, BakeShard{}, regionSize);
+
+    const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+    const auto& hierarchicalData = static_cast<const BakedPathData&>(hierarchicalProbeBatch[identifier]);
+
+    PortalSearch search;
+
+    auto numValidPaths = 0;
+    auto numInvalidPaths = 0;
+    for (auto i = 0; i < probeBatch.numProbes(); ++i)
+    {
+        for (auto j = 0; j < probeBatch.numProbes(); ++j)
+        {
+            if (i == j)
+                continue;
+
+            auto path = data.lookupShortestPath(i, j, nullptr);
+            auto hierarchicalPath = hierarchicalData.lookupShortestPath(i, j, nullptr);
+
+            // Paths between regions can't be shorter than the shortest path, so if there is no path within the path
+            // range, there is no hierarchical path either.
+            if (!path.isValid())
+            {
+                REQUIRE(!hierarchicalPath.isValid());
+            }
+
+            if (hierarchicalPath.isValid())
+            {
+                REQUIRE(hierarchicalPath.distance(probeBatch, i, j) <= pathRange + 1e-4f);
+                ++numValidPaths;
+            }
+            else
+            {
+                ++numInvalidPaths;
+            }
+
+            ProbePath probePath;
+            ProbePath reusedProbePath;
+            hierarchicalData.lookupShortestPath(i, j, &probePath);
+            auto reusedPath = hierarchicalData.lookupShortestPath(i, j, &reusedProbePath, &search);
+
+            REQUIRE(reusedPath.isValid() == hierarchicalPath.isValid());
+            REQUIRE(reusedPath.direct == hierarchicalPath.direct);
+            REQUIRE(reusedPath.firstProbe == hierarchicalPath.firstProbe);
+            REQUIRE(reusedPath.lastProbe == hierarchicalPath.lastProbe);
+            REQUIRE(reusedPath.distanceInternal == hierarchicalPath.distanceInternal);
+            REQUIRE(reusedProbePath.nodes == probePath.nodes);
+        }
+    }
+
+    REQUIRE(numValidPaths > 0);
+    REQUIRE(numInvalidPaths > 0);
+}
+
+// Checks that two sets of baked paths have the same visibility graph, and the same paths between every pair of probes.
+static void requireSamePaths(const BakedPathData& data,
+                             const BakedPathData& expectedData,
+                             int numProbes)
+{
+    REQUIRE(data.serializedSize() == expectedData.serializedSize());
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        for (auto j = 0; j < numProbes; ++j)
+        {
+            REQUIRE(data.visGraph().hasEdge(i, j) == expectedData.visGraph().hasEdge(i, j));
+
+            auto path = data.lookupShortestPath(i, j, nullptr);
+            auto expectedPath = expectedData.lookupShortestPath(i, j, nullptr);
+
+            REQUIRE(path.isValid() == expectedPath.isValid());
+            REQUIRE(path.direct == expectedPath.direct);
+            REQUIRE(path.firstProbe == expectedPath.firstProbe);
+            REQUIRE(path.lastProbe == expectedPath.lastProbe);
+            REQUIRE(path.probeAfterFirst == expectedPath.probeAfterFirst);
+            REQUIRE(path.probeBeforeLast == expectedPath.probeBeforeLast);
+            REQUIRE(path.distanceInternal == expectedPath.distanceInternal);
+            REQUIRE(path.deviationInternal == expectedPath.deviationInternal);
+        }
+    }
+}
+
+static void editProbes(ProbeBatch& probeBatch)
+{
+    probeBatch.updateProbePosition(6, Vector3f(-2.0f, 1.0f, 1.0f));
+    probeBatch.removeProbe(3);
+    probeBatch.addProbe(Sphere(Vector3f(2.0f, 1.0f, 5.0f), 1.0f));
+    probeBatch.commit();
+}
+
+TEST_CASE("Incremental path bakes match baking from scratch.", "[PathBaker]")
+{
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    SECTION("Moved, added, and removed probes")
+    {
+        auto scene = createWallScene();
+
+        ProbeBatch probeBatch;
+        addProbes(probeBatch);
+        bakePaths(*scene, identifier, probeBatch);
+
+        editProbes(probeBatch);
+        REQUIRE(static_cast<const BakedPathData&>(probeBatch[identifier]).needsUpdate());
+
+        bakePaths(*scene, identifier, probeBatch, BakeShard{}, 2, true);
+
+        ProbeBatch expectedProbeBatch;
+        addProbes(expectedProbeBatch);
+        editProbes(expectedProbeBatch);
+        bakePaths(*scene, identifier, expectedProbeBatch);
+
+        const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+        const auto& expectedData = static_cast<const BakedPathData&>(expectedProbeBatch[identifier]);
+
+        REQUIRE(!data.needsUpdate());
+        requireSamePaths(data, expectedData, probeBatch.numProbes());
+    }
+
+    SECTION("Changed geometry")
+    {
+        auto scene = createWallScene();
+        auto changedScene = createWallScene(5.0f);
+
+        ProbeBatch probeBatch;
+        addProbes(probeBatch);
+        bakePaths(*scene, identifier, probeBatch);
+
+        probeBatch.invalidateBakedData(identifier, Box(Vector3f(0.0f, -1.0f, 3.0f), Vector3f(0.0f, 3.0f, 5.0f)), 20.0f);
+        bakePaths(*changedScene, identifier, probeBatch, BakeShard{}, 2, true);
+
+        ProbeBatch expectedProbeBatch;
+        addProbes(expectedProbeBatch);
+        bakePaths(*changedScene, identifier, expectedProbeBatch);
+
+        const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+        const auto& expectedData = static_cast<const BakedPathData&>(expectedProbeBatch[identifier]);
+
+        requireSamePaths(data, expectedData, probeBatch.numProbes());
+    }
+
+    SECTION("Changed bake parameters")
+    {
+        auto scene = createWallScene();
+
+        ProbeBatch probeBatch;
+        addProbes(probeBatch);
+        bakePaths(*scene, identifier, probeBatch);
+
+        editProbes(probeBatch);
+        PathBaker::bake(*scene, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, 10.0f, false, Vector3f(0.0f, -1.0f, 0.0f),
+                        false, 2, probeBatch, nullptr, nullptr, BakeShard{}, 0.0f, true);
+
+        ProbeBatch expectedProbeBatch;
+        addProbes(expectedProbeBatch);
+        editProbes(expectedProbeBatch);
+        PathBaker::bake(*scene, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, 10.0f, false, Vector3f(0.0f, -1.0f, 0.0f),
+                        false, 2, expectedProbeBatch, nullptr, nullptr);
+
+        const auto& data = static_cast<const BakedPathData&>(probeBatch[identifier]);
+        const auto& expectedData = static_cast<const BakedPathData&>(expectedProbeBatch[identifier]);
+
+        REQUIRE(data.params().pathRange == 10.0f);
+        requireSamePaths(data, expectedData, probeBatch.numProbes());
+    }
+}
+
+TEST_CASE("Path simulation with a path cache matches simulation without one.", "[PathSimulator]")
+{
+    const auto order = 1;
+
+    auto scene = createWallScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    ProbeBatch probeBatch;
+    addProbes(probeBatch);
+    bakePaths(*scene, identifier, probeBatch);
+
+    PathSimulator simulator(probeBatch, 1, false, Vector3f(0.0f, -1.0f, 0.0f));
+    PathCache cache;
+
+    DistanceAttenuationModel distanceAttenuationModel{};
+    DeviationModel deviationModel{};
+
+    ProbeNeighborhood sourceProbes;
+    ProbeNeighborhood listenerProbes;
+    sourceProbes.resize(ProbeNeighborhood::kMaxProbesPerBatch);
+    listenerProbes.resize(ProbeNeighborhood::kMaxProbesPerBatch);
+
+    Vector3f listener(3.0f, 1.0f, -4.0f);
+    probeBatch.getInfluencingProbes(listener, listenerProbes);
+    listenerProbes.calcWeights(listener);
+
+    auto simulate = [&](const Vector3f& source)
+    {
+        sourceProbes.reset();
+        probeBatch.getInfluencingProbes(source, sourceProbes);
+        sourceProbes.calcWeights(source);
+
+        float eqGains[2][Bands::kNumBands];
+        vector<float> coeffs[2];
+        Vector3f direction[2];
+
+        for (auto i = 0; i < 2; ++i)
+        {
+            coeffs[i].resize(SphericalHarmonics::numCoeffsForOrder(order));
+
+            simulator.findPaths(source, listener, *scene, probeBatch, sourceProbes, listenerProbes, 0.0f, 1.0f, 20.0f,
+                                order, true, true, false, true, eqGains[i], coeffs[i].data(), distanceAttenuationModel,
+                                deviationModel, &direction[i], nullptr, nullptr, nullptr, nullptr, false,
+                                (i == 0) ? &cache : nullptr);
+        }
+
+        for (auto j = 0; j < Bands::kNumBands; ++j)
+        {
+            REQUIRE(eqGains[0][j] == eqGains[1][j]);
+        }
+
+        REQUIRE(coeffs[0] == coeffs[1]);
+        REQUIRE(direction[0].x() == direction[1].x());
+        REQUIRE(direction[0].y() == direction[1].y());
+        REQUIRE(direction[0].z() == direction[1].z());
+
+        return coeffs[0];
+    };
+
+    // Move the source slowly, so consecutive updates use mostly the same pairs of probes.
+    for (auto i = 0; i <= 20; ++i)
+    {
+        auto coeffs = simulate(Vector3f(-3.0f, 1.0f, -4.0f + 0.1f * i));
+        REQUIRE(coeffs[0] != 0.0f);
+    }
+
+    // Close the gap in the wall. Cached paths must not be used once the scene has changed, since they now fail
+    // validation.
+    Vector3f vertices[] = {
+        Vector3f(0.0f, -1.0f, 2.0f), Vector3f(0.0f, -1.0f, 6.0f), Vector3f(0.0f, 3.0f, 6.0f), Vector3f(0.0f, 3.0f, 2.0f)
+    };
+
+    Triangle triangles[] = {
+        {{0, 1, 2}}, {{0, 2, 3}}
+    };
+
+    int materialIndices[2] = {};
+    Material material{};
+
+    scene->addStaticMesh(scene->createStaticMesh(4, 2, 1, vertices, triangles, materialIndices, &material));
+    scene->commit();
+
+    auto coeffs = simulate(Vector3f(-3.0f, 1.0f, -2.0f));
+    REQUIRE(coeffs[0] == 0.0f);
+}
@@ -0,0 +1,75 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <path_effect.h>
+using namespace ipl;
+
+#include <catch.hpp>
+
+TEST_CASE("The blended pathing HRTF is derived again only when SH coefficients change enough.", "[PathEffect]")
+{
+    // The cache only compares HRTF database pointers, so no HRTF data is needed.
+    const auto hrtf = reinterpret_cast<const HRTFDatabase*>(&PathHRTFCache::sHRTFUpdateTolerance);
+    const auto order = 1;
+
+    float coeffs[] = {1.0f, 0.5f, -0.25f, 0.1f};
+
+    PathHRTFCache cache(order);
+    REQUIRE(cache.needsUpdate(hrtf, order, coeffs));
+
+    cache.update(hrtf, order, coeffs);
+    REQUIRE(!cache.needsUpdate(hrtf, order, coeffs));
+
+    SECTION("Small changes reuse the blended HRTF.")
+    {
+        coeffs[1] += 0.5f * PathHRTFCache::sHRTFUpdateTolerance;
+        REQUIRE(!cache.needsUpdate(hrtf, order, coeffs));
+    }
+
+    SECTION("Small changes that add up derive the HRTF again.")
+    {
+        auto numUpdates = 0;
+        for (auto i = 0; i < 10; ++i)
+        {
+            coeffs[2] += 0.5f * PathHRTFCache::sHRTFUpdateTolerance;
+            if (cache.needsUpdate(hrtf, order, coeffs))
+            {
+                cache.update(hrtf, order, coeffs);
+                ++numUpdates;
+            }
+        }
+
+        REQUIRE(numUpdates > 0);
+        REQUIRE(numUpdates < 10);
+    }
+
+    SECTION("Changing the order derives the HRTF again.")
+    {
+        REQUIRE(cache.needsUpdate(hrtf, 0, coeffs));
+    }
+
+    SECTION("Changing the HRTF database derives the HRTF again.")
+    {
+        REQUIRE(cache.needsUpdate(nullptr, order, coeffs));
+    }
+
+    SECTION("Resetting derives the HRTF again.")
+    {
+        cache.reset();
+        REQUIRE(cache.needsUpdate(hrtf, order, coeffs));
+        REQUIRE(cache.needsUpdate(nullptr, order, coeffs));
+    }
+}
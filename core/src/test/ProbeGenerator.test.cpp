@@ -0,0 +1,133 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <catch.hpp>
+
+#include <probe_generator.h>
+#include <scene_factory.h>
+using namespace ipl;
+
+static void addQuad(const Vector3f& a,
+                    const Vector3f& b,
+                    const Vector3f& c,
+                    const Vector3f& d,
+                    int material,
+                    vector<Vector3f>& vertices,
+                    vector<Triangle>& triangles,
+                    vector<int>& materialIndices)
+{
+    auto base = static_cast<int>(vertices.size());
+    vertices.insert(vertices.end(), {a, b, c, d});
+    triangles.push_back(Triangle{{base, base + 1, base + 2}});
+    triangles.push_back(Triangle{{base, base + 2, base + 3}});
+    materialIndices.insert(materialIndices.end(), {material, material});
+}
+
+// Returns a scene containing a 32m x 24m x 4m reverberant hall (x from 0 to 32), connected through a doorway to an
+// 8m x 24m x 4m absorbent side room (x from 32 to 40).
+static shared_ptr<IScene> createHallScene()
+{
+    vector<Vector3f> vertices;
+    vector<Triangle> triangles;
+    vector<int> materialIndices;
+
+    auto addBox = [&](float x0, float x1, int material)
+    {
+        addQuad(Vector3f(x0, 0, 0), Vector3f(x1, 0, 0), Vector3f(x1, 0, 24), Vector3f(x0, 0, 24), material, vertices, triangles, materialIndices);
+        addQuad(Vector3f(x0, 4, 0), Vector3f(x1, 4, 0), Vector3f(x1, 4, 24), Vector3f(x0, 4, 24), material, vertices, triangles, materialIndices);
+        addQuad(Vector3f(x0, 0, 0), Vector3f(x1, 0, 0), Vector3f(x1, 4, 0), Vector3f(x0, 4, 0), material, vertices, triangles, materialIndices);
+        addQuad(Vector3f(x0, 0, 24), Vector3f(x1, 0, 24), Vector3f(x1, 4, 24), Vector3f(x0, 4, 24), material, vertices, triangles, materialIndices);
+    };
+
+    addBox(0.0f, 32.0f, 0);
+    addBox(32.0f, 40.0f, 1);
+    addQuad(Vector3f(0, 0, 0), Vector3f(0, 0, 24), Vector3f(0, 4, 24), Vector3f(0, 4, 0), 0, vertices, triangles, materialIndices);
+    addQuad(Vector3f(40, 0, 0), Vector3f(40, 0, 24), Vector3f(40, 4, 24), Vector3f(40, 4, 0), 1, vertices, triangles, materialIndices);
+
+    // Partition wall with a 2m wide doorway.
+    addQuad(Vector3f(32, 0, 0), Vector3f(32, 0, 11), Vector3f(32, 4, 11), Vector3f(32, 4, 0), 1, vertices, triangles, materialIndices);
+    addQuad(Vector3f(32, 0, 13), Vector3f(32, 0, 24), Vector3f(32, 4, 24), Vector3f(32, 4, 13), 1, vertices, triangles, materialIndices);
+
+    Material materials[2]{};
+    for (auto band = 0; band < Bands::kNumBands; ++band)
+    {
+        materials[0].absorption[band] = 0.05f;
+        materials[1].absorption[band] = 0.8f;
+    }
+
+    auto scene = shared_ptr<IScene>(SceneFactory::create(SceneType::Default, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+    scene->addStaticMesh(scene->createStaticMesh(static_cast<int>(vertices.size()), static_cast<int>(triangles.size()), 2,
+                                                 vertices.data(), triangles.data(), materialIndices.data(), materials));
+    scene->commit();
+
+    return scene;
+}
+
+TEST_CASE("Adaptive probe generation only subdivides where the acoustics change.", "[ProbeGenerator]")
+{
+    auto scene = createHallScene();
+
+    // Keep probes away from the outer walls.
+    Matrix4x4f transform({{39.0f, 0.0f, 0.0f, 20.0f}, {0.0f, 6.0f, 0.0f, 2.0f}, {0.0f, 0.0f, 23.0f, 12.0f}, {0.0f, 0.0f, 0.0f, 1.0f}});
+
+    const auto spacing = 2.0f;
+    const auto height = 1.5f;
+
+    AdaptiveProbeGenerationSettings settings{};
+    settings.numSubdivisions = 2;
+    settings.tolerance = 0.25f;
+    settings.numThreads = 2;
+
+    ProbeArray uniformProbes;
+    ProbeGenerator::generateProbes(*scene, transform, ProbeGenerationType::UniformFloor, spacing, height, uniformProbes);
+
+    ProbeArray coarseProbes;
+    ProbeGenerator::generateProbes(*scene, transform, ProbeGenerationType::UniformFloor, 4.0f * spacing, height, coarseProbes);
+
+    ProbeArray adaptiveProbes;
+    ProbeGenerator::generateProbes(*scene, transform, ProbeGenerationType::Adaptive, spacing, height, adaptiveProbes, settings);
+
+    printf("Probes: uniform %d, coarse %d, adaptive %d\n", uniformProbes.numProbes(), coarseProbes.numProbes(), adaptiveProbes.numProbes());
+
+    REQUIRE(adaptiveProbes.numProbes() > coarseProbes.numProbes());
+    REQUIRE(3 * adaptiveProbes.numProbes() < 2 * uniformProbes.numProbes());
+
+    // Every uniformly-spaced probe position is covered by some adaptive probe.
+    for (auto i = 0; i < uniformProbes.numProbes(); ++i)
+    {
+        auto covered = false;
+        for (auto j = 0; j < adaptiveProbes.numProbes() && !covered; ++j)
+        {
+            covered = adaptiveProbes[j].influence.contains(uniformProbes[i].influence.center);
+        }
+
+        REQUIRE(covered);
+    }
+
+    // The finest probes are close to the doorway between the hall and the side room.
+    auto numFineProbes = 0;
+    for (auto i = 0; i < adaptiveProbes.numProbes(); ++i)
+    {
+        const auto& influence = adaptiveProbes[i].influence;
+        if (influence.radius <= spacing)
+        {
+            REQUIRE(fabsf(influence.center.x() - 32.0f) < 16.0f);
+            ++numFineProbes;
+        }
+    }
+
+    REQUIRE(numFineProbes > 0);
+}
@@ -17,8 +17,10 @@
 #include <catch.hpp>
 
 #include <random>
+#include <set>
 
 #include <probe_manager.h>
+#include <scene_factory.h>
 using namespace ipl;
 
 TEST_CASE("Weight function sums to 1", "[Probe]")
@@ -78,3 +80,346 @@ TEST_CASE("ProbeTree::getSamplesThatInfluence returns correct number of probes",
 
     REQUIRE(numValidProbes == 2);
 }
+
+// A 10 x 10 grid of 4m x 4m cells, each with its own probe batch, plus one probe batch covering everything.
+static vector<shared_ptr<ProbeBatch>> createGridOfProbeBatches()
+{
+    vector<shared_ptr<ProbeBatch>> probeBatches;
+    for (auto x = 0; x < 10; ++x)
+    {
+        for (auto z = 0; z < 10; ++z)
+        {
+            auto probeBatch = make_shared<ProbeBatch>();
+            for (auto i = 0; i < 4; ++i)
+            {
+                auto center = Vector3f(x * 4.0f + (i % 2) * 2.0f + 1.0f, 1.5f, z * 4.0f + (i / 2) * 2.0f + 1.0f);
+                probeBatch->addProbe(Sphere(center, 1.5f));
+            }
+            probeBatch->commit();
+            probeBatches.push_back(probeBatch);
+        }
+    }
+
+    auto globalProbeBatch = make_shared<ProbeBatch>();
+    globalProbeBatch->addProbe(Sphere(Vector3f(20.0f, 1.5f, 20.0f), std::numeric_limits<float>::max()));
+    globalProbeBatch->commit();
+    probeBatches.push_back(globalProbeBatch);
+
+    // Probe batches with no probes are ignored.
+    probeBatches.push_back(make_shared<ProbeBatch>());
+
+    return probeBatches;
+}
+
+TEST_CASE("ProbeManager finds the same probes as searching every probe batch.", "[ProbeManager]")
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> distribution(-2.0f, 42.0f);
+
+    auto probeBatches = createGridOfProbeBatches();
+
+    ProbeManager probeManager;
+    for (const auto& probeBatch : probeBatches)
+    {
+        probeManager.addProbeBatch(probeBatch);
+    }
+    probeManager.commit();
+
+    ProbeNeighborhood neighborhood;
+    ProbeNeighborhood expectedNeighborhood;
+    expectedNeighborhood.resize(ProbeNeighborhood::kMaxProbesPerBatch);
+
+    for (auto i = 0; i < 1000; ++i)
+    {
+        auto point = Vector3f(distribution(rng), 1.5f, distribution(rng));
+
+        probeManager.getInfluencingProbes(point, neighborhood);
+        REQUIRE(neighborhood.numProbes() < static_cast<int>(probeBatches.size()) * ProbeNeighborhood::kMaxProbesPerBatch);
+
+        std::set<std::pair<const ProbeBatch*, int>> found;
+        for (auto j = 0; j < neighborhood.numProbes(); ++j)
+        {
+            if (neighborhood.batches[j] && neighborhood.probeIndices[j] >= 0)
+            {
+                found.insert(std::make_pair(neighborhood.batches[j], neighborhood.probeIndices[j]));
+            }
+        }
+
+        std::set<std::pair<const ProbeBatch*, int>> expected;
+        for (const auto& probeBatch : probeBatches)
+        {
+            if (probeBatch->numProbes() == 0)
+                continue;
+
+            probeBatch->getInfluencingProbes(point, expectedNeighborhood);
+            for (auto j = 0; j < ProbeNeighborhood::kMaxProbesPerBatch; ++j)
+            {
+                if (expectedNeighborhood.probeIndices[j] >= 0)
+                {
+                    expected.insert(std::make_pair(probeBatch.get(), expectedNeighborhood.probeIndices[j]));
+                }
+            }
+        }
+
+        REQUIRE(found == expected);
+    }
+}
+
+TEST_CASE("ProbeManager finds probes added to a probe batch after the probe manager was committed.", "[ProbeManager]")
+{
+    auto probeBatch = make_shared<ProbeBatch>();
+    probeBatch->addProbe(Sphere(Vector3f(0.0f, 1.5f, 0.0f), 2.0f));
+    probeBatch->commit();
+
+    // An empty probe batch that is only populated later.
+    auto laterProbeBatch = make_shared<ProbeBatch>();
+
+    ProbeManager probeManager;
+    probeManager.addProbeBatch(probeBatch);
+    probeManager.addProbeBatch(laterProbeBatch);
+    probeManager.commit();
+
+    auto farPoint = Vector3f(30.0f, 1.5f, 0.0f);
+    auto laterPoint = Vector3f(-30.0f, 1.5f, 0.0f);
+
+    auto findsProbe = [&](const Vector3f& point, const ProbeBatch* batch, int probeIndex)
+    {
+        ProbeNeighborhood neighborhood;
+        probeManager.getInfluencingProbes(point, neighborhood);
+
+        ProbeNeighborhood batchedNeighborhood;
+        probeManager.getInfluencingProbes(1, &point, &batchedNeighborhood);
+
+        auto found = false;
+        auto foundBatched = false;
+        for (auto i = 0; i < neighborhood.numProbes(); ++i)
+        {
+            found = found || (neighborhood.batches[i] == batch && neighborhood.probeIndices[i] == probeIndex);
+        }
+        for (auto i = 0; i < batchedNeighborhood.numProbes(); ++i)
+        {
+            foundBatched = foundBatched || (batchedNeighborhood.batches[i] == batch && batchedNeighborhood.probeIndices[i] == probeIndex);
+        }
+
+        REQUIRE(found == foundBatched);
+        return found;
+    };
+
+    REQUIRE(findsProbe(Vector3f(0.5f, 1.5f, 0.0f), probeBatch.get(), 0));
+    REQUIRE(!findsProbe(farPoint, probeBatch.get(), 1));
+
+    // Only the probe batches are committed, not the probe manager.
+    probeBatch->addProbe(Sphere(farPoint, 2.0f));
+    probeBatch->commit();
+
+    laterProbeBatch->addProbe(Sphere(laterPoint, 2.0f));
+    laterProbeBatch->commit();
+
+    REQUIRE(findsProbe(Vector3f(0.5f, 1.5f, 0.0f), probeBatch.get(), 0));
+    REQUIRE(findsProbe(farPoint, probeBatch.get(), 1));
+    REQUIRE(findsProbe(laterPoint, laterProbeBatch.get(), 0));
+}
+
+TEST_CASE("Single-point and batched ProbeTree lookups find the nearest influencing probes.", "[ProbeTree]")
+{
+    const auto numPoints = 37;
+    const auto maxInfluencingProbes = ProbeNeighborhood::kMaxProbesPerBatch;
+
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> position(0.0f, 20.0f);
+    std::uniform_real_distribution<float> radius(2.0f, 6.0f);
+
+    vector<Probe> probes;
+    for (auto i = 0; i < 200; ++i)
+    {
+        probes.push_back(Probe{Sphere(Vector3f(position(rng), position(rng), position(rng)), radius(rng))});
+    }
+
+    ProbeTree tree(static_cast<int>(probes.size()), probes.data());
+
+    // Include points outside every probe.
+    vector<Vector3f> points;
+    for (auto i = 0; i < numPoints - 1; ++i)
+    {
+        points.push_back(Vector3f(position(rng), position(rng), position(rng)));
+    }
+    points.push_back(Vector3f(100.0f, 100.0f, 100.0f));
+
+    BatchedProbeNeighborhood neighborhood;
+    neighborhood.resize(numPoints, maxInfluencingProbes);
+    tree.getInfluencingProbes(numPoints, points.data(), probes.data(), maxInfluencingProbes,
+                              neighborhood.probeIndices.data(), neighborhood.distances.data());
+
+    vector<int> singlePointIndices(maxInfluencingProbes);
+
+    auto numFullNeighborhoods = 0;
+    for (auto i = 0; i < numPoints; ++i)
+    {
+        tree.getInfluencingProbes(points[i], probes.data(), maxInfluencingProbes, singlePointIndices.data());
+
+        vector<std::pair<float, int>> expected;
+        for (auto j = 0u; j < probes.size(); ++j)
+        {
+            auto distance = (points[i] - probes[j].influence.center).length();
+            if (distance <= probes[j].influence.radius)
+            {
+                expected.push_back(std::make_pair(distance, static_cast<int>(j)));
+            }
+        }
+
+        std::sort(expected.begin(), expected.end());
+
+        for (auto j = 0; j < maxInfluencingProbes; ++j)
+        {
+            auto k = i * maxInfluencingProbes + j;
+            if (j < static_cast<int>(expected.size()))
+            {
+                REQUIRE(neighborhood.probeIndices[k] == expected[j].second);
+                REQUIRE(neighborhood.distances[k] == Approx(expected[j].first));
+            }
+            else
+            {
+                REQUIRE(neighborhood.probeIndices[k] == -1);
+            }
+
+            REQUIRE(singlePointIndices[j] == neighborhood.probeIndices[k]);
+        }
+
+        if (expected.size() > maxInfluencingProbes)
+        {
+            ++numFullNeighborhoods;
+        }
+    }
+
+    REQUIRE(numFullNeighborhoods > 0);
+
+    neighborhood.calcWeights();
+
+    for (auto i = 0; i < numPoints - 1; ++i)
+    {
+        auto weightSum = 0.0f;
+        for (auto j = 0; j < maxInfluencingProbes; ++j)
+        {
+            weightSum += neighborhood.weights[i * maxInfluencingProbes + j];
+        }
+
+        if (neighborhood.probeIndices[i * maxInfluencingProbes] >= 0)
+        {
+            REQUIRE(weightSum == Approx(1.0f));
+        }
+    }
+
+    for (auto j = 0; j < maxInfluencingProbes; ++j)
+    {
+        REQUIRE(neighborhood.weights[(numPoints - 1) * maxInfluencingProbes + j] == 0.0f);
+    }
+}
+
+TEST_CASE("Batched ProbeManager lookups find the same probes as single-point lookups.", "[ProbeManager]")
+{
+    const auto numPoints = 250;
+
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> distribution(-2.0f, 42.0f);
+
+    auto probeBatches = createGridOfProbeBatches();
+
+    ProbeManager probeManager;
+    for (const auto& probeBatch : probeBatches)
+    {
+        probeManager.addProbeBatch(probeBatch);
+    }
+    probeManager.commit();
+
+    vector<Vector3f> points;
+    for (auto i = 0; i < numPoints; ++i)
+    {
+        points.push_back(Vector3f(distribution(rng), 1.5f, distribution(rng)));
+    }
+
+    Array<ProbeNeighborhood> neighborhoods(numPoints);
+    probeManager.getInfluencingProbes(numPoints, points.data(), neighborhoods.data());
+
+    ProbeNeighborhood expectedNeighborhood;
+
+    for (auto i = 0; i < numPoints; ++i)
+    {
+        probeManager.getInfluencingProbes(points[i], expectedNeighborhood);
+        REQUIRE(neighborhoods[i].numProbes() == expectedNeighborhood.numProbes());
+
+        for (auto j = 0; j < expectedNeighborhood.numProbes(); ++j)
+        {
+            REQUIRE(neighborhoods[i].probeIndices[j] == expectedNeighborhood.probeIndices[j]);
+            if (expectedNeighborhood.probeIndices[j] >= 0)
+            {
+                REQUIRE(neighborhoods[i].batches[j] == expectedNeighborhood.batches[j]);
+            }
+        }
+    }
+}
+
+TEST_CASE("ProbeOcclusionCache reuses results until the endpoint moves or the scene changes.", "[ProbeManager]")
+{
+    Vector3f vertices[] = {
+        Vector3f(0.0f, -1.0f, -5.0f), Vector3f(0.0f, -1.0f, 5.0f), Vector3f(0.0f, 3.0f, 5.0f), Vector3f(0.0f, 3.0f, -5.0f)
+    };
+
+    Triangle triangles[] = {
+        {{0, 1, 2}}, {{0, 2, 3}}
+    };
+
+    int materialIndices[2] = {};
+
+    Material material{};
+
+    auto scene = shared_ptr<IScene>(SceneFactory::create(SceneType::Default, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+    auto staticMesh = scene->createStaticMesh(4, 2, 1, vertices, triangles, materialIndices, &material);
+    scene->addStaticMesh(staticMesh);
+    scene->commit();
+
+    ProbeBatch probeBatch;
+    probeBatch.addProbe(Sphere(Vector3f(-1.0f, 1.0f, 0.0f), 10.0f));
+    probeBatch.addProbe(Sphere(Vector3f(1.0f, 1.0f, 0.0f), 10.0f));
+    probeBatch.commit();
+
+    ProbeOcclusionCache cache;
+
+    auto countVisibleProbes = [&](const Vector3f& point, bool useCache)
+    {
+        ProbeNeighborhood neighborhood;
+        neighborhood.resize(ProbeNeighborhood::kMaxProbesPerBatch);
+        probeBatch.getInfluencingProbes(point, neighborhood);
+
+        if (useCache)
+        {
+            neighborhood.checkOcclusion(*scene, point, cache);
+        }
+        else
+        {
+            neighborhood.checkOcclusion(*scene, point);
+        }
+
+        return neighborhood.numValidProbes();
+    };
+
+    auto point = Vector3f(2.1f, 1.1f, 0.1f);
+
+    REQUIRE(countVisibleProbes(point, false) == 1);
+    REQUIRE(countVisibleProbes(point, true) == 1);
+    REQUIRE(cache.numCachedResults() == 2);
+
+    // Nearby points reuse the cached results.
+    REQUIRE(countVisibleProbes(point + Vector3f(0.05f, 0.05f, 0.05f), true) == 1);
+    REQUIRE(cache.numCachedResults() == 2);
+
+    // Points further away trace rays again.
+    REQUIRE(countVisibleProbes(point + Vector3f(1.0f, 0.0f, 0.0f), true) == 1);
+    REQUIRE(cache.numCachedResults() == 4);
+
+    // Removing the wall invalidates the cache.
+    scene->removeStaticMesh(staticMesh);
+    scene->commit();
+
+    REQUIRE(countVisibleProbes(point, true) == 2);
+    REQUIRE(cache.numCachedResults() == 2);
+}
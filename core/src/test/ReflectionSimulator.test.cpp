@@ -16,6 +16,12 @@
 
 #include <catch.hpp>
 
+#include <baked_reflection_data.h>
+#include <reflection_baker.h>
+#include <reflection_simulator_factory.h>
+#include <scene_factory.h>
+using namespace ipl;
+
 TEST_CASE("ReflectionSimulator", "[ReflectionSimulator]")
 {
 }
@@ -23,3 +29,457 @@ TEST_CASE("ReflectionSimulator", "[ReflectionSimulator]")
 TEST_CASE("DecoupledReflectionSimulator", "[DecoupledReflectionSimulator]")
 {
 }
+
+// Returns a scene containing a closed 10m x 4m x 6m box.
+static shared_ptr<IScene> createBoxScene()
+{
+    Vector3f vertices[] = {
+        Vector3f(-5.0f, 0.0f, -3.0f), Vector3f(5.0f, 0.0f, -3.0f), Vector3f(5.0f, 0.0f, 3.0f), Vector3f(-5.0f, 0.0f, 3.0f),
+        Vector3f(-5.0f, 4.0f, -3.0f), Vector3f(5.0f, 4.0f, -3.0f), Vector3f(5.0f, 4.0f, 3.0f), Vector3f(-5.0f, 4.0f, 3.0f)
+    };
+
+    Triangle triangles[] = {
+        {{0, 1, 2}}, {{0, 2, 3}}, {{4, 6, 5}}, {{4, 7, 6}},
+        {{0, 4, 5}}, {{0, 5, 1}}, {{1, 5, 6}}, {{1, 6, 2}},
+        {{2, 6, 7}}, {{2, 7, 3}}, {{3, 7, 4}}, {{3, 4, 0}}
+    };
+
+    int materialIndices[12] = {};
+
+    Material material{};
+    for (auto i = 0; i < Bands::kNumBands; ++i)
+    {
+        material.absorption[i] = 0.2f;
+    }
+    material.scattering = 0.5f;
+
+    auto scene = shared_ptr<IScene>(SceneFactory::create(SceneType::Default, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+    scene->addStaticMesh(scene->createStaticMesh(8, 12, 1, vertices, triangles, materialIndices, &material));
+    scene->commit();
+
+    return scene;
+}
+
+static float totalEnergy(const EnergyField& energyField)
+{
+    auto total = 0.0f;
+    for (auto i = 0; i < Bands::kNumBands; ++i)
+    {
+        for (auto j = 0; j < energyField.numBins(); ++j)
+        {
+            total += energyField[0][i][j];
+        }
+    }
+
+    return total;
+}
+
+TEST_CASE("Probe-parallel baking produces results comparable to ray-parallel baking.", "[ReflectionBaker]")
+{
+    const auto numRays = 4096;
+    const auto numBounces = 16;
+    const auto duration = 1.0f;
+    const auto order = 0;
+    const auto numThreads = 2;
+
+    auto scene = createBoxScene();
+
+    ProbeBatch rayParallelProbes;
+    ProbeBatch probeParallelProbes;
+    for (auto i = 0; i < 8; ++i)
+    {
+        auto probe = Sphere(Vector3f(-4.0f + i, 1.5f, (i % 3) - 1.0f), 2.0f);
+        rayParallelProbes.addProbe(probe);
+        probeParallelProbes.addProbe(probe);
+    }
+
+    rayParallelProbes.commit();
+    probeParallelProbes.commit();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Reflections;
+    identifier.variation = BakedDataVariation::Reverb;
+
+    auto simulator = ReflectionSimulatorFactory::create(SceneType::Default, numRays, 512, duration, order, 1, 1, numThreads, 1, nullptr);
+    ReflectionBaker::bake(*scene, *simulator, identifier, true, false, numRays, numBounces, duration, duration, order,
+                          1.0f, numThreads, 1, SceneType::Default, nullptr, rayParallelProbes);
+
+    Array<unique_ptr<IReflectionSimulator>> simulators(numThreads);
+    for (auto i = 0; i < numThreads; ++i)
+    {
+        simulators[i] = ReflectionSimulatorFactory::create(SceneType::Default, numRays, 512, duration, order, 1, 1, 1, 1, nullptr);
+    }
+
+    ReflectionBaker::bakeProbeParallel(*scene, simulators, identifier, true, false, numRays, numBounces, duration,
+                                       duration, order, 1.0f, probeParallelProbes);
+
+    const auto& rayParallelData = static_cast<const BakedReflectionsData&>(rayParallelProbes[identifier]);
+    const auto& probeParallelData = static_cast<const BakedReflectionsData&>(probeParallelProbes[identifier]);
+
+    EnergyField rayParallelField(duration, order);
+    EnergyField probeParallelField(duration, order);
+
+    for (auto i = 0; i < rayParallelProbes.numProbes(); ++i)
+    {
+        REQUIRE(rayParallelData.getEnergyField(i, rayParallelField));
+        REQUIRE(probeParallelData.getEnergyField(i, probeParallelField));
+
+        auto expected = totalEnergy(rayParallelField);
+        auto actual = totalEnergy(probeParallelField);
+
+        REQUIRE(expected > 0.0f);
+        REQUIRE(fabsf(actual - expected) < 0.1f * expected);
+    }
+}
+
+TEST_CASE("Incremental reflection bakes only bake invalidated probes.", "[ReflectionBaker]")
+{
+    const auto numRays = 1024;
+    const auto duration = 0.5f;
+
+    auto scene = createBoxScene();
+
+    ProbeBatch probeBatch;
+    for (auto i = 0; i < 4; ++i)
+    {
+        probeBatch.addProbe(Sphere(Vector3f(-3.0f + 2.0f * i, 1.5f, 0.0f), 2.0f));
+    }
+
+    probeBatch.commit();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Reflections;
+    identifier.variation = BakedDataVariation::Reverb;
+
+    ReflectionBakeCheckpointSettings checkpoint{};
+    checkpoint.skipValidProbes = true;
+
+    auto simulator = ReflectionSimulatorFactory::create(SceneType::Default, numRays, 512, duration, 0, 1, 1, 1, 1, nullptr);
+    ReflectionBaker::bake(*scene, *simulator, identifier, true, false, numRays, 8, duration, duration, 0, 1.0f, 1, 1,
+                          SceneType::Default, nullptr, probeBatch, nullptr, nullptr, EnergyFieldCompressionSettings{},
+                          checkpoint);
+
+    auto& data = static_cast<BakedReflectionsData&>(probeBatch[identifier]);
+
+    EnergyField* energyFields[4];
+    for (auto i = 0; i < 4; ++i)
+    {
+        REQUIRE(!data.needsUpdate(i));
+        energyFields[i] = data.lookupEnergyField(i);
+        REQUIRE(energyFields[i]);
+    }
+
+    // Only the last probe is within 1m of the changed region.
+    probeBatch.invalidateBakedData(identifier, Box(Vector3f(3.5f, 0.0f, -1.0f), Vector3f(4.0f, 1.0f, 1.0f)), 1.0f);
+
+    for (auto i = 0; i < 4; ++i)
+    {
+        REQUIRE(data.needsUpdate(i) == (i == 3));
+    }
+
+    ReflectionBaker::bake(*scene, *simulator, identifier, true, false, numRays, 8, duration, duration, 0, 1.0f, 1, 1,
+                          SceneType::Default, nullptr, probeBatch, nullptr, nullptr, EnergyFieldCompressionSettings{},
+                          checkpoint);
+
+    for (auto i = 0; i < 4; ++i)
+    {
+        REQUIRE(!data.needsUpdate(i));
+        REQUIRE((data.lookupEnergyField(i) == energyFields[i]) == (i < 3));
+    }
+}
+
+TEST_CASE("Sharded reflection bakes merge into a complete bake.", "[ReflectionBaker]")
+{
+    const auto numRays = 1024;
+    const auto duration = 0.5f;
+    const auto numProbes = 7;
+    const auto numShards = 3;
+
+    auto scene = createBoxScene();
+
+    ProbeBatch probeBatch;
+    ProbeBatch shards[numShards];
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        auto probe = Sphere(Vector3f(-4.0f + 1.2f * i, 1.5f, 0.5f), 2.0f);
+        probeBatch.addProbe(probe);
+        for (auto j = 0; j < numShards; ++j)
+        {
+            shards[j].addProbe(probe);
+        }
+    }
+
+    probeBatch.commit();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Reflections;
+    identifier.variation = BakedDataVariation::Reverb;
+
+    auto simulator = ReflectionSimulatorFactory::create(SceneType::Default, numRays, 512, duration, 0, 1, 1, 1, 1, nullptr);
+
+    EnergyField* energyFields[numProbes] = {};
+    ProbeBatch* shardPtrs[numShards] = {};
+
+    for (auto i = 0; i < numShards; ++i)
+    {
+        shards[i].commit();
+        shardPtrs[i] = &shards[i];
+
+        ReflectionBakeCheckpointSettings checkpoint{};
+        checkpoint.shard.index = i;
+        checkpoint.shard.numShards = numShards;
+
+        ReflectionBaker::bake(*scene, *simulator, identifier, true, true, numRays, 8, duration, duration, 0, 1.0f, 1, 1,
+                              SceneType::Default, nullptr, shards[i], nullptr, nullptr, EnergyFieldCompressionSettings{},
+                              checkpoint);
+
+        auto& shardData = static_cast<BakedReflectionsData&>(shards[i][identifier]);
+        for (auto j = 0; j < numProbes; ++j)
+        {
+            REQUIRE(shardData.needsUpdate(j) == (j % numShards != i));
+            if (j % numShards == i)
+            {
+                energyFields[j] = shardData.lookupEnergyField(j);
+            }
+        }
+    }
+
+    REQUIRE(ReflectionBaker::merge(identifier, numShards, shardPtrs, probeBatch));
+
+    auto& data = static_cast<BakedReflectionsData&>(probeBatch[identifier]);
+    REQUIRE(data.hasConvolution());
+    REQUIRE(data.hasParametric());
+
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        REQUIRE(!data.needsUpdate(i));
+        REQUIRE(data.lookupEnergyField(i) == energyFields[i]);
+        REQUIRE(data.lookupReverb(i)->reverbTimes[0] > 0.0f);
+    }
+
+    // Shards for a different set of probes can't be merged.
+    ProbeBatch otherProbeBatch;
+    otherProbeBatch.addProbe(Sphere(Vector3f(0.0f, 1.5f, 0.0f), 2.0f));
+    otherProbeBatch.commit();
+
+    REQUIRE(!ReflectionBaker::merge(identifier, numShards, shardPtrs, otherProbeBatch));
+}
+
+TEST_CASE("Sharded reflection bakes into already-baked probe batches merge only the probes of each shard.", "[ReflectionBaker]")
+{
+    const auto numRays = 1024;
+    const auto duration = 0.5f;
+    const auto numProbes = 5;
+    const auto numShards = 2;
+
+    auto scene = createBoxScene();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Reflections;
+    identifier.variation = BakedDataVariation::Reverb;
+
+    ProbeBatch probeBatch;
+    ProbeBatch shards[numShards];
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        auto probe = Sphere(Vector3f(-4.0f + 2.0f * i, 1.5f, 0.5f), 2.0f);
+        probeBatch.addProbe(probe);
+        for (auto j = 0; j < numShards; ++j)
+        {
+            shards[j].addProbe(probe);
+        }
+    }
+
+    probeBatch.commit();
+
+    auto simulator = ReflectionSimulatorFactory::create(SceneType::Default, numRays, 512, duration, 0, 1, 1, 1, 1, nullptr);
+
+    EnergyField* energyFields[numProbes] = {};
+    ProbeBatch* shardPtrs[numShards] = {};
+
+    for (auto i = 0; i < numShards; ++i)
+    {
+        shards[i].commit();
+        shardPtrs[i] = &shards[i];
+
+        // Each shard starts out as a copy of a probe batch in which every probe has already been baked.
+        auto staleData = ipl::make_unique<BakedReflectionsData>(identifier, numProbes, true, false);
+        for (auto j = 0; j < numProbes; ++j)
+        {
+            staleData->set(j, ipl::make_unique<EnergyField>(duration, 0));
+        }
+        shards[i].addData(identifier, std::move(staleData));
+
+        ReflectionBakeCheckpointSettings checkpoint{};
+        checkpoint.shard.index = i;
+        checkpoint.shard.numShards = numShards;
+
+        ReflectionBaker::bake(*scene, *simulator, identifier, true, false, numRays, 8, duration, duration, 0, 1.0f, 1, 1,
+                              SceneType::Default, nullptr, shards[i], nullptr, nullptr, EnergyFieldCompressionSettings{},
+                              checkpoint);
+
+        auto& shardData = static_cast<BakedReflectionsData&>(shards[i][identifier]);
+        for (auto j = 0; j < numProbes; ++j)
+        {
+            REQUIRE(!shardData.needsUpdate(j));
+            if (j % numShards == i)
+            {
+                energyFields[j] = shardData.lookupEnergyField(j);
+            }
+        }
+    }
+
+    REQUIRE(ReflectionBaker::merge(identifier, numShards, shardPtrs, probeBatch));
+
+    auto& data = static_cast<BakedReflectionsData&>(probeBatch[identifier]);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        REQUIRE(!data.needsUpdate(i));
+        REQUIRE(data.lookupEnergyField(i) == energyFields[i]);
+        REQUIRE(totalEnergy(*data.lookupEnergyField(i)) > 0.0f);
+    }
+
+    // The same shard can't be merged twice.
+    ProbeBatch* duplicateShardPtrs[numShards] = { &shards[0], &shards[0] };
+    REQUIRE(!ReflectionBaker::merge(identifier, numShards, duplicateShardPtrs, probeBatch));
+}
+
+TEST_CASE("Cancelled reflection bakes resume from their checkpoint.", "[ReflectionBaker]")
+{
+    const auto numRays = 1024;
+    const auto duration = 0.5f;
+    const auto numProbes = 6;
+
+    auto scene = createBoxScene();
+
+    ProbeBatch cancelledProbes;
+    ProbeBatch resumedProbes;
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        auto probe = Sphere(Vector3f(-4.0f + 1.5f * i, 1.5f, 0.5f), 2.0f);
+        cancelledProbes.addProbe(probe);
+        resumedProbes.addProbe(probe);
+    }
+
+    cancelledProbes.commit();
+    resumedProbes.commit();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Reflections;
+    identifier.variation = BakedDataVariation::Reverb;
+
+    ReflectionBakeCheckpointSettings checkpoint{};
+    checkpoint.fileName = "reflections_bake_checkpoint.test.bin";
+    checkpoint.interval = 2;
+    std::remove(checkpoint.fileName.c_str());
+
+    // Cancel the bake once half the probes have been baked.
+    auto cancelAtHalfway = [](float progress, void*)
+    {
+        if (progress >= 0.5f)
+        {
+            ReflectionBaker::cancel();
+        }
+    };
+
+    auto simulator = ReflectionSimulatorFactory::create(SceneType::Default, numRays, 512, duration, 0, 1, 1, 1, 1, nullptr);
+    ReflectionBaker::bake(*scene, *simulator, identifier, true, false, numRays, 8, duration, duration, 0, 1.0f, 1, 1,
+                          SceneType::Default, nullptr, cancelledProbes, cancelAtHalfway, nullptr,
+                          EnergyFieldCompressionSettings{}, checkpoint);
+
+    const auto& cancelledData = static_cast<const BakedReflectionsData&>(cancelledProbes[identifier]);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        REQUIRE(cancelledData.needsUpdate(i) == (i >= numProbes / 2));
+    }
+
+    auto file = fopen(checkpoint.fileName.c_str(), "rb");
+    REQUIRE(file);
+    fclose(file);
+
+    ReflectionBaker::bake(*scene, *simulator, identifier, true, false, numRays, 8, duration, duration, 0, 1.0f, 1, 1,
+                          SceneType::Default, nullptr, resumedProbes, nullptr, nullptr,
+                          EnergyFieldCompressionSettings{}, checkpoint);
+
+    const auto& resumedData = static_cast<const BakedReflectionsData&>(resumedProbes[identifier]);
+
+    EnergyField expected(duration, 0);
+    EnergyField actual(duration, 0);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        REQUIRE(!resumedData.needsUpdate(i));
+        REQUIRE(resumedData.getEnergyField(i, actual));
+
+        // Probes restored from the checkpoint are identical to the ones baked before cancelling.
+        if (i < numProbes / 2)
+        {
+            REQUIRE(cancelledData.getEnergyField(i, expected));
+            REQUIRE(memcmp(expected.flatData(), actual.flatData(), expected.numChannels() * Bands::kNumBands * expected.numBins() * sizeof(float)) == 0);
+        }
+        else
+        {
+            REQUIRE(totalEnergy(actual) > 0.0f);
+        }
+    }
+
+    // The checkpoint is deleted once the bake completes.
+    file = fopen(checkpoint.fileName.c_str(), "rb");
+    REQUIRE(!file);
+}
+
+TEST_CASE("Corrupt reflection bake checkpoints are ignored.", "[ReflectionBaker]")
+{
+    const auto numRays = 1024;
+    const auto duration = 0.5f;
+    const auto numProbes = 3;
+
+    auto scene = createBoxScene();
+
+    ProbeBatch probeBatch;
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        probeBatch.addProbe(Sphere(Vector3f(-2.0f + 2.0f * i, 1.5f, 0.5f), 2.0f));
+    }
+
+    probeBatch.commit();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Reflections;
+    identifier.variation = BakedDataVariation::Reverb;
+
+    ReflectionBakeCheckpointSettings checkpoint{};
+    checkpoint.fileName = "reflections_bake_checkpoint_corrupt.test.bin";
+    checkpoint.interval = 1;
+
+    // A checkpoint whose root offset points far past the end of the file.
+    uint8_t garbage[64];
+    for (auto i = 0u; i < sizeof(garbage); ++i)
+    {
+        garbage[i] = static_cast<uint8_t>(0xf0 + i);
+    }
+
+    auto file = fopen(checkpoint.fileName.c_str(), "wb");
+    REQUIRE(file);
+    fwrite(garbage, 1, sizeof(garbage), file);
+    fclose(file);
+
+    auto simulator = ReflectionSimulatorFactory::create(SceneType::Default, numRays, 512, duration, 0, 1, 1, 1, 1, nullptr);
+    ReflectionBaker::bake(*scene, *simulator, identifier, true, false, numRays, 8, duration, duration, 0, 1.0f, 1, 1,
+                          SceneType::Default, nullptr, probeBatch, nullptr, nullptr,
+                          EnergyFieldCompressionSettings{}, checkpoint);
+
+    // Every probe is baked from scratch.
+    const auto& data = static_cast<const BakedReflectionsData&>(probeBatch[identifier]);
+
+    EnergyField energyField(duration, 0);
+    for (auto i = 0; i < numProbes; ++i)
+    {
+        REQUIRE(!data.needsUpdate(i));
+        REQUIRE(data.getEnergyField(i, energyField));
+        REQUIRE(totalEnergy(energyField) > 0.0f);
+    }
+
+    // The corrupt checkpoint is replaced while baking, and deleted once the bake completes.
+    file = fopen(checkpoint.fileName.c_str(), "rb");
+    REQUIRE(!file);
+}
@@ -0,0 +1,284 @@
+//
+// Copyright 2017-2023 Valve Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <catch.hpp>
+
+#include <baked_reflection_data.h>
+#include <path_data.h>
+#include <scene_factory.h>
+#include <simulation_data.h>
+#include <simulation_manager.h>
+using namespace ipl;
+
+static unique_ptr<EnergyField> createEnergyField(float duration,
+                                                 float value)
+{
+    auto energyField = ipl::make_unique<EnergyField>(duration, 0);
+    for (auto i = 0; i < Bands::kNumBands; ++i)
+    {
+        for (auto j = 0; j < energyField->numBins(); ++j)
+        {
+            (*energyField)[0][i][j] = value / (1.0f + j);
+        }
+    }
+
+    return energyField;
+}
+
+// Returns a scene containing a 10m x 4m wall along the z axis, with a 2m wide gap at one end. The gap can be closed
+// by moving the end of the wall.
+static shared_ptr<IScene> createWallScene(float wallEnd = 3.0f)
+{
+    Vector3f vertices[] = {
+        Vector3f(0.0f, -1.0f, -5.0f), Vector3f(0.0f, -1.0f, wallEnd), Vector3f(0.0f, 3.0f, wallEnd), Vector3f(0.0f, 3.0f, -5.0f)
+    };
+
+    Triangle triangles[] = {
+        {{0, 1, 2}}, {{0, 2, 3}}
+    };
+
+    int materialIndices[2] = {};
+
+    Material material{};
+
+    auto scene = shared_ptr<IScene>(SceneFactory::create(SceneType::Default, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+    scene->addStaticMesh(scene->createStaticMesh(4, 2, 1, vertices, triangles, materialIndices, &material));
+    scene->commit();
+
+    return scene;
+}
+
+// Custom scene callbacks that trace rays against another scene, which can be replaced without the custom scene
+// knowing about it.
+static void IPL_CALLBACK closestHit(const Ray* ray,
+                                    float minDistance,
+                                    float maxDistance,
+                                    Hit* hit,
+                                    void* userData)
+{
+    const auto& geometry = *reinterpret_cast<shared_ptr<IScene>*>(userData);
+    *hit = geometry->closestHit(*ray, minDistance, maxDistance);
+}
+
+static void IPL_CALLBACK anyHit(const Ray* ray,
+                                float minDistance,
+                                float maxDistance,
+                                uint8_t* occluded,
+                                void* userData)
+{
+    const auto& geometry = *reinterpret_cast<shared_ptr<IScene>*>(userData);
+    *occluded = (geometry->anyHit(*ray, minDistance, maxDistance)) ? 1 : 0;
+}
+
+TEST_CASE("Baked impulse responses are reused only while their inputs are unchanged.", "[SimulationManager]")
+{
+    const auto duration = 0.1f;
+    const auto samplingRate = 48000;
+    const auto frameSize = 1024;
+
+    SimulationManager simulator(false, true, false, SceneType::Default, IndirectEffectType::Convolution, 1, 1024, 32,
+                                duration, 0, 1, 1, 1, 1, 1, false, Vector3f(0.0f, -1.0f, 0.0f), samplingRate, frameSize,
+                                nullptr, nullptr, nullptr);
+
+    simulator.scene() = shared_ptr<IScene>(SceneFactory::create(SceneType::Default, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+    simulator.scene()->commit();
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Reflections;
+    identifier.variation = BakedDataVariation::Reverb;
+
+    // Two overlapping probes. Points near x = -3.5 are only influenced by the first one.
+    auto probeBatch = ipl::make_shared<ProbeBatch>();
+    probeBatch->addProbe(Sphere(Vector3f(-1.0f, 1.5f, 0.0f), 3.0f));
+    probeBatch->addProbe(Sphere(Vector3f(1.0f, 1.5f, 0.0f), 3.0f));
+    probeBatch->commit();
+
+    auto data = ipl::make_unique<BakedReflectionsData>(identifier, 2, true, false);
+    data->set(0, createEnergyField(duration, 1.0f));
+    data->set(1, createEnergyField(duration, 0.5f));
+    probeBatch->addData(identifier, std::move(data));
+    auto& bakedData = static_cast<BakedReflectionsData&>((*probeBatch)[identifier]);
+
+    auto source = ipl::make_shared<SimulationData>(true, false, SceneType::Default, IndirectEffectType::Convolution, 1,
+                                                   duration, 0, samplingRate, frameSize, nullptr, nullptr);
+    source->reflectionInputs.enabled = true;
+    source->reflectionInputs.baked = true;
+    source->reflectionInputs.bakedDataIdentifier = identifier;
+
+    simulator.addProbeBatch(probeBatch);
+    simulator.addSource(source);
+    simulator.commit();
+
+    SharedReflectionSimulationInputs sharedInputs{};
+    sharedInputs.listener = CoordinateSpace3f(Vector3f(-0.5f, 1.5f, 0.0f));
+    sharedInputs.duration = duration;
+    sharedInputs.order = 0;
+    sharedInputs.reconstructionType = ReconstructionType::Gaussian;
+    simulator.setSharedReflectionInputs(sharedInputs);
+
+    auto& state = source->reflectionState;
+    auto& overlapSaveFIR = source->reflectionOutputs.overlapSaveFIR;
+
+    // Runs a simulation, and then picks up whatever impulse response was published, as the audio thread would.
+    auto simulate = [&]()
+    {
+        simulator.simulateIndirect();
+        REQUIRE(state.validSimulationData);
+        return overlapSaveFIR.updateReadBuffer();
+    };
+
+    SECTION("Unchanged inputs reuse the previous impulse response.")
+    {
+        REQUIRE(simulate());
+        REQUIRE(!state.reuseImpulseResponse);
+
+        REQUIRE(!simulate());
+        REQUIRE(state.reuseImpulseResponse);
+        REQUIRE(!simulate());
+        REQUIRE(state.reuseImpulseResponse);
+    }
+
+    SECTION("A reused impulse response that could not be published is published later.")
+    {
+        simulator.simulateIndirect();
+        REQUIRE(state.impulseResponsePublished);
+
+        // The audio thread hasn't picked up the first impulse response, so the second one can't be committed yet.
+        sharedInputs.listener.origin = Vector3f(0.5f, 1.5f, 0.0f);
+        simulator.setSharedReflectionInputs(sharedInputs);
+        simulator.simulateIndirect();
+        REQUIRE(!state.reuseImpulseResponse);
+        REQUIRE(!state.impulseResponsePublished);
+
+        REQUIRE(overlapSaveFIR.updateReadBuffer());
+
+        REQUIRE(simulate());
+        REQUIRE(state.reuseImpulseResponse);
+        REQUIRE(state.impulseResponsePublished);
+    }
+
+    SECTION("Changing the probe weights republishes the impulse response.")
+    {
+        REQUIRE(simulate());
+
+        sharedInputs.listener.origin = Vector3f(0.5f, 1.5f, 0.0f);
+        simulator.setSharedReflectionInputs(sharedInputs);
+        REQUIRE(simulate());
+        REQUIRE(!state.reuseImpulseResponse);
+    }
+
+    SECTION("Changing the set of influencing probes republishes the impulse response.")
+    {
+        REQUIRE(simulate());
+
+        sharedInputs.listener.origin = Vector3f(-3.5f, 1.5f, 0.0f);
+        simulator.setSharedReflectionInputs(sharedInputs);
+        REQUIRE(simulate());
+        REQUIRE(!state.reuseImpulseResponse);
+        REQUIRE(state.bakedImpulseResponseKey.probes.size() == 1);
+
+        REQUIRE(!simulate());
+        REQUIRE(state.reuseImpulseResponse);
+    }
+
+    SECTION("Changing the baked data republishes the impulse response.")
+    {
+        REQUIRE(simulate());
+
+        bakedData.set(1, createEnergyField(duration, 0.25f));
+        REQUIRE(simulate());
+        REQUIRE(!state.reuseImpulseResponse);
+
+        REQUIRE(!simulate());
+        REQUIRE(state.reuseImpulseResponse);
+    }
+
+    SECTION("Changing the reconstruction settings republishes the impulse response.")
+    {
+        REQUIRE(simulate());
+
+        source->reflectionInputs.reverbScale[0] = 0.5f;
+        REQUIRE(simulate());
+        REQUIRE(!state.reuseImpulseResponse);
+    }
+}
+
+TEST_CASE("Paths are not cached when the geometry of a custom scene changes.", "[SimulationManager]")
+{
+    const auto order = 1;
+    const auto samplingRate = 48000;
+    const auto frameSize = 1024;
+
+    BakedDataIdentifier identifier{};
+    identifier.type = BakedDataType::Pathing;
+    identifier.variation = BakedDataVariation::Dynamic;
+
+    auto probeBatch = ipl::make_shared<ProbeBatch>();
+    for (auto x = -3; x <= 3; x += 2)
+    {
+        for (auto z = -4; z <= 4; z += 2)
+        {
+            probeBatch->addProbe(Sphere(Vector3f(static_cast<float>(x), 1.0f, static_cast<float>(z)), 1.0f));
+        }
+    }
+    probeBatch->commit();
+
+    auto geometry = createWallScene();
+    PathBaker::bake(*geometry, identifier, 1, 0.0f, 1.0f, 20.0f, 20.0f, 50.0f, false, Vector3f(0.0f, -1.0f, 0.0f),
+                    false, 1, *probeBatch);
+
+    SimulationManager simulator(false, false, true, SceneType::Custom, IndirectEffectType::Convolution, 1, 1024, 32,
+                                0.1f, order, 1, 1, 1, 1, 1, false, Vector3f(0.0f, -1.0f, 0.0f), samplingRate, frameSize,
+                                nullptr, nullptr, nullptr);
+
+    simulator.scene() = shared_ptr<IScene>(SceneFactory::create(SceneType::Custom, closestHit, anyHit, nullptr, nullptr, &geometry, nullptr, nullptr));
+    simulator.scene()->commit();
+
+    auto source = ipl::make_shared<SimulationData>(false, true, SceneType::Custom, IndirectEffectType::Convolution, 1,
+                                                   0.1f, order, samplingRate, frameSize, nullptr, nullptr);
+    source->pathingInputs.enabled = true;
+    source->pathingInputs.source = CoordinateSpace3f(Vector3f(-3.0f, 1.0f, -2.0f));
+    source->pathingInputs.probes = probeBatch;
+    source->pathingInputs.visRadius = 0.0f;
+    source->pathingInputs.visThreshold = 1.0f;
+    source->pathingInputs.visRange = 20.0f;
+    source->pathingInputs.order = order;
+    source->pathingInputs.enableValidation = true;
+    source->pathingInputs.findAlternatePaths = true;
+    source->pathingInputs.simplifyPaths = false;
+    source->pathingInputs.realTimeVis = true;
+
+    simulator.addProbeBatch(probeBatch);
+    simulator.addSource(source);
+    simulator.commit();
+
+    SharedPathingSimulationInputs sharedInputs{};
+    sharedInputs.listener = CoordinateSpace3f(Vector3f(3.0f, 1.0f, -4.0f));
+    simulator.setSharedPathingInputs(sharedInputs);
+
+    simulator.simulatePathing();
+    REQUIRE(source->pathingOutputs.sh[0] != 0.0f);
+
+    simulator.simulatePathing();
+    REQUIRE(source->pathingOutputs.sh[0] != 0.0f);
+
+    // Close the gap in the wall. The custom scene's version doesn't change, so paths found before must not be reused,
+    // since they now fail validation.
+    geometry = createWallScene(6.0f);
+
+    simulator.simulatePathing();
+    REQUIRE(source->pathingOutputs.sh[0] == 0.0f);
+}
@@ -448,6 +448,7 @@ namespace SteamAudio
         public int sofaFileDataSize;
         public float volume;
         public HRTFNormType normType;
+        public float interpolationGridResolution;
     }
 
     [StructLayout(LayoutKind.Sequential)]